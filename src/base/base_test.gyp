@@ -104,6 +104,7 @@
       'sources': [
         'container/bitarray_test.cc',
         'logging_test.cc',
+        'memory_usage_test.cc',
         'mmap_test.cc',
         'random_test.h',
         'singleton_test.cc',
@@ -314,6 +315,7 @@
       'target_name': 'trie_test',
       'type': 'executable',
       'sources': [
+        'container/flat_trie_test.cc',
         'container/trie_test.cc',
       ],
       'dependencies': [
@@ -31,6 +31,7 @@
 
 #include <cstdint>
 
+#include "base/clock.h"
 #include "testing/googletest.h"
 #include "testing/gunit.h"
 #include "absl/time/time.h"
@@ -199,5 +200,15 @@ TEST(ClockMockTest, AutoPutForwardTest) {
   }
 }
 
+TEST(ClockMockTest, ScopedClockMockTest) {
+  {
+    ScopedClockMock clock(kTestTime);
+    EXPECT_EQ(Clock::GetAbslTime(), kTestTime);
+    clock->Advance(kDelta);
+    EXPECT_EQ(Clock::GetAbslTime(), kTestTime + kDelta);
+  }
+  EXPECT_NE(Clock::GetAbslTime(), kTestTime + kDelta);
+}
+
 }  // namespace
 }  // namespace mozc
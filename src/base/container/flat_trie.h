@@ -0,0 +1,328 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Immutable trie with the same lookup semantics as Trie<T>, built once from
+// the full set of entries. The nodes are stored in a single array in
+// breadth-first order and the children of a node are consecutive and sorted by
+// their labels, so that a lookup does a binary search on a contiguous array per
+// character instead of following a pointer to a hash map per node.
+
+#ifndef MOZC_BASE_CONTAINER_FLAT_TRIE_H_
+#define MOZC_BASE_CONTAINER_FLAT_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/util.h"
+#include "absl/strings/string_view.h"
+
+namespace mozc {
+
+template <typename T>
+class FlatTrie final {
+ public:
+  // Creates an empty trie.
+  FlatTrie() : labels_(1), nodes_(1) { root_ascii_children_.fill(kNotFound); }
+
+  // Creates a trie holding |entries|. If a key appears more than once, the
+  // last one wins as with Trie<T>::AddEntry().
+  explicit FlatTrie(std::vector<std::pair<std::string, T>> entries);
+
+  FlatTrie(const FlatTrie &) = delete;
+  FlatTrie &operator=(const FlatTrie &) = delete;
+  FlatTrie(FlatTrie &&) = default;
+  FlatTrie &operator=(FlatTrie &&) = default;
+
+  ~FlatTrie() = default;
+
+  // The following methods behave the same as the ones of Trie<T>.
+  bool LookUp(absl::string_view key, T *data) const;
+  bool LookUpPrefix(absl::string_view key, T *data, size_t *key_length,
+                    bool *fixed) const;
+  bool LongestMatch(absl::string_view key, T *data, size_t *key_length) const;
+  void LookUpPredictiveAll(absl::string_view key,
+                           std::vector<T> *data_list) const;
+  bool HasSubTrie(absl::string_view key) const;
+
+  size_t num_nodes() const { return nodes_.size(); }
+
+ private:
+  static constexpr uint32_t kRoot = 0;
+  static constexpr uint32_t kNotFound = 0xFFFFFFFF;
+  static constexpr char32_t kNumAsciiLabels = 0x80;
+
+  struct Node {
+    // The children are nodes_[children_begin, children_end).
+    uint32_t children_begin = 0;
+    uint32_t children_end = 0;
+    // Index to values_, or kNotFound if the node has no data.
+    uint32_t value = kNotFound;
+  };
+
+  struct WalkResult {
+    // The deepest node reached.
+    uint32_t node = kRoot;
+    // Bytes of the key consumed to reach |node|.
+    size_t key_length = 0;
+  };
+
+  // Returns the child of |node| labeled with |label|, or kNotFound.
+  uint32_t FindChild(uint32_t node, char32_t label) const {
+    if (node == kRoot && label < kNumAsciiLabels) {
+      return root_ascii_children_[label];
+    }
+    const auto begin = labels_.begin() + nodes_[node].children_begin;
+    const auto end = labels_.begin() + nodes_[node].children_end;
+    // Most nodes have only a few children, for which a linear scan is
+    // faster than a binary search.
+    constexpr ptrdiff_t kMaxLinearScanSize = 8;
+    const auto it = end - begin <= kMaxLinearScanSize
+                        ? std::find(begin, end, label)
+                        : std::lower_bound(begin, end, label);
+    if (it == end || *it != label) {
+      return kNotFound;
+    }
+    return static_cast<uint32_t>(it - labels_.begin());
+  }
+
+  // Splits the first character of non-empty |key| into |label| and |rest|.
+  static void SplitFirstLabel(absl::string_view key, char32_t *label,
+                              absl::string_view *rest) {
+    if (static_cast<unsigned char>(key[0]) < kNumAsciiLabels) {
+      *label = static_cast<unsigned char>(key[0]);
+      *rest = key.substr(1);
+      return;
+    }
+    Util::SplitFirstChar32(key, label, rest);
+  }
+
+  // Follows |key| from the root as far as possible.
+  WalkResult Walk(absl::string_view key) const {
+    WalkResult result;
+    absl::string_view rest = key;
+    while (!rest.empty()) {
+      char32_t label;
+      absl::string_view next;
+      SplitFirstLabel(rest, &label, &next);
+      const uint32_t child = FindChild(result.node, label);
+      if (child == kNotFound) {
+        break;
+      }
+      result.node = child;
+      rest = next;
+      result.key_length = key.size() - rest.size();
+    }
+    return result;
+  }
+
+  bool HasChildren(uint32_t node) const {
+    return nodes_[node].children_begin != nodes_[node].children_end;
+  }
+
+  void CollectValues(uint32_t node, std::vector<T> *data_list) const {
+    if (nodes_[node].value != kNotFound) {
+      data_list->push_back(values_[nodes_[node].value]);
+    }
+    for (uint32_t child = nodes_[node].children_begin;
+         child < nodes_[node].children_end; ++child) {
+      CollectValues(child, data_list);
+    }
+  }
+
+  // labels_[i] is the last character of the key of nodes_[i].
+  std::vector<char32_t> labels_;
+  std::vector<Node> nodes_;
+  std::vector<T> values_;
+  // Children of the root indexed by their ASCII labels, as most keys start
+  // with an ASCII character.
+  std::array<uint32_t, kNumAsciiLabels> root_ascii_children_;
+};
+
+template <typename T>
+FlatTrie<T>::FlatTrie(std::vector<std::pair<std::string, T>> entries) {
+  // Keys are split at the character boundaries in the same way as lookups.
+  std::vector<std::pair<std::u32string, T>> sorted;
+  sorted.reserve(entries.size());
+  for (auto &[key, value] : entries) {
+    std::u32string labels;
+    absl::string_view rest = key;
+    while (!rest.empty()) {
+      char32_t label;
+      Util::SplitFirstChar32(rest, &label, &rest);
+      labels.push_back(label);
+    }
+    sorted.emplace_back(std::move(labels), std::move(value));
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const auto &lhs, const auto &rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  // Keeps the last one of the same keys.
+  size_t size = 0;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (size > 0 && sorted[size - 1].first == sorted[i].first) {
+      sorted[size - 1].second = std::move(sorted[i].second);
+    } else {
+      if (size != i) {
+        sorted[size] = std::move(sorted[i]);
+      }
+      ++size;
+    }
+  }
+  sorted.resize(size);
+
+  // Builds the nodes in breadth-first order so that the children of each node
+  // are allocated consecutively.
+  struct Range {
+    uint32_t node;
+    size_t begin;
+    size_t end;
+    size_t depth;
+  };
+  labels_.push_back(0);
+  nodes_.emplace_back();
+  std::deque<Range> queue = {{kRoot, 0, sorted.size(), 0}};
+  while (!queue.empty()) {
+    Range range = queue.front();
+    queue.pop_front();
+    // The key ending at this node, if any, is sorted first in the range.
+    if (range.begin < range.end &&
+        sorted[range.begin].first.size() == range.depth) {
+      nodes_[range.node].value = values_.size();
+      values_.push_back(std::move(sorted[range.begin].second));
+      ++range.begin;
+    }
+    nodes_[range.node].children_begin = nodes_.size();
+    for (size_t begin = range.begin; begin < range.end;) {
+      const char32_t label = sorted[begin].first[range.depth];
+      size_t end = begin + 1;
+      while (end < range.end && sorted[end].first[range.depth] == label) {
+        ++end;
+      }
+      queue.push_back({static_cast<uint32_t>(nodes_.size()), begin, end,
+                       range.depth + 1});
+      labels_.push_back(label);
+      nodes_.emplace_back();
+      begin = end;
+    }
+    nodes_[range.node].children_end = nodes_.size();
+  }
+  DCHECK_EQ(labels_.size(), nodes_.size());
+  root_ascii_children_.fill(kNotFound);
+  for (uint32_t child = nodes_[kRoot].children_begin;
+       child < nodes_[kRoot].children_end; ++child) {
+    if (labels_[child] < kNumAsciiLabels) {
+      root_ascii_children_[labels_[child]] = child;
+    }
+  }
+  labels_.shrink_to_fit();
+  nodes_.shrink_to_fit();
+}
+
+template <typename T>
+bool FlatTrie<T>::LookUp(absl::string_view key, T *data) const {
+  const WalkResult result = Walk(key);
+  if (result.key_length != key.size() ||
+      nodes_[result.node].value == kNotFound) {
+    return false;
+  }
+  *data = values_[nodes_[result.node].value];
+  return true;
+}
+
+template <typename T>
+bool FlatTrie<T>::LookUpPrefix(absl::string_view key, T *data,
+                               size_t *key_length, bool *fixed) const {
+  const WalkResult result = Walk(key);
+  *key_length = result.key_length;
+  if (nodes_[result.node].value == kNotFound) {
+    *fixed = true;
+    return false;
+  }
+  *data = values_[nodes_[result.node].value];
+  *fixed = !HasChildren(result.node);
+  return true;
+}
+
+template <typename T>
+bool FlatTrie<T>::LongestMatch(absl::string_view key, T *data,
+                               size_t *key_length) const {
+  uint32_t node = kRoot;
+  absl::string_view rest = key;
+  bool found = false;
+  while (true) {
+    if (nodes_[node].value != kNotFound) {
+      *data = values_[nodes_[node].value];
+      *key_length = key.size() - rest.size();
+      found = true;
+    }
+    if (rest.empty()) {
+      break;
+    }
+    char32_t label;
+    absl::string_view next;
+    SplitFirstLabel(rest, &label, &next);
+    node = FindChild(node, label);
+    if (node == kNotFound) {
+      break;
+    }
+    rest = next;
+  }
+  if (!found) {
+    *key_length = 0;
+  }
+  return found;
+}
+
+template <typename T>
+void FlatTrie<T>::LookUpPredictiveAll(absl::string_view key,
+                                      std::vector<T> *data_list) const {
+  DCHECK(data_list);
+  const WalkResult result = Walk(key);
+  if (result.key_length != key.size()) {
+    return;
+  }
+  CollectValues(result.node, data_list);
+}
+
+template <typename T>
+bool FlatTrie<T>::HasSubTrie(absl::string_view key) const {
+  return !key.empty() && Walk(key).key_length == key.size();
+}
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_CONTAINER_FLAT_TRIE_H_
@@ -0,0 +1,182 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for FlatTrie against Trie with the rules of the romaji table,
+// which composer::Table looks up on every key typed.
+//
+// Usage:
+//   bazel run -c opt //base/container:flat_trie_benchmark
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/container/flat_trie.h"
+#include "base/container/trie.h"
+#include "base/file_stream.h"
+#include "base/init_mozc.h"
+#include "base/logging.h"
+#include "testing/googletest.h"
+#include "testing/mozctest.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+namespace mozc {
+namespace {
+
+// Inputs of the rules in data/preedit/romanji-hiragana.tsv.
+const std::vector<std::string> &GetRuleInputs() {
+  static const std::vector<std::string> *inputs = [] {
+    auto *inputs = new std::vector<std::string>();
+    const std::string path = testing::GetSourceFileOrDie(
+        {"data", "preedit", "romanji-hiragana.tsv"});
+    InputFileStream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      const std::vector<absl::string_view> fields =
+          absl::StrSplit(line, '\t');
+      if (fields.size() < 2 || fields[0].empty()) {
+        continue;
+      }
+      inputs->emplace_back(fields[0]);
+    }
+    CHECK(!inputs->empty()) << "No rule is loaded from " << path;
+    return inputs;
+  }();
+  return *inputs;
+}
+
+// Text typed in the benchmarks: every rule input, each followed by the next
+// one so that prefix lookups also see keys that don't match exactly.
+const std::string &GetTypedText() {
+  static const std::string *text = [] {
+    auto *text = new std::string();
+    for (const std::string &input : GetRuleInputs()) {
+      text->append(input);
+    }
+    return text;
+  }();
+  return *text;
+}
+
+const Trie<int> &GetTrie() {
+  static const Trie<int> *trie = [] {
+    auto *trie = new Trie<int>();
+    const std::vector<std::string> &inputs = GetRuleInputs();
+    for (int i = 0; i < inputs.size(); ++i) {
+      trie->AddEntry(inputs[i], i);
+    }
+    return trie;
+  }();
+  return *trie;
+}
+
+const FlatTrie<int> &GetFlatTrie() {
+  static const FlatTrie<int> *trie = [] {
+    std::vector<std::pair<std::string, int>> entries;
+    const std::vector<std::string> &inputs = GetRuleInputs();
+    for (int i = 0; i < inputs.size(); ++i) {
+      entries.emplace_back(inputs[i], i);
+    }
+    return new FlatTrie<int>(std::move(entries));
+  }();
+  return *trie;
+}
+
+// Looks up the rule at every position of the typed text, as CharChunk does
+// for each key.
+template <typename TrieType>
+void LookUpPrefix(::benchmark::State &state, const TrieType &trie) {
+  const absl::string_view text = GetTypedText();
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+      int data = 0;
+      size_t key_length = 0;
+      bool fixed = false;
+      ::benchmark::DoNotOptimize(trie.LookUpPrefix(
+          text.substr(pos, 4), &data, &key_length, &fixed));
+      ++num_lookups;
+    }
+  }
+  state.SetItemsProcessed(num_lookups);
+}
+
+void BM_TrieLookUpPrefix(::benchmark::State &state) {
+  LookUpPrefix(state, GetTrie());
+}
+BENCHMARK(BM_TrieLookUpPrefix);
+
+void BM_FlatTrieLookUpPrefix(::benchmark::State &state) {
+  LookUpPrefix(state, GetFlatTrie());
+}
+BENCHMARK(BM_FlatTrieLookUpPrefix);
+
+// Checks whether each prefix of every rule input has longer rules.
+template <typename TrieType>
+void HasSubTrie(::benchmark::State &state, const TrieType &trie) {
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const std::string &input : GetRuleInputs()) {
+      for (size_t len = 1; len <= input.size(); ++len) {
+        ::benchmark::DoNotOptimize(
+            trie.HasSubTrie(absl::string_view(input).substr(0, len)));
+        ++num_lookups;
+      }
+    }
+  }
+  state.SetItemsProcessed(num_lookups);
+}
+
+void BM_TrieHasSubTrie(::benchmark::State &state) {
+  HasSubTrie(state, GetTrie());
+}
+BENCHMARK(BM_TrieHasSubTrie);
+
+void BM_FlatTrieHasSubTrie(::benchmark::State &state) {
+  HasSubTrie(state, GetFlatTrie());
+}
+BENCHMARK(BM_FlatTrieHasSubTrie);
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  // Let the benchmark library consume its own flags first, as InitMozc()
+  // rejects unknown flags.
+  ::benchmark::Initialize(&argc, argv);
+  mozc::InitMozc(argv[0], &argc, &argv);
+  mozc::InitTestFlags();
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  return 0;
+}
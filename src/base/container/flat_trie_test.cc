@@ -0,0 +1,142 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/container/flat_trie.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/container/trie.h"
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+#include "absl/strings/string_view.h"
+
+namespace mozc {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAreArray;
+
+TEST(FlatTrieTest, Empty) {
+  const FlatTrie<int> trie;
+  int data = 0;
+  size_t key_length = 0;
+  bool fixed = false;
+  EXPECT_FALSE(trie.LookUp("", &data));
+  EXPECT_FALSE(trie.LookUp("a", &data));
+  EXPECT_FALSE(trie.LookUpPrefix("a", &data, &key_length, &fixed));
+  EXPECT_EQ(key_length, 0);
+  EXPECT_TRUE(fixed);
+  EXPECT_FALSE(trie.HasSubTrie("a"));
+  std::vector<int> data_list;
+  trie.LookUpPredictiveAll("", &data_list);
+  EXPECT_THAT(data_list, IsEmpty());
+}
+
+TEST(FlatTrieTest, LastEntryWins) {
+  const FlatTrie<int> trie({{"ab", 1}, {"a", 2}, {"ab", 3}});
+  int data = 0;
+  EXPECT_TRUE(trie.LookUp("ab", &data));
+  EXPECT_EQ(data, 3);
+  EXPECT_TRUE(trie.LookUp("a", &data));
+  EXPECT_EQ(data, 2);
+  // Root, "a" and "ab".
+  EXPECT_EQ(trie.num_nodes(), 3);
+}
+
+TEST(FlatTrieTest, LookUpPredictiveAllIsSorted) {
+  const FlatTrie<std::string> trie(
+      {{"kb", "kb"}, {"k", "k"}, {"ka", "ka"}, {"kaa", "kaa"}, {"x", "x"}});
+  std::vector<std::string> data_list;
+  trie.LookUpPredictiveAll("k", &data_list);
+  EXPECT_THAT(data_list, ElementsAre("k", "ka", "kaa", "kb"));
+}
+
+// FlatTrie must return the same results as Trie for the same entries.
+TEST(FlatTrieTest, SameAsTrie) {
+  const std::vector<std::pair<std::string, std::string>> entries = {
+      {"a", "あ"},      {"ka", "か"},     {"kya", "きゃ"},   {"kk", "っ"},
+      {"n", "ん"},      {"nn", "ん"},     {"ny", ""},        {"nya", "にゃ"},
+      {"xtu", "っ"},    {"xtsu", "っ"},   {"か゛", "が"},    {"か", "か"},
+      {"{?}", "？"},    {"\tk", "k"},     {"1", "あ"},       {"11", "い"},
+      {"111", "う"},    {"\xff", "bad"},  {"zzzz", "zzzz"},
+  };
+  Trie<std::string> trie;
+  for (const auto &[key, value] : entries) {
+    trie.AddEntry(key, value);
+  }
+  const FlatTrie<std::string> flat_trie(entries);
+
+  const std::vector<absl::string_view> queries = {
+      "",     "a",   "ab",    "k",    "ka",    "kay", "ky",  "kya", "kyaa",
+      "kk",   "kka", "n",     "nn",   "nny",   "ny",  "nyo", "x",   "xt",
+      "xts",  "xtu", "xtsua", "か",   "か゛",  "が",  "{",   "{?}", "\t",
+      "\tka", "1",   "11",    "111",  "1111",  "2",   "z",   "zz",  "zzzzz",
+      "\xff", "\xe3",
+  };
+  for (const absl::string_view query : queries) {
+    SCOPED_TRACE(query);
+    std::string expected, actual;
+    EXPECT_EQ(flat_trie.LookUp(query, &actual), trie.LookUp(query, &expected));
+    EXPECT_EQ(actual, expected);
+
+    size_t expected_length = 0, actual_length = 0;
+    bool expected_fixed = false, actual_fixed = false;
+    expected.clear();
+    actual.clear();
+    EXPECT_EQ(
+        flat_trie.LookUpPrefix(query, &actual, &actual_length, &actual_fixed),
+        trie.LookUpPrefix(query, &expected, &expected_length,
+                          &expected_fixed));
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(actual_length, expected_length);
+    EXPECT_EQ(actual_fixed, expected_fixed);
+
+    expected_length = actual_length = 0;
+    expected.clear();
+    actual.clear();
+    EXPECT_EQ(flat_trie.LongestMatch(query, &actual, &actual_length),
+              trie.LongestMatch(query, &expected, &expected_length));
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(actual_length, expected_length);
+
+    EXPECT_EQ(flat_trie.HasSubTrie(query), trie.HasSubTrie(query));
+
+    std::vector<std::string> expected_list, actual_list;
+    trie.LookUpPredictiveAll(query, &expected_list);
+    flat_trie.LookUpPredictiveAll(query, &actual_list);
+    EXPECT_THAT(actual_list, UnorderedElementsAreArray(expected_list));
+  }
+}
+
+}  // namespace
+}  // namespace mozc
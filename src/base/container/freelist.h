@@ -56,12 +56,17 @@ class FreeList {
 
   void Reset() { chunk_index_ = current_index_ = 0; }
 
-  void Free() {
-    for (size_t i = 1; i < pool_.size(); ++i) {
+  void Free() { Free(1); }
+
+  // Frees the chunks except for the first |num_chunks| ones. The objects in
+  // the kept chunks are not destructed and are returned by Alloc() again, so
+  // the memory they own (e.g. string buffers) can be reused.
+  void Free(size_t num_chunks) {
+    for (size_t i = num_chunks; i < pool_.size(); ++i) {
       delete[] pool_[i];
     }
-    if (pool_.size() > 1) {
-      pool_.resize(1);
+    if (pool_.size() > num_chunks) {
+      pool_.resize(num_chunks);
     }
     current_index_ = 0;
     chunk_index_ = 0;
@@ -116,6 +116,24 @@ TEST_F(FreeListTest, FreeListAllocResetFree) {
   EXPECT_GT(Stub::destructed(), 0);
 }
 
+TEST_F(FreeListTest, FreeListFreeKeepsChunks) {
+  FreeList<Stub> list(4);
+  for (int i = 0; i < 10; ++i) {
+    list.Alloc()->Use();
+  }
+  EXPECT_EQ(Stub::constructed(), 12);
+
+  list.Free(2);
+  EXPECT_EQ(Stub::destructed(), 4);
+
+  // The objects in the kept chunks are reused.
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(list.Alloc()->IsUsed());
+  }
+  EXPECT_FALSE(list.Alloc()->IsUsed());
+  EXPECT_EQ(Stub::constructed(), 16);
+}
+
 TEST_F(FreeListTest, ObjectPoolSize) {
   ObjectPool<std::string> pool(10);
 
@@ -82,7 +82,8 @@ class Trie final {
     if (const FindResult res = FindSubTrie(key);
         res.trie != nullptr && res.trie->DeleteEntry(res.rest)) {
       trie_.erase(res.first_char);
-      return trie_.empty();
+      // Keep this node if it still has data.
+      return trie_.empty() && !data_.has_value();
     }
     return false;
   }
@@ -98,6 +98,19 @@ TEST(TrieTest, Trie) {
   }
 }
 
+TEST(TrieTest, DeleteEntryKeepsParentData) {
+  Trie<std::string> trie;
+  trie.AddEntry("a", "data_a");
+  trie.AddEntry("ab", "data_ab");
+  trie.DeleteEntry("ab");
+
+  std::string value;
+  EXPECT_FALSE(trie.LookUp("ab", &value));
+  EXPECT_TRUE(trie.LookUp("a", &value));
+  EXPECT_EQ(value, "data_a");
+  EXPECT_FALSE(trie.HasSubTrie("ab"));
+}
+
 TEST(TrieTest, LongestMatch) {
   Trie<std::string> trie;
   trie.AddEntry("abc", "[ABC]");
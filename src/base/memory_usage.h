@@ -0,0 +1,129 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef MOZC_BASE_MEMORY_USAGE_H_
+#define MOZC_BASE_MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace mozc {
+
+// Memory footprint of a component.
+struct MemoryUsage {
+  // Bytes allocated on the heap and owned by the component.
+  size_t heap_bytes = 0;
+  // Bytes of read-only data the component refers to, e.g., sections of a
+  // memory-mapped or embedded data file. They are shared with other processes
+  // and are not freed with the component.
+  size_t mapped_bytes = 0;
+
+  MemoryUsage &operator+=(const MemoryUsage &other) {
+    heap_bytes += other.heap_bytes;
+    mapped_bytes += other.mapped_bytes;
+    return *this;
+  }
+};
+
+inline MemoryUsage operator+(MemoryUsage lhs, const MemoryUsage &rhs) {
+  return lhs += rhs;
+}
+
+// Returns the number of bytes |str| allocated on the heap, which is zero when
+// the contents fit in the small string buffer of the object itself.
+inline size_t GetStringHeapBytes(const std::string &str) {
+  const char *data = str.data();
+  const char *object = reinterpret_cast<const char *>(&str);
+  if (data >= object && data < object + sizeof(str)) {
+    return 0;
+  }
+  return str.capacity() + 1;
+}
+
+// Collects the memory usage of named components. Composite components report
+// their parts under a common prefix, e.g., "SystemDictionary.KeyTrie".
+//
+// Usage:
+//   MemoryUsageCollector collector;
+//   engine->CollectMemoryUsage(&collector);
+//   for (const auto &[name, usage] : collector.entries()) { ... }
+class MemoryUsageCollector {
+ public:
+  MemoryUsageCollector() = default;
+  MemoryUsageCollector(const MemoryUsageCollector &) = delete;
+  MemoryUsageCollector &operator=(const MemoryUsageCollector &) = delete;
+
+  // Records |usage| of the component |name| under the current prefix.
+  void Add(absl::string_view name, const MemoryUsage &usage) {
+    entries_.emplace_back(absl::StrCat(prefix_, name), usage);
+  }
+
+  // Returns the sum of all the recorded usages.
+  MemoryUsage Total() const {
+    MemoryUsage total;
+    for (const auto &[name, usage] : entries_) {
+      total += usage;
+    }
+    return total;
+  }
+
+  const std::vector<std::pair<std::string, MemoryUsage>> &entries() const {
+    return entries_;
+  }
+
+  // Prepends "<name>." to the names added while this object is alive.
+  class ScopedPrefix {
+   public:
+    ScopedPrefix(MemoryUsageCollector *collector, absl::string_view name)
+        : collector_(collector), prefix_size_(collector->prefix_.size()) {
+      absl::StrAppend(&collector_->prefix_, name, ".");
+    }
+    ScopedPrefix(const ScopedPrefix &) = delete;
+    ScopedPrefix &operator=(const ScopedPrefix &) = delete;
+    ~ScopedPrefix() { collector_->prefix_.resize(prefix_size_); }
+
+   private:
+    MemoryUsageCollector *collector_;
+    size_t prefix_size_;
+  };
+
+ private:
+  std::string prefix_;
+  std::vector<std::pair<std::string, MemoryUsage>> entries_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_MEMORY_USAGE_H_
@@ -0,0 +1,91 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "base/memory_usage.h"
+
+#include <string>
+#include <utility>
+
+#include "testing/gmock.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+MATCHER_P2(UsageIs, heap_bytes, mapped_bytes, "") {
+  return arg.heap_bytes == heap_bytes && arg.mapped_bytes == mapped_bytes;
+}
+
+TEST(MemoryUsageTest, Add) {
+  MemoryUsage usage = {10, 100};
+  usage += {1, 2};
+  EXPECT_EQ(usage.heap_bytes, 11);
+  EXPECT_EQ(usage.mapped_bytes, 102);
+  EXPECT_THAT(usage + MemoryUsage({1, 1}), UsageIs(12, 103));
+}
+
+TEST(MemoryUsageTest, GetStringHeapBytes) {
+  EXPECT_EQ(GetStringHeapBytes(std::string()), 0);
+  const std::string long_string(1000, 'a');
+  EXPECT_GT(GetStringHeapBytes(long_string), 1000);
+}
+
+TEST(MemoryUsageCollectorTest, CollectsEntriesWithPrefix) {
+  MemoryUsageCollector collector;
+  EXPECT_THAT(collector.Total(), UsageIs(0, 0));
+
+  collector.Add("Connector", {1, 10});
+  {
+    const MemoryUsageCollector::ScopedPrefix dictionary(&collector,
+                                                        "SystemDictionary");
+    collector.Add("KeyTrie", {2, 20});
+    {
+      const MemoryUsageCollector::ScopedPrefix nested(&collector, "Index");
+      collector.Add("Reverse", {3, 0});
+    }
+    collector.Add("ValueTrie", {4, 40});
+  }
+  collector.Add("UserDictionary", {5, 0});
+
+  EXPECT_THAT(
+      collector.entries(),
+      ElementsAre(Pair("Connector", UsageIs(1, 10)),
+                  Pair("SystemDictionary.KeyTrie", UsageIs(2, 20)),
+                  Pair("SystemDictionary.Index.Reverse", UsageIs(3, 0)),
+                  Pair("SystemDictionary.ValueTrie", UsageIs(4, 40)),
+                  Pair("UserDictionary", UsageIs(5, 0))));
+  EXPECT_THAT(collector.Total(), UsageIs(15, 70));
+}
+
+}  // namespace
+}  // namespace mozc
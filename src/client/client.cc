@@ -137,6 +137,7 @@ void Client::InitRequestForSvsJapanese(bool use_svs) {
 }
 
 void Client::SetIPCClientFactory(IPCClientFactoryInterface *client_factory) {
+  ipc_client_.reset();
   client_factory_ = client_factory;
 }
 
@@ -664,59 +665,82 @@ bool Client::Call(const commands::Input &input, commands::Output *output) {
   std::string request;
   input.SerializeToString(&request);
 
-  // Call IPC
-  std::unique_ptr<IPCClientInterface> client(client_factory_->NewClient(
-      kServerAddress, server_launcher_->server_program()));
+  // Reuse the connection of the previous call if the server has not closed it
+  // in the meantime (e.g. the server restarted). The server may still close it
+  // right before the request is sent. The request is sent again on a new
+  // connection only if it could not be written, as a request which reached
+  // the server (e.g. SEND_KEY) must not be processed twice.
+  for (int trial = 0; trial < 2; ++trial) {
+    std::unique_ptr<IPCClientInterface> client = std::move(ipc_client_);
+    if (client != nullptr && !client->IsReusable()) {
+      VLOG(1) << "The kept connection is no longer available";
+      client.reset();
+    }
+    const bool is_reused = client != nullptr;
+    if (!is_reused) {
+      client.reset(client_factory_->NewClient(
+          kServerAddress, server_launcher_->server_program()));
+
+      // set client protocol version.
+      // When an error occurs inside Connected() function,
+      // the server_protocol_version_ may be set to
+      // the default value defined in .proto file.
+      // This caused an mis-version-detection.
+      // To avoid such situation, we set the client protocol version
+      // before calling IPC request.
+      server_protocol_version_ = IPC_PROTOCOL_VERSION;
+      server_product_version_ = Version::GetMozcVersion();
+      server_process_id_ = 0;
+
+      if (client == nullptr) {
+        LOG(ERROR) << "Cannot make client object";
+        server_status_ = SERVER_FATAL;
+        return false;
+      }
 
-  // set client protocol version.
-  // When an error occurs inside Connected() function,
-  // the server_protocol_version_ may be set to
-  // the default value defined in .proto file.
-  // This caused an mis-version-detection.
-  // To avoid such situation, we set the client protocol version
-  // before calling IPC request.
-  server_protocol_version_ = IPC_PROTOCOL_VERSION;
-  server_product_version_ = Version::GetMozcVersion();
-  server_process_id_ = 0;
+      if (!client->Connected()) {
+        LOG(ERROR) << "Connection failure to " << kServerAddress;
+        // if the status is not SERVER_UNKNOWN, it means that
+        // the server WAS working as correctly.
+        if (server_status_ != SERVER_UNKNOWN) {
+          server_status_ = SERVER_SHUTDOWN;
+        }
+        return false;
+      }
 
-  if (client == nullptr) {
-    LOG(ERROR) << "Cannot make client object";
-    server_status_ = SERVER_FATAL;
-    return false;
-  }
+      server_protocol_version_ = client->GetServerProtocolVersion();
+      server_product_version_ = client->GetServerProductVersion();
+      server_process_id_ = client->GetServerProcessId();
 
-  if (!client->Connected()) {
-    LOG(ERROR) << "Connection failure to " << kServerAddress;
-    // if the status is not SERVER_UNKNOWN, it means that
-    // the server WAS working as correctly.
-    if (server_status_ != SERVER_UNKNOWN) {
-      server_status_ = SERVER_SHUTDOWN;
+      if (server_protocol_version_ != IPC_PROTOCOL_VERSION) {
+        LOG(ERROR)
+            << "Server version mismatch. skipped to update the status here";
+        return false;
+      }
     }
-    return false;
-  }
-
-  server_protocol_version_ = client->GetServerProtocolVersion();
-  server_product_version_ = client->GetServerProductVersion();
-  server_process_id_ = client->GetServerProcessId();
-
-  if (server_protocol_version_ != IPC_PROTOCOL_VERSION) {
-    LOG(ERROR) << "Server version mismatch. skipped to update the status here";
-    return false;
-  }
 
-  // Drop DebugString() as it raises segmentation fault.
-  // http://b/2126375
-  // TODO(taku): Investigate the error in detail.
-  if (!client->Call(request, &response_, timeout_)) {
+    // Drop DebugString() as it raises segmentation fault.
+    // http://b/2126375
+    // TODO(taku): Investigate the error in detail.
+    if (client->Call(request, &response_, timeout_)) {
+      if (client->IsReusable()) {
+        ipc_client_ = std::move(client);
+      }
+      break;
+    }
     LOG(ERROR) << "Call failure";
     //               << input.DebugString();
     if (client->GetLastIPCError() == IPC_TIMEOUT_ERROR) {
       server_status_ = SERVER_TIMEOUT;
-    } else {
+      return false;
+    }
+    if (!is_reused || client->GetLastIPCError() != IPC_WRITE_ERROR) {
       // server crash
       server_status_ = SERVER_SHUTDOWN;
+      return false;
     }
-    return false;
+    VLOG(1) << "Reconnecting as the request could not be sent on the kept "
+               "connection";
   }
 
   if (!output->ParseFromString(response_)) {
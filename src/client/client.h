@@ -244,6 +244,9 @@ class Client : public ClientInterface {
 
   uint64_t id_;
   IPCClientFactoryInterface *client_factory_;
+  // Connection kept open after the last successful call. Reused by the next
+  // call if the transport supports it.
+  std::unique_ptr<IPCClientInterface> ipc_client_;
   std::unique_ptr<ServerLauncherInterface> server_launcher_;
   std::unique_ptr<config::Config> preferences_;
   std::unique_ptr<commands::Request> request_;
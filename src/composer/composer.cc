@@ -57,6 +57,7 @@
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
 #include "transliteration/transliteration.h"
+#include "usage_stats/latency_stats.h"
 #include "absl/flags/flag.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -73,6 +74,8 @@ namespace {
 
 using config::CharacterFormManager;
 using strings::OneCharLen;
+using usage_stats::LatencyStats;
+using usage_stats::ScopedLatencyTimer;
 
 Transliterators::Transliterator GetTransliterator(
     transliteration::TransliterationType comp_mode) {
@@ -529,6 +532,9 @@ bool Composer::InsertCharacterKeyAndPreedit(const absl::string_view key,
 }
 
 bool Composer::InsertCharacterKeyEvent(const commands::KeyEvent &key) {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("Composer.InsertCharacterKeyEvent");
+  ScopedLatencyTimer timer(kStage);
   if (!EnableInsert()) {
     return false;
   }
@@ -891,6 +897,8 @@ void Composer::GetTypeCorrectedQueriesForPrediction(
 
 size_t Composer::GetLength() const { return composition_.GetLength(); }
 
+void Composer::FillCaches() const { composition_.FillCaches(); }
+
 size_t Composer::GetCursor() const { return position_; }
 
 void Composer::GetTransliteratedText(Transliterators::Transliterator t12r,
@@ -65,6 +65,7 @@
         '../protocol/protocol.gyp:commands_proto',
         '../protocol/protocol.gyp:config_proto',
         '../transliteration/transliteration.gyp:transliteration',
+        '../usage_stats/usage_stats_base.gyp:latency_stats',
       ],
     },
     {
@@ -135,6 +135,11 @@ class Composer final {
 
   size_t GetLength() const;
   size_t GetCursor() const;
+
+  // Fills the internal caches so that the const methods can be called from
+  // multiple threads until the composer is modified.
+  void FillCaches() const;
+
   void EditErase();
 
   // Deletes a character at specified position.
@@ -31,6 +31,7 @@
 
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
@@ -60,22 +61,36 @@ CharChunkList DeepCopyCharChunkList(const CharChunkList &chunks) {
 }  // namespace
 
 Composition::Composition(const Table *table)
-    : table_(table), input_t12r_(Transliterators::CONVERSION_STRING) {}
+    : table_(table),
+      input_t12r_(Transliterators::CONVERSION_STRING),
+      length_cache_(std::string::npos) {}
 
 Composition::Composition(const Composition &x)
     : table_(x.table_),
       chunks_(DeepCopyCharChunkList(x.chunks_)),
-      input_t12r_(x.input_t12r_) {}
+      input_t12r_(x.input_t12r_),
+      length_cache_(std::string::npos) {}
 
 Composition &Composition::operator=(const Composition &x) {
   Erase();
   table_ = x.table_;
   chunks_ = DeepCopyCharChunkList(x.chunks_);
   input_t12r_ = x.input_t12r_;
+  InvalidateCache();
   return *this;
 }
 
-void Composition::Erase() { chunks_.clear(); }
+void Composition::Erase() {
+  chunks_.clear();
+  InvalidateCache();
+}
+
+void Composition::InvalidateCache() {
+  length_cache_ = std::string::npos;
+  for (std::optional<std::string> &cache : string_cache_) {
+    cache.reset();
+  }
+}
 
 size_t Composition::InsertAt(size_t pos, const absl::string_view input) {
   CompositionInput composition_input;
@@ -116,6 +131,7 @@ size_t Composition::InsertInput(size_t pos, const CompositionInput &input) {
     left_chunk = InsertChunk(right_chunk);
     mutable_input.set_is_new_input(false);
   }
+  InvalidateCache();
 
   return GetPosition(Transliterators::LOCAL, right_chunk);
 }
@@ -142,11 +158,13 @@ size_t Composition::DeleteAt(const size_t position) {
     // the result of GetLength is 0.
     if ((*chunk_it)->GetLength(Transliterators::LOCAL) <= 1) {
       chunks_.erase(chunk_it);
+      InvalidateCache();
       continue;
     }
 
     std::unique_ptr<CharChunk> left_deleted_chunk =
         (*chunk_it)->SplitChunk(Transliterators::LOCAL, 1);
+    InvalidateCache();
   }
   return new_position;
 }
@@ -248,7 +266,29 @@ Transliterators::Transliterator Composition::GetTransliterator(
 }
 
 size_t Composition::GetLength() const {
-  return GetPosition(Transliterators::LOCAL, chunks_.end());
+  if (length_cache_ == std::string::npos) {
+    length_cache_ = GetPosition(Transliterators::LOCAL, chunks_.end());
+  }
+  return length_cache_;
+}
+
+void Composition::FillCaches() const {
+  // GetLength() also fills the local length cache of each chunk.
+  GetLength();
+  for (const TrimMode trim_mode : {TRIM, ASIS, FIX}) {
+    GetCachedString(trim_mode);
+  }
+}
+
+const std::string &Composition::GetCachedString(TrimMode trim_mode) const {
+  DCHECK_GE(trim_mode, TRIM);
+  DCHECK_LE(trim_mode, FIX);
+  std::optional<std::string> &cache = string_cache_[trim_mode];
+  if (!cache.has_value()) {
+    cache.emplace();
+    GetStringWithModes(Transliterators::LOCAL, trim_mode, &cache.value());
+  }
+  return cache.value();
 }
 
 void Composition::GetStringWithModes(
@@ -311,16 +351,7 @@ void Composition::GetExpandedStringsWithTransliterator(
 }
 
 void Composition::GetString(std::string *composition) const {
-  composition->clear();
-  if (chunks_.empty()) {
-    VLOG(1) << "The composition size is zero.";
-    return;
-  }
-
-  for (CharChunkList::const_iterator it = chunks_.begin(); it != chunks_.end();
-       ++it) {
-    (*it)->AppendResult(Transliterators::LOCAL, composition);
-  }
+  *composition = GetCachedString(ASIS);
 }
 
 void Composition::GetStringWithTransliterator(
@@ -330,24 +361,35 @@ void Composition::GetStringWithTransliterator(
 
 void Composition::GetStringWithTrimMode(const TrimMode trim_mode,
                                         std::string *output) const {
-  GetStringWithModes(Transliterators::LOCAL, trim_mode, output);
+  if (trim_mode < TRIM || trim_mode > FIX) {
+    GetStringWithModes(Transliterators::LOCAL, trim_mode, output);
+    return;
+  }
+  *output = GetCachedString(trim_mode);
 }
 
 void Composition::GetPreedit(size_t position, std::string *left,
                              std::string *focused, std::string *right) const {
-  std::string composition;
-  GetString(&composition);
+  const absl::string_view composition = GetCachedString(ASIS);
   Util::Utf8SubString(composition, 0, position, left);
   Util::Utf8SubString(composition, position, 1, focused);
   Util::Utf8SubString(composition, position + 1, std::string::npos, right);
 }
 
-// This function is essentialy a const function, but it cannot be const because
-// it outputs a mutable CharChunkList::iterator.  Const version is provided
-// below.
 CharChunkList::iterator Composition::GetChunkAt(
     const size_t position, Transliterators::Transliterator transliterator,
     size_t *inner_position) {
+  const CharChunkList::const_iterator it =
+      std::as_const(*this).GetChunkAt(position, transliterator, inner_position);
+  // The returned chunk may be modified by the caller.
+  InvalidateCache();
+  // Erasing an empty range converts the const_iterator to an iterator.
+  return chunks_.erase(it, it);
+}
+
+CharChunkList::const_iterator Composition::GetChunkAt(
+    size_t position, Transliterators::Transliterator transliterator,
+    size_t *inner_position) const {
   if (chunks_.empty()) {
     *inner_position = 0;
     return chunks_.begin();
@@ -370,14 +412,6 @@ CharChunkList::iterator Composition::GetChunkAt(
   return it;
 }
 
-CharChunkList::const_iterator Composition::GetChunkAt(
-    size_t position, Transliterators::Transliterator transliterator,
-    size_t *inner_position) const {
-  // This const_cast is safe as GetChunkAt() above doesn't mutate any members.
-  return const_cast<Composition *>(this)->GetChunkAt(position, transliterator,
-                                                     inner_position);
-}
-
 size_t Composition::GetPosition(Transliterators::Transliterator transliterator,
                                 CharChunkList::const_iterator cur_it) const {
   size_t position = 0;
@@ -406,6 +440,7 @@ CharChunkList::iterator Composition::MaybeSplitChunkAt(const size_t position) {
   std::unique_ptr<CharChunk> left_chunk =
       chunk->SplitChunk(Transliterators::LOCAL, inner_position);
   chunks_.insert(it, std::move(left_chunk));
+  InvalidateCache();
   return it;
 }
 
@@ -425,12 +460,14 @@ void Composition::CombinePendingChunks(CharChunkList::iterator it,
 
     (*it)->Combine(**left_it);
     chunks_.erase(left_it);
+    InvalidateCache();
   }
 }
 
 // Insert a chunk to the prev of it.
 CharChunkList::iterator Composition::InsertChunk(
     CharChunkList::const_iterator it) {
+  InvalidateCache();
   return chunks_.insert(it, std::make_unique<CharChunk>(input_t12r_, table_));
 }
 
@@ -454,6 +491,7 @@ CharChunkList::iterator Composition::GetInsertionChunk(
 
   const CharChunkList::iterator left_it = std::prev(it);
   if ((*left_it)->IsAppendable(input_t12r_, table_)) {
+    InvalidateCache();
     return left_it;
   }
   return InsertChunk(it);
@@ -463,7 +501,10 @@ void Composition::SetInputMode(Transliterators::Transliterator transliterator) {
   input_t12r_ = transliterator;
 }
 
-void Composition::SetTable(const Table *table) { table_ = table; }
+void Composition::SetTable(const Table *table) {
+  table_ = table;
+  InvalidateCache();
+}
 
 bool Composition::IsToggleable(size_t position) const {
   size_t inner_position = 0;
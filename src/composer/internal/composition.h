@@ -32,6 +32,7 @@
 
 #include <list>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -122,6 +123,10 @@ class Composition final {
 
   size_t GetLength() const;
   void GetString(std::string *composition) const;
+  // Fills the caches of GetLength() and GetStringWithTrimMode(). The const
+  // methods do not update any cache afterwards, so they can be called from
+  // multiple threads until the composition is modified.
+  void FillCaches() const;
   void GetStringWithTransliterator(
       Transliterators::Transliterator transliterator,
       std::string *output) const;
@@ -146,6 +151,10 @@ class Composition final {
 
   // Following methods are declared as public for unit test.
 
+  // Note, the methods below returning a mutable iterator clear the cached
+  // strings. Chunks should be modified through the iterator before the const
+  // getters like GetString() are called again.
+
   // Return the focused CharChunk iterator at the `position`,
   // and fill `inner_position` as the position inside the returned CharChunk.
   // ["a", "bc", "e"].GetChunkAt(2) returns "bc" and fills inner_position to 1,
@@ -203,9 +212,21 @@ class Composition final {
   void GetStringWithModes(Transliterators::Transliterator transliterator,
                           TrimMode trim_mode, std::string *composition) const;
 
+  // Returns the string of the LOCAL transliterator, building it only when the
+  // cache is cleared.
+  const std::string &GetCachedString(TrimMode trim_mode) const;
+
+  // Clears the caches below. Must be called on every modification of chunks_.
+  void InvalidateCache();
+
   const Table *table_;
   CharChunkList chunks_;
   Transliterators::Transliterator input_t12r_;
+
+  // Caches of GetLength() and GetStringWithTrimMode() for the LOCAL
+  // transliterator, as they are called several times per key event.
+  mutable size_t length_cache_;
+  mutable std::optional<std::string> string_cache_[FIX + 1];  // By TrimMode.
 };
 
 }  // namespace composer
@@ -37,6 +37,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/thread2.h"
 #include "composer/internal/char_chunk.h"
 #include "composer/internal/composition_input.h"
 #include "composer/internal/transliterators.h"
@@ -1859,5 +1860,78 @@ TEST_F(CompositionTest, IsToggleable) {
   EXPECT_FALSE(composition_->IsToggleable(0));
 }
 
+TEST_F(CompositionTest, CachedStringsAreUpdatedOnEdit) {
+  table_->AddRule("ka", "か", "");
+  table_->AddRule("n", "ん", "");
+  table_->AddRule("na", "な", "");
+
+  size_t pos = composition_->InsertAt(0, "k");
+  pos = composition_->InsertAt(pos, "a");
+  pos = composition_->InsertAt(pos, "n");
+  EXPECT_EQ(GetString(*composition_), "かn");
+  EXPECT_EQ(composition_->GetLength(), 2);
+  std::string output;
+  composition_->GetStringWithTrimMode(TRIM, &output);
+  EXPECT_EQ(output, "か");
+  composition_->GetStringWithTrimMode(FIX, &output);
+  EXPECT_EQ(output, "かん");
+
+  pos = composition_->InsertAt(pos, "a");
+  EXPECT_EQ(GetString(*composition_), "かな");
+  composition_->GetStringWithTrimMode(TRIM, &output);
+  EXPECT_EQ(output, "かな");
+
+  std::string left, focused, right;
+  composition_->GetPreedit(1, &left, &focused, &right);
+  EXPECT_EQ(left, "か");
+  EXPECT_EQ(focused, "な");
+  EXPECT_EQ(right, "");
+
+  composition_->DeleteAt(0);
+  EXPECT_EQ(GetString(*composition_), "な");
+  EXPECT_EQ(composition_->GetLength(), 1);
+
+  composition_->SetTransliterator(0, composition_->GetLength(),
+                                  Transliterators::HALF_ASCII);
+  EXPECT_EQ(GetString(*composition_), "na");
+  EXPECT_EQ(composition_->GetLength(), 2);
+
+  // The copy doesn't share the cache with the original.
+  Composition copy(*composition_);
+  composition_->Erase();
+  EXPECT_EQ(GetString(*composition_), "");
+  EXPECT_EQ(composition_->GetLength(), 0);
+  EXPECT_EQ(GetString(copy), "na");
+}
+
+TEST_F(CompositionTest, ConcurrentReadsAfterFillCaches) {
+  table_->AddRule("ka", "か", "");
+  table_->AddRule("n", "ん", "");
+  table_->AddRule("na", "な", "");
+
+  size_t pos = composition_->InsertAt(0, "k");
+  pos = composition_->InsertAt(pos, "a");
+  composition_->InsertAt(pos, "n");
+  composition_->FillCaches();
+
+  const Composition &composition = *composition_;
+  std::vector<Thread2> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.push_back(Thread2([&composition] {
+      for (int j = 0; j < 100; ++j) {
+        std::string output;
+        composition.GetStringWithTrimMode(TRIM, &output);
+        EXPECT_EQ(output, "か");
+        composition.GetStringWithTrimMode(FIX, &output);
+        EXPECT_EQ(output, "かん");
+        EXPECT_EQ(composition.GetLength(), 2);
+      }
+    }));
+  }
+  for (Thread2 &thread : threads) {
+    thread.Join();
+  }
+}
+
 }  // namespace composer
 }  // namespace mozc
@@ -43,6 +43,7 @@
 #include <vector>
 
 #include "base/config_file_stream.h"
+#include "base/container/flat_trie.h"
 #include "base/hash.h"
 #include "base/logging.h"
 #include "base/util.h"
@@ -380,6 +381,7 @@ const Entry *Table::AddRuleWithAttributes(
   if (entries_.LookUp(input, &old_entry)) {
     DeleteEntry(old_entry);
   }
+  flat_entries_.reset();
 
   Entry *entry = new Entry(input, output, pending, attributes);
   entries_.AddEntry(input, entry);
@@ -414,6 +416,7 @@ void Table::DeleteRule(const absl::string_view input) {
     DeleteEntry(old_entry);
   }
   entries_.DeleteEntry(input);
+  flat_entries_.reset();
 }
 
 bool Table::LoadFromString(const std::string &str) {
@@ -483,17 +486,29 @@ bool Table::LoadFromStream(std::istream *is) {
     }
   }
 
+  BuildFlatEntries();
   return true;
 }
 
+void Table::BuildFlatEntries() {
+  std::vector<std::pair<std::string, const Entry *>> entries;
+  entries.reserve(entry_set_.size());
+  for (const Entry *entry : entry_set_) {
+    entries.emplace_back(entry->input(), entry);
+  }
+  flat_entries_ =
+      std::make_unique<FlatTrie<const Entry *>>(std::move(entries));
+}
+
 const Entry *Table::LookUp(const absl::string_view input) const {
   const Entry *entry = nullptr;
   if (case_sensitive_) {
-    entries_.LookUp(input, &entry);
+    VisitEntries([&](const auto &trie) { trie.LookUp(input, &entry); });
   } else {
     std::string normalized_input(input);
     Util::LowerString(&normalized_input);
-    entries_.LookUp(normalized_input, &entry);
+    VisitEntries(
+        [&](const auto &trie) { trie.LookUp(normalized_input, &entry); });
   }
   return entry;
 }
@@ -502,11 +517,15 @@ const Entry *Table::LookUpPrefix(const absl::string_view input,
                                  size_t *key_length, bool *fixed) const {
   const Entry *entry = nullptr;
   if (case_sensitive_) {
-    entries_.LookUpPrefix(input, &entry, key_length, fixed);
+    VisitEntries([&](const auto &trie) {
+      trie.LookUpPrefix(input, &entry, key_length, fixed);
+    });
   } else {
     std::string normalized_input(input);
     Util::LowerString(&normalized_input);
-    entries_.LookUpPrefix(normalized_input, &entry, key_length, fixed);
+    VisitEntries([&](const auto &trie) {
+      trie.LookUpPrefix(normalized_input, &entry, key_length, fixed);
+    });
   }
   return entry;
 }
@@ -514,11 +533,14 @@ const Entry *Table::LookUpPrefix(const absl::string_view input,
 void Table::LookUpPredictiveAll(const absl::string_view input,
                                 std::vector<const Entry *> *results) const {
   if (case_sensitive_) {
-    entries_.LookUpPredictiveAll(input, results);
+    VisitEntries(
+        [&](const auto &trie) { trie.LookUpPredictiveAll(input, results); });
   } else {
     std::string normalized_input(input);
     Util::LowerString(&normalized_input);
-    entries_.LookUpPredictiveAll(normalized_input, results);
+    VisitEntries([&](const auto &trie) {
+      trie.LookUpPredictiveAll(normalized_input, results);
+    });
   }
 }
 
@@ -540,11 +562,13 @@ bool Table::HasNewChunkEntry(const absl::string_view input) const {
 
 bool Table::HasSubRules(const absl::string_view input) const {
   if (case_sensitive_) {
-    return entries_.HasSubTrie(input);
+    return VisitEntries(
+        [&](const auto &trie) { return trie.HasSubTrie(input); });
   } else {
     std::string normalized_input(input);
     Util::LowerString(&normalized_input);
-    return entries_.HasSubTrie(normalized_input);
+    return VisitEntries(
+        [&](const auto &trie) { return trie.HasSubTrie(normalized_input); });
   }
 }
 
@@ -41,6 +41,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/container/flat_trie.h"
 #include "base/container/trie.h"
 #include "composer/internal/special_key.h"
 #include "composer/internal/typing_model.h"
@@ -152,8 +153,21 @@ class Table final {
   bool LoadFromStream(std::istream *is);
   void DeleteEntry(const Entry *entry);
 
+  // Builds |flat_entries_| from the current rules.
+  void BuildFlatEntries();
+
+  // Calls |func| with the trie to look up, i.e., |flat_entries_| if it is
+  // up to date and |entries_| otherwise.
+  template <typename Func>
+  decltype(auto) VisitEntries(Func func) const {
+    return flat_entries_ != nullptr ? func(*flat_entries_) : func(entries_);
+  }
+
   using EntryTrie = Trie<const Entry *>;
   EntryTrie entries_;
+  // Contiguous copy of |entries_| for fast lookups, built when a table file
+  // is loaded. Modifying the rules resets it until the next load.
+  std::unique_ptr<const FlatTrie<const Entry *>> flat_entries_;
   using EntrySet = absl::flat_hash_set<const Entry *>;
   EntrySet entry_set_;
 
@@ -849,6 +849,37 @@ TEST_F(TableTest, AddRuleWithAttributes) {
   EXPECT_EQ(entry->attributes(), (NEW_CHUNK | NO_TRANSLITERATION));
 }
 
+TEST_F(TableTest, AddRuleAfterLoad) {
+  Table table;
+  table.LoadFromString("ka\tか\nk\tっ\tk\n");
+  size_t key_length = 0;
+  bool fixed = false;
+  const Entry *entry = table.LookUpPrefix("kak", &key_length, &fixed);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->result(), "か");
+  EXPECT_EQ(key_length, 2);
+  EXPECT_TRUE(fixed);
+
+  // Rules added after the load are visible to the lookups.
+  table.AddRule("kak", "カク", "");
+  entry = table.LookUpPrefix("kak", &key_length, &fixed);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->result(), "カク");
+  EXPECT_EQ(key_length, 3);
+  EXPECT_TRUE(table.HasSubRules("kak"));
+
+  table.DeleteRule("kak");
+  EXPECT_EQ(table.LookUp("kak"), nullptr);
+  EXPECT_FALSE(table.HasSubRules("kak"));
+  EXPECT_NE(table.LookUp("ka"), nullptr);
+
+  // Loading more rules keeps the existing ones.
+  table.LoadFromString("sa\tさ\n");
+  ASSERT_NE(table.LookUp("ka"), nullptr);
+  ASSERT_NE(table.LookUp("sa"), nullptr);
+  EXPECT_EQ(table.LookUp("sa")->result(), "さ");
+}
+
 TEST_F(TableTest, LoadFromString) {
   const std::string kRule =
       "# This is a comment\n"
@@ -30,6 +30,7 @@
 #include "converter/connector.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -39,20 +40,28 @@
 #include "base/logging.h"
 #include "base/util.h"
 #include "data_manager/data_manager_interface.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 
 namespace mozc {
 namespace {
 
+using ::mozc::storage::louds::BitVectorIndexType;
+
 constexpr uint32_t kInvalidCacheKey = 0xFFFFFFFF;
 constexpr uint16_t kConnectorMagicNumber = 0xCDAB;
 constexpr uint8_t kInvalid1ByteCostValue = 255;
 
+// Stored in the dense matrix for costs that don't fit in int16_t. Costs are
+// never negative, so lookups of this value fall back to the compressed rows.
+constexpr int16_t kDenseFallbackCost = -1;
+
 inline uint32_t GetHashValue(uint16_t rid, uint16_t lid, uint32_t hash_mask) {
   return (3 * static_cast<uint32_t>(rid) + lid) & hash_mask;
   // Note: The above value is equivalent to
@@ -137,24 +146,34 @@ absl::StatusOr<Metadata> ParseMetadata(const char *connection_data,
 
 void Connector::Row::Init(const uint8_t *chunk_bits, size_t chunk_bits_size,
                           const uint8_t *compact_bits, size_t compact_bits_size,
-                          const uint8_t *values, bool use_1byte_value) {
-  chunk_bits_index_.Init(chunk_bits, chunk_bits_size);
-  compact_bits_index_.Init(compact_bits, compact_bits_size);
+                          const uint8_t *values, bool use_1byte_value,
+                          BitVectorIndexType index_type) {
+  use_rank_select_index_ = index_type == BitVectorIndexType::kRankSelect;
+  if (use_rank_select_index_) {
+    chunk_bits_rs_index_.Init(chunk_bits, chunk_bits_size);
+    compact_bits_rs_index_.Init(compact_bits, compact_bits_size);
+  } else {
+    chunk_bits_index_.Init(chunk_bits, chunk_bits_size);
+    compact_bits_index_.Init(compact_bits, compact_bits_size);
+  }
   values_ = values;
   use_1byte_value_ = use_1byte_value;
 }
 
 bool Connector::Row::GetValue(uint16_t index, uint16_t *value) const {
   int chunk_bit_position = index / 8;
-  if (!chunk_bits_index_.Get(chunk_bit_position)) {
+  if (!GetBit(chunk_bits_index_, chunk_bits_rs_index_, chunk_bit_position)) {
     return false;
   }
   int compact_bit_position =
-      chunk_bits_index_.Rank1(chunk_bit_position) * 8 + index % 8;
-  if (!compact_bits_index_.Get(compact_bit_position)) {
+      Rank1(chunk_bits_index_, chunk_bits_rs_index_, chunk_bit_position) * 8 +
+      index % 8;
+  if (!GetBit(compact_bits_index_, compact_bits_rs_index_,
+              compact_bit_position)) {
     return false;
   }
-  int value_position = compact_bits_index_.Rank1(compact_bit_position);
+  int value_position =
+      Rank1(compact_bits_index_, compact_bits_rs_index_, compact_bit_position);
   if (use_1byte_value_) {
     *value = values_[value_position];
     if (*value == kInvalid1ByteCostValue) {
@@ -169,6 +188,18 @@ bool Connector::Row::GetValue(uint16_t index, uint16_t *value) const {
 
 absl::StatusOr<std::unique_ptr<Connector>> Connector::CreateFromDataManager(
     const DataManagerInterface &data_manager) {
+  return CreateFromDataManager(data_manager, BitVectorIndexType::kSimple);
+}
+
+absl::StatusOr<std::unique_ptr<Connector>> Connector::CreateFromDataManager(
+    const DataManagerInterface &data_manager, BitVectorIndexType index_type) {
+  Options options;
+  options.index_type = index_type;
+  return CreateFromDataManager(data_manager, options);
+}
+
+absl::StatusOr<std::unique_ptr<Connector>> Connector::CreateFromDataManager(
+    const DataManagerInterface &data_manager, const Options &options) {
 #ifdef __ANDROID__
   constexpr int kCacheSize = 256;
 #else   // __ANDROID__
@@ -177,13 +208,29 @@ absl::StatusOr<std::unique_ptr<Connector>> Connector::CreateFromDataManager(
   const char *connection_data = nullptr;
   size_t connection_data_size = 0;
   data_manager.GetConnectorData(&connection_data, &connection_data_size);
-  return Create(connection_data, connection_data_size, kCacheSize);
+  return Create(connection_data, connection_data_size, kCacheSize, options);
 }
 
 absl::StatusOr<std::unique_ptr<Connector>> Connector::Create(
     const char *connection_data, size_t connection_size, int cache_size) {
+  return Create(connection_data, connection_size, cache_size,
+                BitVectorIndexType::kSimple);
+}
+
+absl::StatusOr<std::unique_ptr<Connector>> Connector::Create(
+    const char *connection_data, size_t connection_size, int cache_size,
+    BitVectorIndexType index_type) {
+  Options options;
+  options.index_type = index_type;
+  return Create(connection_data, connection_size, cache_size, options);
+}
+
+absl::StatusOr<std::unique_ptr<Connector>> Connector::Create(
+    const char *connection_data, size_t connection_size, int cache_size,
+    const Options &options) {
   auto connector = std::make_unique<Connector>();
-  auto status = connector->Init(connection_data, connection_size, cache_size);
+  auto status =
+      connector->Init(connection_data, connection_size, cache_size, options);
   if (!status.ok()) {
     return status;
   }
@@ -191,7 +238,8 @@ absl::StatusOr<std::unique_ptr<Connector>> Connector::Create(
 }
 
 absl::Status Connector::Init(const char *connection_data,
-                             size_t connection_size, int cache_size) {
+                             size_t connection_size, int cache_size,
+                             const Options &options) {
   // Check if the cache_size is the power of 2.
   if ((cache_size & (cache_size - 1)) != 0) {
     return absl::InvalidArgumentError(absl::StrCat(
@@ -208,6 +256,7 @@ absl::Status Connector::Init(const char *connection_data,
     return std::move(metadata).status();
   }
   resolution_ = metadata->resolution;
+  matrix_size_ = metadata->lsize;
 
   // Set the read location to the metadata end.
   auto *ptr = connection_data + Metadata::kByteSize;
@@ -259,6 +308,8 @@ absl::Status Connector::Init(const char *connection_data,
   const size_t chunk_bits_size = metadata->ChunkBitsSize();
   const uint16_t rsize = metadata->rsize;
   rows_ = std::make_unique<Row[]>(rsize);
+  num_rows_ = rsize;
+  connection_size_ = connection_size;
   for (size_t i = 0; i < rsize; ++i) {
     // Each row is formatted as follows:
     // +-------------------+-------------+------------+------------+-----------+
@@ -293,10 +344,27 @@ absl::Status Connector::Init(const char *connection_data,
     ptr += values_size;
 
     rows_[i].Init(chunk_bits, chunk_bits_size, compact_bits, compact_bits_size,
-                  values, metadata->Use1ByteValue());
+                  values, metadata->Use1ByteValue(), options.index_type);
   }
   VALIDATE_SIZE(ptr, 0, "Data end");
   ClearCache();
+
+  matrix_mode_ = options.matrix_mode;
+  if (options.matrix_mode != MatrixMode::kCompressed) {
+    // Default-initialized so that the pages of lazily decoded rows are not
+    // committed until they are written.
+    dense_matrix_.reset(
+        new int16_t[static_cast<size_t>(rsize) * metadata->lsize]);
+    num_dense_rows_ = 0;
+    if (options.matrix_mode == MatrixMode::kDenseEager) {
+      // All the rows are decoded here, so lookups skip the once flags.
+      for (size_t i = 0; i < rsize; ++i) {
+        DecodeDenseRow(i);
+      }
+    } else {
+      dense_row_once_ = std::make_unique<absl::once_flag[]>(rsize);
+    }
+  }
   return absl::Status();
 
 #undef VALIDATE_ALIGNMENT
@@ -305,6 +373,10 @@ absl::Status Connector::Init(const char *connection_data,
 
 
 int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
+  if (dense_matrix_ != nullptr) {
+    const int16_t cost = GetDenseRow(rid)[lid];
+    return cost == kDenseFallbackCost ? LookupCost(rid, lid) : cost;
+  }
   const uint32_t index = EncodeKey(rid, lid);
   const uint32_t bucket = GetHashValue(rid, lid, cache_hash_mask_);
   if (cache_key_[bucket] == index) {
@@ -316,8 +388,49 @@ int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
   return value;
 }
 
+void Connector::GetTransitionCosts(uint16_t rid,
+                                   absl::Span<const uint16_t> lids,
+                                   absl::Span<int> costs) const {
+  DCHECK_GE(costs.size(), lids.size());
+  if (dense_matrix_ != nullptr) {
+    const int16_t *row = GetDenseRow(rid);
+    for (size_t i = 0; i < lids.size(); ++i) {
+      costs[i] = row[lids[i]];
+    }
+    for (size_t i = 0; i < lids.size(); ++i) {
+      if (costs[i] == kDenseFallbackCost) {
+        costs[i] = LookupCost(rid, lids[i]);
+      }
+    }
+    return;
+  }
+  for (size_t i = 0; i < lids.size(); ++i) {
+    costs[i] = GetTransitionCost(rid, lids[i]);
+  }
+}
+
 int Connector::GetResolution() const { return resolution_; }
 
+size_t Connector::GetDenseMatrixByteSize() const {
+  return static_cast<size_t>(num_dense_rows_.load(std::memory_order_relaxed)) *
+         matrix_size_ * sizeof(int16_t);
+}
+
+MemoryUsage Connector::GetMemoryUsage() const {
+  MemoryUsage usage;
+  usage.heap_bytes = sizeof(Row) * num_rows_;
+  for (size_t i = 0; i < num_rows_; ++i) {
+    usage.heap_bytes += rows_[i].GetIndexByteSize();
+  }
+  usage.heap_bytes += GetDenseMatrixByteSize();
+  if (dense_row_once_ != nullptr) {
+    usage.heap_bytes += sizeof(absl::once_flag) * num_rows_;
+  }
+  usage.heap_bytes += (sizeof(uint32_t) + sizeof(int)) * cache_size_;
+  usage.mapped_bytes = connection_size_;
+  return usage;
+}
+
 void Connector::ClearCache() {
   std::fill(cache_key_.get(), cache_key_.get() + cache_size_, kInvalidCacheKey);
 }
@@ -330,4 +443,23 @@ int Connector::LookupCost(uint16_t rid, uint16_t lid) const {
   return value * resolution_;
 }
 
+const int16_t *Connector::GetDenseRow(uint16_t rid) const {
+  if (dense_row_once_ != nullptr) {
+    absl::call_once(dense_row_once_[rid], &Connector::DecodeDenseRow, this,
+                    rid);
+  }
+  return dense_matrix_.get() + static_cast<size_t>(rid) * matrix_size_;
+}
+
+void Connector::DecodeDenseRow(uint16_t rid) const {
+  int16_t *row = dense_matrix_.get() + static_cast<size_t>(rid) * matrix_size_;
+  for (size_t lid = 0; lid < matrix_size_; ++lid) {
+    const int cost = LookupCost(rid, lid);
+    row[lid] = cost <= std::numeric_limits<int16_t>::max()
+                   ? static_cast<int16_t>(cost)
+                   : kDenseFallbackCost;
+  }
+  num_dense_rows_.fetch_add(1, std::memory_order_relaxed);
+}
+
 }  // namespace mozc
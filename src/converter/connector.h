@@ -30,14 +30,19 @@
 #ifndef MOZC_CONVERTER_CONNECTOR_H_
 #define MOZC_CONVERTER_CONNECTOR_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 
+#include "base/memory_usage.h"
 #include "data_manager/data_manager_interface.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
+#include "absl/base/call_once.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 
@@ -45,33 +50,104 @@ class Connector final {
  public:
   static constexpr int16_t kInvalidCost = 30000;
 
+  // How the connection matrix is held in memory.
+  enum class MatrixMode {
+    // Looks up the compressed rows of the connection data on every cache
+    // miss. This is the smallest in memory.
+    kCompressed,
+    // Decodes each row into a dense int16 array on its first lookup. Pages of
+    // the dense matrix are committed only for the rows actually used.
+    kDenseLazy,
+    // Decodes the whole matrix into a dense int16 array at creation.
+    kDenseEager,
+  };
+
+  struct Options {
+    // Bit vector index used to decode the compressed rows.
+    storage::louds::BitVectorIndexType index_type =
+        storage::louds::BitVectorIndexType::kSimple;
+    MatrixMode matrix_mode = MatrixMode::kCompressed;
+  };
+
   static absl::StatusOr<std::unique_ptr<Connector>> CreateFromDataManager(
       const DataManagerInterface &data_manager);
 
+  // Same as above but also selects the bit vector index used to decode the
+  // compressed rows.
+  static absl::StatusOr<std::unique_ptr<Connector>> CreateFromDataManager(
+      const DataManagerInterface &data_manager,
+      storage::louds::BitVectorIndexType index_type);
+
+  static absl::StatusOr<std::unique_ptr<Connector>> CreateFromDataManager(
+      const DataManagerInterface &data_manager, const Options &options);
+
   static absl::StatusOr<std::unique_ptr<Connector>> Create(
       const char *connection_data, size_t connection_size, int cache_size);
 
+  static absl::StatusOr<std::unique_ptr<Connector>> Create(
+      const char *connection_data, size_t connection_size, int cache_size,
+      storage::louds::BitVectorIndexType index_type);
+
+  static absl::StatusOr<std::unique_ptr<Connector>> Create(
+      const char *connection_data, size_t connection_size, int cache_size,
+      const Options &options);
+
   Connector() = default;
 
   Connector(const Connector &) = delete;
   Connector &operator=(const Connector &) = delete;
 
   int GetTransitionCost(uint16_t rid, uint16_t lid) const;
+
+  // Row-oriented batch version of GetTransitionCost(). Stores the cost of
+  // (rid, lids[i]) into costs[i] for every i. |costs| must be at least as
+  // large as |lids|.
+  void GetTransitionCosts(uint16_t rid, absl::Span<const uint16_t> lids,
+                          absl::Span<int> costs) const;
+
   int GetResolution() const;
 
+  MatrixMode matrix_mode() const { return matrix_mode_; }
+
+  // Returns the number of the left IDs, i.e., the number of columns.
+  uint16_t GetMatrixSize() const { return matrix_size_; }
+
+  // Returns the number of bytes of the dense matrix decoded so far. Always 0
+  // for MatrixMode::kCompressed.
+  size_t GetDenseMatrixByteSize() const;
+
+  // Returns the memory used by the row indices, the dense matrix, and the
+  // cache. The connection data counts as mapped bytes.
+  MemoryUsage GetMemoryUsage() const;
+
   void ClearCache();
 
  private:
   class Row;
 
   absl::Status Init(const char *connection_data, size_t connection_size,
-                    int cache_size);
+                    int cache_size, const Options &options);
 
   int LookupCost(uint16_t rid, uint16_t lid) const;
 
+  // Returns the dense row for |rid|, decoding it on the first call.
+  const int16_t *GetDenseRow(uint16_t rid) const;
+  void DecodeDenseRow(uint16_t rid) const;
+
   std::unique_ptr<Row[]> rows_;
+  uint16_t num_rows_ = 0;
+  size_t connection_size_ = 0;
   const uint16_t *default_cost_ = nullptr;
   int resolution_ = 0;
+  uint16_t matrix_size_ = 0;
+  MatrixMode matrix_mode_ = MatrixMode::kCompressed;
+  // Dense matrix in row-major order (rid * matrix_size_ + lid). Null for
+  // MatrixMode::kCompressed. For MatrixMode::kDenseLazy, rows are decoded
+  // exactly once under |dense_row_once_|, which is null for
+  // MatrixMode::kDenseEager.
+  std::unique_ptr<int16_t[]> dense_matrix_;
+  std::unique_ptr<absl::once_flag[]> dense_row_once_;
+  mutable std::atomic<int> num_dense_rows_{0};
   int cache_size_ = 0;
   uint32_t cache_hash_mask_ = 0;
   mutable std::unique_ptr<uint32_t[]> cache_key_;
@@ -89,16 +165,39 @@ class Connector::Row final {
 
   void Init(const uint8_t *chunk_bits, size_t chunk_bits_size,
             const uint8_t *compact_bits, size_t compact_bits_size,
-            const uint8_t *values, bool use_1byte_value);
+            const uint8_t *values, bool use_1byte_value,
+            storage::louds::BitVectorIndexType index_type);
   // Returns true if the value is found in the row and then store the found
   // value into |value|. Otherwise returns false.
   bool GetValue(uint16_t index, uint16_t *value) const;
 
+  size_t GetIndexByteSize() const {
+    return chunk_bits_index_.GetIndexByteSize() +
+           compact_bits_index_.GetIndexByteSize() +
+           chunk_bits_rs_index_.GetIndexByteSize() +
+           compact_bits_rs_index_.GetIndexByteSize();
+  }
+
  private:
+  int GetBit(const storage::louds::SimpleSuccinctBitVectorIndex &index,
+             const storage::louds::RankSelectBitVectorIndex &rs_index,
+             int n) const {
+    return use_rank_select_index_ ? rs_index.Get(n) : index.Get(n);
+  }
+  int Rank1(const storage::louds::SimpleSuccinctBitVectorIndex &index,
+            const storage::louds::RankSelectBitVectorIndex &rs_index,
+            int n) const {
+    return use_rank_select_index_ ? rs_index.Rank1(n) : index.Rank1(n);
+  }
+
   storage::louds::SimpleSuccinctBitVectorIndex chunk_bits_index_;
   storage::louds::SimpleSuccinctBitVectorIndex compact_bits_index_;
+  // Used instead of the above two when initialized with kRankSelect.
+  storage::louds::RankSelectBitVectorIndex chunk_bits_rs_index_;
+  storage::louds::RankSelectBitVectorIndex compact_bits_rs_index_;
   const uint8_t *values_ = nullptr;
   bool use_1byte_value_ = false;
+  bool use_rank_select_index_ = false;
 };
 
 }  // namespace mozc
@@ -0,0 +1,137 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for the transition cost lookups of Connector built from the OSS
+// data set in each Connector::MatrixMode.
+//
+// Usage:
+//   bazel run -c opt //converter:connector_benchmark
+// To run a subset, append e.g. "-- --benchmark_filter=GetTransitionCosts".
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "base/init_mozc.h"
+#include "base/logging.h"
+#include "base/status.h"
+#include "converter/connector.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+
+namespace mozc {
+namespace {
+
+constexpr size_t kNumLookups = 1 << 16;
+// The number of the right nodes folded into columns at a lattice position.
+constexpr size_t kNumColumns = 64;
+
+std::unique_ptr<Connector> CreateConnector(int64_t matrix_mode) {
+  static const oss::OssDataManager *data_manager = new oss::OssDataManager();
+  Connector::Options options;
+  options.index_type = storage::louds::BitVectorIndexType::kRankSelect;
+  options.matrix_mode = static_cast<Connector::MatrixMode>(matrix_mode);
+  absl::StatusOr<std::unique_ptr<Connector>> connector =
+      Connector::CreateFromDataManager(*data_manager, options);
+  CHECK_OK(connector);
+  return *std::move(connector);
+}
+
+// Args: {matrix_mode}.
+void BM_GetTransitionCost(::benchmark::State &state) {
+  const std::unique_ptr<Connector> connector = CreateConnector(state.range(0));
+  const uint16_t size = connector->GetMatrixSize();
+  std::mt19937 gen(0);
+  std::vector<std::pair<uint16_t, uint16_t>> ids(kNumLookups);
+  for (auto &[rid, lid] : ids) {
+    rid = gen() % size;
+    lid = gen() % size;
+  }
+  // Decodes the rows used in the lazy mode.
+  for (const auto &[rid, lid] : ids) {
+    connector->GetTransitionCost(rid, lid);
+  }
+
+  for (auto _ : state) {
+    for (const auto &[rid, lid] : ids) {
+      ::benchmark::DoNotOptimize(connector->GetTransitionCost(rid, lid));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+BENCHMARK(BM_GetTransitionCost)->ArgName("matrix_mode")->DenseRange(0, 2);
+
+// Emulates the access pattern of Viterbi algorithm, which fetches a row of
+// costs for the columns at a lattice position.
+// Args: {matrix_mode}.
+void BM_GetTransitionCosts(::benchmark::State &state) {
+  const std::unique_ptr<Connector> connector = CreateConnector(state.range(0));
+  const uint16_t size = connector->GetMatrixSize();
+  std::mt19937 gen(0);
+  std::vector<uint16_t> rids(kNumLookups / kNumColumns);
+  for (uint16_t &rid : rids) {
+    rid = gen() % size;
+  }
+  std::vector<uint16_t> lids(kNumColumns);
+  for (uint16_t &lid : lids) {
+    lid = gen() % size;
+  }
+  std::vector<int> costs(kNumColumns);
+  for (uint16_t rid : rids) {
+    connector->GetTransitionCosts(rid, lids, absl::MakeSpan(costs));
+  }
+
+  for (auto _ : state) {
+    for (uint16_t rid : rids) {
+      connector->GetTransitionCosts(rid, lids, absl::MakeSpan(costs));
+      ::benchmark::DoNotOptimize(costs.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * rids.size() * lids.size());
+}
+BENCHMARK(BM_GetTransitionCosts)->ArgName("matrix_mode")->DenseRange(0, 2);
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  // Let the benchmark library consume its own flags first, as InitMozc()
+  // rejects unknown flags.
+  ::benchmark::Initialize(&argc, argv);
+  mozc::InitMozc(argv[0], &argc, &argv);
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  return 0;
+}
@@ -40,26 +40,33 @@
 #include "base/logging.h"
 #include "base/mmap.h"
 #include "data_manager/connection_file_reader.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace {
 
+using ::mozc::storage::louds::BitVectorIndexType;
+
 struct ConnectionDataEntry {
   uint16_t rid;
   uint16_t lid;
   int cost;
 };
 
-TEST(ConnectorTest, CompareWithRawData) {
+class ConnectorIndexTypeTest
+    : public ::testing::TestWithParam<BitVectorIndexType> {};
+
+TEST_P(ConnectorIndexTypeTest, CompareWithRawData) {
   const std::string path = testing::GetSourceFileOrDie(
       {"data_manager", "testing", "connection.data"});
   absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
   ASSERT_OK(cmmap) << cmmap.status();
   auto status_or_connector =
-      Connector::Create(cmmap->begin(), cmmap->size(), 256);
+      Connector::Create(cmmap->begin(), cmmap->size(), 256, GetParam());
   ASSERT_TRUE(status_or_connector.ok()) << status_or_connector.status();
   auto connector = std::move(status_or_connector).value();
   ASSERT_EQ(1, connector->GetResolution());
@@ -92,6 +99,149 @@ TEST(ConnectorTest, CompareWithRawData) {
   }
 }
 
+TEST_P(ConnectorIndexTypeTest, GetTransitionCostsMatchesSingleLookup) {
+  const std::string path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection.data"});
+  absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
+  ASSERT_OK(cmmap) << cmmap.status();
+  auto status_or_connector =
+      Connector::Create(cmmap->begin(), cmmap->size(), 256, GetParam());
+  ASSERT_TRUE(status_or_connector.ok()) << status_or_connector.status();
+  auto connector = std::move(status_or_connector).value();
+
+  const std::string connection_text_path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection_single_column.txt"});
+  std::vector<ConnectionDataEntry> data;
+  for (ConnectionFileReader reader(connection_text_path); !reader.done();
+       reader.Next()) {
+    ConnectionDataEntry entry;
+    entry.rid = reader.rid_of_left_node();
+    entry.lid = reader.lid_of_right_node();
+    entry.cost = reader.cost();
+    data.push_back(entry);
+  }
+  ASSERT_FALSE(data.empty());
+
+  // Pick a few rows and look up random columns, including duplicates.
+  std::mt19937 urbg(0);
+  std::uniform_int_distribution<size_t> dist(0, data.size() - 1);
+  for (int trial = 0; trial < 100; ++trial) {
+    const uint16_t rid = data[dist(urbg)].rid;
+    std::vector<uint16_t> lids;
+    for (int i = 0; i < 64; ++i) {
+      lids.push_back(data[dist(urbg)].lid);
+    }
+    std::vector<int> costs(lids.size(), -1);
+    connector->GetTransitionCosts(rid, lids, absl::MakeSpan(costs));
+    for (size_t i = 0; i < lids.size(); ++i) {
+      EXPECT_EQ(costs[i], connector->GetTransitionCost(rid, lids[i]))
+          << "rid=" << rid << ", lid=" << lids[i];
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(IndexTypes, ConnectorIndexTypeTest,
+                         ::testing::Values(BitVectorIndexType::kSimple,
+                                           BitVectorIndexType::kRankSelect));
+
+class ConnectorMatrixModeTest
+    : public ::testing::TestWithParam<Connector::MatrixMode> {};
+
+TEST_P(ConnectorMatrixModeTest, CompareWithRawData) {
+  const std::string path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection.data"});
+  absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
+  ASSERT_OK(cmmap) << cmmap.status();
+  Connector::Options options;
+  options.matrix_mode = GetParam();
+  auto status_or_connector =
+      Connector::Create(cmmap->begin(), cmmap->size(), 256, options);
+  ASSERT_TRUE(status_or_connector.ok()) << status_or_connector.status();
+  auto connector = std::move(status_or_connector).value();
+  const size_t initial_dense_size = connector->GetDenseMatrixByteSize();
+
+  const std::string connection_text_path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection_single_column.txt"});
+  size_t matrix_size = 0;
+  for (ConnectionFileReader reader(connection_text_path); !reader.done();
+       reader.Next()) {
+    matrix_size = std::max<size_t>(matrix_size, reader.rid_of_left_node() + 1);
+    EXPECT_EQ(connector->GetTransitionCost(reader.rid_of_left_node(),
+                                           reader.lid_of_right_node()),
+              reader.cost());
+  }
+
+  // The binary data may have a few more rows for special POSs than the text.
+  const size_t min_dense_size = matrix_size * matrix_size * sizeof(int16_t);
+  switch (GetParam()) {
+    case Connector::MatrixMode::kCompressed:
+      EXPECT_EQ(initial_dense_size, 0);
+      EXPECT_EQ(connector->GetDenseMatrixByteSize(), 0);
+      break;
+    case Connector::MatrixMode::kDenseLazy:
+      EXPECT_EQ(initial_dense_size, 0);
+      EXPECT_GE(connector->GetDenseMatrixByteSize(), min_dense_size);
+      break;
+    case Connector::MatrixMode::kDenseEager:
+      EXPECT_GE(initial_dense_size, min_dense_size);
+      EXPECT_EQ(connector->GetDenseMatrixByteSize(), initial_dense_size);
+      break;
+  }
+}
+
+TEST(ConnectorTest, DenseMatrixIsDecodedLazily) {
+  const std::string path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection.data"});
+  absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
+  ASSERT_OK(cmmap) << cmmap.status();
+  Connector::Options options;
+  options.matrix_mode = Connector::MatrixMode::kDenseLazy;
+  auto status_or_connector =
+      Connector::Create(cmmap->begin(), cmmap->size(), 256, options);
+  ASSERT_TRUE(status_or_connector.ok()) << status_or_connector.status();
+  auto connector = std::move(status_or_connector).value();
+  EXPECT_EQ(connector->GetDenseMatrixByteSize(), 0);
+
+  connector->GetTransitionCost(0, 0);
+  const size_t row_size = connector->GetDenseMatrixByteSize();
+  EXPECT_GT(row_size, 0);
+
+  // Lookups in the same row don't decode any more rows.
+  connector->GetTransitionCost(0, 1);
+  EXPECT_EQ(connector->GetDenseMatrixByteSize(), row_size);
+  connector->GetTransitionCost(1, 0);
+  EXPECT_EQ(connector->GetDenseMatrixByteSize(), 2 * row_size);
+}
+
+TEST(ConnectorTest, GetMemoryUsage) {
+  const std::string path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection.data"});
+  absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
+  ASSERT_OK(cmmap) << cmmap.status();
+  Connector::Options options;
+  options.matrix_mode = Connector::MatrixMode::kDenseLazy;
+  auto status_or_connector =
+      Connector::Create(cmmap->begin(), cmmap->size(), 256, options);
+  ASSERT_TRUE(status_or_connector.ok()) << status_or_connector.status();
+  auto connector = std::move(status_or_connector).value();
+
+  const MemoryUsage initial_usage = connector->GetMemoryUsage();
+  EXPECT_EQ(initial_usage.mapped_bytes, cmmap->size());
+  EXPECT_GT(initial_usage.heap_bytes, 0);
+
+  // Decoded dense rows are accounted as heap.
+  connector->GetTransitionCost(0, 0);
+  const MemoryUsage usage = connector->GetMemoryUsage();
+  EXPECT_EQ(usage.mapped_bytes, initial_usage.mapped_bytes);
+  EXPECT_EQ(usage.heap_bytes,
+            initial_usage.heap_bytes + connector->GetDenseMatrixByteSize());
+}
+
+INSTANTIATE_TEST_SUITE_P(MatrixModes, ConnectorMatrixModeTest,
+                         ::testing::Values(Connector::MatrixMode::kCompressed,
+                                           Connector::MatrixMode::kDenseLazy,
+                                           Connector::MatrixMode::kDenseEager));
+
 TEST(ConnectorTest, BrokenData) {
   const std::string path = testing::GetSourceFileOrDie(
       {"data_manager", "testing", "connection.data"});
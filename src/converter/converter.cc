@@ -886,10 +886,10 @@ void ConverterImpl::CompletePosIds(Segment::Candidate *candidate) const {
   // If no valid candidates are found within 5 candidates, expand
   // candidates step-by-step.
   ConversionRequest request;
+  request.set_keep_candidate_generator_state(true);
+  Segments segments;
   for (size_t size = kExpandSizeStart; size < kExpandSizeMax;
        size += kExpandSizeDiff) {
-    Segments segments;
-    SetKey(&segments, candidate->key);
     // use PREDICTION mode, as the size of segments after
     // PREDICTION mode is always 1, thanks to real time conversion.
     // However, PREDICTION mode produces "predictions", meaning
@@ -897,10 +897,15 @@ void ConverterImpl::CompletePosIds(Segment::Candidate *candidate) const {
     // query key. It would be nice to have PREDICTION_REALTIME_CONVERSION_ONLY.
     request.set_request_type(ConversionRequest::PREDICTION);
     request.set_max_conversion_candidates_size(size);
-    // In order to complete PosIds, call ImmutableConverter again.
-    if (!immutable_converter_->ConvertForRequest(request, &segments)) {
-      LOG(ERROR) << "ImmutableConverter::Convert() failed";
-      return;
+    // Resume the search of the previous step instead of converting again.
+    if (!immutable_converter_->ExpandCandidatesForRequest(request,
+                                                          &segments)) {
+      SetKey(&segments, candidate->key);
+      // In order to complete PosIds, call ImmutableConverter again.
+      if (!immutable_converter_->ConvertForRequest(request, &segments)) {
+        LOG(ERROR) << "ImmutableConverter::Convert() failed";
+        return;
+      }
     }
     for (size_t i = 0; i < segments.segment(0).candidates_size(); ++i) {
       const Segment::Candidate &ref_candidate =
@@ -926,7 +931,11 @@ void ConverterImpl::CompletePosIds(Segment::Candidate *candidate) const {
 
 void ConverterImpl::RewriteAndSuppressCandidates(
     const ConversionRequest &request, Segments *segments) const {
-  if (!rewriter_->Rewrite(request, segments)) {
+  const bool rewritten = rewriter_->Rewrite(request, segments);
+  // The stages before this point cut their work short only after the deadline
+  // has passed, so report the result as partial if it has passed by now.
+  segments->set_truncated(request.IsDeadlineExceeded());
+  if (!rewritten) {
     return;
   }
   // Optimization for common use case: Since most of users don't use suppression
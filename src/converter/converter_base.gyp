@@ -55,8 +55,10 @@
         'connector.cc',
       ],
       'dependencies': [
+        '../base/absl.gyp:absl_base',
         '../base/absl.gyp:absl_status',
         '../base/base.gyp:base',
+        '../storage/louds/louds.gyp:rank_select_bit_vector_index',
         '../storage/louds/louds.gyp:simple_succinct_bit_vector_index',
       ],
     },
@@ -129,6 +131,7 @@
         '../protocol/protocol.gyp:commands_proto',
         '../protocol/protocol.gyp:config_proto',
         '../rewriter/rewriter_base.gyp:gen_rewriter_files#host',
+        '../usage_stats/usage_stats_base.gyp:latency_stats',
         'connector',
         'immutable_converter_interface',
         'segmenter',
@@ -37,6 +37,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/clock_mock.h"
 #include "base/logging.h"
 #include "base/port.h"
 #include "base/system_util.h"
@@ -88,6 +89,7 @@
 #include "usage_stats/usage_stats_testing_util.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace {
@@ -1348,6 +1350,37 @@ TEST_F(ConverterTest, ComposerKeySelection) {
   }
 }
 
+TEST_F(ConverterTest, ConversionTimeBudget) {
+  ScopedClockMock clock(absl::FromUnixSeconds(1000));
+
+  std::unique_ptr<EngineInterface> engine =
+      MockDataEngineFactory::Create().value();
+  ConverterInterface *converter = engine->GetConverter();
+  composer::Table table;
+  config::Config config;
+  commands::Request request_proto;
+  request_proto.set_conversion_time_budget_msec(30);
+  composer::Composer composer(&table, &request_proto, &config);
+  composer.InsertCharacterPreedit("わたしのなまえはなかのです");
+  const ConversionRequest request(&composer, &request_proto, &config);
+  EXPECT_EQ(request.deadline(),
+            absl::FromUnixSeconds(1000) + absl::Milliseconds(30));
+  {
+    Segments segments;
+    ASSERT_TRUE(converter->StartConversionForRequest(request, &segments));
+    EXPECT_FALSE(segments.truncated());
+    EXPECT_LT(1, segments.conversion_segment(0).candidates_size());
+  }
+  clock->Advance(absl::Milliseconds(30));
+  {
+    // The best result is still returned after the deadline.
+    Segments segments;
+    ASSERT_TRUE(converter->StartConversionForRequest(request, &segments));
+    EXPECT_TRUE(segments.truncated());
+    EXPECT_LE(1, segments.conversion_segment(0).candidates_size());
+  }
+}
+
 TEST_F(ConverterTest, SuppressionDictionaryForRewriter) {
   std::unique_ptr<ConverterAndData> ret(
       CreateConverterAndDataWithInsertDummyWordsRewriter());
@@ -32,9 +32,10 @@
 #include <algorithm>
 #include <cctype>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
-#include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -61,9 +62,12 @@
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
 #include "request/conversion_request.h"
+#include "usage_stats/latency_stats.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace {
@@ -73,6 +77,8 @@ using ::mozc::dictionary::PosGroup;
 using ::mozc::dictionary::PosMatcher;
 using ::mozc::dictionary::SuppressionDictionary;
 using ::mozc::dictionary::Token;
+using ::mozc::usage_stats::LatencyStats;
+using ::mozc::usage_stats::ScopedLatencyTimer;
 
 constexpr size_t kMaxSegmentsSize = 256;
 constexpr size_t kMaxCharLength = 1024;
@@ -243,7 +249,23 @@ void NormalizeHistorySegments(Segments *segments) {
   }
 }
 
-Lattice *GetLattice(Segments *segments, bool is_prediction) {
+size_t GetExpandSize(size_t max_candidates_size) {
+  return std::max<size_t>(1, std::min<size_t>(512, max_candidates_size));
+}
+
+// The N-best generator of a realtime conversion kept in Segments.
+struct NBestGeneratorState : public Segments::CandidateGeneratorState {
+  std::unique_ptr<NBestGenerator> generator;
+  std::string original_key;
+  // The segment filled by |generator|, to check that the segments are not
+  // rebuilt since then.
+  const Segment *segment = nullptr;
+  // The number of the candidates from |generator|, followed by the dummy
+  // candidates.
+  size_t nbest_candidates_size = 0;
+};
+
+Lattice *GetLattice(Segments *segments, bool is_reverse) {
   Lattice *lattice = segments->mutable_cached_lattice();
   if (lattice == nullptr) {
     return nullptr;
@@ -262,14 +284,16 @@ Lattice *GetLattice(Segments *segments, bool is_prediction) {
 
   const size_t lattice_history_end_pos = lattice->history_end_pos();
 
-  if (!is_prediction || Util::CharsLen(conversion_key) <= 1 ||
+  if (is_reverse || Util::CharsLen(conversion_key) <= 1 ||
       lattice_history_end_pos != history_key.size()) {
-    // Do not cache if conversion is not prediction.  In addition, if a user
-    // input the key right after the finish of conversion, reset the lattice to
-    // erase old nodes.  Even if the lattice key is not changed, we should reset
-    // the lattice when the history size is changed.  When we submit the
-    // candidate partially, the entire key will not changed, but the history
-    // position will be changed.
+    // The dictionary nodes are shared by prediction, conversion and
+    // resegmentation for the same key prefix, but not by reverse conversion,
+    // whose lookup is not cached.  In addition, if a user input the key right
+    // after the finish of conversion, reset the lattice to erase old nodes.
+    // Even if the lattice key is not changed, we should reset the lattice when
+    // the history size is changed.  When we submit the candidate partially,
+    // the entire key will not changed, but the history position will be
+    // changed.
     lattice->Clear();
   }
 
@@ -738,7 +762,7 @@ class NodeListBuilderWithCacheEnabled : public NodeListBuilderForLookupPrefix {
 
 Node *ImmutableConverterImpl::Lookup(const int begin_pos, const int end_pos,
                                      const ConversionRequest &request,
-                                     bool is_reverse, bool is_prediction,
+                                     bool is_reverse, bool use_cache,
                                      Lattice *lattice) const {
   CHECK_LE(begin_pos, end_pos);
   const char *begin = lattice->key().data() + begin_pos;
@@ -755,7 +779,7 @@ Node *ImmutableConverterImpl::Lookup(const int begin_pos, const int end_pos,
                                &builder);
     result_node = builder.result();
   } else {
-    if (is_prediction) {
+    if (use_cache) {
       NodeListBuilderWithCacheEnabled builder(
           lattice->node_allocator(), lattice->cache_info(begin_pos) + 1,
           GetSpatialCostParams(request));
@@ -776,6 +800,44 @@ Node *ImmutableConverterImpl::Lookup(const int begin_pos, const int end_pos,
   return AddCharacterTypeBasedNodes(begin, end, lattice, result_node);
 }
 
+void ImmutableConverterImpl::LookupBatch(
+    absl::Span<const size_t> begin_positions, const int end_pos,
+    const ConversionRequest &request, bool use_cache, Lattice *lattice,
+    std::vector<Node *> *results) const {
+  lattice->node_allocator()->set_max_nodes_size(8192);
+  std::vector<std::unique_ptr<BaseNodeListBuilder>> builders;
+  builders.reserve(begin_positions.size());
+  for (const size_t begin_pos : begin_positions) {
+    DCHECK_LT(begin_pos, end_pos);
+    if (use_cache) {
+      builders.push_back(std::make_unique<NodeListBuilderWithCacheEnabled>(
+          lattice->node_allocator(), lattice->cache_info(begin_pos) + 1,
+          GetSpatialCostParams(request)));
+    } else {
+      builders.push_back(std::make_unique<BaseNodeListBuilder>(
+          lattice->node_allocator(),
+          lattice->node_allocator()->max_nodes_size(),
+          GetSpatialCostParams(request)));
+    }
+  }
+  std::vector<DictionaryInterface::Callback *> callbacks;
+  callbacks.reserve(builders.size());
+  for (const std::unique_ptr<BaseNodeListBuilder> &builder : builders) {
+    callbacks.push_back(builder.get());
+  }
+
+  const absl::string_view key(lattice->key().data(), end_pos);
+  dictionary_->LookupPrefixBatch(key, begin_positions, request, callbacks);
+
+  results->clear();
+  results->reserve(begin_positions.size());
+  for (size_t i = 0; i < begin_positions.size(); ++i) {
+    results->push_back(AddCharacterTypeBasedNodes(
+        key.data() + begin_positions[i], key.data() + key.size(), lattice,
+        builders[i]->result()));
+  }
+}
+
 Node *ImmutableConverterImpl::AddCharacterTypeBasedNodes(const char *begin,
                                                          const char *end,
                                                          Lattice *lattice,
@@ -853,79 +915,72 @@ Node *ImmutableConverterImpl::AddCharacterTypeBasedNodes(const char *begin,
 
 namespace {
 
-// A wrapper for Connector to minimize calls of Connector::GetTransitionCost()
-// in Viterbi algorithm. This way the performance of Viterbi algorithm improves
-// significantly in terms of time consumption because
-// Connector::GetTransitionCost() is slow due to its compression format. This
-// class implements a cache strategy designed for the access pattern in Viterbi
-// algorithm.
-//
-// In Viterbi algorithm, the connection matrix is looked up in a nested loop as
-// follows:
+// Reasonably big cost. Cannot use INT_MAX because a new cost will be
+// calculated based on kVeryBigCost.
+constexpr int kVeryBigCost = (INT_MAX >> 2);
+
+// Scratch buffers for ViterbiInternal() holding the nodes of one lattice
+// position in structure-of-arrays form.
 //
-// for each right node `r`:
-//   for each left node `l`:
-//     ...
-//     transition cost = connector.GetTransitionCost(l.rid, r.lid)
-//     ...
+// In Viterbi algorithm, the connection matrix is looked up in a nested loop
+// over the right nodes `r` beginning at a position and the left nodes `l`
+// ending there. The best left node of `r` only depends on `r.lid`, so right
+// nodes sharing a lid (they are likely ordered by lid) are folded into one
+// column. The loop is then transposed so that the left nodes are the outer
+// loop: for each `l`, a row of transition costs for all the columns is
+// fetched with Connector::GetTransitionCosts() and the column minimums are
+// updated by a branch-free loop over contiguous arrays, which compilers can
+// vectorize.
 //
-// Therefore, in the inner loop, `r.lid` is fixed. So we can simply use an array
-// to cache the transition cost for (l.rid, r.lid) in `cache[l.rid]`, and cache
-// is reset before the inner loop. Moreover, right nodes are likely to be
-// ordered by `r.lid` although it's not guaranteed in general. This fact is plus
-// for this caching strategy as we only need to reset the cache if `r.lid` is
-// different from the previous value.
+// Rows of the compressed connection matrix are slow to decode, and left nodes
+// sharing a rid are not always adjacent, so the rows are cached by rid for the
+// position. Rows of the dense matrix are cheap to gather again and are not
+// cached.
 //
-// NOTE: This class is designed only for Viterbi algorithm and won't work for
-// other purposes.
-class CachingConnector final {
- public:
-  explicit CachingConnector(const Connector &connector)
-      : connector_{connector} {}
-
-  CachingConnector(const CachingConnector &) = delete;
-  CachingConnector &operator=(const CachingConnector &) = delete;
-
-  void ResetCacheIfNecessary(uint16_t rnode_lid) {
-    if (cache_lid_ != rnode_lid) {
-      std::fill_n(cache_, kCacheSize, -1);
-      cache_lid_ = rnode_lid;
-    }
-  }
-
-  int GetTransitionCost(uint16_t lnode_rid, uint16_t rnode_lid) {
-    DCHECK_EQ(cache_lid_, rnode_lid);
-    // Values for rid >= kCacheSize cannot be cached. However, frequent PoSs
-    // have smaller IDs, so caching only for rid in [0, kCacheSize) works well.
-    if (lnode_rid >= kCacheSize) {
-      return connector_.GetTransitionCost(lnode_rid, rnode_lid);
-    }
-    if (cache_[lnode_rid] != -1) {
-      return cache_[lnode_rid];
-    }
-    cache_[lnode_rid] = connector_.GetTransitionCost(lnode_rid, rnode_lid);
-    return cache_[lnode_rid];
-  }
-
- private:
-  constexpr static int kCacheSize = 2048;
-
-  const Connector &connector_;
-  int cache_[kCacheSize];
-  uint16_t cache_lid_ = std::numeric_limits<uint16_t>::max();
+// The buffers are reused across positions to avoid reallocation.
+struct ViterbiColumns {
+  void Clear() {
+    lnodes.clear();
+    lnode_rids.clear();
+    lnode_costs.clear();
+    rnodes.clear();
+    rnode_columns.clear();
+    lids.clear();
+    best_costs.clear();
+    best_indices.clear();
+    row_offsets.clear();
+    cached_rows.clear();
+  }
+
+  // Valid left nodes in the order of Node::enext.
+  std::vector<Node *> lnodes;
+  std::vector<uint16_t> lnode_rids;
+  std::vector<int> lnode_costs;
+
+  // Unconstrained right nodes to be updated and their column indices.
+  std::vector<Node *> rnodes;
+  std::vector<int> rnode_columns;
+
+  // Per-column data.
+  std::vector<uint16_t> lids;
+  std::vector<int> best_costs;
+  std::vector<int> best_indices;
+  std::vector<int> transition_costs;
+
+  // Rows of transition costs for the columns, cached by rid. Row of rid `r`
+  // starts at cached_rows[row_offsets[r]].
+  absl::flat_hash_map<uint16_t, size_t> row_offsets;
+  std::vector<int> cached_rows;
 };
 
-// Reasonably big cost. Cannot use INT_MAX because a new cost will be
-// calculated based on kVeryBigCost.
-constexpr int kVeryBigCost = (INT_MAX >> 2);
-
 // Runs viterbi algorithm at position |pos|. The left_boundary/right_boundary
 // are the next boundary looked from pos. (If pos is on the boundary,
 // left_boundary should be the previous one, and right_boundary should be
 // the next).
-inline void ViterbiInternal(const Connector &connector, size_t pos,
-                            size_t right_boundary, Lattice *lattice) {
-  CachingConnector conn(connector);
+void ViterbiInternal(const Connector &connector, size_t pos,
+                     size_t right_boundary, Lattice *lattice,
+                     ViterbiColumns *columns) {
+  columns->Clear();
   for (Node *rnode = lattice->begin_nodes(pos); rnode != nullptr;
        rnode = rnode->bnext) {
     if (rnode->end_pos > right_boundary) {
@@ -934,45 +989,95 @@ inline void ViterbiInternal(const Connector &connector, size_t pos,
       continue;
     }
 
-    conn.ResetCacheIfNecessary(rnode->lid);
-
     if (rnode->constrained_prev != nullptr) {
       // Constrained node.
       if (rnode->constrained_prev->prev == nullptr) {
         rnode->prev = nullptr;
       } else {
         rnode->prev = rnode->constrained_prev;
-        rnode->cost = rnode->prev->cost + rnode->wcost +
-                      conn.GetTransitionCost(rnode->prev->rid, rnode->lid);
+        rnode->cost =
+            rnode->prev->cost + rnode->wcost +
+            connector.GetTransitionCost(rnode->prev->rid, rnode->lid);
       }
       continue;
     }
 
-    // Find a valid node which connects to the rnode with minimum cost.
-    int best_cost = kVeryBigCost;
-    Node *best_node = nullptr;
-    for (Node *lnode = lattice->end_nodes(pos); lnode != nullptr;
-         lnode = lnode->enext) {
-      if (lnode->prev == nullptr) {
-        // Invalid lnode.
-        continue;
-      }
+    if (columns->lids.empty() || columns->lids.back() != rnode->lid) {
+      columns->lids.push_back(rnode->lid);
+    }
+    columns->rnodes.push_back(rnode);
+    columns->rnode_columns.push_back(columns->lids.size() - 1);
+  }
+  if (columns->rnodes.empty()) {
+    return;
+  }
 
-      int cost = lnode->cost + conn.GetTransitionCost(lnode->rid, rnode->lid);
-      if (cost < best_cost) {
-        best_cost = cost;
-        best_node = lnode;
+  for (Node *lnode = lattice->end_nodes(pos); lnode != nullptr;
+       lnode = lnode->enext) {
+    if (lnode->prev == nullptr) {
+      // Invalid lnode.
+      continue;
+    }
+    columns->lnodes.push_back(lnode);
+    columns->lnode_rids.push_back(lnode->rid);
+    columns->lnode_costs.push_back(lnode->cost);
+  }
+
+  // Find a valid node which connects to each column with minimum cost. Left
+  // nodes are visited in the order of enext and only a strictly smaller cost
+  // replaces the current best, so ties are resolved in the same way as the
+  // node-by-node scan.
+  const size_t num_columns = columns->lids.size();
+  columns->best_costs.assign(num_columns, kVeryBigCost);
+  columns->best_indices.assign(num_columns, -1);
+  columns->transition_costs.resize(num_columns);
+  int *best_costs = columns->best_costs.data();
+  int *best_indices = columns->best_indices.data();
+  const int *transition_costs = columns->transition_costs.data();
+  const bool cache_rows =
+      connector.matrix_mode() == Connector::MatrixMode::kCompressed;
+  for (size_t i = 0; i < columns->lnodes.size(); ++i) {
+    // Left nodes sharing a rid share the same row of transition costs.
+    const uint16_t rid = columns->lnode_rids[i];
+    if (cache_rows) {
+      const auto [iter, inserted] =
+          columns->row_offsets.try_emplace(rid, columns->cached_rows.size());
+      if (inserted) {
+        columns->cached_rows.resize(iter->second + num_columns);
+        connector.GetTransitionCosts(
+            rid, columns->lids,
+            absl::MakeSpan(columns->cached_rows).subspan(iter->second));
       }
+      transition_costs = columns->cached_rows.data() + iter->second;
+    } else if (i == 0 || rid != columns->lnode_rids[i - 1]) {
+      connector.GetTransitionCosts(rid, columns->lids,
+                                   absl::MakeSpan(columns->transition_costs));
+    }
+    const int lnode_cost = columns->lnode_costs[i];
+    const int index = static_cast<int>(i);
+    for (size_t j = 0; j < num_columns; ++j) {
+      const int cost = lnode_cost + transition_costs[j];
+      const bool is_better = cost < best_costs[j];
+      best_costs[j] = is_better ? cost : best_costs[j];
+      best_indices[j] = is_better ? index : best_indices[j];
     }
+  }
 
-    rnode->prev = best_node;
-    rnode->cost = best_cost + rnode->wcost;
+  for (size_t k = 0; k < columns->rnodes.size(); ++k) {
+    Node *rnode = columns->rnodes[k];
+    const int column = columns->rnode_columns[k];
+    const int best_index = best_indices[column];
+    rnode->prev = best_index < 0 ? nullptr : columns->lnodes[best_index];
+    rnode->cost = best_costs[column] + rnode->wcost;
   }
 }
 }  // namespace
 
 bool ImmutableConverterImpl::Viterbi(const Segments &segments,
                                      Lattice *lattice) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("ImmutableConverter.Viterbi");
+  ScopedLatencyTimer timer(kStage);
   const std::string &key = lattice->key();
 
   // Process BOS.
@@ -1003,6 +1108,8 @@ bool ImmutableConverterImpl::Viterbi(const Segments &segments,
   size_t left_boundary = 0;
   const size_t segments_size = segments.segments_size();
 
+  ViterbiColumns columns;
+
   // Specialization for the first segment.
   // Don't run on the left boundary (the connection with BOS node),
   // because it is already run above.
@@ -1010,7 +1117,7 @@ bool ImmutableConverterImpl::Viterbi(const Segments &segments,
     const size_t right_boundary =
         left_boundary + segments.segment(0).key().size();
     for (size_t pos = left_boundary + 1; pos < right_boundary; ++pos) {
-      ViterbiInternal(*connector_, pos, right_boundary, lattice);
+      ViterbiInternal(*connector_, pos, right_boundary, lattice, &columns);
     }
     left_boundary = right_boundary;
   }
@@ -1021,7 +1128,7 @@ bool ImmutableConverterImpl::Viterbi(const Segments &segments,
     const size_t right_boundary =
         left_boundary + segments.segment(i).key().size();
     for (size_t pos = left_boundary; pos < right_boundary; ++pos) {
-      ViterbiInternal(*connector_, pos, right_boundary, lattice);
+      ViterbiInternal(*connector_, pos, right_boundary, lattice, &columns);
     }
     left_boundary = right_boundary;
   }
@@ -1102,6 +1209,9 @@ bool ImmutableConverterImpl::Viterbi(const Segments &segments,
 
 bool ImmutableConverterImpl::PredictionViterbi(const Segments &segments,
                                                Lattice *lattice) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("ImmutableConverter.PredictionViterbi");
+  ScopedLatencyTimer timer(kStage);
   const size_t key_length = lattice->key().size();
   const size_t history_segments_size = segments.history_segments_size();
   size_t history_length = 0;
@@ -1359,6 +1469,9 @@ void ImmutableConverterImpl::MakeLatticeNodesForPredictiveNodes(
 bool ImmutableConverterImpl::MakeLattice(const ConversionRequest &request,
                                          Segments *segments,
                                          Lattice *lattice) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("ImmutableConverter.MakeLattice");
+  ScopedLatencyTimer timer(kStage);
   if (segments == nullptr) {
     LOG(ERROR) << "Segments is nullptr";
     return false;
@@ -1554,8 +1667,9 @@ bool ImmutableConverterImpl::MakeLatticeNodesForHistorySegments(
         (request.request_type() == ConversionRequest::SUGGESTION ||
          request.request_type() == ConversionRequest::PREDICTION);
     if (!is_prediction && s + 1 == history_segments_size) {
+      // The nodes are not inserted to the lattice, so the cache is not used.
       const Node *node = Lookup(segments_pos, key.size(), request, is_reverse,
-                                is_prediction, lattice);
+                                /*use_cache=*/false, lattice);
       for (const Node *compound_node = node; compound_node != nullptr;
            compound_node = compound_node->bnext) {
         // No overlapps
@@ -1649,13 +1763,37 @@ void ImmutableConverterImpl::MakeLatticeNodesForConversionSegments(
 
   const bool is_reverse =
       (request.request_type() == ConversionRequest::REVERSE_CONVERSION);
-  const bool is_prediction =
-      (request.request_type() == ConversionRequest::SUGGESTION ||
-       request.request_type() == ConversionRequest::PREDICTION);
+
+  // Every character boundary after the history is reachable, as Lookup() adds
+  // a single character node at each position.  So look up the dictionary for
+  // all of them at once, except for reverse conversion.
+  std::vector<size_t> batch_positions;
+  std::vector<Node *> batch_results;
+  if (!is_reverse) {
+    for (size_t pos = history_key.size(); pos < key.size();
+         pos += Util::OneCharLen(key.data() + pos)) {
+      batch_positions.push_back(pos);
+    }
+    LookupBatch(batch_positions, key.size(), request, /*use_cache=*/true,
+                lattice, &batch_results);
+  }
+
+  size_t batch_index = 0;
   for (size_t pos = history_key.size(); pos < key.size(); ++pos) {
+    while (batch_index < batch_positions.size() &&
+           batch_positions[batch_index] < pos) {
+      ++batch_index;
+    }
     if (lattice->end_nodes(pos) != nullptr) {
-      Node *rnode =
-          Lookup(pos, key.size(), request, is_reverse, is_prediction, lattice);
+      Node *rnode = nullptr;
+      if (batch_index < batch_positions.size() &&
+          batch_positions[batch_index] == pos) {
+        rnode = batch_results[batch_index];
+        lattice->SetCacheInfo(pos, key.size() - pos);
+      } else {
+        rnode = Lookup(pos, key.size(), request, is_reverse,
+                       /*use_cache=*/!is_reverse, lattice);
+      }
       // If history key is NOT empty and user input seems to starts with
       // a particle ("はにで..."), mark the node as STARTS_WITH_PARTICLE.
       // We change the segment boundary if STARTS_WITH_PARTICLE attribute
@@ -1874,6 +2012,9 @@ void ImmutableConverterImpl::InsertCandidates(
     const Lattice &lattice, const std::vector<uint16_t> &group,
     size_t max_candidates_size, InsertCandidatesType type,
     FilterType filter_type) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("NBestGenerator");
+  ScopedLatencyTimer timer(kStage);
   // skip HIS_NODE(s)
   Node *prev = lattice.bos_nodes();
   for (Node *node = lattice.bos_nodes()->next;
@@ -1882,13 +2023,31 @@ void ImmutableConverterImpl::InsertCandidates(
     prev = node;
   }
 
-  const size_t expand_size =
-      std::max<size_t>(1, std::min<size_t>(512, max_candidates_size));
+  const size_t expand_size = GetExpandSize(max_candidates_size);
 
   const bool is_single_segment = (type == SINGLE_SEGMENT);
-  NBestGenerator nbest_generator(suppression_dictionary_, segmenter_,
-                                 connector_, pos_matcher_, &lattice,
-                                 suggestion_filter_, (filter_type == DESKTOP));
+
+  // Keep the generator of a realtime conversion if the caller asks, so that
+  // ExpandCandidatesForRequest() can resume it. Partial candidates are
+  // appended after the realtime conversion results, so the search cannot be
+  // resumed in that case. Otherwise the generator stays on the stack.
+  const bool keep_generator = is_single_segment &&
+                              request.keep_candidate_generator_state() &&
+                              !request.create_partial_candidates() &&
+                              &lattice == segments->mutable_cached_lattice();
+  std::optional<NBestGenerator> local_generator;
+  std::unique_ptr<NBestGenerator> kept_generator;
+  NBestGenerator *nbest_generator = nullptr;
+  if (keep_generator) {
+    kept_generator = std::make_unique<NBestGenerator>(
+        suppression_dictionary_, segmenter_, connector_, pos_matcher_,
+        &lattice, suggestion_filter_, (filter_type == DESKTOP));
+    nbest_generator = kept_generator.get();
+  } else {
+    nbest_generator = &local_generator.emplace(
+        suppression_dictionary_, segmenter_, connector_, pos_matcher_,
+        &lattice, suggestion_filter_, (filter_type == DESKTOP));
+  }
 
   std::string original_key;
   for (size_t i = 0; i < segments->conversion_segments_size(); ++i) {
@@ -1896,6 +2055,9 @@ void ImmutableConverterImpl::InsertCandidates(
   }
 
   size_t begin_pos = std::string::npos;
+  size_t num_target_segments = 0;
+  Segment *segment = nullptr;
+  size_t nbest_candidates_size = 0;
   for (Node *node = prev->next; node->next != nullptr; node = node->next) {
     if (begin_pos == std::string::npos) {
       begin_pos = node->begin_pos;
@@ -1905,9 +2067,10 @@ void ImmutableConverterImpl::InsertCandidates(
       continue;
     }
 
-    Segment *segment =
+    segment =
         GetInsertTargetSegment(lattice, group, type, begin_pos, node, segments);
     CHECK(segment);
+    ++num_target_segments;
 
     NBestGenerator::BoundaryCheckMode mode = NBestGenerator::STRICT;
     if (type == SINGLE_SEGMENT) {
@@ -1917,11 +2080,17 @@ void ImmutableConverterImpl::InsertCandidates(
       // Boundary is specified. Skip boundary check in nbest generator.
       mode = NBestGenerator::ONLY_MID;
     }
-    nbest_generator.Reset(prev, node->next, mode);
-    nbest_generator.SetCandidates(request, original_key, expand_size, segment);
-
+    nbest_generator->Reset(prev, node->next, mode);
     if (type == MULTI_SEGMENTS || type == SINGLE_SEGMENT) {
-      InsertDummyCandidates(segment, expand_size);
+      nbest_candidates_size = ExpandCandidates(request, original_key,
+                                               nbest_generator, segment,
+                                               expand_size);
+    } else {
+      nbest_generator->SetCandidates(request, original_key, expand_size,
+                                     segment);
+    }
+    if (nbest_generator->truncated()) {
+      segments->set_truncated(true);
     }
 
     if (node->node_type == Node::CON_NODE) {
@@ -1934,6 +2103,56 @@ void ImmutableConverterImpl::InsertCandidates(
     begin_pos = std::string::npos;
     prev = node;
   }
+
+  if (keep_generator && num_target_segments == 1) {
+    auto state = std::make_unique<NBestGeneratorState>();
+    state->generator = std::move(kept_generator);
+    state->original_key = std::move(original_key);
+    state->segment = segment;
+    state->nbest_candidates_size = nbest_candidates_size;
+    segments->set_candidate_generator_state(std::move(state));
+  }
+}
+
+size_t ImmutableConverterImpl::ExpandCandidates(
+    const ConversionRequest &request, const std::string &original_key,
+    NBestGenerator *nbest, Segment *segment, size_t expand_size) const {
+  nbest->SetCandidates(request, original_key, expand_size, segment);
+  const size_t nbest_candidates_size = segment->candidates_size();
+  InsertDummyCandidates(segment, expand_size);
+  return nbest_candidates_size;
+}
+
+bool ImmutableConverterImpl::ExpandCandidatesForRequest(
+    const ConversionRequest &request, Segments *segments) const {
+  // Only this class sets the state.
+  NBestGeneratorState *state = static_cast<NBestGeneratorState *>(
+      segments->mutable_candidate_generator_state());
+  if (state == nullptr || segments->conversion_segments_size() != 1) {
+    return false;
+  }
+  Segment *segment = segments->mutable_conversion_segment(0);
+  if (segment != state->segment || segment->key() != state->original_key ||
+      segment->candidates_size() < state->nbest_candidates_size) {
+    return false;
+  }
+
+  const size_t expand_size =
+      GetExpandSize(request.max_conversion_candidates_size());
+  if (expand_size <= state->nbest_candidates_size) {
+    return true;
+  }
+  // Erase the dummy candidates, which are inserted again after the new ones.
+  segment->erase_candidates(
+      state->nbest_candidates_size,
+      segment->candidates_size() - state->nbest_candidates_size);
+  state->nbest_candidates_size =
+      ExpandCandidates(request, state->original_key, state->generator.get(),
+                       segment, expand_size);
+  if (state->generator->truncated()) {
+    segments->set_truncated(true);
+  }
+  return true;
 }
 
 bool ImmutableConverterImpl::MakeSegments(const ConversionRequest &request,
@@ -2050,8 +2269,13 @@ bool ImmutableConverterImpl::ConvertForRequest(const ConversionRequest &request,
   const bool is_prediction =
       (request.request_type() == ConversionRequest::PREDICTION ||
        request.request_type() == ConversionRequest::SUGGESTION);
+  const bool is_reverse =
+      (request.request_type() == ConversionRequest::REVERSE_CONVERSION);
 
-  Lattice *lattice = GetLattice(segments, is_prediction);
+  // The generator kept by the last conversion refers to the lattice, which
+  // is reset or updated below.
+  segments->set_candidate_generator_state(nullptr);
+  Lattice *lattice = GetLattice(segments, is_reverse);
 
   if (!MakeLattice(request, segments, lattice)) {
     LOG(WARNING) << "could not make lattice";
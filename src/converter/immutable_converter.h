@@ -30,6 +30,7 @@
 #ifndef MOZC_CONVERTER_IMMUTABLE_CONVERTER_H_
 #define MOZC_CONVERTER_IMMUTABLE_CONVERTER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -44,6 +45,7 @@
 #include "dictionary/pos_matcher.h"
 #include "dictionary/suppression_dictionary.h"
 #include "absl/base/attributes.h"
+#include "absl/types/span.h"
 //  for FRIEND_TEST()
 #include "testing/gunit_prod.h"
 
@@ -73,6 +75,12 @@ class ImmutableConverterImpl : public ImmutableConverterInterface {
   ABSL_MUST_USE_RESULT bool ConvertForRequest(
       const ConversionRequest &request, Segments *segments) const override;
 
+  // Resumes the N-best search of the last realtime conversion, i.e.,
+  // prediction or suggestion into a single segment without partial
+  // candidates, which was requested with keep_candidate_generator_state().
+  ABSL_MUST_USE_RESULT bool ExpandCandidatesForRequest(
+      const ConversionRequest &request, Segments *segments) const override;
+
  private:
   FRIEND_TEST(ImmutableConverterTest, AddPredictiveNodes);
   FRIEND_TEST(ImmutableConverterTest, DummyCandidatesCost);
@@ -81,7 +89,9 @@ class ImmutableConverterImpl : public ImmutableConverterInterface {
   FRIEND_TEST(ImmutableConverterTest, PredictiveNodesOnlyForConversionKey);
   FRIEND_TEST(NBestGeneratorTest, InnerSegmentBoundary);
   FRIEND_TEST(NBestGeneratorTest, MultiSegmentConnectionTest);
+  FRIEND_TEST(NBestGeneratorTest, ResumesEnumeration);
   FRIEND_TEST(NBestGeneratorTest, SingleSegmentConnectionTest);
+  FRIEND_TEST(NBestGeneratorTest, StopsExpandingAfterDeadline);
   friend class NBestGeneratorTest;
 
   enum InsertCandidatesType {
@@ -99,13 +109,27 @@ class ImmutableConverterImpl : public ImmutableConverterInterface {
     MOBILE,
   };
 
-  void ExpandCandidates(const ConversionRequest &request,
-                        const std::string &original_key, NBestGenerator *nbest,
-                        Segment *segment, size_t expand_size) const;
+  // Enumerates the candidates of |segment| with |nbest| up to |expand_size|,
+  // followed by the dummy candidates. Returns the number of the candidates
+  // from |nbest|.
+  size_t ExpandCandidates(const ConversionRequest &request,
+                          const std::string &original_key,
+                          NBestGenerator *nbest, Segment *segment,
+                          size_t expand_size) const;
   void InsertDummyCandidates(Segment *segment, size_t expand_size) const;
+  // If |use_cache| is true, only the keys longer than the cache info of
+  // |begin_pos| are looked up, and the dictionary nodes are kept in |lattice|
+  // for the next request with the same key prefix.
   Node *Lookup(const int begin_pos, const int end_pos,
                const ConversionRequest &request, bool is_reverse,
-               bool is_prediction, Lattice *lattice) const;
+               bool use_cache, Lattice *lattice) const;
+  // Same as Lookup() without reverse conversion for each of
+  // |begin_positions|, but looks up the dictionary for all the positions at
+  // once.  Unlike Lookup(), the cache info of |lattice| is not updated, as
+  // the caller may discard some of |results|.
+  void LookupBatch(absl::Span<const size_t> begin_positions, int end_pos,
+                   const ConversionRequest &request, bool use_cache,
+                   Lattice *lattice, std::vector<Node *> *results) const;
   Node *AddCharacterTypeBasedNodes(const char *begin, const char *end,
                                    Lattice *lattice, Node *nodes) const;
 
@@ -49,4 +49,9 @@ bool ImmutableConverterInterface::ConvertForRequest(
   return false;
 }
 
+bool ImmutableConverterInterface::ExpandCandidatesForRequest(
+    const ConversionRequest &request, Segments *segments) const {
+  return false;
+}
+
 }  // namespace mozc
@@ -56,6 +56,14 @@ class ImmutableConverterInterface {
   ABSL_MUST_USE_RESULT virtual bool ConvertForRequest(
       const ConversionRequest &request, Segments *segments) const;
 
+  // Expands the candidates of the last ConvertForRequest() on |segments| up
+  // to the max_conversion_candidates_size() of |request| by resuming its
+  // search. Returns false if the conversion didn't keep the state to resume,
+  // in which case the caller should convert |segments| again. The state is
+  // kept only if ConversionRequest::keep_candidate_generator_state() is set.
+  ABSL_MUST_USE_RESULT virtual bool ExpandCandidatesForRequest(
+      const ConversionRequest &request, Segments *segments) const;
+
  protected:
   ImmutableConverterInterface() {}
 };
@@ -383,6 +383,98 @@ TEST(ImmutableConverterTest, NoInnerSegmenBoundaryForConversion) {
   }
 }
 
+TEST(ImmutableConverterTest, ReuseLatticeForConversion) {
+  std::unique_ptr<MockDataAndImmutableConverter> data_and_converter(
+      new MockDataAndImmutableConverter);
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+  const std::string kRequestKey = "わたしのなまえはなかのです";
+
+  const auto get_result = [](const Segments &segments) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < segments.segments_size(); ++i) {
+      result.push_back(segments.segment(i).key());
+      result.push_back(segments.segment(i).candidate(0).value);
+    }
+    return result;
+  };
+
+  Segments fresh_segments;
+  fresh_segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->Convert(&fresh_segments));
+
+  // The nodes looked up for the first conversion are kept in the lattice, and
+  // the second conversion of the same key gives the same result.
+  Segments segments;
+  segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->Convert(&segments));
+  EXPECT_EQ(segments.mutable_cached_lattice()->cache_info(0),
+            kRequestKey.size());
+
+  segments.clear_segments();
+  segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->Convert(&segments));
+  EXPECT_EQ(get_result(segments), get_result(fresh_segments));
+}
+
+TEST(ImmutableConverterTest, ExpandCandidatesForRequest) {
+  std::unique_ptr<MockDataAndImmutableConverter> data_and_converter(
+      new MockDataAndImmutableConverter);
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+  const std::string kRequestKey = "わたしのなまえはなかのです";
+
+  const auto get_values = [](const Segments &segments) {
+    std::vector<std::string> values;
+    for (size_t i = 0; i < segments.segment(0).candidates_size(); ++i) {
+      values.push_back(segments.segment(0).candidate(i).value);
+    }
+    return values;
+  };
+
+  ConversionRequest request;
+  request.set_request_type(ConversionRequest::PREDICTION);
+  request.set_max_conversion_candidates_size(20);
+  Segments expected_segments;
+  expected_segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->ConvertForRequest(request, &expected_segments));
+
+  // The state is not kept unless the request asks for it.
+  request.set_max_conversion_candidates_size(3);
+  Segments segments;
+  segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->ConvertForRequest(request, &segments));
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+  request.set_max_conversion_candidates_size(20);
+  EXPECT_FALSE(converter->ExpandCandidatesForRequest(request, &segments));
+
+  // Expanding the result of a smaller request gives the same candidates.
+  request.set_keep_candidate_generator_state(true);
+  request.set_max_conversion_candidates_size(3);
+  segments.clear_segments();
+  segments.add_segment()->set_key(kRequestKey);
+  ASSERT_TRUE(converter->ConvertForRequest(request, &segments));
+  EXPECT_LT(segments.segment(0).candidates_size(),
+            expected_segments.segment(0).candidates_size());
+  request.set_max_conversion_candidates_size(20);
+  ASSERT_TRUE(converter->ExpandCandidatesForRequest(request, &segments));
+  EXPECT_EQ(get_values(segments), get_values(expected_segments));
+
+  // The state is not used once the key of the segment is changed.
+  segments.mutable_segment(0)->set_key("わたしの");
+  EXPECT_FALSE(converter->ExpandCandidatesForRequest(request, &segments));
+
+  // The state is dropped when the segments are cleared.
+  segments.clear_segments();
+  segments.add_segment()->set_key(kRequestKey);
+  EXPECT_FALSE(converter->ExpandCandidatesForRequest(request, &segments));
+
+  // Conversion into multiple segments cannot be expanded.
+  request.set_request_type(ConversionRequest::CONVERSION);
+  request.set_max_conversion_candidates_size(3);
+  ASSERT_TRUE(converter->ConvertForRequest(request, &segments));
+  request.set_max_conversion_candidates_size(20);
+  EXPECT_FALSE(converter->ExpandCandidatesForRequest(request, &segments));
+}
+
 TEST(ImmutableConverterTest, NotConnectedTest) {
   std::unique_ptr<MockDataAndImmutableConverter> data_and_converter(
       new MockDataAndImmutableConverter);
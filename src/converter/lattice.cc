@@ -342,60 +342,34 @@ void Lattice::SetCacheInfo(const size_t pos, const size_t len) {
 }
 
 void Lattice::ResetNodeCost() {
+  // If a node has ENABLE_CACHE attribute, then revert its wcost. Otherwise,
+  // erase the node from the lattice.  BOS / EOS nodes are kept as they are.
+  const auto is_kept = [](Node *node) {
+    if (node->node_type == Node::BOS_NODE ||
+        node->node_type == Node::EOS_NODE) {
+      return true;
+    }
+    if (node->attributes & Node::ENABLE_CACHE) {
+      node->wcost = node->raw_wcost;
+      return true;
+    }
+    return false;
+  };
+
   for (size_t i = 0; i <= key_.size(); ++i) {
-    if (begin_nodes_[i] != nullptr) {
-      Node *prev = nullptr;
-      for (Node *node = begin_nodes_[i]; node != nullptr; node = node->bnext) {
-        // do not process BOS / EOS nodes
-        if (node->node_type == Node::BOS_NODE ||
-            node->node_type == Node::EOS_NODE) {
-          continue;
-        }
-        // if the node has ENABLE_CACHE attribute, then revert its wcost.
-        // Otherwise, erase the node from the lattice.
-        if (node->attributes & Node::ENABLE_CACHE) {
-          node->wcost = node->raw_wcost;
-        } else {
-          if (node == begin_nodes_[i]) {
-            if (node->bnext == nullptr) {
-              begin_nodes_[i] = nullptr;
-            } else {
-              begin_nodes_[i] = node->bnext;
-            }
-          } else {
-            CHECK(prev);
-            CHECK_EQ(prev->bnext, node);
-            prev->next = node->bnext;
-          }
-        }
-        // traverse a next node
-        prev = node;
+    // |link| points to the bnext (enext) field of the last kept node.
+    for (Node **link = &begin_nodes_[i]; *link != nullptr;) {
+      if (is_kept(*link)) {
+        link = &(*link)->bnext;
+      } else {
+        *link = (*link)->bnext;
       }
     }
-
-    if (end_nodes_[i] != nullptr) {
-      Node *prev = nullptr;
-      for (Node *node = end_nodes_[i]; node != nullptr; node = node->enext) {
-        if (node->node_type == Node::BOS_NODE ||
-            node->node_type == Node::EOS_NODE) {
-          continue;
-        }
-        if (node->attributes & Node::ENABLE_CACHE) {
-          node->wcost = node->raw_wcost;
-        } else {
-          if (node == end_nodes_[i]) {
-            if (node->enext == nullptr) {
-              end_nodes_[i] = nullptr;
-            } else {
-              end_nodes_[i] = node->enext;
-            }
-          } else {
-            CHECK(prev);
-            CHECK_EQ(prev->enext, node);
-            prev->next = node->enext;
-          }
-        }
-        prev = node;
+    for (Node **link = &end_nodes_[i]; *link != nullptr;) {
+      if (is_kept(*link)) {
+        link = &(*link)->enext;
+      } else {
+        *link = (*link)->enext;
       }
     }
   }
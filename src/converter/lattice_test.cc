@@ -31,6 +31,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/port.h"
 #include "converter/node.h"
@@ -222,4 +223,48 @@ TEST(LatticeTest, ShrinkKeyTest) {
     }
   }
 }
+
+TEST(LatticeTest, ResetNodeCostTest) {
+  Lattice lattice;
+  lattice.SetKey("abc");
+
+  // Cached and non-cached nodes are interleaved in both of begin_nodes(0)
+  // and end_nodes(2).
+  std::vector<Node *> nodes;
+  for (int i = 0; i < 4; ++i) {
+    Node *node = lattice.NewNode();
+    node->key = "ab";
+    node->wcost = 100 + i;
+    node->raw_wcost = i;
+    if (i % 2 == 0) {
+      node->attributes |= Node::ENABLE_CACHE;
+    }
+    lattice.Insert(0, node);
+    nodes.push_back(node);
+  }
+
+  lattice.ResetNodeCost();
+
+  std::vector<Node *> begin_nodes;
+  for (Node *node = lattice.begin_nodes(0); node != nullptr;
+       node = node->bnext) {
+    begin_nodes.push_back(node);
+  }
+  EXPECT_EQ(begin_nodes, (std::vector<Node *>{nodes[2], nodes[0]}));
+
+  std::vector<Node *> end_nodes;
+  for (Node *node = lattice.end_nodes(2); node != nullptr;
+       node = node->enext) {
+    end_nodes.push_back(node);
+  }
+  EXPECT_EQ(end_nodes, (std::vector<Node *>{nodes[2], nodes[0]}));
+
+  EXPECT_EQ(nodes[0]->wcost, 0);
+  EXPECT_EQ(nodes[2]->wcost, 2);
+
+  // BOS and EOS nodes are kept.
+  EXPECT_NE(lattice.bos_nodes(), nullptr);
+  EXPECT_NE(lattice.eos_nodes(), nullptr);
+}
+
 }  // namespace mozc
@@ -125,6 +125,8 @@ void NBestGenerator::Reset(const Node *begin_node, const Node *end_node,
   top_nodes_.clear();
   filter_->Reset();
   viterbi_result_checked_ = false;
+  truncated_ = false;
+  exhausted_ = false;
   check_mode_ = mode;
 
   begin_node_ = begin_node;
@@ -265,7 +267,12 @@ void NBestGenerator::SetCandidates(const ConversionRequest &request,
     return;
   }
 
-  while (segment->candidates_size() < expand_size) {
+  truncated_ = false;
+  while (!exhausted_ && segment->candidates_size() < expand_size) {
+    if (segment->candidates_size() > 0 && request.IsDeadlineExceeded()) {
+      truncated_ = true;
+      break;
+    }
     Segment::Candidate *candidate = segment->push_back_candidate();
     DCHECK(candidate);
     candidate->Init();
@@ -273,6 +280,7 @@ void NBestGenerator::SetCandidates(const ConversionRequest &request,
     // if Next() returns false, no more entries are generated.
     if (!Next(request, original_key, candidate)) {
       segment->pop_back_candidate();
+      exhausted_ = true;
       break;
     }
   }
@@ -96,11 +96,19 @@ class NBestGenerator {
   void Reset(const Node *begin_node, const Node *end_node,
              BoundaryCheckMode mode);
 
-  // Set candidates.
+  // Set candidates. Once the deadline of |request| has passed, stops
+  // expanding as soon as |segment| has at least one candidate.
+  // Calling this again for the same |segment| with a larger |expand_size|
+  // without Reset() resumes the enumeration: the agenda and the filter are
+  // kept, so only the additional candidates are searched.
   void SetCandidates(const ConversionRequest &request,
                      const std::string &original_key, size_t expand_size,
                      Segment *segment);
 
+  // Returns true if the last SetCandidates() stopped early because the
+  // deadline of the request had passed.
+  bool truncated() const { return truncated_; }
+
  private:
   enum BoundaryCheckResult {
     VALID = 0,
@@ -189,6 +197,8 @@ class NBestGenerator {
   std::vector<const Node *> top_nodes_;
   std::unique_ptr<converter::CandidateFilter> filter_;
   bool viterbi_result_checked_ = false;
+  bool truncated_ = false;
+  bool exhausted_ = false;
   BoundaryCheckMode check_mode_ = STRICT;
 
 #ifdef MOZC_CANDIDATE_DEBUG
@@ -56,6 +56,7 @@
 #include "testing/googletest.h"
 #include "testing/gunit.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace {
@@ -272,6 +273,103 @@ TEST_F(NBestGeneratorTest, SingleSegmentConnectionTest) {
   }
 }
 
+TEST_F(NBestGeneratorTest, StopsExpandingAfterDeadline) {
+  auto data_and_converter = std::make_unique<MockDataAndImmutableConverter>();
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+
+  Segments segments;
+  std::string kText = "わたしのなまえはなかのです";
+  {
+    Segment *segment = segments.add_segment();
+    segment->set_segment_type(Segment::FREE);
+    segment->set_key(kText);
+  }
+
+  Lattice lattice;
+  lattice.SetKey(kText);
+  ConversionRequest request;
+  request.set_request_type(ConversionRequest::CONVERSION);
+  converter->MakeLattice(request, &segments, &lattice);
+
+  std::vector<uint16_t> group;
+  converter->MakeGroup(segments, &group);
+  converter->Viterbi(segments, &lattice);
+
+  std::unique_ptr<NBestGenerator> nbest_generator =
+      data_and_converter->CreateNBestGenerator(&lattice);
+
+  constexpr bool kSingleSegment = true;  // For realtime conversion
+  const Node *begin_node = lattice.bos_nodes();
+  const Node *end_node = GetEndNode(request, *converter, segments, *begin_node,
+                                    group, kSingleSegment);
+  {
+    nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+    Segment result_segment;
+    nbest_generator->SetCandidates(request, "", 10, &result_segment);
+    EXPECT_LT(1, result_segment.candidates_size());
+    EXPECT_FALSE(nbest_generator->truncated());
+  }
+  {
+    // Past the deadline, only the Viterbi best result is returned.
+    request.set_deadline(absl::InfinitePast());
+    nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+    Segment result_segment;
+    nbest_generator->SetCandidates(request, "", 10, &result_segment);
+    ASSERT_EQ(result_segment.candidates_size(), 1);
+    EXPECT_EQ(result_segment.candidate(0).value, "私の名前は中ノです");
+    EXPECT_TRUE(nbest_generator->truncated());
+  }
+}
+
+TEST_F(NBestGeneratorTest, ResumesEnumeration) {
+  auto data_and_converter = std::make_unique<MockDataAndImmutableConverter>();
+  ImmutableConverterImpl *converter = data_and_converter->GetConverter();
+
+  Segments segments;
+  const std::string kText = "わたしのなまえはなかのです";
+  {
+    Segment *segment = segments.add_segment();
+    segment->set_segment_type(Segment::FREE);
+    segment->set_key(kText);
+  }
+
+  Lattice lattice;
+  lattice.SetKey(kText);
+  ConversionRequest request;
+  request.set_request_type(ConversionRequest::CONVERSION);
+  converter->MakeLattice(request, &segments, &lattice);
+
+  std::vector<uint16_t> group;
+  converter->MakeGroup(segments, &group);
+  converter->Viterbi(segments, &lattice);
+
+  std::unique_ptr<NBestGenerator> nbest_generator =
+      data_and_converter->CreateNBestGenerator(&lattice);
+
+  constexpr bool kSingleSegment = true;  // For realtime conversion
+  const Node *begin_node = lattice.bos_nodes();
+  const Node *end_node = GetEndNode(request, *converter, segments, *begin_node,
+                                    group, kSingleSegment);
+
+  Segment expected_segment;
+  nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+  nbest_generator->SetCandidates(request, "", 10, &expected_segment);
+  ASSERT_GT(expected_segment.candidates_size(), 3);
+
+  // Enumerating 3 candidates and then resuming up to 10 gives the same
+  // candidates as enumerating 10 candidates at once.
+  Segment segment;
+  nbest_generator->Reset(begin_node, end_node, NBestGenerator::ONLY_EDGE);
+  nbest_generator->SetCandidates(request, "", 3, &segment);
+  EXPECT_EQ(segment.candidates_size(), 3);
+  nbest_generator->SetCandidates(request, "", 10, &segment);
+  ASSERT_EQ(segment.candidates_size(), expected_segment.candidates_size());
+  for (size_t i = 0; i < segment.candidates_size(); ++i) {
+    EXPECT_EQ(segment.candidate(i).value, expected_segment.candidate(i).value);
+    EXPECT_EQ(segment.candidate(i).cost, expected_segment.candidate(i).cost);
+  }
+}
+
 TEST_F(NBestGeneratorTest, InnerSegmentBoundary) {
   auto data_and_converter = std::make_unique<MockDataAndImmutableConverter>();
   ImmutableConverterImpl *converter = data_and_converter->GetConverter();
@@ -30,6 +30,9 @@
 #ifndef MOZC_CONVERTER_NODE_ALLOCATOR_H_
 #define MOZC_CONVERTER_NODE_ALLOCATOR_H_
 
+#include <atomic>
+#include <cstddef>
+
 #include "base/container/freelist.h"
 #include "base/logging.h"
 #include "base/port.h"
@@ -43,7 +46,7 @@ class NodeAllocator {
       : node_freelist_(1024), max_nodes_size_(8192), node_count_(0) {}
   NodeAllocator(const NodeAllocator &) = delete;
   NodeAllocator &operator=(const NodeAllocator &) = delete;
-  ~NodeAllocator() {}
+  ~NodeAllocator() { UpdatePeakNodeCount(); }
 
   Node *NewNode() {
     Node *node = node_freelist_.Alloc();
@@ -53,9 +56,13 @@ class NodeAllocator {
     return node;
   }
 
-  // Frees all nodes allocateed by NewNode().
+  // Frees all nodes allocateed by NewNode(). Up to max_nodes_size() nodes are
+  // kept for the next lattice so that their strings reuse the buffers
+  // allocated for the previous one.
   void Free() {
-    node_freelist_.Free();
+    UpdatePeakNodeCount();
+    const size_t chunk_size = node_freelist_.size();
+    node_freelist_.Free((max_nodes_size_ + chunk_size - 1) / chunk_size);
     node_count_ = 0;
   }
 
@@ -67,7 +74,27 @@ class NodeAllocator {
 
   size_t node_count() const { return node_count_; }
 
+  // Returns the largest number of nodes held by a NodeAllocator at once in
+  // this process. The count is updated when the nodes are freed.
+  static size_t peak_node_count() {
+    return PeakNodeCount().load(std::memory_order_relaxed);
+  }
+
  private:
+  static std::atomic<size_t> &PeakNodeCount() {
+    static std::atomic<size_t> peak_node_count(0);
+    return peak_node_count;
+  }
+
+  void UpdatePeakNodeCount() const {
+    std::atomic<size_t> &peak = PeakNodeCount();
+    size_t current = peak.load(std::memory_order_relaxed);
+    while (node_count_ > current &&
+           !peak.compare_exchange_weak(current, node_count_,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
   FreeList<Node> node_freelist_;
   size_t max_nodes_size_;
   size_t node_count_;
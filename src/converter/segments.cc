@@ -75,6 +75,7 @@ void Segment::Candidate::Init() {
   prefix.clear();
   suffix.clear();
   description.clear();
+  a11y_description.clear();
   usage_title.clear();
   usage_description.clear();
   cost = 0;
@@ -209,8 +210,12 @@ absl::string_view Segment::Candidate::InnerSegmentIterator::GetContentValue()
 }
 
 constexpr int kCandidatesPoolSize = 16;
+// The max number of the released candidates kept for reuse per segment. More
+// candidates are only needed for the conversion, and keeping them would hold
+// too much memory for the segments recycled by Segments.
+constexpr size_t kMaxFreeCandidatesSize = 64;
 
-Segment::Segment() : segment_type_(FREE), pool_(kCandidatesPoolSize) {}
+Segment::Segment() : segment_type_(FREE) { pool_.reserve(kCandidatesPoolSize); }
 
 Segment::Segment(const Segment &x)
     : removed_candidates_for_debug_(x.removed_candidates_for_debug_),
@@ -273,21 +278,37 @@ Segment::Candidate *Segment::mutable_candidate(int i) {
 size_t Segment::candidates_size() const { return candidates_.size(); }
 
 void Segment::clear_candidates() {
+  for (std::unique_ptr<Candidate> &candidate : pool_) {
+    if (free_candidates_.size() >= kMaxFreeCandidatesSize) {
+      break;
+    }
+    if (candidate != nullptr) {
+      free_candidates_.push_back(std::move(candidate));
+    }
+  }
   pool_.clear();
   candidates_.clear();
 }
 
-Segment::Candidate *Segment::push_back_candidate() {
+Segment::Candidate *Segment::NewCandidate() {
+  if (free_candidates_.empty()) {
+    return pool_.emplace_back(std::make_unique<Candidate>()).get();
+  }
   Candidate *candidate =
-      pool_.emplace_back(std::make_unique<Candidate>()).get();
+      pool_.emplace_back(std::move(free_candidates_.back())).get();
+  free_candidates_.pop_back();
+  return candidate;
+}
+
+Segment::Candidate *Segment::push_back_candidate() {
+  Candidate *candidate = NewCandidate();
   candidate->Init();
   candidates_.push_back(candidate);
   return candidate;
 }
 
 Segment::Candidate *Segment::push_front_candidate() {
-  Candidate *candidate =
-      pool_.emplace_back(std::make_unique<Candidate>()).get();
+  Candidate *candidate = NewCandidate();
   candidate->Init();
   candidates_.push_front(candidate);
   return candidate;
@@ -306,8 +327,7 @@ Segment::Candidate *Segment::insert_candidate(int i) {
                 << candidates_.size();
     i = static_cast<int>(candidates_.size());
   }
-  Candidate *candidate =
-      pool_.emplace_back(std::make_unique<Candidate>()).get();
+  Candidate *candidate = NewCandidate();
   candidate->Init();
   candidates_.insert(candidates_.begin() + i, candidate);
   return candidate;
@@ -477,12 +497,14 @@ std::string Segment::DebugString() const {
 Segments::Segments()
     : max_history_segments_size_(0),
       resized_(false),
+      truncated_(false),
       pool_(32),
       cached_lattice_(new Lattice()) {}
 
 Segments::Segments(const Segments &x)
     : max_history_segments_size_(x.max_history_segments_size_),
       resized_(x.resized_),
+      truncated_(x.truncated_),
       pool_(32),
       revert_entries_(x.revert_entries_),
       cached_lattice_(new Lattice()) {
@@ -500,6 +522,7 @@ Segments &Segments::operator=(const Segments &x) {
 
   max_history_segments_size_ = x.max_history_segments_size_;
   resized_ = x.resized_;
+  truncated_ = x.truncated_;
   // Deep-copy segments.
   for (const Segment *segment : x.segments_) {
     *add_segment() = *segment;
@@ -534,6 +557,7 @@ Segment *Segments::insert_segment(size_t i) {
   Segment *segment = pool_.Alloc();
   segment->Clear();
   segments_.insert(segments_.begin() + i, segment);
+  candidate_generator_state_.reset();
   return segment;
 }
 
@@ -541,6 +565,7 @@ Segment *Segments::push_back_segment() {
   Segment *segment = pool_.Alloc();
   segment->Clear();
   segments_.push_back(segment);
+  candidate_generator_state_.reset();
   return segment;
 }
 
@@ -548,6 +573,7 @@ Segment *Segments::push_front_segment() {
   Segment *segment = pool_.Alloc();
   segment->Clear();
   segments_.push_front(segment);
+  candidate_generator_state_.reset();
   return segment;
 }
 
@@ -575,6 +601,7 @@ void Segments::erase_segment(size_t i) {
   }
   pool_.Release(mutable_segment(i));
   segments_.erase(segments_.begin() + i);
+  candidate_generator_state_.reset();
 }
 
 void Segments::erase_segments(size_t i, size_t size) {
@@ -586,6 +613,7 @@ void Segments::erase_segments(size_t i, size_t size) {
     pool_.Release(mutable_segment(j));
   }
   segments_.erase(segments_.begin() + i, segments_.begin() + end);
+  candidate_generator_state_.reset();
 }
 
 void Segments::pop_front_segment() {
@@ -593,6 +621,7 @@ void Segments::pop_front_segment() {
     Segment *seg = segments_.front();
     pool_.Release(seg);
     segments_.pop_front();
+    candidate_generator_state_.reset();
   }
 }
 
@@ -601,6 +630,7 @@ void Segments::pop_back_segment() {
     Segment *seg = segments_.back();
     pool_.Release(seg);
     segments_.pop_back();
+    candidate_generator_state_.reset();
   }
 }
 
@@ -612,7 +642,9 @@ void Segments::Clear() {
 void Segments::clear_segments() {
   pool_.Free();
   resized_ = false;
+  truncated_ = false;
   segments_.clear();
+  candidate_generator_state_.reset();
 }
 
 void Segments::clear_history_segments() {
@@ -632,7 +664,9 @@ void Segments::clear_conversion_segments() {
     pool_.Release(mutable_segment(i));
   }
   resized_ = false;
+  truncated_ = false;
   segments_.resize(size);
+  candidate_generator_state_.reset();
 }
 
 size_t Segments::max_history_segments_size() const {
@@ -649,6 +683,10 @@ void Segments::set_resized(bool resized) { resized_ = resized; }
 
 bool Segments::resized() const { return resized_; }
 
+void Segments::set_truncated(bool truncated) { truncated_ = truncated; }
+
+bool Segments::truncated() const { return truncated_; }
+
 void Segments::clear_revert_entries() { revert_entries_.clear(); }
 
 size_t Segments::revert_entries_size() const { return revert_entries_.size(); }
@@ -673,6 +711,16 @@ Segments::RevertEntry *Segments::mutable_revert_entry(size_t i) {
 
 Lattice *Segments::mutable_cached_lattice() { return cached_lattice_.get(); }
 
+Segments::CandidateGeneratorState *
+Segments::mutable_candidate_generator_state() {
+  return candidate_generator_state_.get();
+}
+
+void Segments::set_candidate_generator_state(
+    std::unique_ptr<CandidateGeneratorState> state) {
+  candidate_generator_state_ = std::move(state);
+}
+
 std::string Segments::DebugString() const {
   std::stringstream os;
   os << "{" << std::endl;
@@ -378,6 +378,9 @@ class Segment final {
 
  private:
   void DeepCopyCandidates(const std::deque<Candidate *> &candidates);
+  // Returns a candidate owned by |pool_|, reusing a released one if any. The
+  // caller should initialize it.
+  Candidate *NewCandidate();
 
   // LINT.IfChange
   SegmentType segment_type_;
@@ -392,6 +395,10 @@ class Segment final {
   std::deque<Candidate *> candidates_;
   std::vector<Candidate> meta_candidates_;
   std::vector<std::unique_ptr<Candidate>> pool_;
+  // Candidates released by clear_candidates(). They are reused for the new
+  // candidates, so that copying a segment into a recycled one and refilling
+  // it while typing reuse the string buffers instead of allocating them.
+  std::vector<std::unique_ptr<Candidate>> free_candidates_;
   // LINT.ThenChange(//converter/segments_matchers.h)
 };
 
@@ -477,6 +484,11 @@ class Segments final {
   bool resized() const;
   void set_resized(bool resized);
 
+  // True if the deadline of the conversion request passed while the
+  // candidates were generated, i.e., some stages were cut short.
+  bool truncated() const;
+  void set_truncated(bool truncated);
+
   // clear segments
   void Clear();
 
@@ -497,15 +509,30 @@ class Segments final {
   // setter
   Lattice *mutable_cached_lattice();
 
+  // Opaque state of the candidate generation of the last conversion, which
+  // lets the converter expand the candidates later without searching the
+  // lattice again. It refers to the cached lattice, so it is not copied
+  // either, and it is dropped whenever segments are added, removed or cleared,
+  // as the Segment it filled may be released to the pool and reused.
+  class CandidateGeneratorState {
+   public:
+    virtual ~CandidateGeneratorState() = default;
+  };
+  CandidateGeneratorState *mutable_candidate_generator_state();
+  void set_candidate_generator_state(
+      std::unique_ptr<CandidateGeneratorState> state);
+
  private:
   // LINT.IfChange
   size_t max_history_segments_size_;
   bool resized_;
+  bool truncated_;
 
   ObjectPool<Segment> pool_;
   std::deque<Segment *> segments_;
   std::vector<RevertEntry> revert_entries_;
   std::unique_ptr<Lattice> cached_lattice_;
+  std::unique_ptr<CandidateGeneratorState> candidate_generator_state_;
   // LINT.ThenChange(//converter/segments_matchers.h)
 };
 
@@ -81,9 +81,10 @@ MATCHER_P(EqualsCandidate, candidate, "") {
 }
 
 // Checks if a segment exactly matches the given segment except for the
-// following two fields:
+// following three fields:
 //   * removed_candidates_for_debug_
 //   * pool_
+//   * free_candidates_
 // Note: this is more useful than defining operator==() in testing as it can
 // display which field is different.
 //
@@ -204,10 +205,11 @@ MATCHER_P(ContainsCandidate, matcher, "") {
 }
 
 // Checks if a segments exactly matches the given segments except for the
-// following three fields:
+// following four fields:
 //   * pool_
 //   * revert_entries_
 //   * cached_lattice_
+//   * candidate_generator_state_
 // Note: this is more useful than defining operator==() in testing as it can
 // display which field is different.
 //
@@ -222,6 +224,7 @@ MATCHER_P(EqualsSegments, segments, "") {
   }
   COMPARE_PROPERTY(max_history_segments_size);
   COMPARE_PROPERTY(resized);
+  COMPARE_PROPERTY(truncated);
 #undef COMPARE_PROPERTY
 
   const size_t common_segments_size =
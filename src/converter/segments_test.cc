@@ -381,6 +381,46 @@ TEST(SegmentsTest, CopyTest) {
   }
 }
 
+TEST(SegmentsTest, CandidateGeneratorStateIsDroppedOnSegmentChanges) {
+  Segments segments;
+  segments.add_segment()->set_key("a");
+  segments.add_segment()->set_key("b");
+  const auto set_state = [&segments]() {
+    segments.set_candidate_generator_state(
+        std::make_unique<Segments::CandidateGeneratorState>());
+    EXPECT_NE(segments.mutable_candidate_generator_state(), nullptr);
+  };
+
+  set_state();
+  segments.add_segment();
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.push_front_segment();
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.insert_segment(1);
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.erase_segment(1);
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.erase_segments(0, 2);
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.pop_front_segment();
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+
+  set_state();
+  segments.pop_back_segment();
+  EXPECT_EQ(segments.mutable_candidate_generator_state(), nullptr);
+  EXPECT_EQ(segments.segments_size(), 0);
+}
+
 TEST(CandidateTest, functional_key) {
   Segment::Candidate candidate;
   candidate.Init();
@@ -522,6 +562,33 @@ TEST(SegmentTest, Copy) {
   EXPECT_EQ(dest.meta_candidate(0).key, src.meta_candidate(0).key);
 }
 
+TEST(SegmentTest, RecycleCandidates) {
+  Segment segment;
+  Segment::Candidate *candidate = segment.add_candidate();
+  candidate->key = "key";
+  candidate->value = "value";
+  candidate->description = "description";
+  candidate->a11y_description = "a11y_description";
+  candidate->attributes = Segment::Candidate::USER_DICTIONARY;
+
+  // The released candidate is reused, and it is initialized.
+  segment.clear_candidates();
+  EXPECT_EQ(segment.add_candidate(), candidate);
+  EXPECT_TRUE(candidate->key.empty());
+  EXPECT_TRUE(candidate->value.empty());
+  EXPECT_TRUE(candidate->description.empty());
+  EXPECT_TRUE(candidate->a11y_description.empty());
+  EXPECT_EQ(candidate->attributes, 0);
+
+  // The candidates are reused on copy assignment.
+  Segment src;
+  src.add_candidate()->value = "src";
+  segment = src;
+  ASSERT_EQ(segment.candidates_size(), 1);
+  EXPECT_EQ(segment.mutable_candidate(0), candidate);
+  EXPECT_EQ(segment.candidate(0).value, "src");
+}
+
 TEST(SegmentTest, MetaCandidateTest) {
   Segment segment;
 
@@ -29,9 +29,11 @@
 
 #include "dictionary/dictionary_impl.h"
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/util.h"
@@ -41,6 +43,7 @@
 #include "dictionary/suppression_dictionary.h"
 #include "protocol/config.pb.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
@@ -170,6 +173,31 @@ void DictionaryImpl::LookupPrefix(absl::string_view key,
   }
 }
 
+void DictionaryImpl::LookupPrefixBatch(
+    absl::string_view key, absl::Span<const size_t> positions,
+    const ConversionRequest &conversion_request,
+    absl::Span<Callback *const> callbacks) const {
+  DCHECK_EQ(positions.size(), callbacks.size());
+  std::vector<CallbackWithFilter> callbacks_with_filter;
+  callbacks_with_filter.reserve(callbacks.size());
+  for (Callback *callback : callbacks) {
+    callbacks_with_filter.emplace_back(
+        conversion_request.config().use_spelling_correction(),
+        conversion_request.config().use_zip_code_conversion(),
+        conversion_request.config().use_t13n_conversion(), pos_matcher_,
+        suppression_dictionary_, callback);
+  }
+  std::vector<Callback *> callback_ptrs;
+  callback_ptrs.reserve(callbacks_with_filter.size());
+  for (CallbackWithFilter &callback_with_filter : callbacks_with_filter) {
+    callback_ptrs.push_back(&callback_with_filter);
+  }
+  for (size_t i = 0; i < dics_.size(); ++i) {
+    dics_[i]->LookupPrefixBatch(key, positions, conversion_request,
+                                callback_ptrs);
+  }
+}
+
 void DictionaryImpl::LookupExact(absl::string_view key,
                                  const ConversionRequest &conversion_request,
                                  Callback *callback) const {
@@ -225,5 +253,20 @@ void DictionaryImpl::ClearReverseLookupCache() const {
   }
 }
 
+void DictionaryImpl::CollectMemoryUsage(MemoryUsageCollector *collector) const {
+  {
+    MemoryUsageCollector::ScopedPrefix prefix(collector, "SystemDictionary");
+    system_dictionary_->CollectMemoryUsage(collector);
+  }
+  {
+    MemoryUsageCollector::ScopedPrefix prefix(collector, "ValueDictionary");
+    value_dictionary_->CollectMemoryUsage(collector);
+  }
+  {
+    MemoryUsageCollector::ScopedPrefix prefix(collector, "UserDictionary");
+    user_dictionary_->CollectMemoryUsage(collector);
+  }
+}
+
 }  // namespace dictionary
 }  // namespace mozc
@@ -30,6 +30,7 @@
 #ifndef MOZC_DICTIONARY_DICTIONARY_IMPL_H_
 #define MOZC_DICTIONARY_DICTIONARY_IMPL_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -38,6 +39,7 @@
 #include "dictionary/pos_matcher.h"
 #include "dictionary/suppression_dictionary.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
@@ -72,6 +74,10 @@ class DictionaryImpl : public DictionaryInterface {
   void LookupPrefix(absl::string_view key,
                     const ConversionRequest &conversion_request,
                     Callback *callback) const override;
+  void LookupPrefixBatch(absl::string_view key,
+                         absl::Span<const size_t> positions,
+                         const ConversionRequest &conversion_request,
+                         absl::Span<Callback *const> callbacks) const override;
 
   void LookupExact(absl::string_view key,
                    const ConversionRequest &conversion_request,
@@ -87,6 +93,7 @@ class DictionaryImpl : public DictionaryInterface {
   bool Reload() override;
   void PopulateReverseLookupCache(absl::string_view str) const override;
   void ClearReverseLookupCache() const override;
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
 
  private:
   enum LookupType {
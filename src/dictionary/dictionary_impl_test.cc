@@ -34,6 +34,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/port.h"
 #include "base/system_util.h"
@@ -238,6 +239,47 @@ TEST_F(DictionaryImplTest, WordSuppressionTest) {
   }
 }
 
+TEST_F(DictionaryImplTest, LookupPrefixBatchWithSuppression) {
+  std::unique_ptr<DictionaryData> data = CreateDictionaryData();
+  DictionaryInterface *d = data->dictionary.get();
+  SuppressionDictionary *s = data->suppression_dictionary.get();
+
+  constexpr char kKey[] = "ぐーぐる";
+  constexpr char kValue[] = "グーグル";
+  // "ぐーぐる" is a prefix at the positions 0 and 15 (5 characters).
+  constexpr char kQuery[] = "ぐーぐるのぐーぐる";
+  const std::vector<size_t> positions = {0, 3, 15};
+
+  s->Lock();
+  s->Clear();
+  s->AddEntry(kKey, kValue);
+  s->UnLock();
+  {
+    CheckKeyValueExistenceCallback callback0(kKey, kValue),
+        callback1(kKey, kValue), callback2(kKey, kValue);
+    const std::vector<DictionaryInterface::Callback *> callbacks = {
+        &callback0, &callback1, &callback2};
+    d->LookupPrefixBatch(kQuery, positions, convreq_, callbacks);
+    EXPECT_FALSE(callback0.found());
+    EXPECT_FALSE(callback1.found());
+    EXPECT_FALSE(callback2.found());
+  }
+
+  s->Lock();
+  s->Clear();
+  s->UnLock();
+  {
+    CheckKeyValueExistenceCallback callback0(kKey, kValue),
+        callback1(kKey, kValue), callback2(kKey, kValue);
+    const std::vector<DictionaryInterface::Callback *> callbacks = {
+        &callback0, &callback1, &callback2};
+    d->LookupPrefixBatch(kQuery, positions, convreq_, callbacks);
+    EXPECT_TRUE(callback0.found());
+    EXPECT_FALSE(callback1.found());
+    EXPECT_TRUE(callback2.found());
+  }
+}
+
 TEST_F(DictionaryImplTest, DisableSpellingCorrectionTest) {
   std::unique_ptr<DictionaryData> data = CreateDictionaryData();
   DictionaryInterface *d = data->dictionary.get();
@@ -30,13 +30,16 @@
 #ifndef MOZC_DICTIONARY_DICTIONARY_INTERFACE_H_
 #define MOZC_DICTIONARY_DICTIONARY_INTERFACE_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "base/memory_usage.h"
 #include "base/port.h"
 #include "dictionary/dictionary_token.h"
 #include "request/conversion_request.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
@@ -129,6 +132,23 @@ class DictionaryInterface {
                             const ConversionRequest &conversion_request,
                             Callback *callback) const = 0;
 
+  // Runs LookupPrefix() for the suffixes of the key starting at each of
+  // `positions`, which are byte offsets at character boundaries in ascending
+  // order.  `callbacks[i]` receives the results for `positions[i]`, exactly as
+  // LookupPrefix(key.substr(positions[i]), ...) would call it.  Implementations
+  // can share the work among the positions, e.g., locking, key encoding and
+  // decoded tokens for the keys found at several positions.
+  // (e.g. key = "abc", positions = {0, 1} -> {"a": "A", "ab": "AB"} to
+  // callbacks[0] and {"b": "B", "bc": "BC"} to callbacks[1])
+  virtual void LookupPrefixBatch(absl::string_view key,
+                                 absl::Span<const size_t> positions,
+                                 const ConversionRequest &conversion_request,
+                                 absl::Span<Callback *const> callbacks) const {
+    for (size_t i = 0; i < positions.size() && i < callbacks.size(); ++i) {
+      LookupPrefix(key.substr(positions[i]), conversion_request, callbacks[i]);
+    }
+  }
+
   // Looks up values whose keys are same with the key.
   // (e.g. key = "abc" -> {"abc": "ABC"})
   virtual void LookupExact(absl::string_view key,
@@ -162,6 +182,9 @@ class DictionaryInterface {
   // Reload dictionary data from local disk.
   virtual bool Reload() { return true; }
 
+  // Reports the memory used by this dictionary to |collector|.
+  virtual void CollectMemoryUsage(MemoryUsageCollector *collector) const {}
+
  protected:
   // Do not allow instantiation
   DictionaryInterface() = default;
@@ -30,8 +30,8 @@
 #include "dictionary/suppression_dictionary.h"
 
 #include <atomic>
+#include <memory>
 #include <string>
-#include <thread>  // NOLINT for portability
 
 #include "base/logging.h"
 #include "absl/strings/str_cat.h"
@@ -44,16 +44,17 @@ namespace {
 
 constexpr absl::string_view kDelimiter = "\t";
 
-class Unlocker final {
- public:
-  explicit Unlocker(std::atomic<bool> *locked) : locked_{locked} {}
-  ~Unlocker() { locked_->store(false, std::memory_order_release); }
+}  // namespace
 
- private:
-  std::atomic<bool> *locked_;
-};
+SuppressionDictionary::SuppressionDictionary()
+    : entries_(std::make_shared<const Entries>()) {}
 
-}  // namespace
+SuppressionDictionary::Entries *SuppressionDictionary::MutablePendingEntries() {
+  if (!pending_) {
+    pending_ = std::make_unique<Entries>(*std::atomic_load(&entries_));
+  }
+  return pending_.get();
+}
 
 bool SuppressionDictionary::AddEntry(const absl::string_view key,
                                      const absl::string_view value) {
@@ -67,15 +68,16 @@ bool SuppressionDictionary::AddEntry(const absl::string_view key,
     return false;
   }
 
+  Entries *entries = MutablePendingEntries();
   if (key.empty()) {
-    has_key_empty_ = true;
+    entries->has_key_empty = true;
   }
 
   if (value.empty()) {
-    has_value_empty_ = true;
+    entries->has_value_empty = true;
   }
 
-  dic_.insert(absl::StrCat(key, kDelimiter, value));
+  entries->dic.insert(absl::StrCat(key, kDelimiter, value));
 
   return true;
 }
@@ -85,74 +87,60 @@ void SuppressionDictionary::Clear() {
     LOG(ERROR) << "Dictionary is not locked";
     return;
   }
-  has_key_empty_ = false;
-  has_value_empty_ = false;
-  dic_.clear();
+  // No need to copy the published snapshot just to clear it.
+  pending_ = std::make_unique<Entries>();
 }
 
 void SuppressionDictionary::Lock() {
-  absl::MutexLock l(&mutex_);  // TODO(noriyukit): Check if we need this lock.
-  for (;;) {
-    bool expected = false;
-    if (locked_.compare_exchange_weak(expected, true, std::memory_order_acquire,
-                                      std::memory_order_relaxed)) {
-      return;
-    }
-    std::this_thread::yield();
-  }
+  mutex_.Lock();
+  DCHECK(!pending_);
+  locked_.store(true, std::memory_order_relaxed);
 }
 
 void SuppressionDictionary::UnLock() {
-  absl::MutexLock l(&mutex_);  // TODO(noriyukit): Check if we need this lock.
-  bool expected = true;
-  if (!locked_.compare_exchange_weak(expected, false, std::memory_order_release,
-                                     std::memory_order_relaxed)) {
+  if (!locked_.load(std::memory_order_relaxed)) {
     LOG(DFATAL) << "The dictionary was not locked";
+    return;
+  }
+  if (pending_) {
+    std::shared_ptr<const Entries> entries = std::move(pending_);
+    std::atomic_store(&entries_, std::move(entries));
   }
+  locked_.store(false, std::memory_order_relaxed);
+  mutex_.Unlock();
 }
 
 bool SuppressionDictionary::IsEmpty() const {
-  bool expected = false;
-  if (!locked_.compare_exchange_weak(expected, true, std::memory_order_acquire,
-                                     std::memory_order_relaxed)) {
-    VLOG(2) << "Dictionary is locked now";
-    return true;
-  }
-  Unlocker u(&locked_);
-  return dic_.empty();
+  return std::atomic_load(&entries_)->dic.empty();
 }
 
 bool SuppressionDictionary::SuppressEntry(const absl::string_view key,
                                           const absl::string_view value) const {
-  bool expected = false;
-  if (!locked_.compare_exchange_weak(expected, true, std::memory_order_acquire,
-                                     std::memory_order_relaxed)) {
-    VLOG(2) << "Dictionary is locked now";
-    return false;
-  }
-  Unlocker u(&locked_);
+  // Holding the snapshot keeps it alive even if UnLock() replaces it meanwhile.
+  const std::shared_ptr<const Entries> entries = std::atomic_load(&entries_);
+  const absl::flat_hash_set<std::string> &dic = entries->dic;
 
-  if (dic_.empty()) {
+  if (dic.empty()) {
     // Almost all users don't use word suppression function.
     // We can return false as early as possible.
     return false;
   }
 
   std::string lookup_key(absl::StrCat(key, kDelimiter, value));
-  if (dic_.find(lookup_key) != dic_.end()) {
+  if (dic.find(lookup_key) != dic.end()) {
     return true;
   }
 
-  if (has_key_empty_) {
+  if (entries->has_key_empty) {
     lookup_key = absl::StrCat(kDelimiter, value);
-    if (dic_.find(lookup_key) != dic_.end()) {
+    if (dic.find(lookup_key) != dic.end()) {
       return true;
     }
   }
 
-  if (has_value_empty_) {
+  if (entries->has_value_empty) {
     lookup_key = absl::StrCat(key, kDelimiter);
-    if (dic_.find(lookup_key) != dic_.end()) {
+    if (dic.find(lookup_key) != dic.end()) {
       return true;
     }
   }
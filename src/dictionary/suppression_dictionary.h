@@ -31,7 +31,7 @@
 #define MOZC_DICTIONARY_SUPPRESSION_DICTIONARY_H_
 
 #include <atomic>
-#include <set>
+#include <memory>
 #include <string>
 
 #include "absl/container/flat_hash_set.h"
@@ -42,13 +42,14 @@ namespace mozc {
 namespace dictionary {
 
 // Provides a functionality to test if a word should be suppressed in conversion
-// results. This class is not thread safe in general use but is safe under
-// single-producer single-consumer model, provided that the usage is correct. In
-// our usage, the producer is UserDictionary::UserDictionaryReloader thread and
-// the consumer is the main converter thread.
+// results. The contents are published as immutable snapshots: the producer
+// (UserDictionary::UserDictionaryReloader thread) builds a new snapshot between
+// Lock() and UnLock(), and the consumers (converter threads) keep reading the
+// previously published one until UnLock() swaps it in atomically. Consumers
+// never wait for the producer.
 class SuppressionDictionary final {
  public:
-  SuppressionDictionary() = default;
+  SuppressionDictionary();
   SuppressionDictionary(const SuppressionDictionary &) = delete;
   SuppressionDictionary &operator=(const SuppressionDictionary &) = delete;
 
@@ -58,13 +59,13 @@ class SuppressionDictionary final {
   // Calls of AddEntry() and/or Clear()
   // Unlock();
   //
-  // The producer thread must not call the other methods.
+  // Edits are invisible to the consumers until UnLock() is called.
 
   // Locks the dictionary (the producer thread is blocked until it gets the
   // lock). Should not be called recursively.
   void Lock();
 
-  // Unlocks the dictionary.
+  // Publishes the edits made since Lock() and unlocks the dictionary.
   void UnLock();
 
   // Adds an entry into the dictionary.
@@ -76,9 +77,8 @@ class SuppressionDictionary final {
   // Returns true if the dictionary is locked. This method is for debugging.
   bool IsLocked() const { return locked_.load(std::memory_order_relaxed); }
 
-  // Methods for the consumer thread. If the producer thread is updating the
-  // dictionary contents, the following methods behave as if the dictionary is
-  // empty.
+  // Methods for the consumer threads. They see the most recently published
+  // contents, even while the producer is editing the dictionary.
 
   // Returns true if SuppressionDictionary doesn't have any entries.
   bool IsEmpty() const;
@@ -87,11 +87,25 @@ class SuppressionDictionary final {
   bool SuppressEntry(absl::string_view key, absl::string_view value) const;
 
  private:
-  absl::flat_hash_set<std::string> dic_;
-  bool has_key_empty_ = false;
-  bool has_value_empty_ = false;
-  mutable std::atomic<bool> locked_ = false;
-  // TODO(noriyukit): Check if this mutex is still necessary.
+  struct Entries {
+    absl::flat_hash_set<std::string> dic;
+    bool has_key_empty = false;
+    bool has_value_empty = false;
+  };
+
+  // Returns the entries being edited, creating them from the published
+  // snapshot on the first edit after Lock().
+  Entries *MutablePendingEntries();
+
+  // The published snapshot. Always accessed via std::atomic_load() and
+  // std::atomic_store() so that UnLock() can replace it while consumers hold
+  // the previous one.
+  std::shared_ptr<const Entries> entries_;
+  // Edited entries between Lock() and UnLock(). Only touched by the producer
+  // holding `mutex_`.
+  std::unique_ptr<Entries> pending_;
+  std::atomic<bool> locked_ = false;
+  // Serializes producers.
   absl::Mutex mutex_;
 };
 
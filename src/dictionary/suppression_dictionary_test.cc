@@ -54,7 +54,7 @@ TEST(SuppressionDictionary, BasicTest) {
     // Not locked
     EXPECT_FALSE(dic.AddEntry("test", "test"));
 
-    // IsEmpty() returns always true when dic is locked
+    // Entries added under the lock are not visible until it is released.
     {
       const SuppressionDictionaryLock l(&dic);
       EXPECT_TRUE(dic.IsEmpty());
@@ -74,10 +74,19 @@ TEST(SuppressionDictionary, BasicTest) {
     // Not locked
     EXPECT_FALSE(dic.AddEntry("test", "test"));
 
-    // locked now => SuppressEntry always returns false
+    // The published entries stay visible while the dictionary is locked.
     {
       const SuppressionDictionaryLock l(&dic);
-      EXPECT_FALSE(dic.SuppressEntry("key1", "value1"));
+      EXPECT_TRUE(dic.SuppressEntry("key1", "value1"));
+      dic.Clear();
+      EXPECT_TRUE(dic.SuppressEntry("key1", "value1"));
+      EXPECT_TRUE(dic.AddEntry("key1", "value1"));
+      EXPECT_TRUE(dic.AddEntry("key2", "value2"));
+      EXPECT_TRUE(dic.AddEntry("key3", "value3"));
+      EXPECT_TRUE(dic.AddEntry("key4", ""));
+      EXPECT_TRUE(dic.AddEntry("key5", ""));
+      EXPECT_TRUE(dic.AddEntry("", "value4"));
+      EXPECT_TRUE(dic.AddEntry("", "value5"));
     }
 
     EXPECT_TRUE(dic.SuppressEntry("key1", "value1"));
@@ -143,6 +152,40 @@ TEST(SuppressionDictionary, ThreadTest) {
   }
 }
 
+TEST(SuppressionDictionary, ConsumerSeesCompleteSnapshotDuringReload) {
+  SuppressionDictionary dic;
+  {
+    const SuppressionDictionaryLock l(&dic);
+    EXPECT_TRUE(dic.AddEntry("old_key", "old_value"));
+  }
+
+  // While another thread rebuilds the dictionary, the consumer keeps seeing
+  // the old contents as a whole, and then the new contents as a whole.
+  mozc::Thread2 producer([&dic] {
+    const SuppressionDictionaryLock l(&dic);
+    dic.Clear();
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(dic.AddEntry(absl::StrCat("key", i), absl::StrCat("value", i)));
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+  });
+
+  // Snapshots only move from the old contents to the new ones, so once the
+  // old entry disappears every new entry must be visible.
+  bool has_old_entry = true;
+  while (has_old_entry) {
+    has_old_entry = dic.SuppressEntry("old_key", "old_value");
+    if (!has_old_entry) {
+      for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(
+            dic.SuppressEntry(absl::StrCat("key", i), absl::StrCat("value", i)));
+      }
+    }
+    EXPECT_FALSE(dic.IsEmpty());
+  }
+  producer.Join();
+}
+
 }  // namespace
 }  // namespace dictionary
 }  // namespace mozc
@@ -61,6 +61,9 @@ class SystemDictionaryCodec : public SystemDictionaryCodecInterface {
   // Return section name for frequent pos map
   const std::string GetSectionNameForPos() const override;
 
+  // Return section name for child table of key trie
+  const std::string GetSectionNameForKeyChildTable() const override;
+
   // Compresses key string into small bytes.
   void EncodeKey(const absl::string_view src, std::string *dst) const override;
 
@@ -64,6 +64,9 @@ class SystemDictionaryCodecInterface {
   // Return section name for frequent pos map
   virtual const std::string GetSectionNameForPos() const = 0;
 
+  // Return section name for child table of key trie
+  virtual const std::string GetSectionNameForKeyChildTable() const = 0;
+
   // Encode value(word) string
   virtual void EncodeValue(const absl::string_view src,
                            std::string *dst) const = 0;
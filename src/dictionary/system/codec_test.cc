@@ -321,6 +321,9 @@ class SystemDictionaryCodecMock : public SystemDictionaryCodecInterface {
   const std::string GetSectionNameForValue() const override { return "Mock"; }
   const std::string GetSectionNameForTokens() const override { return "Mock"; }
   const std::string GetSectionNameForPos() const override { return "Mock"; }
+  const std::string GetSectionNameForKeyChildTable() const override {
+    return "Mock";
+  }
   void EncodeKey(const absl::string_view src, std::string *dst) const override {
   }
   void DecodeKey(const absl::string_view src, std::string *dst) const override {
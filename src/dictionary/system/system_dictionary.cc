@@ -47,6 +47,7 @@
 #include "dictionary/system/system_dictionary.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
@@ -71,13 +72,17 @@
 #include "dictionary/system/words_info.h"
 #include "storage/louds/bit_vector_based_array.h"
 #include "storage/louds/louds_trie.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
 
 using ::mozc::storage::louds::BitVectorBasedArray;
+using ::mozc::storage::louds::BitVectorIndexType;
 using ::mozc::storage::louds::LoudsTrie;
 
 namespace {
@@ -247,6 +252,37 @@ struct ReverseLookupResult {
 
 }  // namespace
 
+// Caches the tokens decoded for each key ID.  In a batch of prefix lookups for
+// a long key, short keys like particles are found at many positions, and their
+// tokens are decoded only once.
+class SystemDictionary::DecodedTokenCache {
+ public:
+  DecodedTokenCache() = default;
+  DecodedTokenCache(const DecodedTokenCache &) = delete;
+  DecodedTokenCache &operator=(const DecodedTokenCache &) = delete;
+
+  // Returns the tokens for |key_id|.  They are decoded with |actual_key| on
+  // the first call for |key_id|.
+  const std::vector<Token> &GetTokens(const SystemDictionary &dictionary,
+                                      int key_id,
+                                      absl::string_view actual_key) {
+    auto [iter, inserted] = tokens_.try_emplace(key_id);
+    if (inserted) {
+      for (TokenDecodeIterator decoder(
+               dictionary.codec_, dictionary.value_trie_,
+               dictionary.frequent_pos_, actual_key,
+               GetTokenArrayPtr(dictionary.token_array_, key_id));
+           !decoder.Done(); decoder.Next()) {
+        iter->second.push_back(*decoder.Get().token);
+      }
+    }
+    return iter->second;
+  }
+
+ private:
+  absl::flat_hash_map<int, std::vector<Token>> tokens_;
+};
+
 class SystemDictionary::ReverseLookupCache {
  public:
   ReverseLookupCache() = default;
@@ -342,6 +378,15 @@ class SystemDictionary::ReverseLookupIndex {
     }
   }
 
+  // Returns the number of bytes allocated for the index.
+  size_t GetByteSize() const {
+    size_t byte_size = sizeof(ReverseLookupResultArray) * index_size_;
+    for (size_t i = 0; i < index_size_; ++i) {
+      byte_size += sizeof(ReverseLookupResult) * index_[i].size;
+    }
+    return byte_size;
+  }
+
  private:
   struct ReverseLookupResultArray {
     ReverseLookupResultArray() : size(0) {}
@@ -427,8 +472,7 @@ SystemDictionary::Builder::Build() {
       return absl::InvalidArgumentError("Invalid spec type");
   }
 
-  if (!instance->OpenDictionaryFile(
-          (spec_->options & ENABLE_REVERSE_LOOKUP_INDEX) != 0)) {
+  if (!instance->OpenDictionaryFile(spec_->options)) {
     return absl::UnknownError("Failed to create system dictionary");
   }
 
@@ -444,17 +488,30 @@ SystemDictionary::SystemDictionary(
 
 SystemDictionary::~SystemDictionary() = default;
 
-bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
+bool SystemDictionary::OpenDictionaryFile(Options options) {
   int len;
+  const BitVectorIndexType index_type =
+      (options & ENABLE_RANK_SELECT_INDEX) != 0
+          ? BitVectorIndexType::kRankSelect
+          : BitVectorIndexType::kSimple;
 
   const uint8_t *key_image = reinterpret_cast<const uint8_t *>(
       dictionary_file_->GetSection(codec_->GetSectionNameForKey(), &len));
   if (!key_trie_.Open(key_image, kKeyTrieLb0CacheSize, kKeyTrieLb1CacheSize,
                       kKeyTrieSelect0CacheSize, kKeyTrieSelect1CacheSize,
-                      kKeyTrieTermvecCacheSize)) {
+                      kKeyTrieTermvecCacheSize, index_type)) {
     LOG(ERROR) << "cannot open key trie";
     return false;
   }
+  // The child table is optional; dictionaries built by older versions don't
+  // have it, and then the key trie falls back to LOUDS traversal.
+  const uint8_t *key_child_table_image =
+      reinterpret_cast<const uint8_t *>(dictionary_file_->GetSection(
+          codec_->GetSectionNameForKeyChildTable(), &len));
+  if (key_child_table_image != nullptr &&
+      !key_trie_.OpenChildTable(key_child_table_image, len)) {
+    LOG(WARNING) << "cannot open child table of key trie";
+  }
 
   BuildHiraganaExpansionTable(*codec_, &hiragana_expansion_table_);
 
@@ -463,7 +520,7 @@ bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
   if (!value_trie_.Open(value_image, kValueTrieLb0CacheSize,
                         kValueTrieLb1CacheSize, kValueTrieSelect0CacheSize,
                         kValueTrieSelect1CacheSize,
-                        kValueTrieTermvecCacheSize)) {
+                        kValueTrieTermvecCacheSize, index_type)) {
     LOG(ERROR) << "can not open value trie";
     return false;
   }
@@ -479,7 +536,7 @@ bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
     return false;
   }
 
-  if (enable_reverse_lookup_index) {
+  if ((options & ENABLE_REVERSE_LOOKUP_INDEX) != 0) {
     InitReverseLookupIndex();
   }
 
@@ -724,26 +781,25 @@ namespace {
 // An implementation of prefix search without key expansion.  Runs |callback|
 // for prefixes of |encoded_key| in |key_trie|.
 // Args:
-//   key_trie, value_trie, token_array, codec, frequent_pos:
+//   key_trie, codec:
 //     Members in SystemDictionary.
 //   key:
-//     The head address of the original key before applying codec.
+//     The original key before applying codec.
 //   encoded_key:
 //     The encoded |key|.
 //   callback:
 //     A callback function to be called.
-//   token_filter:
-//     A functor of signature bool(const TokenInfo &).  Only tokens for which
-//     this functor returns true are passed to callback function.
+//   run_callback_on_tokens:
+//     A functor of signature
+//     Callback::ResultType(int key_id, absl::string_view prefix), which runs
+//     |callback| on the tokens of |key_id|.
 template <typename Func>
 void RunCallbackOnEachPrefix(const LoudsTrie &key_trie,
-                             const LoudsTrie &value_trie,
-                             const BitVectorBasedArray &token_array,
                              const SystemDictionaryCodecInterface *codec,
-                             const uint32_t *frequent_pos, const char *key,
+                             absl::string_view key,
                              absl::string_view encoded_key,
                              DictionaryInterface::Callback *callback,
-                             Func token_filter) {
+                             Func run_callback_on_tokens) {
   typedef DictionaryInterface::Callback Callback;
   LoudsTrie::Node node;
   for (absl::string_view::size_type i = 0; i < encoded_key.size();) {
@@ -755,8 +811,8 @@ void RunCallbackOnEachPrefix(const LoudsTrie &key_trie,
       continue;
     }
     const absl::string_view encoded_prefix = encoded_key.substr(0, i);
-    const absl::string_view prefix(key,
-                                   codec->GetDecodedKeyLength(encoded_prefix));
+    const absl::string_view prefix =
+        key.substr(0, codec->GetDecodedKeyLength(encoded_prefix));
 
     switch (callback->OnKey(prefix)) {
       case Callback::TRAVERSE_DONE:
@@ -778,30 +834,15 @@ void RunCallbackOnEachPrefix(const LoudsTrie &key_trie,
         break;
     }
 
-    const int key_id = key_trie.GetKeyIdOfTerminalNode(node);
-    for (TokenDecodeIterator iter(codec, value_trie, frequent_pos, prefix,
-                                  GetTokenArrayPtr(token_array, key_id));
-         !iter.Done(); iter.Next()) {
-      const TokenInfo &token_info = iter.Get();
-      if (!token_filter(token_info)) {
-        continue;
-      }
-      const Callback::ResultType res =
-          callback->OnToken(prefix, prefix, *token_info.token);
-      if (res == Callback::TRAVERSE_DONE || res == Callback::TRAVERSE_CULL) {
-        return;
-      }
-      if (res == Callback::TRAVERSE_NEXT_KEY) {
-        break;
-      }
+    const Callback::ResultType result =
+        run_callback_on_tokens(key_trie.GetKeyIdOfTerminalNode(node), prefix);
+    if (result == Callback::TRAVERSE_DONE ||
+        result == Callback::TRAVERSE_CULL) {
+      return;
     }
   }
 }
 
-struct SelectAllTokens {
-  bool operator()(const TokenInfo &token_info) const { return true; }
-};
-
 class ReverseLookupCallbackWrapper : public DictionaryInterface::Callback {
  public:
   explicit ReverseLookupCallbackWrapper(DictionaryInterface::Callback *callback)
@@ -850,7 +891,8 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
     const char *key, absl::string_view encoded_key,
     const KeyExpansionTable &table, Callback *callback, LoudsTrie::Node node,
     absl::string_view::size_type key_pos, int num_expanded,
-    char *actual_key_buffer, std::string *actual_prefix) const {
+    char *actual_key_buffer, std::string *actual_prefix,
+    DecodedTokenCache *token_cache) const {
   // This do-block handles a terminal node and callback.  do-block is used to
   // break the block and continue to the subsequent traversal phase.
   do {
@@ -882,20 +924,11 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
       break;  // Go to the traversal phase.
     }
 
-    const int key_id = key_trie_.GetKeyIdOfTerminalNode(node);
-    for (TokenDecodeIterator iter(codec_, value_trie_, frequent_pos_,
-                                  *actual_prefix,
-                                  GetTokenArrayPtr(token_array_, key_id));
-         !iter.Done(); iter.Next()) {
-      const TokenInfo &token_info = iter.Get();
-      result = callback->OnToken(prefix, *actual_prefix, *token_info.token);
-      if (result == Callback::TRAVERSE_DONE ||
-          result == Callback::TRAVERSE_CULL) {
-        return result;
-      }
-      if (result == Callback::TRAVERSE_NEXT_KEY) {
-        break;  // Go to the traversal phase.
-      }
+    result = RunCallbackOnTokens(key_trie_.GetKeyIdOfTerminalNode(node),
+                                 prefix, *actual_prefix, callback, token_cache);
+    if (result == Callback::TRAVERSE_DONE ||
+        result == Callback::TRAVERSE_CULL) {
+      return result;
     }
   } while (false);
 
@@ -915,7 +948,7 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
     const Callback::ResultType result = LookupPrefixWithKeyExpansionImpl(
         key, encoded_key, table, callback, node, key_pos + 1,
         num_expanded + static_cast<int>(c != current_char), actual_key_buffer,
-        actual_prefix);
+        actual_prefix, token_cache);
     if (result == Callback::TRAVERSE_DONE) {
       return Callback::TRAVERSE_DONE;
     }
@@ -929,20 +962,85 @@ void SystemDictionary::LookupPrefix(absl::string_view key,
                                     Callback *callback) const {
   std::string encoded_key;
   codec_->EncodeKey(key, &encoded_key);
+  LookupPrefixImpl(key, encoded_key, conversion_request, callback, nullptr);
+}
 
+void SystemDictionary::LookupPrefixBatch(
+    absl::string_view key, absl::Span<const size_t> positions,
+    const ConversionRequest &conversion_request,
+    absl::Span<Callback *const> callbacks) const {
+  DCHECK_EQ(positions.size(), callbacks.size());
+  // The key codec maps each character independently, so the encoded suffix
+  // starting at a character boundary is a suffix of the encoded key.
+  std::string encoded_key;
+  codec_->EncodeKey(key, &encoded_key);
+
+  DecodedTokenCache token_cache;
+  size_t prev_pos = 0;
+  size_t encoded_pos = 0;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const size_t pos = positions[i];
+    DCHECK_LE(prev_pos, pos);
+    DCHECK_LE(pos, key.size());
+    encoded_pos +=
+        codec_->GetEncodedKeyLength(key.substr(prev_pos, pos - prev_pos));
+    prev_pos = pos;
+    const absl::string_view encoded_suffix =
+        absl::string_view(encoded_key).substr(encoded_pos);
+    LookupPrefixImpl(key.substr(pos), encoded_suffix, conversion_request,
+                     callbacks[i], &token_cache);
+  }
+}
+
+void SystemDictionary::LookupPrefixImpl(
+    absl::string_view key, absl::string_view encoded_key,
+    const ConversionRequest &conversion_request, Callback *callback,
+    DecodedTokenCache *token_cache) const {
   if (!conversion_request.IsKanaModifierInsensitiveConversion()) {
-    RunCallbackOnEachPrefix(key_trie_, value_trie_, token_array_, codec_,
-                            frequent_pos_, key.data(), encoded_key, callback,
-                            SelectAllTokens());
+    RunCallbackOnEachPrefix(
+        key_trie_, codec_, key, encoded_key, callback,
+        [&](int key_id, absl::string_view prefix) {
+          return RunCallbackOnTokens(key_id, prefix, prefix, callback,
+                                     token_cache);
+        });
     return;
   }
 
   char actual_key_buffer[LoudsTrie::kMaxDepth + 1];
   std::string actual_prefix;
   actual_prefix.reserve(key.size() * 3);
-  LookupPrefixWithKeyExpansionImpl(
-      key.data(), encoded_key, hiragana_expansion_table_, callback,
-      LoudsTrie::Node(), 0, false, actual_key_buffer, &actual_prefix);
+  LookupPrefixWithKeyExpansionImpl(key.data(), encoded_key,
+                                   hiragana_expansion_table_, callback,
+                                   LoudsTrie::Node(), 0, false,
+                                   actual_key_buffer, &actual_prefix,
+                                   token_cache);
+}
+
+DictionaryInterface::Callback::ResultType SystemDictionary::RunCallbackOnTokens(
+    int key_id, absl::string_view prefix, absl::string_view actual_prefix,
+    Callback *callback, DecodedTokenCache *token_cache) const {
+  if (token_cache != nullptr) {
+    for (const Token &token :
+         token_cache->GetTokens(*this, key_id, actual_prefix)) {
+      const Callback::ResultType result =
+          callback->OnToken(prefix, actual_prefix, token);
+      if (result != Callback::TRAVERSE_CONTINUE) {
+        return result;
+      }
+    }
+    return Callback::TRAVERSE_CONTINUE;
+  }
+  for (TokenDecodeIterator iter(codec_, value_trie_, frequent_pos_,
+                                actual_prefix,
+                                GetTokenArrayPtr(token_array_, key_id));
+       !iter.Done(); iter.Next()) {
+    const Callback::ResultType result =
+        callback->OnToken(prefix, actual_prefix, *iter.Get().token);
+    if (result != Callback::TRAVERSE_CONTINUE) {
+      return result;
+    }
+  }
+  return Callback::TRAVERSE_CONTINUE;
 }
 
 void SystemDictionary::LookupExact(absl::string_view key,
@@ -1031,6 +1129,29 @@ void SystemDictionary::ClearReverseLookupCache() const {
   reverse_lookup_cache_.reset();
 }
 
+void SystemDictionary::CollectMemoryUsage(
+    MemoryUsageCollector *collector) const {
+  auto section_size = [this](absl::string_view name) -> size_t {
+    int len = 0;
+    return dictionary_file_->GetSection(name, &len) != nullptr ? len : 0;
+  };
+  collector->Add(
+      "KeyTrie",
+      {key_trie_.GetIndexByteSize(),
+       section_size(codec_->GetSectionNameForKey()) +
+           section_size(codec_->GetSectionNameForKeyChildTable())});
+  collector->Add("ValueTrie",
+                 {value_trie_.GetIndexByteSize(),
+                  section_size(codec_->GetSectionNameForValue())});
+  collector->Add("TokenArray",
+                 {token_array_.GetIndexByteSize(),
+                  section_size(codec_->GetSectionNameForTokens())});
+  if (reverse_lookup_index_ != nullptr) {
+    collector->Add("ReverseLookupIndex",
+                   {reverse_lookup_index_->GetByteSize(), 0});
+  }
+}
+
 namespace {
 
 class FilterTokenForRegisterReverseLookupTokensForT13N {
@@ -1067,10 +1188,26 @@ void SystemDictionary::RegisterReverseLookupTokensForT13N(
   std::string hiragana_value, encoded_key;
   japanese_util::KatakanaToHiragana(value, &hiragana_value);
   codec_->EncodeKey(hiragana_value, &encoded_key);
-  RunCallbackOnEachPrefix(key_trie_, value_trie_, token_array_, codec_,
-                          frequent_pos_, hiragana_value.data(), encoded_key,
-                          callback,
-                          FilterTokenForRegisterReverseLookupTokensForT13N());
+  FilterTokenForRegisterReverseLookupTokensForT13N token_filter;
+  RunCallbackOnEachPrefix(
+      key_trie_, codec_, hiragana_value, encoded_key, callback,
+      [&](int key_id, absl::string_view prefix) {
+        for (TokenDecodeIterator iter(codec_, value_trie_, frequent_pos_,
+                                      prefix,
+                                      GetTokenArrayPtr(token_array_, key_id));
+             !iter.Done(); iter.Next()) {
+          const TokenInfo &token_info = iter.Get();
+          if (!token_filter(token_info)) {
+            continue;
+          }
+          const Callback::ResultType result =
+              callback->OnToken(prefix, prefix, *token_info.token);
+          if (result != Callback::TRAVERSE_CONTINUE) {
+            return result;
+          }
+        }
+        return Callback::TRAVERSE_CONTINUE;
+      });
 }
 
 void SystemDictionary::RegisterReverseLookupTokensForValue(
@@ -30,6 +30,7 @@
 #ifndef MOZC_DICTIONARY_SYSTEM_SYSTEM_DICTIONARY_H_
 #define MOZC_DICTIONARY_SYSTEM_SYSTEM_DICTIONARY_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <set>
@@ -47,6 +48,7 @@
 #include "absl/container/btree_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
@@ -60,6 +62,10 @@ class SystemDictionary : public DictionaryInterface {
     // from the id in value trie to the id in key trie.
     // That consumes more memory but we can perform reverse lookup more quickly.
     ENABLE_REVERSE_LOOKUP_INDEX = 1,
+    // If ENABLE_RANK_SELECT_INDEX is set, the key and value tries are indexed
+    // by RankSelectBitVectorIndex instead of SimpleSuccinctBitVectorIndex.
+    // That consumes a bit more memory but makes trie traversal faster.
+    ENABLE_RANK_SELECT_INDEX = 2,
   };
 
   // Builder class for system dictionary
@@ -145,6 +151,13 @@ class SystemDictionary : public DictionaryInterface {
                     const ConversionRequest &conversion_request,
                     Callback *callback) const override;
 
+  // Encodes the key once and reuses the decoded tokens for the keys found at
+  // multiple positions.
+  void LookupPrefixBatch(absl::string_view key,
+                         absl::Span<const size_t> positions,
+                         const ConversionRequest &conversion_request,
+                         absl::Span<Callback *const> callbacks) const override;
+
   void LookupExact(absl::string_view key,
                    const ConversionRequest &conversion_request,
                    Callback *callback) const override;
@@ -155,8 +168,10 @@ class SystemDictionary : public DictionaryInterface {
 
   void PopulateReverseLookupCache(absl::string_view str) const override;
   void ClearReverseLookupCache() const override;
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
 
  private:
+  class DecodedTokenCache;
   class ReverseLookupCache;
   class ReverseLookupIndex;
   struct PredictiveLookupSearchState;
@@ -164,7 +179,7 @@ class SystemDictionary : public DictionaryInterface {
   SystemDictionary(const SystemDictionaryCodecInterface *codec,
                    const DictionaryFileCodecInterface *file_codec);
 
-  bool OpenDictionaryFile(bool enable_reverse_lookup_index);
+  bool OpenDictionaryFile(Options options);
 
   void RegisterReverseLookupTokensForT13N(absl::string_view value,
                                           Callback *callback) const;
@@ -177,12 +192,27 @@ class SystemDictionary : public DictionaryInterface {
                                     Callback *callback) const;
   void InitReverseLookupIndex();
 
+  // Runs prefix lookup for |key| whose encoded form is |encoded_key|.  When
+  // |token_cache| is not nullptr, the decoded tokens are taken from and stored
+  // into it.
+  void LookupPrefixImpl(absl::string_view key, absl::string_view encoded_key,
+                        const ConversionRequest &conversion_request,
+                        Callback *callback,
+                        DecodedTokenCache *token_cache) const;
+
   Callback::ResultType LookupPrefixWithKeyExpansionImpl(
       const char *key, absl::string_view encoded_key,
       const KeyExpansionTable &table, Callback *callback,
       storage::louds::LoudsTrie::Node node,
       absl::string_view::size_type key_pos, int num_expanded,
-      char *actual_key_buffer, std::string *actual_prefix) const;
+      char *actual_key_buffer, std::string *actual_prefix,
+      DecodedTokenCache *token_cache) const;
+
+  // Calls back OnToken() for each token of |key_id|.  Returns the result of
+  // the callback that stopped the iteration, or TRAVERSE_CONTINUE.
+  Callback::ResultType RunCallbackOnTokens(
+      int key_id, absl::string_view prefix, absl::string_view actual_prefix,
+      Callback *callback, DecodedTokenCache *token_cache) const;
 
   void CollectPredictiveNodesInBfsOrder(
       absl::string_view encoded_key, const KeyExpansionTable &table,
@@ -27,3 +27,295 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+// Benchmarks for the lookup methods of SystemDictionary built from the OSS
+// data set.  The keys are taken from data/dictionary_oss/evaluation.tsv, which
+// contains realistic sentence-length readings and their conversions.
+//
+// Usage:
+//   bazel run -c opt //dictionary/system:system_dictionary_benchmark
+// To run a subset, append e.g. "-- --benchmark_filter=LookupPrefix".
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/file_stream.h"
+#include "base/init_mozc.h"
+#include "base/logging.h"
+#include "base/strings/unicode.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "dictionary/dictionary_interface.h"
+#include "dictionary/dictionary_token.h"
+#include "dictionary/system/system_dictionary.h"
+#include "protocol/commands.pb.h"
+#include "protocol/config.pb.h"
+#include "request/conversion_request.h"
+#include "testing/googletest.h"
+#include "testing/mozctest.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+// Readings (keys) and surfaces (values) of the evaluation corpus.
+struct Corpus {
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+};
+
+const Corpus &GetCorpus() {
+  static const Corpus *corpus = [] {
+    auto *corpus = new Corpus();
+    const std::string path = testing::GetSourceFileOrDie(
+        {"data", "dictionary_oss", "evaluation.tsv"});
+    InputFileStream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      // Format: status, input, output, command, argument, version.
+      const std::vector<absl::string_view> fields =
+          absl::StrSplit(line, '\t');
+      if (fields.size() < 3 || fields[1].empty() || fields[2].empty()) {
+        continue;
+      }
+      corpus->keys.emplace_back(fields[1]);
+      corpus->values.emplace_back(fields[2]);
+    }
+    CHECK(!corpus->keys.empty()) << "No key is loaded from " << path;
+    return corpus;
+  }();
+  return *corpus;
+}
+
+const DataManager &GetDataManager() {
+  static const DataManager *data_manager = new oss::OssDataManager();
+  return *data_manager;
+}
+
+// Returns the system dictionary for |options|.  Dictionaries are built once
+// per option set so that the build cost is not measured.
+const SystemDictionary &GetSystemDictionary(SystemDictionary::Options options) {
+  static auto *dictionaries =
+      new std::map<int, std::unique_ptr<SystemDictionary>>();
+  std::unique_ptr<SystemDictionary> &dictionary = (*dictionaries)[options];
+  if (dictionary == nullptr) {
+    const char *data = nullptr;
+    int size = 0;
+    GetDataManager().GetSystemDictionaryData(&data, &size);
+    dictionary = SystemDictionary::Builder(data, size)
+                     .SetOptions(options)
+                     .Build()
+                     .value();
+  }
+  return *dictionary;
+}
+
+// Returns the split of |key| at each character boundary, i.e., the keys
+// looked up by the converter when it builds the lattice.
+std::vector<absl::string_view> GetSuffixes(absl::string_view key) {
+  std::vector<absl::string_view> suffixes;
+  for (absl::string_view rest = key; !rest.empty();
+       rest = strings::FrontChar(rest).second) {
+    suffixes.push_back(rest);
+  }
+  return suffixes;
+}
+
+// Returns the prefixes of |key| at each character boundary, i.e., the keys
+// looked up by the predictor while the user is typing.
+std::vector<absl::string_view> GetPrefixes(absl::string_view key) {
+  std::vector<absl::string_view> prefixes;
+  for (size_t len = 0; len < key.size();) {
+    len += strings::OneCharLen(key[len]);
+    prefixes.push_back(key.substr(0, len));
+  }
+  return prefixes;
+}
+
+class CountTokenCallback : public DictionaryInterface::Callback {
+ public:
+  ResultType OnToken(absl::string_view key, absl::string_view actual_key,
+                     const Token &token) override {
+    ::benchmark::DoNotOptimize(token.value.data());
+    ++num_tokens_;
+    return TRAVERSE_CONTINUE;
+  }
+
+  int64_t num_tokens() const { return num_tokens_; }
+
+ private:
+  int64_t num_tokens_ = 0;
+};
+
+// Holds a request whose kana modifier insensitive conversion is enabled only
+// when |use_key_expansion| is true.
+class BenchmarkRequest {
+ public:
+  explicit BenchmarkRequest(bool use_key_expansion) {
+    request_.set_kana_modifier_insensitive_conversion(use_key_expansion);
+    config_.set_use_kana_modifier_insensitive_conversion(use_key_expansion);
+    convreq_.set_request(&request_);
+    convreq_.set_config(&config_);
+  }
+
+  const ConversionRequest &get() const { return convreq_; }
+
+ private:
+  commands::Request request_;
+  config::Config config_;
+  ConversionRequest convreq_;
+};
+
+SystemDictionary::Options GetOptions(bool use_rank_select_index,
+                                     bool use_reverse_lookup_index) {
+  int options = SystemDictionary::NONE;
+  if (use_rank_select_index) {
+    options |= SystemDictionary::ENABLE_RANK_SELECT_INDEX;
+  }
+  if (use_reverse_lookup_index) {
+    options |= SystemDictionary::ENABLE_REVERSE_LOOKUP_INDEX;
+  }
+  return static_cast<SystemDictionary::Options>(options);
+}
+
+void ReportCounters(::benchmark::State &state, int64_t num_lookups,
+                    int64_t num_tokens) {
+  state.SetItemsProcessed(num_lookups);
+  state.counters["tokens_per_lookup"] =
+      num_lookups == 0 ? 0.0 : static_cast<double>(num_tokens) / num_lookups;
+}
+
+// Args: {use_key_expansion, use_rank_select_index}.
+void BM_LookupPrefix(::benchmark::State &state) {
+  const SystemDictionary &dictionary =
+      GetSystemDictionary(GetOptions(state.range(1) != 0, false));
+  const BenchmarkRequest request(state.range(0) != 0);
+  std::vector<absl::string_view> keys;
+  for (const std::string &key : GetCorpus().keys) {
+    const std::vector<absl::string_view> suffixes = GetSuffixes(key);
+    keys.insert(keys.end(), suffixes.begin(), suffixes.end());
+  }
+
+  CountTokenCallback callback;
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (absl::string_view key : keys) {
+      dictionary.LookupPrefix(key, request.get(), &callback);
+    }
+    num_lookups += keys.size();
+  }
+  ReportCounters(state, num_lookups, callback.num_tokens());
+}
+BENCHMARK(BM_LookupPrefix)
+    ->ArgNames({"key_expansion", "rank_select"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+// Args: {use_key_expansion, use_rank_select_index}.
+void BM_LookupPredictive(::benchmark::State &state) {
+  const SystemDictionary &dictionary =
+      GetSystemDictionary(GetOptions(state.range(1) != 0, false));
+  const BenchmarkRequest request(state.range(0) != 0);
+  std::vector<absl::string_view> keys;
+  for (const std::string &key : GetCorpus().keys) {
+    const std::vector<absl::string_view> prefixes = GetPrefixes(key);
+    keys.insert(keys.end(), prefixes.begin(), prefixes.end());
+  }
+
+  CountTokenCallback callback;
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (absl::string_view key : keys) {
+      dictionary.LookupPredictive(key, request.get(), &callback);
+    }
+    num_lookups += keys.size();
+  }
+  ReportCounters(state, num_lookups, callback.num_tokens());
+}
+BENCHMARK(BM_LookupPredictive)
+    ->ArgNames({"key_expansion", "rank_select"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+// Args: {use_rank_select_index}.
+void BM_LookupExact(::benchmark::State &state) {
+  const SystemDictionary &dictionary =
+      GetSystemDictionary(GetOptions(state.range(0) != 0, false));
+  const BenchmarkRequest request(false);
+  // Look up all the substrings of up to 8 characters, most of which are
+  // misses as in the rewriters and the predictors.
+  constexpr size_t kMaxChars = 8;
+  std::vector<absl::string_view> keys;
+  for (const std::string &key : GetCorpus().keys) {
+    for (absl::string_view suffix : GetSuffixes(key)) {
+      const std::vector<absl::string_view> prefixes = GetPrefixes(suffix);
+      keys.insert(keys.end(), prefixes.begin(),
+                  prefixes.size() > kMaxChars ? prefixes.begin() + kMaxChars
+                                              : prefixes.end());
+    }
+  }
+
+  CountTokenCallback callback;
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (absl::string_view key : keys) {
+      dictionary.LookupExact(key, request.get(), &callback);
+    }
+    num_lookups += keys.size();
+  }
+  ReportCounters(state, num_lookups, callback.num_tokens());
+}
+BENCHMARK(BM_LookupExact)->ArgNames({"rank_select"})->Arg(0)->Arg(1);
+
+// Args: {use_reverse_lookup_index, use_rank_select_index}.
+void BM_LookupReverse(::benchmark::State &state) {
+  const SystemDictionary &dictionary =
+      GetSystemDictionary(GetOptions(state.range(1) != 0, state.range(0) != 0));
+  const BenchmarkRequest request(false);
+  std::vector<std::pair<absl::string_view, std::vector<absl::string_view>>>
+      inputs;
+  for (const std::string &value : GetCorpus().values) {
+    inputs.emplace_back(value, GetSuffixes(value));
+  }
+
+  // Emulates the reverse conversion, which looks up every suffix of the input
+  // after populating the cache.
+  CountTokenCallback callback;
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const auto &[value, suffixes] : inputs) {
+      dictionary.PopulateReverseLookupCache(value);
+      for (absl::string_view suffix : suffixes) {
+        dictionary.LookupReverse(suffix, request.get(), &callback);
+      }
+      num_lookups += suffixes.size();
+      dictionary.ClearReverseLookupCache();
+    }
+  }
+  ReportCounters(state, num_lookups, callback.num_tokens());
+}
+BENCHMARK(BM_LookupReverse)
+    ->ArgNames({"reverse_index", "rank_select"})
+    ->ArgsProduct({{0, 1}, {0, 1}});
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
+
+int main(int argc, char **argv) {
+  // Let the benchmark library consume its own flags first, as InitMozc()
+  // rejects unknown flags.
+  ::benchmark::Initialize(&argc, argv);
+  mozc::InitMozc(argv[0], &argc, &argv);
+  mozc::InitTestFlags();
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  return 0;
+}
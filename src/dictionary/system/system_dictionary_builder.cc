@@ -70,6 +70,11 @@ namespace mozc {
 namespace dictionary {
 namespace {
 
+// The number of the upper nodes of the key trie covered by the child table
+// (4 bytes per node).  Lookups visit these nodes for every key, so they are
+// worth the extra 1MB.
+constexpr int kKeyTrieChildTableMaxNodes = 256 * 1024;
+
 struct TokenGreaterThan {
   bool operator()(const TokenInfo &lhs, const TokenInfo &rhs) const {
     if (lhs.token->lid != rhs.token->lid) {
@@ -161,6 +166,11 @@ void SystemDictionaryBuilder::WriteToStream(
       file_codec_->GetSectionName(codec_->GetSectionNameForPos()));
   sections.push_back(frequent_pos_section);
 
+  DictionaryFileSection key_child_table_section(
+      key_child_table_image_.data(), key_child_table_image_.size(),
+      file_codec_->GetSectionName(codec_->GetSectionNameForKeyChildTable()));
+  sections.push_back(key_child_table_section);
+
   if (absl::GetFlag(FLAGS_preserve_intermediate_dictionary) &&
       !intermediate_output_file_base_path.empty()) {
     // Write out intermediate results to files.
@@ -171,6 +181,8 @@ void SystemDictionaryBuilder::WriteToStream(
     WriteSectionToFile(token_array_section, absl::StrCat(basepath, ".tokens"));
     WriteSectionToFile(frequent_pos_section,
                        absl::StrCat(basepath, ".freq_pos"));
+    WriteSectionToFile(key_child_table_section,
+                       absl::StrCat(basepath, ".key_child_table"));
   }
 
   LOG(INFO) << "Start writing dictionary file.";
@@ -441,6 +453,8 @@ void SystemDictionaryBuilder::BuildKeyTrie(const KeyInfoList &key_info_list) {
     key_trie_builder_.Add(key_str);
   }
   key_trie_builder_.Build();
+  key_child_table_image_ =
+      key_trie_builder_.BuildChildTableImage(kKeyTrieChildTableMaxNodes);
 }
 
 void SystemDictionaryBuilder::SetIdForKey(KeyInfoList *key_info_list) const {
@@ -105,6 +105,7 @@ class SystemDictionaryBuilder final {
 
   storage::louds::LoudsTrieBuilder value_trie_builder_;
   storage::louds::LoudsTrieBuilder key_trie_builder_;
+  std::string key_child_table_image_;
   storage::louds::BitVectorBasedArrayBuilder token_array_builder_;
 
   // mapping from {left_id, right_id} to POS index (0--255)
@@ -456,6 +456,59 @@ TEST_F(SystemDictionaryTest, LookupPrefix) {
   }
 }
 
+TEST_F(SystemDictionaryTest, LookupPrefixBatch) {
+  struct {
+    const char *key;
+    const char *value;
+  } kKeyValues[] = {
+      {"あ", "亜"},   {"あい", "愛"}, {"は", "葉"},   {"は", "歯"},
+      {"はひ", "ハヒ"}, {"ば", "場"}, {"はび", "波美"}, {"ひ", "火"},
+      {"ひは", "日葉"}, {"ばび", "馬尾"},
+  };
+  std::vector<Token> tokens;
+  for (const auto &kv : kKeyValues) {
+    tokens.emplace_back(kv.key, kv.value);
+  }
+  std::unique_ptr<SystemDictionary> system_dic =
+      BuildSystemDictionary(MakeTokenPointers(&tokens), std::size(kKeyValues));
+  ASSERT_TRUE(system_dic);
+
+  // "は", "ひ" and "はひ" are found at several positions.
+  const std::string key = "はひはひはばびあい";
+  std::vector<size_t> positions;
+  for (size_t pos = 0; pos < key.size(); pos += 3) {  // 3 bytes per hiragana.
+    positions.push_back(pos);
+  }
+
+  for (const bool kana_modifier_insensitive : {false, true}) {
+    SCOPED_TRACE(kana_modifier_insensitive);
+    request_.set_kana_modifier_insensitive_conversion(
+        kana_modifier_insensitive);
+    config_.set_use_kana_modifier_insensitive_conversion(
+        kana_modifier_insensitive);
+
+    std::vector<CollectTokenCallback> batch_callbacks(positions.size());
+    std::vector<DictionaryInterface::Callback *> callback_ptrs;
+    for (CollectTokenCallback &callback : batch_callbacks) {
+      callback_ptrs.push_back(&callback);
+    }
+    system_dic->LookupPrefixBatch(key, positions, convreq_, callback_ptrs);
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+      CollectTokenCallback callback;
+      system_dic->LookupPrefix(absl::string_view(key).substr(positions[i]),
+                               convreq_, &callback);
+      EXPECT_EQ(PrintTokens(batch_callbacks[i].tokens()),
+                PrintTokens(callback.tokens()))
+          << "pos: " << positions[i];
+    }
+    // "は" is found at 12, and so is "ば" with kana modifier insensitive
+    // lookup.
+    EXPECT_EQ(batch_callbacks[4].tokens().size(),
+              kana_modifier_insensitive ? 3 : 2);
+  }
+}
+
 TEST_F(SystemDictionaryTest, LookupPredictive) {
   Token tokens[] = {
       {"まみむめもや", "value0", 0, 0, 0, Token::NONE},
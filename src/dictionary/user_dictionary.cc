@@ -142,6 +142,8 @@ class UserDictionary::TokensIndex {
     std::set<uint64_t> seen;
     std::vector<UserPos::Token> tokens;
 
+    // The suppression entries are published when `l` is released; until then
+    // the converter keeps using the previous ones.
     const SuppressionDictionaryLock l(suppression_dictionary_);
     suppression_dictionary_->Clear();
 
@@ -225,6 +227,17 @@ class UserDictionary::TokensIndex {
         "UserRegisteredWord", static_cast<int>(user_pos_tokens_.size()));
   }
 
+  // Returns the number of bytes allocated for the tokens.
+  size_t GetByteSize() const {
+    size_t byte_size = sizeof(UserPos::Token) * user_pos_tokens_.capacity();
+    for (const UserPos::Token &token : user_pos_tokens_) {
+      byte_size += GetStringHeapBytes(token.key) +
+                   GetStringHeapBytes(token.value) +
+                   GetStringHeapBytes(token.comment);
+    }
+    return byte_size;
+  }
+
  private:
   const UserPosInterface *user_pos_;
   SuppressionDictionary *suppression_dictionary_;
@@ -304,16 +317,14 @@ UserDictionary::UserDictionary(std::unique_ptr<const UserPosInterface> user_pos,
       user_pos_(std::move(user_pos)),
       pos_matcher_(pos_matcher),
       suppression_dictionary_(suppression_dictionary),
-      tokens_(new TokensIndex(user_pos_.get(), suppression_dictionary)) {
+      tokens_(std::make_shared<const TokensIndex>(user_pos_.get(),
+                                                  suppression_dictionary)) {
   DCHECK(user_pos_.get());
   DCHECK(suppression_dictionary_);
   Reload();
 }
 
-UserDictionary::~UserDictionary() {
-  reloader_->Join();
-  delete tokens_;
-}
+UserDictionary::~UserDictionary() { reloader_->Join(); }
 
 bool UserDictionary::HasKey(absl::string_view key) const {
   // TODO(noriyukit): Currently, we don't support HasKey() for user dictionary
@@ -333,13 +344,12 @@ bool UserDictionary::HasValue(absl::string_view value) const {
 void UserDictionary::LookupPredictive(
     absl::string_view key, const ConversionRequest &conversion_request,
     Callback *callback) const {
-  absl::ReaderMutexLock l(&mutex_);
-
   if (key.empty()) {
     VLOG(2) << "string of length zero is passed.";
     return;
   }
-  if (tokens_->empty()) {
+  const std::shared_ptr<const TokensIndex> tokens = GetTokens();
+  if (tokens->empty()) {
     return;
   }
   if (conversion_request.config().incognito_mode()) {
@@ -348,8 +358,8 @@ void UserDictionary::LookupPredictive(
 
   // Find the starting point of iteration over dictionary contents.
   Token token;
-  for (auto [begin, end] = std::equal_range(tokens_->begin(), tokens_->end(),
-                                            key, OrderByKeyPrefix());
+  for (auto [begin, end] = std::equal_range(tokens->begin(), tokens->end(), key,
+                                            OrderByKeyPrefix());
        begin != end; ++begin) {
     const UserPos::Token &user_pos_token = *begin;
     switch (callback->OnKey(user_pos_token.key)) {
@@ -373,26 +383,51 @@ void UserDictionary::LookupPredictive(
 void UserDictionary::LookupPrefix(absl::string_view key,
                                   const ConversionRequest &conversion_request,
                                   Callback *callback) const {
-  absl::ReaderMutexLock l(&mutex_);
-
   if (key.empty()) {
     LOG(WARNING) << "string of length zero is passed.";
     return;
   }
-  if (tokens_->empty()) {
+  const std::shared_ptr<const TokensIndex> tokens = GetTokens();
+  if (tokens->empty()) {
+    return;
+  }
+  if (conversion_request.config().incognito_mode()) {
+    return;
+  }
+  LookupPrefixInternal(*tokens, key, callback);
+}
+
+void UserDictionary::LookupPrefixBatch(
+    absl::string_view key, absl::Span<const size_t> positions,
+    const ConversionRequest &conversion_request,
+    absl::Span<Callback *const> callbacks) const {
+  DCHECK_EQ(positions.size(), callbacks.size());
+  const std::shared_ptr<const TokensIndex> tokens = GetTokens();
+  if (tokens->empty()) {
     return;
   }
   if (conversion_request.config().incognito_mode()) {
     return;
   }
+  for (size_t i = 0; i < positions.size(); ++i) {
+    if (positions[i] >= key.size()) {
+      LOG(WARNING) << "string of length zero is passed.";
+      continue;
+    }
+    LookupPrefixInternal(*tokens, key.substr(positions[i]), callbacks[i]);
+  }
+}
 
+void UserDictionary::LookupPrefixInternal(const TokensIndex &tokens,
+                                          absl::string_view key,
+                                          Callback *callback) const {
   // Find the starting point for iteration over dictionary contents.
   const absl::string_view first_char =
       key.substr(0, Util::OneCharLen(key.data()));
   Token token;
-  for (auto it = std::lower_bound(tokens_->begin(), tokens_->end(), first_char,
+  for (auto it = std::lower_bound(tokens.begin(), tokens.end(), first_char,
                                   OrderByKey());
-       it != tokens_->end(); ++it) {
+       it != tokens.end(); ++it) {
     const UserPos::Token &user_pos_token = *it;
     if (user_pos_token.key > key) {
       break;
@@ -430,13 +465,12 @@ void UserDictionary::LookupPrefix(absl::string_view key,
 void UserDictionary::LookupExact(absl::string_view key,
                                  const ConversionRequest &conversion_request,
                                  Callback *callback) const {
-  absl::ReaderMutexLock l(&mutex_);
-  if (key.empty() || tokens_->empty() ||
-      conversion_request.config().incognito_mode()) {
+  if (key.empty() || conversion_request.config().incognito_mode()) {
     return;
   }
+  const std::shared_ptr<const TokensIndex> tokens = GetTokens();
   auto [begin, end] =
-      std::equal_range(tokens_->begin(), tokens_->end(), key, OrderByKey());
+      std::equal_range(tokens->begin(), tokens->end(), key, OrderByKey());
   if (begin == end) {
     return;
   }
@@ -469,14 +503,14 @@ bool UserDictionary::LookupComment(absl::string_view key,
     return false;
   }
 
-  absl::ReaderMutexLock l(&mutex_);
-  if (tokens_->empty()) {
+  const std::shared_ptr<const TokensIndex> tokens = GetTokens();
+  if (tokens->empty()) {
     return false;
   }
 
   // Set the comment that was found first.
-  for (auto [begin, end] = std::equal_range(tokens_->begin(), tokens_->end(),
-                                            key, OrderByKey());
+  for (auto [begin, end] = std::equal_range(tokens->begin(), tokens->end(), key,
+                                            OrderByKey());
        begin != end; ++begin) {
     const UserPos::Token &token = *begin;
     if (token.value == value && !token.comment.empty()) {
@@ -525,23 +559,23 @@ class FindValueCallback : public DictionaryInterface::Callback {
 
 void UserDictionary::WaitForReloader() { reloader_->Join(); }
 
-void UserDictionary::Swap(TokensIndex *new_tokens) {
+std::shared_ptr<const UserDictionary::TokensIndex> UserDictionary::GetTokens()
+    const {
+  return std::atomic_load(&tokens_);
+}
+
+void UserDictionary::CollectMemoryUsage(MemoryUsageCollector *collector) const {
+  collector->Add("Tokens", {GetTokens()->GetByteSize(), 0});
+}
+
+void UserDictionary::Swap(std::shared_ptr<const TokensIndex> new_tokens) {
   DCHECK(new_tokens);
-  TokensIndex *old_tokens = tokens_;
-  {
-    absl::WriterMutexLock l(&mutex_);
-    tokens_ = new_tokens;
-  }
-  delete old_tokens;
+  std::atomic_store(&tokens_, std::move(new_tokens));
 }
 
 bool UserDictionary::Load(
     const user_dictionary::UserDictionaryStorage &storage) {
-  size_t size = 0;
-  {
-    absl::ReaderMutexLock l(&mutex_);
-    size = tokens_->size();
-  }
+  const size_t size = GetTokens()->size();
 
   // If UserDictionary is pretty big, we first remove the
   // current dictionary to save memory usage.
@@ -552,15 +586,16 @@ bool UserDictionary::Load(
 #endif  // __ANDROID__
 
   if (size >= kVeryBigUserDictionarySize) {
-    TokensIndex *dummy_empty_tokens =
-        new TokensIndex(user_pos_.get(), suppression_dictionary_);
-    Swap(dummy_empty_tokens);
+    Swap(std::make_shared<const TokensIndex>(user_pos_.get(),
+                                             suppression_dictionary_));
   }
 
-  TokensIndex *tokens =
-      new TokensIndex(user_pos_.get(), suppression_dictionary_);
+  // Build the new index off to the side; lookups keep using the current one
+  // until it is published.
+  auto tokens =
+      std::make_shared<TokensIndex>(user_pos_.get(), suppression_dictionary_);
   tokens->Load(storage);
-  Swap(tokens);
+  Swap(std::move(tokens));
   return true;
 }
 
@@ -30,6 +30,7 @@
 #ifndef MOZC_DICTIONARY_USER_DICTIONARY_H_
 #define MOZC_DICTIONARY_USER_DICTIONARY_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,7 +42,7 @@
 #include "dictionary/user_pos_interface.h"
 #include "protocol/user_dictionary_storage.pb.h"
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace dictionary {
@@ -68,6 +69,10 @@ class UserDictionary : public DictionaryInterface {
   void LookupPrefix(absl::string_view key,
                     const ConversionRequest &conversion_request,
                     Callback *callback) const override;
+  void LookupPrefixBatch(absl::string_view key,
+                         absl::Span<const size_t> positions,
+                         const ConversionRequest &conversion_request,
+                         absl::Span<Callback *const> callbacks) const override;
   void LookupExact(absl::string_view key,
                    const ConversionRequest &conversion_request,
                    Callback *callback) const override;
@@ -89,6 +94,8 @@ class UserDictionary : public DictionaryInterface {
   // Reloads dictionary asynchronously
   bool Reload() override;
 
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
+
   // Waits until reloader finishes
   void WaitForReloader();
 
@@ -111,15 +118,25 @@ class UserDictionary : public DictionaryInterface {
   class TokensIndex;
   class UserDictionaryReloader;
 
-  // Swaps internal tokens index to |new_tokens|.
-  void Swap(TokensIndex *new_tokens);
+  // Returns the currently published tokens index. The returned snapshot stays
+  // valid even if the reloader swaps in a new index meanwhile.
+  std::shared_ptr<const TokensIndex> GetTokens() const;
+
+  // Publishes |new_tokens| as the tokens index. Lookups in flight keep using
+  // the previous index, which is destroyed when the last of them finishes.
+  void Swap(std::shared_ptr<const TokensIndex> new_tokens);
+
+  // Runs the prefix lookup for non-empty |key| on |tokens|.
+  void LookupPrefixInternal(const TokensIndex &tokens, absl::string_view key,
+                            Callback *callback) const;
 
   std::unique_ptr<UserDictionaryReloader> reloader_;
   std::unique_ptr<const UserPosInterface> user_pos_;
   const PosMatcher pos_matcher_;
   SuppressionDictionary *suppression_dictionary_;
-  TokensIndex *tokens_;
-  mutable absl::Mutex mutex_;
+  // Accessed only via std::atomic_load() and std::atomic_store() so that
+  // lookups never wait for reloading.
+  std::shared_ptr<const TokensIndex> tokens_;
 
   friend class UserDictionaryTest;
 };
@@ -421,6 +421,45 @@ TEST_F(UserDictionaryTest, TestLookupPredictive) {
   EXPECT_TRUE(TestLookupPredictiveHelper(nullptr, 0, "st", *dic));
 }
 
+TEST_F(UserDictionaryTest, TestLookupPrefixBatch) {
+  std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
+  // Wait for async reload called from the constructor.
+  dic->WaitForReloader();
+
+  {
+    UserDictionaryStorage storage("");
+    LoadFromString(kUserDictionary0, &storage);
+    dic->Load(storage.GetProto());
+  }
+
+  constexpr absl::string_view kKey = "xstarting";
+  const std::vector<size_t> positions = {0, 1, 2};
+  EntryCollector collectors[3];
+  const std::vector<DictionaryInterface::Callback *> callbacks = {
+      &collectors[0], &collectors[1], &collectors[2]};
+  dic->LookupPrefixBatch(kKey, positions, convreq_, callbacks);
+
+  // The same results as LookupPrefix("starting").
+  const Entry kExpected1[] = {
+      {"star", "star", 100, 100},
+      {"start", "start", 200, 200},
+      {"starting", "starting", 100, 100},
+      {"starting", "starting", 220, 220},
+  };
+  EXPECT_TRUE(collectors[0].entries().empty());
+  CompareEntries(kExpected1, std::size(kExpected1), collectors[1].entries());
+  EXPECT_TRUE(collectors[2].entries().empty());
+
+  // Nothing is looked up in incognito mode.
+  config_.set_incognito_mode(true);
+  EntryCollector incognito_collector;
+  const std::vector<DictionaryInterface::Callback *> incognito_callbacks = {
+      &incognito_collector};
+  dic->LookupPrefixBatch(kKey, {1}, convreq_, incognito_callbacks);
+  EXPECT_TRUE(incognito_collector.entries().empty());
+  config_.set_incognito_mode(false);
+}
+
 TEST_F(UserDictionaryTest, TestLookupPrefix) {
   std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
   // Wait for async reload called from the constructor.
@@ -36,10 +36,13 @@
 #include <utility>
 
 #include "base/logging.h"
+#include "base/memory_usage.h"
 #include "converter/connector.h"
 #include "converter/converter.h"
 #include "converter/immutable_converter.h"
 #include "converter/immutable_converter_interface.h"
+#include "converter/node.h"
+#include "converter/node_allocator.h"
 #include "converter/segmenter.h"
 #include "data_manager/data_manager_interface.h"
 #include "dictionary/dictionary_impl.h"
@@ -60,11 +63,18 @@
 #include "prediction/user_history_predictor.h"
 #include "rewriter/rewriter.h"
 #include "rewriter/rewriter_interface.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
+ABSL_FLAG(std::string, connector_matrix_mode, "compressed",
+          "How the connection matrix is held in memory: "
+          "(compressed|dense_lazy|dense_eager). The dense modes use a few "
+          "tens of MB more memory for faster transition cost lookups.");
+
 namespace mozc {
 namespace {
 
@@ -77,6 +87,21 @@ using ::mozc::dictionary::UserDictionary;
 using ::mozc::dictionary::UserPos;
 using ::mozc::dictionary::ValueDictionary;
 
+absl::StatusOr<Connector::MatrixMode> GetConnectorMatrixMode() {
+  const std::string mode = absl::GetFlag(FLAGS_connector_matrix_mode);
+  if (mode.empty() || mode == "compressed") {
+    return Connector::MatrixMode::kCompressed;
+  }
+  if (mode == "dense_lazy") {
+    return Connector::MatrixMode::kDenseLazy;
+  }
+  if (mode == "dense_eager") {
+    return Connector::MatrixMode::kDenseEager;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("engine.cc: Unknown connector_matrix_mode: ", mode));
+}
+
 class UserDataManagerImpl final : public UserDataManagerInterface {
  public:
   UserDataManagerImpl(PredictorInterface *predictor,
@@ -196,7 +221,9 @@ absl::Status Engine::Init(
   data_manager->GetSystemDictionaryData(&dictionary_data, &dictionary_size);
 
   absl::StatusOr<std::unique_ptr<SystemDictionary>> sysdic =
-      SystemDictionary::Builder(dictionary_data, dictionary_size).Build();
+      SystemDictionary::Builder(dictionary_data, dictionary_size)
+          .SetOptions(SystemDictionary::ENABLE_RANK_SELECT_INDEX)
+          .Build();
   if (!sysdic.ok()) {
     return std::move(sysdic).status();
   }
@@ -215,7 +242,16 @@ absl::Status Engine::Init(
       suffix_key_array_data, suffix_value_array_data, token_array);
   RETURN_IF_NULL(suffix_dictionary_);
 
-  auto status_or_connector = Connector::CreateFromDataManager(*data_manager);
+  absl::StatusOr<Connector::MatrixMode> matrix_mode = GetConnectorMatrixMode();
+  if (!matrix_mode.ok()) {
+    return std::move(matrix_mode).status();
+  }
+  Connector::Options connector_options;
+  connector_options.index_type =
+      storage::louds::BitVectorIndexType::kRankSelect;
+  connector_options.matrix_mode = *matrix_mode;
+  auto status_or_connector =
+      Connector::CreateFromDataManager(*data_manager, connector_options);
   if (!status_or_connector.ok()) {
     return std::move(status_or_connector).status();
   }
@@ -309,4 +345,19 @@ bool Engine::Reload() {
   return result_dictionary && result_user_data;
 }
 
+void Engine::CollectMemoryUsage(MemoryUsageCollector *collector) const {
+  if (connector_) {
+    collector->Add("Connector", connector_->GetMemoryUsage());
+  }
+  if (dictionary_) {
+    dictionary_->CollectMemoryUsage(collector);
+  }
+  if (predictor_) {
+    predictor_->CollectMemoryUsage(collector);
+  }
+  // Lattices are owned by sessions, so only the high-water mark is reported.
+  collector->Add("NodeAllocator.Peak",
+                 {NodeAllocator::peak_node_count() * sizeof(Node), 0});
+}
+
 }  // namespace mozc
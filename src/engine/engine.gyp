@@ -57,6 +57,7 @@
         'engine.cc',
       ],
       'dependencies': [
+        '../base/absl.gyp:absl_flags',
         '../base/absl.gyp:absl_status',
         '../base/absl.gyp:absl_strings',
         '../base/base.gyp:base',
@@ -115,6 +115,8 @@ class Engine : public EngineInterface {
     return data_manager_.get();
   }
 
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
+
   std::vector<std::string> GetPosList() const override {
     return user_dictionary_->GetPosList();
   }
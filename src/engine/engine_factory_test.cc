@@ -30,10 +30,16 @@
 #include "engine/engine_factory.h"
 
 #include <memory>
+#include <string>
 
 #include "engine/engine_interface.h"
 #include "prediction/predictor_interface.h"
+#include "testing/gmock.h"
 #include "testing/gunit.h"
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+
+ABSL_DECLARE_FLAG(std::string, connector_matrix_mode);
 
 namespace mozc {
 
@@ -47,4 +53,15 @@ TEST(EngineFactoryTest, MobilePredictorOnAndroid) {
 #endif  // __ANDROID__
 }
 
+TEST(EngineFactoryTest, ConnectorMatrixMode) {
+  const std::string orig_mode = absl::GetFlag(FLAGS_connector_matrix_mode);
+  for (const char *mode : {"", "compressed", "dense_lazy", "dense_eager"}) {
+    absl::SetFlag(&FLAGS_connector_matrix_mode, mode);
+    EXPECT_OK(EngineFactory::Create()) << mode;
+  }
+  absl::SetFlag(&FLAGS_connector_matrix_mode, "unknown");
+  EXPECT_FALSE(EngineFactory::Create().ok());
+  absl::SetFlag(&FLAGS_connector_matrix_mode, orig_mode);
+}
+
 }  // namespace mozc
@@ -33,6 +33,7 @@
 #include <string>
 #include <vector>
 
+#include "base/memory_usage.h"
 #include "converter/converter_interface.h"
 #include "data_manager/data_manager_interface.h"
 #include "dictionary/suppression_dictionary.h"
@@ -80,6 +81,9 @@ class EngineInterface {
   // Gets the user POS list.
   virtual std::vector<std::string> GetPosList() const = 0;
 
+  // Reports the memory used by the modules of this engine to |collector|.
+  virtual void CollectMemoryUsage(MemoryUsageCollector *collector) const {}
+
  protected:
   EngineInterface() = default;
 };
@@ -50,6 +50,8 @@ class MockEngine : public EngineInterface {
   MOCK_METHOD(const DataManagerInterface *, GetDataManager, (),
               (const, override));
   MOCK_METHOD(std::vector<std::string>, GetPosList, (), (const, override));
+  MOCK_METHOD(void, CollectMemoryUsage, (MemoryUsageCollector * collector),
+              (const, override));
 };
 
 }  // namespace mozc
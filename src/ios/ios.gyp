@@ -116,6 +116,7 @@
           '<(PRODUCT_DIR)/libprediction_protocol.a',
           # libprotobuf is included in a different place.
           # '<(PRODUCT_DIR)/libprotobuf.a',
+          '<(PRODUCT_DIR)/librank_select_bit_vector_index.a',
           '<(PRODUCT_DIR)/librequest_test_util.a',
           '<(PRODUCT_DIR)/librewriter.a',
           '<(PRODUCT_DIR)/libsegmenter.a',
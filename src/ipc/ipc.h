@@ -30,6 +30,7 @@
 #ifndef MOZC_IPC_IPC_H_
 #define MOZC_IPC_IPC_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -56,8 +57,15 @@ enum {
 };
 
 // increment this value if protocol has changed.
+// Version 4: On Linux, messages are prefixed with their length and a
+// connection can be used for multiple calls. The transports of the other
+// platforms are unchanged and stay at version 3.
 enum {
+#ifdef __linux__
+  IPC_PROTOCOL_VERSION = 4,
+#else   // __linux__
   IPC_PROTOCOL_VERSION = 3,
+#endif  // __linux__
 };
 
 enum IPCErrorType {
@@ -80,6 +88,10 @@ class IPCClientInterface {
   virtual bool Call(const std::string &request, std::string *response,
                     absl::Duration timeout) = 0;
 
+  // Returns true if Call() can be invoked again on the same connection, i.e.,
+  // the connection is kept open and the server has not closed it.
+  virtual bool IsReusable() const { return false; }
+
   virtual uint32_t GetServerProtocolVersion() const = 0;
   virtual const std::string &GetServerProductVersion() const = 0;
   virtual uint32_t GetServerProcessId() const = 0;
@@ -143,11 +155,14 @@ class IPCClient : public IPCClientInterface {
   // Return true when IPC finishes successfully.
   // When Server doesn't send response within timeout, 'Call' returns false.
   // When timeout (in msec) is set -1, 'Call' waits forever.
-  // Note that on Linux and Windows, Call() closes the socket_. This means you
-  // cannot call the Call() function more than once.
+  // Note that on Windows, Call() closes the pipe. This means you cannot call
+  // the Call() function more than once. On Linux, the connection is kept
+  // open and Call() can be invoked repeatedly while IsReusable() is true.
   bool Call(const std::string &request, std::string *response,
             absl::Duration timeout) override;
 
+  bool IsReusable() const override;
+
   IPCErrorType GetLastIPCError() const override { return last_ipc_error_; }
 
   // terminate the server process named |name|
@@ -206,7 +221,7 @@ class IPCClientFactory : public IPCClientFactoryInterface {
   static IPCClientFactory *GetIPCClientFactory();
 };
 
-// Synchronous, Single-thread IPC Server
+// Synchronous IPC Server
 // Usage:
 // class MyEchoServer: public IPCServer {
 //  public:
@@ -249,6 +264,13 @@ class IPCServer {
   // Wait until the thread ends
   void Wait();
 
+  // Sets the number of threads calling Process(). With more than one
+  // worker, Process() can be called concurrently for requests on different
+  // connections, while the requests on one connection are processed in
+  // order. Only the Linux implementation runs multiple workers; it has to be
+  // called before Loop().
+  void SetNumWorkers(size_t num_workers) { num_workers_ = num_workers; }
+
   // Terminate select loop from other thread
   // On Win32, we make a control event to terminate
   // main loop gracefully. On Mac/Linux, we simply
@@ -280,6 +302,7 @@ class IPCServer {
 #endif  // _WIN32
 
   absl::Duration timeout_;
+  size_t num_workers_ = 1;
 };
 
 }  // namespace mozc
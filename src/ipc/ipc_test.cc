@@ -42,6 +42,7 @@
 #include "absl/random/distributions.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
@@ -77,6 +78,37 @@ class EchoServer : public mozc::IPCServer {
     return true;
   }
 };
+
+#if defined(__linux__) && !defined(__ANDROID__)
+// Holds the "wait" request until the "release" request is processed.
+class BlockingServer : public mozc::IPCServer {
+ public:
+  BlockingServer(const std::string &path, int32_t num_connections,
+                 absl::Duration timeout)
+      : IPCServer(path, num_connections, timeout) {}
+  bool Process(absl::string_view input, std::string *output) override {
+    if (input == "kill") {
+      output->clear();
+      return false;
+    }
+    if (input == "wait") {
+      waiting_.Notify();
+      *output = released_.WaitForNotificationWithTimeout(absl::Seconds(10))
+                    ? "released"
+                    : "timeout";
+      return true;
+    }
+    if (input == "release") {
+      released_.Notify();
+    }
+    output->assign(input.data(), input.size());
+    return true;
+  }
+
+  absl::Notification waiting_;
+  absl::Notification released_;
+};
+#endif  // __linux__ && !__ANDROID__
 }  // namespace
 
 TEST(IPCTest, IPCTest) {
@@ -135,3 +167,97 @@ TEST(IPCTest, IPCTest) {
 
   con.Wait();
 }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(IPCTest, PersistentConnection) {
+  mozc::SystemUtil::SetUserProfileDirectory(absl::GetFlag(FLAGS_test_tmpdir));
+
+  EchoServer con(kServerAddress, 10, absl::Milliseconds(1000));
+  con.LoopAndReturn();
+
+  // Each client keeps its connection for all the requests.
+  std::vector<mozc::Thread2> cons;
+  for (int i = 0; i < kNumThreads; ++i) {
+    cons.push_back(mozc::Thread2([] {
+      mozc::Random random;
+      mozc::IPCClient con(kServerAddress, "");
+      ASSERT_TRUE(con.Connected());
+      for (int i = 0; i < kNumRequests; ++i) {
+        ASSERT_TRUE(con.IsReusable());
+        const int size = absl::Uniform(random, 1, 8000);
+        const std::string input = absl::StrCat("test", random.ByteString(size));
+        std::string output;
+        ASSERT_TRUE(con.Call(input, &output, absl::Milliseconds(1000)));
+        EXPECT_EQ(output, input);
+      }
+    }));
+  }
+
+  for (mozc::Thread2 &con : cons) {
+    con.Join();
+  }
+
+  // The server finishes with an empty response.
+  mozc::IPCClient kill(kServerAddress, "");
+  std::string output = "not empty";
+  EXPECT_TRUE(kill.Call("kill", &output, absl::Milliseconds(1000)));
+  EXPECT_TRUE(output.empty());
+
+  con.Wait();
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(IPCTest, ClosedConnectionIsNotReusable) {
+  mozc::SystemUtil::SetUserProfileDirectory(absl::GetFlag(FLAGS_test_tmpdir));
+
+  EchoServer con(kServerAddress, 10, absl::Milliseconds(1000));
+  con.LoopAndReturn();
+
+  mozc::IPCClient client(kServerAddress, "");
+  ASSERT_TRUE(client.Connected());
+  std::string output;
+  ASSERT_TRUE(client.Call("test", &output, absl::Milliseconds(1000)));
+  EXPECT_TRUE(client.IsReusable());
+
+  mozc::IPCClient kill(kServerAddress, "");
+  EXPECT_TRUE(kill.Call("kill", &output, absl::Milliseconds(1000)));
+  con.Wait();
+
+  // The server has closed the kept connection, which must not be reused.
+  EXPECT_FALSE(client.IsReusable());
+}
+#endif  // __linux__ && !__ANDROID__
+
+TEST(IPCTest, ConcurrentWorkers) {
+  mozc::SystemUtil::SetUserProfileDirectory(absl::GetFlag(FLAGS_test_tmpdir));
+
+  BlockingServer con(kServerAddress, 10, absl::Seconds(10));
+  con.SetNumWorkers(2);
+  con.LoopAndReturn();
+
+  mozc::Thread2 waiter([] {
+    mozc::IPCClient con(kServerAddress, "");
+    ASSERT_TRUE(con.Connected());
+    std::string output;
+    ASSERT_TRUE(con.Call("wait", &output, absl::Seconds(20)));
+    EXPECT_EQ(output, "released");
+  });
+
+  // The second worker processes the request while the first one is blocked.
+  con.waiting_.WaitForNotification();
+  {
+    mozc::IPCClient con(kServerAddress, "");
+    ASSERT_TRUE(con.Connected());
+    std::string output;
+    ASSERT_TRUE(con.Call("release", &output, absl::Seconds(20)));
+    EXPECT_EQ(output, "release");
+  }
+  waiter.Join();
+
+  mozc::IPCClient kill(kServerAddress, "");
+  std::string output;
+  kill.Call("kill", &output, absl::Milliseconds(1000));
+
+  con.Wait();
+}
+#endif  // __linux__ && !__ANDROID__
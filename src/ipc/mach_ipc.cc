@@ -379,6 +379,10 @@ bool IPCClient::Connected() const {
   return manager->IsServerRunning(name_);
 }
 
+// Each Call() sends a message to the server port looked up again, so there is
+// no connection to reuse.
+bool IPCClient::IsReusable() const { return false; }
+
 // Server implementation
 IPCServer::IPCServer(const std::string &name, int32_t num_connections,
                      absl::Duration timeout)
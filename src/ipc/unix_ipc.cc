@@ -31,28 +31,39 @@
 #if defined(__linux__)
 
 #include <fcntl.h>
+#include <poll.h>
 #include <stddef.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/thread.h"
+#include "base/thread2.h"
 #include "ipc/ipc.h"
 #include "ipc/ipc_path_manager.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
 #ifndef UNIX_PATH_MAX
@@ -64,6 +75,15 @@ namespace {
 
 constexpr int kInvalidSocket = -1;
 
+// Every message is prefixed with its length so that a connection can carry
+// any number of requests and responses (see IPC_PROTOCOL_VERSION).
+constexpr size_t kMessageHeaderSize = 4;
+constexpr size_t kMaxMessageSize = 64 * 1024 * 1024;
+
+// Maximum number of connections IPCServer keeps open between requests. When
+// exceeded, the least recently used connection is closed.
+constexpr size_t kMaxPersistentConnections = 64;
+
 absl::Status mkdir_p(const std::string &dirname) {
   const std::string parent_dir = FileUtil::Dirname(dirname);
   struct stat st;
@@ -75,47 +95,36 @@ absl::Status mkdir_p(const std::string &dirname) {
   return FileUtil::CreateDirectory(dirname);
 }
 
-bool IsReadTimeout(int socket, absl::Duration timeout) {
+// Waits until |socket| gets ready for |events|. Returns true on timeout.
+// poll() is used instead of select() as the server may hold descriptors
+// beyond FD_SETSIZE.
+bool IsPollTimeout(int socket, short events, absl::Duration timeout) {
   if (timeout < absl::ZeroDuration()) {
     return false;
   }
-  fd_set fds;
-  struct timeval tv = absl::ToTimeval(timeout);
-  FD_ZERO(&fds);
-  FD_SET(socket, &fds);
-  if (select(socket + 1, &fds, nullptr, nullptr, &tv) < 0) {
+  pollfd fd = {socket, events, 0};
+  const int result = ::poll(&fd, 1, absl::ToInt64Milliseconds(timeout));
+  if (result < 0) {
     // Mac OS X and glibc implementations of strerror() return a pointer to a
     // string literal whenever errno is in a valid range, and thus thread-safe.
     // Probably we don't have to use the cumbersome strerror_r() function.
-    LOG(WARNING) << "select() failed: " << strerror(errno);
+    LOG(WARNING) << "poll() failed: " << strerror(errno);
     return true;
   }
-  if (FD_ISSET(socket, &fds)) {
+  if (result > 0) {
     return false;
   }
 
-  LOG(ERROR) << "FD_ISSET failed";
+  LOG(ERROR) << "poll() timed out";
   return true;
 }
 
-bool IsWriteTimeout(int socket, absl::Duration timeout) {
-  if (timeout < absl::ZeroDuration()) {
-    return false;
-  }
-  fd_set fds;
-  struct timeval tv = absl::ToTimeval(timeout);
-  FD_ZERO(&fds);
-  FD_SET(socket, &fds);
-  if (select(socket + 1, nullptr, &fds, nullptr, &tv) < 0) {
-    LOG(WARNING) << "select() failed: " << strerror(errno);
-    return true;
-  }
-  if (FD_ISSET(socket, &fds)) {
-    return false;
-  }
+bool IsReadTimeout(int socket, absl::Duration timeout) {
+  return IsPollTimeout(socket, POLLIN, timeout);
+}
 
-  LOG(ERROR) << "FD_ISSET failed";
-  return true;
+bool IsWriteTimeout(int socket, absl::Duration timeout) {
+  return IsPollTimeout(socket, POLLOUT, timeout);
 }
 
 bool IsPeerValid(int socket, pid_t *pid) {
@@ -146,56 +155,110 @@ bool IsPeerValid(int socket, pid_t *pid) {
   return true;
 }
 
-IPCErrorType SendMessage(int socket, const std::string &msg,
-                         absl::Duration timeout) {
-  int offset = 0;
-  while (msg.size() != offset) {
+IPCErrorType SendBytes(int socket, const char *data, size_t size,
+                       absl::Duration timeout) {
+  size_t offset = 0;
+  while (offset < size) {
     if (IsWriteTimeout(socket, timeout)) {
       LOG(WARNING) << "Write timeout " << timeout;
       return IPC_TIMEOUT_ERROR;
     }
     const ssize_t l =
-        ::send(socket, msg.data() + offset, msg.size() - offset, MSG_NOSIGNAL);
+        ::send(socket, data + offset, size - offset, MSG_NOSIGNAL);
     if (l < 0) {
       // An error occurs.
-      LOG(ERROR) << "an error occurred during sending \"" << msg.substr(offset)
-                 << "\": " << strerror(errno);
+      LOG(ERROR) << "an error occurred during send(): " << strerror(errno);
       return IPC_WRITE_ERROR;
     }
     offset += l;
   }
-  VLOG(1) << offset << " bytes sent";
   return IPC_NO_ERROR;
 }
 
-IPCErrorType RecvMessage(int socket, std::string *msg, absl::Duration timeout) {
-  if (!msg) {
-    LOG(WARNING) << "msg is nullptr";
-    return IPC_UNKNOWN_ERROR;
-  }
-  msg->resize(IPC_RESPONSESIZE);
-  ssize_t read_length = 0;
-  int offset = 0;
-  do {
+// Receives exactly |size| bytes. Returns IPC_NO_CONNECTION if the peer closed
+// the connection before sending any byte.
+IPCErrorType RecvBytes(int socket, char *data, size_t size,
+                       absl::Duration timeout) {
+  size_t offset = 0;
+  while (offset < size) {
     if (IsReadTimeout(socket, timeout)) {
       LOG(WARNING) << "Read timeout " << timeout;
-      msg->clear();
       return IPC_TIMEOUT_ERROR;
     }
-    read_length = ::recv(socket, msg->data() + offset, msg->size() - offset,
-                         /* flags */ 0);
+    const ssize_t read_length =
+        ::recv(socket, data + offset, size - offset, /* flags */ 0);
     if (read_length < 0) {
       LOG(ERROR) << "an error occurred during recv(): " << strerror(errno);
-      msg->clear();
       return IPC_READ_ERROR;
     }
-    offset += read_length;
-    if (msg->size() == offset) {
-      msg->resize(msg->size() * 2);
+    if (read_length == 0) {
+      if (offset == 0) {
+        return IPC_NO_CONNECTION;
+      }
+      LOG(ERROR) << "connection closed after " << offset << " of " << size
+                 << " bytes";
+      return IPC_READ_ERROR;
     }
-  } while (read_length != 0);
-  VLOG(1) << offset << " bytes received";
-  msg->resize(offset);
+    offset += read_length;
+  }
+  return IPC_NO_ERROR;
+}
+
+IPCErrorType SendMessage(int socket, const std::string &msg,
+                         absl::Duration timeout) {
+  if (msg.size() > kMaxMessageSize) {
+    LOG(ERROR) << "too large message: " << msg.size() << " bytes";
+    return IPC_WRITE_ERROR;
+  }
+  char header[kMessageHeaderSize];
+  for (size_t i = 0; i < kMessageHeaderSize; ++i) {
+    header[i] = static_cast<char>((msg.size() >> (8 * i)) & 0xFF);
+  }
+  if (const IPCErrorType error =
+          SendBytes(socket, header, kMessageHeaderSize, timeout);
+      error != IPC_NO_ERROR) {
+    return error;
+  }
+  if (const IPCErrorType error =
+          SendBytes(socket, msg.data(), msg.size(), timeout);
+      error != IPC_NO_ERROR) {
+    return error;
+  }
+  VLOG(1) << msg.size() << " bytes sent";
+  return IPC_NO_ERROR;
+}
+
+// Returns IPC_NO_CONNECTION if the peer closed the connection between
+// messages.
+IPCErrorType RecvMessage(int socket, std::string *msg, absl::Duration timeout) {
+  if (!msg) {
+    LOG(WARNING) << "msg is nullptr";
+    return IPC_UNKNOWN_ERROR;
+  }
+  msg->clear();
+  char header[kMessageHeaderSize];
+  if (const IPCErrorType error =
+          RecvBytes(socket, header, kMessageHeaderSize, timeout);
+      error != IPC_NO_ERROR) {
+    return error;
+  }
+  size_t size = 0;
+  for (size_t i = 0; i < kMessageHeaderSize; ++i) {
+    size |= static_cast<size_t>(static_cast<uint8_t>(header[i])) << (8 * i);
+  }
+  if (size > kMaxMessageSize) {
+    LOG(ERROR) << "too large message: " << size << " bytes";
+    return IPC_READ_ERROR;
+  }
+  msg->resize(size);
+  if (const IPCErrorType error = RecvBytes(socket, msg->data(), size, timeout);
+      error != IPC_NO_ERROR) {
+    msg->clear();
+    // The header has been received, so the connection closed in the middle
+    // of the message.
+    return error == IPC_NO_CONNECTION ? IPC_READ_ERROR : error;
+  }
+  VLOG(1) << size << " bytes received";
   return IPC_NO_ERROR;
 }
 
@@ -218,6 +281,240 @@ void SetCloseOnExecFlag(int fd) {
 bool IsAbstractSocket(const std::string &address) {
   return (!address.empty()) && (address[0] == '\0');
 }
+
+// Result of serving one request on a connection.
+enum class ServeResult {
+  kKeep,    // Keep the connection for the next request.
+  kClose,   // Close the connection.
+  kFinish,  // Close the connection and finish the server loop.
+};
+
+// Owns the connections accepted by IPCServer and runs their requests on
+// worker threads. Connections are registered to the epoll instance with
+// EPOLLONESHOT, so a connection is handed to at most one worker at a time and
+// the requests on it are processed in order.
+class ConnectionDispatcher {
+ public:
+  ConnectionDispatcher(int listen_socket, size_t num_workers,
+                       std::function<ServeResult(int)> serve);
+  ConnectionDispatcher(const ConnectionDispatcher &) = delete;
+  ConnectionDispatcher &operator=(const ConnectionDispatcher &) = delete;
+  // Stops the workers and closes all the connections.
+  ~ConnectionDispatcher();
+
+  bool IsAvailable() const { return epoll_fd_ >= 0 && wakeup_fd_ >= 0; }
+
+  // Waits for events and handles them. Returns false when the server loop
+  // should finish.
+  bool WaitAndDispatch();
+
+ private:
+  void Accept();
+  void Dispatch(int connection);
+  void WorkerLoop();
+  void CloseLocked(int connection) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int listen_socket_;
+  const int epoll_fd_;
+  // Written by a worker to wake up WaitAndDispatch() when finishing.
+  const int wakeup_fd_;
+  const std::function<ServeResult(int)> serve_;
+
+  absl::Mutex mutex_;
+  // Readable connections waiting for a worker.
+  std::deque<int> pending_ ABSL_GUARDED_BY(mutex_);
+  // Connections waiting for the next request, from the least recently used.
+  std::vector<int> idle_ ABSL_GUARDED_BY(mutex_);
+  size_t num_connections_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool finished_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::vector<Thread2> workers_;
+};
+
+ConnectionDispatcher::ConnectionDispatcher(
+    int listen_socket, size_t num_workers,
+    std::function<ServeResult(int)> serve)
+    : listen_socket_(listen_socket),
+      epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)),
+      wakeup_fd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      serve_(std::move(serve)) {
+  if (!IsAvailable()) {
+    LOG(ERROR) << "epoll_create1() or eventfd() failed: " << strerror(errno);
+    return;
+  }
+  for (const int fd : {listen_socket_, wakeup_fd_}) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      LOG(ERROR) << "epoll_ctl() failed: " << strerror(errno);
+    }
+  }
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < std::max<size_t>(num_workers, 1); ++i) {
+    workers_.push_back(Thread2([this] { WorkerLoop(); }));
+  }
+}
+
+ConnectionDispatcher::~ConnectionDispatcher() {
+  {
+    absl::MutexLock l(&mutex_);
+    stopped_ = true;
+  }
+  // Workers finish the request in progress.
+  for (Thread2 &worker : workers_) {
+    worker.Join();
+  }
+  {
+    absl::MutexLock l(&mutex_);
+    for (const int connection : pending_) {
+      ::close(connection);
+    }
+    for (const int connection : idle_) {
+      ::close(connection);
+    }
+    pending_.clear();
+    idle_.clear();
+  }
+  if (wakeup_fd_ >= 0) {
+    ::close(wakeup_fd_);
+  }
+  if (epoll_fd_ >= 0) {
+    ::close(epoll_fd_);
+  }
+}
+
+bool ConnectionDispatcher::WaitAndDispatch() {
+  std::array<epoll_event, 16> events;
+  const int num_events =
+      ::epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+  if (num_events < 0) {
+    if (errno == EINTR) {
+      return true;
+    }
+    LOG(FATAL) << "epoll_wait() failed: " << strerror(errno);
+    return false;
+  }
+
+  // Connections are dispatched before accepting new ones, as an accepted
+  // socket may reuse the descriptor of a connection evicted in Accept().
+  bool accept = false;
+  for (int i = 0; i < num_events; ++i) {
+    const int fd = events[i].data.fd;
+    if (fd == listen_socket_) {
+      accept = true;
+    } else if (fd != wakeup_fd_) {
+      Dispatch(fd);
+    }
+  }
+
+  {
+    absl::MutexLock l(&mutex_);
+    if (finished_) {
+      return false;
+    }
+  }
+  if (accept) {
+    Accept();
+  }
+  return true;
+}
+
+void ConnectionDispatcher::Accept() {
+  const int new_sock = ::accept(listen_socket_, nullptr, nullptr);
+  if (new_sock < 0) {
+    LOG(FATAL) << "accept() failed: " << strerror(errno);
+    return;
+  }
+  pid_t pid = 0;
+  if (!IsPeerValid(new_sock, &pid)) {
+    ::close(new_sock);
+    return;
+  }
+  SetCloseOnExecFlag(new_sock);
+
+  absl::MutexLock l(&mutex_);
+  if (num_connections_ >= kMaxPersistentConnections && !idle_.empty()) {
+    VLOG(1) << "closing the least recently used connection";
+    const int connection = idle_.front();
+    idle_.erase(idle_.begin());
+    CloseLocked(connection);
+  }
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.fd = new_sock;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, new_sock, &event) != 0) {
+    LOG(ERROR) << "epoll_ctl() failed: " << strerror(errno);
+    ::close(new_sock);
+    return;
+  }
+  idle_.push_back(new_sock);
+  ++num_connections_;
+}
+
+void ConnectionDispatcher::Dispatch(int connection) {
+  absl::MutexLock l(&mutex_);
+  const auto it = std::find(idle_.begin(), idle_.end(), connection);
+  if (it == idle_.end()) {
+    return;
+  }
+  idle_.erase(it);
+  pending_.push_back(connection);
+}
+
+void ConnectionDispatcher::WorkerLoop() {
+  while (true) {
+    int connection = kInvalidSocket;
+    {
+      absl::MutexLock l(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](ConnectionDispatcher *self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+               self->mutex_) {
+            return self->stopped_ || !self->pending_.empty();
+          },
+          this));
+      if (stopped_) {
+        return;
+      }
+      connection = pending_.front();
+      pending_.pop_front();
+    }
+
+    const ServeResult result = serve_(connection);
+
+    absl::MutexLock l(&mutex_);
+    if (result == ServeResult::kFinish && !finished_) {
+      finished_ = true;
+      const uint64_t one = 1;
+      if (::write(wakeup_fd_, &one, sizeof(one)) < 0) {
+        LOG(ERROR) << "write() to eventfd failed: " << strerror(errno);
+      }
+    }
+    if (result != ServeResult::kKeep || finished_) {
+      CloseLocked(connection);
+      continue;
+    }
+    // The connection has to be in |idle_| before it is armed again, so that
+    // the event is not ignored by Dispatch().
+    idle_.push_back(connection);
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = connection;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection, &event) != 0) {
+      LOG(ERROR) << "epoll_ctl() failed: " << strerror(errno);
+      idle_.pop_back();
+      CloseLocked(connection);
+    }
+  }
+}
+
+void ConnectionDispatcher::CloseLocked(int connection) {
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection, nullptr);
+  ::close(connection);
+  --num_connections_;
+}
+
 }  // namespace
 
 // Client
@@ -320,14 +617,6 @@ bool IPCClient::Call(const std::string &request, std::string *response,
     return false;
   }
 
-  // Half-close the socket so that mozc_server could know the length of the
-  // request data. Without this, RecvMessage() in mozc_server would fail with
-  // timeout.
-  // TODO(yusukes): It would be also possible to modify Send and RecvMessage()
-  // so that they send/recv the payload size explicitly together with the actual
-  // data. Will revisit later.
-  ::shutdown(socket_, SHUT_WR);
-
   last_ipc_error_ = RecvMessage(socket_, response, timeout);
   if (last_ipc_error_ != IPC_NO_ERROR) {
     LOG(ERROR) << "RecvMessage failed";
@@ -339,6 +628,16 @@ bool IPCClient::Call(const std::string &request, std::string *response,
 
 bool IPCClient::Connected() const { return connected_; }
 
+bool IPCClient::IsReusable() const {
+  if (!connected_) {
+    return false;
+  }
+  // The server sends nothing between calls, so a readable socket means that
+  // the server has closed the connection.
+  pollfd pfd = {socket_, POLLIN, 0};
+  return ::poll(&pfd, 1, 0) == 0;
+}
+
 // Server
 IPCServer::IPCServer(const std::string &name, int32_t num_connections,
                      absl::Duration timeout)
@@ -427,44 +726,49 @@ IPCServer::~IPCServer() {
 bool IPCServer::Connected() const { return connected_; }
 
 void IPCServer::Loop() {
-  // The most portable and straightforward single-thread server
-  bool error = false;
-  pid_t pid = 0;
-  std::string request;
-  std::string response;
-  while (!error) {
-    const int new_sock = ::accept(socket_, nullptr, nullptr);
-    if (new_sock < 0) {
-      LOG(FATAL) << "accept() failed: " << strerror(errno);
+  // The calling thread waits for the events on the listening socket and the
+  // kept connections, and |num_workers_| threads process the requests.
+  {
+    ConnectionDispatcher dispatcher(
+        socket_, num_workers_, [this](int connection) {
+          std::string request;
+          const IPCErrorType recv_error =
+              RecvMessage(connection, &request, timeout_);
+          if (recv_error == IPC_NO_CONNECTION) {
+            VLOG(1) << "connection closed by the client";
+            return ServeResult::kClose;
+          }
+          if (recv_error != IPC_NO_ERROR) {
+            LOG(WARNING) << "RecvMessage() failed";
+            return ServeResult::kClose;
+          }
+
+          std::string response;
+          ServeResult result = ServeResult::kKeep;
+          if (!Process(request, &response)) {
+            LOG(WARNING) << "Process() failed";
+            result = ServeResult::kFinish;
+            // Clients observe an empty response when the server finishes.
+            response.clear();
+          }
+
+          if (response.empty()) {
+            LOG(WARNING) << "response is empty";
+          }
+
+          if (SendMessage(connection, response, timeout_) != IPC_NO_ERROR) {
+            LOG(WARNING) << "SendMessage() failed";
+            return result == ServeResult::kFinish ? result
+                                                  : ServeResult::kClose;
+          }
+          return result;
+        });
+    if (!dispatcher.IsAvailable()) {
+      LOG(FATAL) << "Cannot start the server loop";
       return;
     }
-    if (!IsPeerValid(new_sock, &pid)) {
-      continue;
-    }
-
-    if (RecvMessage(new_sock, &request, timeout_) != IPC_NO_ERROR) {
-      LOG(WARNING) << "RecvMessage() failed";
-      ::close(new_sock);
-      continue;
+    while (dispatcher.WaitAndDispatch()) {
     }
-
-    if (!Process(request, &response)) {
-      LOG(WARNING) << "Process() failed";
-      ::close(new_sock);
-      error = true;
-      continue;
-    }
-
-    if (response.empty()) {
-      LOG(WARNING) << "response is empty";
-      ::close(new_sock);
-      continue;
-    }
-
-    if (SendMessage(new_sock, response, timeout_) != IPC_NO_ERROR) {
-      LOG(WARNING) << "SendMessage() failed";
-    }
-    ::close(new_sock);
   }
 
   ::shutdown(socket_, SHUT_RDWR);
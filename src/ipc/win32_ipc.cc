@@ -753,6 +753,9 @@ IPCClient::~IPCClient() {}
 
 bool IPCClient::Connected() const { return connected_; }
 
+// Call() closes the pipe.
+bool IPCClient::IsReusable() const { return false; }
+
 bool IPCClient::Call(const std::string &request, std::string *response,
                      absl::Duration timeout) {
   last_ipc_error_ = IPC_NO_ERROR;
@@ -31,7 +31,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <set>
 #include <string>
@@ -39,6 +42,7 @@
 #include <vector>
 
 #include "base/japanese_util.h"
+#include "base/thread2.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "composer/type_corrected_query.h"
@@ -56,9 +60,14 @@
 #include "protocol/commands.pb.h"
 #include "request/conversion_request.h"
 #include "transliteration/transliteration.h"
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 
 #ifndef NDEBUG
 #define MOZC_DEBUG
@@ -87,12 +96,26 @@ using ::mozc::dictionary::Token;
 constexpr size_t kSuggestionMaxResultsSize = 256;
 constexpr size_t kPredictionMaxResultsSize = 100000;
 
+// Typing correction is skipped if the other sources already produced more
+// results than this.
+constexpr size_t kMaxPrevResultsSizeForTypingCorrection = 10000;
+
+// Number of the threads running the aggregation steps in parallel in addition
+// to the calling thread. Up to four steps are independent of each other.
+constexpr size_t kNumAggregationWorkers = 3;
+
 bool IsEnableSingleKanjiPrediction(const ConversionRequest &request) {
   return request.request()
       .decoder_experiment_params()
       .enable_single_kanji_prediction();
 }
 
+bool IsParallelAggregationEnabled(const ConversionRequest &request) {
+  return request.request()
+      .decoder_experiment_params()
+      .enable_parallel_prediction_aggregation();
+}
+
 // Returns true if the |target| may be reduncant result.
 bool MaybeRedundant(const absl::string_view reference,
                     const absl::string_view target) {
@@ -460,6 +483,63 @@ class DictionaryPredictionAggregator::PrefixLookupCallback
   std::vector<Result> *results_;
 };
 
+// Runs the scheduled tasks on threads kept for the lifetime of the executor,
+// so that the parallel aggregation does not start threads for every key.
+class DictionaryPredictionAggregator::StepExecutor {
+ public:
+  explicit StepExecutor(size_t num_workers) {
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers_.push_back(Thread2([this] { WorkerLoop(); }));
+    }
+  }
+
+  StepExecutor(const StepExecutor &) = delete;
+  StepExecutor &operator=(const StepExecutor &) = delete;
+
+  ~StepExecutor() {
+    {
+      absl::MutexLock l(&mutex_);
+      stopped_ = true;
+    }
+    for (Thread2 &worker : workers_) {
+      worker.Join();
+    }
+  }
+
+  void Schedule(std::function<void()> task) {
+    absl::MutexLock l(&mutex_);
+    tasks_.push_back(std::move(task));
+  }
+
+ private:
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        absl::MutexLock l(&mutex_);
+        mutex_.Await(absl::Condition(
+            +[](StepExecutor *self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                 self->mutex_) {
+              return self->stopped_ || !self->tasks_.empty();
+            },
+            this));
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> tasks_ ABSL_GUARDED_BY(mutex_);
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<Thread2> workers_;
+};
+
 DictionaryPredictionAggregator::DictionaryPredictionAggregator(
     const DataManagerInterface &data_manager,
     const ConverterInterface *converter,
@@ -506,6 +586,8 @@ DictionaryPredictionAggregator::DictionaryPredictionAggregator(
                                zero_query_number_string_array_data);
 }
 
+DictionaryPredictionAggregator::~DictionaryPredictionAggregator() = default;
+
 std::vector<Result> DictionaryPredictionAggregator::AggregateResults(
     const ConversionRequest &request, const Segments &segments) const {
   std::vector<Result> results;
@@ -586,68 +668,188 @@ PredictionTypes DictionaryPredictionAggregator::AggregatePrediction(
       return NO_PREDICTION;
     }
   }
-  PredictionTypes selected_types = NO_PREDICTION;
+  // The sources only append to the results. Some are skipped when the
+  // preceding ones produced too many results, and the dictionary lookups stop
+  // when the total number of the results reaches their limit.
+  constexpr size_t kNoLimit = std::numeric_limits<size_t>::max();
+  std::vector<AggregationStep> steps;
   if (ShouldAggregateRealTimeConversionResults(request, segments)) {
-    AggregateRealtimeConversion(request, realtime_max_size, segments, results);
-    selected_types |= REALTIME;
+    steps.push_back({[&](std::vector<Result> *results) -> PredictionTypes {
+      AggregateRealtimeConversion(request, realtime_max_size, segments,
+                                  results);
+      return REALTIME;
+    }});
   }
   // In partial suggestion or prediction, only realtime candidates are used.
   if (request.request_type() == ConversionRequest::PARTIAL_SUGGESTION ||
       request.request_type() == ConversionRequest::PARTIAL_PREDICTION) {
-    return selected_types;
+    return RunAggregationSteps(request, steps, results);
   }
 
   // Add unigram candidates.
   const size_t min_unigram_key_len = unigram_config.min_key_len;
   if (key_len >= min_unigram_key_len) {
-    const auto &unigram_fn = unigram_config.unigram_fn;
-    PredictionType type = (this->*unigram_fn)(request, segments, results);
-    selected_types |= type;
-  }
-
-  if (key_len > 0 && AggregateNumberCandidates(request, segments, results)) {
-    selected_types |= NUMBER;
+    // The mixed conversion looks up into its own vector.
+    const bool is_mixed_conversion_unigram =
+        unigram_config.unigram_fn ==
+        &DictionaryPredictionAggregator::
+            AggregateUnigramCandidateForMixedConversion;
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           const auto &unigram_fn = unigram_config.unigram_fn;
+           return (this->*unigram_fn)(request, segments, results);
+         },
+         kNoLimit, !is_mixed_conversion_unigram});
+  }
+
+  if (key_len > 0) {
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           return AggregateNumberCandidates(request, segments, results)
+                      ? NUMBER
+                      : NO_PREDICTION;
+         },
+         GetCandidateCutoffThreshold(request.request_type())});
   }
 
   // Add bigram candidates.
   constexpr int kMinHistoryKeyLen = 3;
   if (HasHistoryKeyLongerThanOrEqualTo(segments, kMinHistoryKeyLen)) {
-    AggregateBigramPrediction(request, segments,
-                              Segment::Candidate::SOURCE_INFO_NONE, results);
-    selected_types |= BIGRAM;
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           AggregateBigramPrediction(
+               request, segments, Segment::Candidate::SOURCE_INFO_NONE,
+               results);
+           return BIGRAM;
+         },
+         kNoLimit, true});
   }
 
   // Add english candidates.
   if (IsLanguageAwareInputEnabled(request) && IsQwertyMobileTable(request) &&
       key_len >= min_unigram_key_len) {
-    AggregateEnglishPredictionUsingRawInput(request, segments, results);
-    selected_types |= ENGLISH;
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           AggregateEnglishPredictionUsingRawInput(request, segments, results);
+           return ENGLISH;
+         },
+         kNoLimit, true});
   }
 
   // Add typing correction candidates.
   constexpr int kMinTypingCorrectionKeyLen = 3;
   if (IsTypingCorrectionEnabled(request) &&
       key_len >= kMinTypingCorrectionKeyLen) {
-    AggregateTypeCorrectingPrediction(request, segments, results);
-    selected_types |= TYPING_CORRECTION;
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           AggregateTypeCorrectingPrediction(request, segments, results);
+           return TYPING_CORRECTION;
+         },
+         kMaxPrevResultsSizeForTypingCorrection, true});
   }
 
   if (IsMixedConversionEnabled(request.request())) {
-    AggregatePrefixCandidates(request, segments, results);
-    selected_types |= PREFIX;
+    steps.push_back(
+        {[&](std::vector<Result> *results) -> PredictionTypes {
+           AggregatePrefixCandidates(request, segments, results);
+           return PREFIX;
+         },
+         GetCandidateCutoffThreshold(request.request_type()), true});
   }
 
   if (IsEnableSingleKanjiPrediction(request)) {
-    const std::vector<Result> single_kanji_results =
-        single_kanji_prediction_aggregator_->AggregateResults(request,
-                                                              segments);
-    if (!single_kanji_results.empty()) {
+    steps.push_back({[&](std::vector<Result> *results) -> PredictionTypes {
+      const std::vector<Result> single_kanji_results =
+          single_kanji_prediction_aggregator_->AggregateResults(request,
+                                                                segments);
+      if (single_kanji_results.empty()) {
+        return NO_PREDICTION;
+      }
       results->insert(results->end(), single_kanji_results.begin(),
                       single_kanji_results.end());
-      selected_types |= SINGLE_KANJI;
+      return SINGLE_KANJI;
+    }});
+  }
+
+  return RunAggregationSteps(request, steps, results);
+}
+
+PredictionTypes DictionaryPredictionAggregator::RunAggregationSteps(
+    const ConversionRequest &request, absl::Span<const AggregationStep> steps,
+    std::vector<Result> *results) const {
+  PredictionTypes selected_types = NO_PREDICTION;
+  std::vector<size_t> concurrent_steps;
+  for (size_t i = 0; i < steps.size(); ++i) {
+    if (!steps[i].depends_on_prev_results) {
+      concurrent_steps.push_back(i);
+    }
+  }
+  if (!IsParallelAggregationEnabled(request) || concurrent_steps.size() <= 1) {
+    for (const AggregationStep &step : steps) {
+      // Past the deadline, return what the preceding steps have found.
+      if (!results->empty() && request.IsDeadlineExceeded()) {
+        break;
+      }
+      if (results->size() <= step.max_prev_results_size) {
+        selected_types |= step.aggregate(results);
+      }
     }
+    return selected_types;
   }
 
+  // The independent steps append to their own buffers. The first one runs on
+  // this thread. A step that would start after the deadline is skipped.
+  struct StepOutput {
+    std::vector<Result> results;
+    PredictionTypes types = NO_PREDICTION;
+    bool skipped = false;
+  };
+  std::vector<StepOutput> outputs(steps.size());
+  const auto run_step = [&request, &steps, &outputs](size_t i) {
+    if (request.IsDeadlineExceeded()) {
+      outputs[i].skipped = true;
+      return;
+    }
+    outputs[i].types = steps[i].aggregate(&outputs[i].results);
+  };
+  // The steps read the composer concurrently.
+  if (request.has_composer()) {
+    request.composer().FillCaches();
+  }
+  absl::call_once(step_executor_once_, [this] {
+    step_executor_ = std::make_unique<StepExecutor>(kNumAggregationWorkers);
+  });
+  absl::BlockingCounter pending_steps(concurrent_steps.size() - 1);
+  for (size_t i = 1; i < concurrent_steps.size(); ++i) {
+    step_executor_->Schedule(
+        [&run_step, &pending_steps, step = concurrent_steps[i]] {
+          run_step(step);
+          pending_steps.DecrementCount();
+        });
+  }
+  run_step(concurrent_steps[0]);
+  pending_steps.Wait();
+
+  // Merge in the order of the steps, skipping the same steps as the serial
+  // execution would. The dependent steps, and the skipped ones while there is
+  // no result yet, run here on the merged results.
+  for (size_t i = 0; i < steps.size(); ++i) {
+    // Past the deadline, return what the preceding steps have found.
+    if (!results->empty() && request.IsDeadlineExceeded()) {
+      break;
+    }
+    if (results->size() > steps[i].max_prev_results_size) {
+      continue;
+    }
+    if (steps[i].depends_on_prev_results || outputs[i].skipped) {
+      selected_types |= steps[i].aggregate(results);
+      continue;
+    }
+    results->insert(results->end(),
+                    std::make_move_iterator(outputs[i].results.begin()),
+                    std::make_move_iterator(outputs[i].results.end()));
+    selected_types |= outputs[i].types;
+  }
   return selected_types;
 }
 
@@ -827,8 +1029,10 @@ void DictionaryPredictionAggregator::AggregateRealtimeConversion(
   DCHECK(converter_);
   DCHECK(immutable_converter_);
   DCHECK(results);
-  // First insert a top conversion result.
-  if (request.use_actual_converter_for_realtime_conversion()) {
+  // First insert a top conversion result. This runs the whole converter
+  // including rewriters, so skip it once the deadline has passed.
+  if (request.use_actual_converter_for_realtime_conversion() &&
+      !request.IsDeadlineExceeded()) {
     if (!PushBackTopConversionResult(request, segments, results)) {
       LOG(WARNING) << "Realtime conversion with converter failed";
     }
@@ -1529,7 +1733,7 @@ void DictionaryPredictionAggregator::AggregateTypeCorrectingPrediction(
   DCHECK(dictionary_);
 
   const size_t prev_results_size = results->size();
-  if (prev_results_size > 10000) {
+  if (prev_results_size > kMaxPrevResultsSizeForTypingCorrection) {
     return;
   }
 
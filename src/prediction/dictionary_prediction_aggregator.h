@@ -32,6 +32,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -51,7 +53,9 @@
 #include "prediction/single_kanji_prediction_aggregator.h"
 #include "prediction/zero_query_dict.h"
 #include "request/conversion_request.h"
+#include "absl/base/call_once.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 namespace prediction {
@@ -62,7 +66,7 @@ class DictionaryPredictionAggregator : public PredictionAggregatorInterface {
       delete;
   DictionaryPredictionAggregator &operator=(
       const DictionaryPredictionAggregator &) = delete;
-  ~DictionaryPredictionAggregator() override = default;
+  ~DictionaryPredictionAggregator() override;
 
   DictionaryPredictionAggregator(
       const DataManagerInterface &data_manager,
@@ -79,6 +83,7 @@ class DictionaryPredictionAggregator : public PredictionAggregatorInterface {
   class PredictiveLookupCallback;
   class PrefixLookupCallback;
   class PredictiveBigramLookupCallback;
+  class StepExecutor;
 
   using AggregateUnigramFn = PredictionType (DictionaryPredictionAggregator::*)(
       const ConversionRequest &request, const Segments &segments,
@@ -89,6 +94,18 @@ class DictionaryPredictionAggregator : public PredictionAggregatorInterface {
     size_t min_key_len;
   };
 
+  // A prediction source run by AggregatePrediction(). |aggregate| appends the
+  // results to the given vector and returns the used prediction types. The
+  // step is skipped if the preceding steps produced more results than
+  // |max_prev_results_size|. |depends_on_prev_results| is set when the results
+  // also depend on the preceding ones, e.g. a lookup limited by the total size
+  // of the vector. Such a step does not run concurrently with the others.
+  struct AggregationStep {
+    std::function<PredictionTypes(std::vector<Result> *)> aggregate;
+    size_t max_prev_results_size = std::numeric_limits<size_t>::max();
+    bool depends_on_prev_results = false;
+  };
+
   // For testing
   DictionaryPredictionAggregator(
       const DataManagerInterface &data_manager,
@@ -112,6 +129,14 @@ class DictionaryPredictionAggregator : public PredictionAggregatorInterface {
                                       const Segments &segments,
                                       std::vector<Result> *results) const;
 
+  // Runs |steps| and appends their results to |results| in order. The steps
+  // that do not depend on the preceding results run concurrently if
+  // enable_parallel_prediction_aggregation is set. The results are the same
+  // either way.
+  PredictionTypes RunAggregationSteps(const ConversionRequest &request,
+                                      absl::Span<const AggregationStep> steps,
+                                      std::vector<Result> *results) const;
+
   // Looks up the given range and appends zero query candidate list for |key|
   // to |results|.
   // Returns false if there is no result for |key|.
@@ -288,6 +313,11 @@ class DictionaryPredictionAggregator : public PredictionAggregatorInterface {
   NumberDecoder number_decoder_;
   std::unique_ptr<PredictionAggregatorInterface>
       single_kanji_prediction_aggregator_;
+
+  // Runs the concurrent aggregation steps. Started by the first parallel
+  // aggregation and kept for the following ones.
+  mutable absl::once_flag step_executor_once_;
+  mutable std::unique_ptr<StepExecutor> step_executor_;
 };
 
 }  // namespace prediction
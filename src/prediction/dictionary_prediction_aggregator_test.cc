@@ -42,6 +42,7 @@
 #include "base/container/serialized_string_array.h"
 #include "base/logging.h"
 #include "base/system_util.h"
+#include "base/util.h"
 #include "composer/composer.h"
 #include "composer/internal/typing_model.h"
 #include "composer/table.h"
@@ -70,6 +71,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace prediction {
@@ -2708,6 +2710,145 @@ TEST_F(DictionaryPredictionAggregatorTest, SingleKanji) {
   }
 }
 
+TEST_F(DictionaryPredictionAggregatorTest, ParallelAggregation) {
+  std::unique_ptr<MockDataAndAggregator> data_and_aggregator =
+      CreateAggregatorWithMockData();
+  const DictionaryPredictionAggregatorTestPeer &aggregator =
+      data_and_aggregator->aggregator();
+  commands::RequestForUnitTest::FillMobileRequest(request_.get());
+  request_->mutable_decoder_experiment_params()
+      ->set_enable_single_kanji_prediction(true);
+  {
+    MockSingleKanjiPredictionAggregator *mock =
+        data_and_aggregator->mutable_single_kanji_prediction_aggregator();
+    EXPECT_CALL(*mock, AggregateResults(_, _)).Times(2);
+  }
+
+  Segments segments;
+  SetUpInputForSuggestion("よんじゅうごかい", composer_.get(), &segments);
+
+  const auto get_values = [](const std::vector<Result> &results) {
+    std::vector<std::pair<std::string, PredictionTypes>> values;
+    for (const Result &result : results) {
+      values.emplace_back(result.value, result.types);
+    }
+    return values;
+  };
+
+  std::vector<Result> serial_results;
+  const PredictionTypes serial_types = aggregator.AggregatePredictionForRequest(
+      *prediction_convreq_, segments, &serial_results);
+
+  // The results are merged in the same order as the serial aggregation.
+  request_->mutable_decoder_experiment_params()
+      ->set_enable_parallel_prediction_aggregation(true);
+  std::vector<Result> parallel_results;
+  EXPECT_EQ(aggregator.AggregatePredictionForRequest(
+                *prediction_convreq_, segments, &parallel_results),
+            serial_types);
+  EXPECT_EQ(get_values(parallel_results), get_values(serial_results));
+  EXPECT_TRUE(FindResultByValue(parallel_results, "45"));
+}
+
+TEST_F(DictionaryPredictionAggregatorTest,
+       ParallelAggregationAcrossPrefixCutoff) {
+  std::unique_ptr<MockDataAndAggregator> data_and_aggregator =
+      CreateAggregatorWithMockData();
+  const DictionaryPredictionAggregatorTestPeer &aggregator =
+      data_and_aggregator->aggregator();
+  commands::RequestForUnitTest::FillMobileRequest(request_.get());
+  const size_t cutoff =
+      aggregator.GetCandidateCutoffThreshold(ConversionRequest::SUGGESTION);
+
+  Segments segments;
+  SetUpInputForSuggestion("あいうえお", composer_.get(), &segments);
+
+  const auto get_values = [](const std::vector<Result> &results) {
+    std::vector<std::pair<std::string, PredictionTypes>> values;
+    for (const Result &result : results) {
+      values.emplace_back(result.value, result.types);
+    }
+    return values;
+  };
+
+  // The prefix candidates are aggregated only when the preceding unigram
+  // results do not exceed the cutoff threshold. The values of the unigram
+  // results start with different characters so that none is redundant.
+  for (const size_t num_unigram_results : {cutoff - 1, cutoff, cutoff + 1}) {
+    SCOPED_TRACE(num_unigram_results);
+    MockDictionary *mock = data_and_aggregator->mutable_dictionary();
+    ::testing::Mock::VerifyAndClearExpectations(mock);
+    std::vector<Token> tokens;
+    for (size_t i = 0; i < num_unigram_results; ++i) {
+      std::string value;
+      Util::Ucs4ToUtf8(0x4E00 + i, &value);
+      value.append("か");
+      tokens.emplace_back("あいうえおか", value,
+                          MockDictionary::kDefaultCost + i,
+                          MockDictionary::kDefaultPosId,
+                          MockDictionary::kDefaultPosId, Token::NONE);
+    }
+    EXPECT_CALL(*mock, LookupPredictive(_, _, _))
+        .WillRepeatedly(InvokeCallbackWithTokens(tokens));
+    EXPECT_CALL(*mock, LookupPrefix(_, _, _))
+        .WillRepeatedly(InvokeCallbackWithKeyValues({{"あいう", "愛鵜"}}));
+
+    request_->mutable_decoder_experiment_params()
+        ->set_enable_parallel_prediction_aggregation(false);
+    std::vector<Result> serial_results;
+    const PredictionTypes serial_types =
+        aggregator.AggregatePredictionForRequest(*suggestion_convreq_, segments,
+                                                 &serial_results);
+    if (serial_results.size() > cutoff) {
+      EXPECT_FALSE(FindResultByValue(serial_results, "愛鵜"));
+    }
+
+    request_->mutable_decoder_experiment_params()
+        ->set_enable_parallel_prediction_aggregation(true);
+    std::vector<Result> parallel_results;
+    EXPECT_EQ(aggregator.AggregatePredictionForRequest(
+                  *suggestion_convreq_, segments, &parallel_results),
+              serial_types);
+    EXPECT_EQ(get_values(parallel_results), get_values(serial_results));
+  }
+}
+
+TEST_F(DictionaryPredictionAggregatorTest, ParallelAggregationAfterDeadline) {
+  std::unique_ptr<MockDataAndAggregator> data_and_aggregator =
+      CreateAggregatorWithMockData();
+  const DictionaryPredictionAggregatorTestPeer &aggregator =
+      data_and_aggregator->aggregator();
+  commands::RequestForUnitTest::FillMobileRequest(request_.get());
+
+  Segments segments;
+  SetUpInputForSuggestion("よんじゅうごかい", composer_.get(), &segments);
+  ConversionRequest convreq = *prediction_convreq_;
+  convreq.set_deadline(absl::InfinitePast());
+
+  const auto get_values = [](const std::vector<Result> &results) {
+    std::vector<std::pair<std::string, PredictionTypes>> values;
+    for (const Result &result : results) {
+      values.emplace_back(result.value, result.types);
+    }
+    return values;
+  };
+
+  // Past the deadline, the steps run only until some results are found.
+  std::vector<Result> serial_results;
+  const PredictionTypes serial_types =
+      aggregator.AggregatePredictionForRequest(convreq, segments,
+                                               &serial_results);
+  EXPECT_TRUE(FindResultByValue(serial_results, "45"));
+
+  request_->mutable_decoder_experiment_params()
+      ->set_enable_parallel_prediction_aggregation(true);
+  std::vector<Result> parallel_results;
+  EXPECT_EQ(aggregator.AggregatePredictionForRequest(convreq, segments,
+                                                     &parallel_results),
+            serial_types);
+  EXPECT_EQ(get_values(parallel_results), get_values(serial_results));
+}
+
 }  // namespace
 }  // namespace prediction
 }  // namespace mozc
@@ -59,6 +59,7 @@
 #include "protocol/commands.pb.h"
 #include "request/conversion_request.h"
 #include "transliteration/transliteration.h"
+#include "usage_stats/latency_stats.h"
 #include "usage_stats/usage_stats.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -87,6 +88,8 @@ using ::mozc::dictionary::DictionaryInterface;
 using ::mozc::dictionary::PosMatcher;
 using ::mozc::prediction::PredictionType;
 using ::mozc::prediction::ResultCostLess;
+using ::mozc::usage_stats::LatencyStats;
+using ::mozc::usage_stats::ScopedLatencyTimer;
 using ::mozc::usage_stats::UsageStats;
 
 // Used to emulate positive infinity for cost. This value is set for those
@@ -276,6 +279,9 @@ void DictionaryPredictor::MaybeRecordUsageStats(
 
 bool DictionaryPredictor::PredictForRequest(const ConversionRequest &request,
                                             Segments *segments) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("DictionaryPredictor");
+  ScopedLatencyTimer timer(kStage);
   if (segments == nullptr) {
     return false;
   }
@@ -30,130 +30,147 @@
 #include "prediction/number_decoder.h"
 
 #include <algorithm>
-#include <istream>
-#include <memory>
-#include <sstream>
+#include <cstddef>
+#include <iterator>
 #include <string>
 #include <vector>
 
-#include "base/number_util.h"
-#include "absl/strings/str_split.h"
+#include "base/logging.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 
-NumberDecoder::NumberDecoder() { InitEntries(); }
+namespace {
 
-void NumberDecoder::InitEntries() {
-  // unit
-  entries_.AddEntry("ぜろ", Entry({UNIT, 0}));
-  entries_.AddEntry("いち", Entry({UNIT, 1}));
-  entries_.AddEntry("いっ", Entry({UNIT, 1}));
-  entries_.AddEntry("に", Entry({UNIT, 2}));
-  entries_.AddEntry("さん", Entry({UNIT, 3}));
-  entries_.AddEntry("し", Entry({UNIT, 4}));
-  entries_.AddEntry("よん", Entry({UNIT, 4}));
-  entries_.AddEntry("よ", Entry({UNIT, 4}));
-  entries_.AddEntry("ご", Entry({UNIT, 5}));
-  entries_.AddEntry("ろく", Entry({UNIT, 6}));
-  entries_.AddEntry("ろっ", Entry({UNIT, 6}));
-  entries_.AddEntry("なな", Entry({UNIT, 7}));
-  entries_.AddEntry("しち", Entry({UNIT, 7}));
-  entries_.AddEntry("はち", Entry({UNIT, 8}));
-  entries_.AddEntry("はっ", Entry({UNIT, 8}));
-  entries_.AddEntry("きゅう", Entry({UNIT, 9}));
-  entries_.AddEntry("きゅー", Entry({UNIT, 9}));
-  entries_.AddEntry("く", Entry({UNIT, 9}));
+struct KeyAndEntry {
+  absl::string_view key;
+  NumberDecoderEntry entry;
+};
 
-  // small digit
-  // "重", etc
-  entries_.AddEntry("じゅう", Entry({SMALL_DIGIT, 10, 2, "", true}));
-  entries_.AddEntry("じゅー", Entry({SMALL_DIGIT, 10, 2, "", true}));
-  entries_.AddEntry("じゅっ", Entry({SMALL_DIGIT, 10, 2}));
-  entries_.AddEntry("ひゃく", Entry({SMALL_DIGIT, 100, 3}));
-  entries_.AddEntry("ひゃっ", Entry({SMALL_DIGIT, 100, 3}));
-  entries_.AddEntry("びゃく", Entry({SMALL_DIGIT, 100, 3}));
-  entries_.AddEntry("びゃっ", Entry({SMALL_DIGIT, 100, 3}));
-  entries_.AddEntry("ぴゃく", Entry({SMALL_DIGIT, 100, 3}));
-  entries_.AddEntry("ぴゃっ", Entry({SMALL_DIGIT, 100, 3}));
-  // "戦", etc
-  entries_.AddEntry("せん", Entry({SMALL_DIGIT, 1000, 4, "", true}));
-  // "膳"
-  entries_.AddEntry("ぜん", Entry({SMALL_DIGIT, 1000, 4, "", true}));
+// Readings of the number parts, sorted by key so that LongestMatch() can
+// narrow the range of the candidates byte by byte like a trie.
+constexpr KeyAndEntry kEntries[] = {
+    {"いち", {UNIT, 1}},
+    {"いっ", {UNIT, 1}},
+    {"おく", {BIG_DIGIT, -1, 2, "億"}},
+    {"おくたーぶ", {}},  // オクターブ
+    {"おっ", {BIG_DIGIT, -1, 2, "億"}},
+    {"がい", {BIG_DIGIT, -1, 5, "垓"}},
+    {"きゅう", {UNIT, 9}},
+    {"きゅー", {UNIT, 9}},
+    {"く", {UNIT, 9}},
+    {"くだり", {}},
+    {"くち", {}},      // 口
+    {"くみ", {}},      // 組
+    {"くらす", {}},    // クラス
+    {"くろーな", {}},  // クローナ
+    {"けい", {BIG_DIGIT, -1, 4, "京", true}},  // "系", etc
+    {"ご", {UNIT, 5}},
+    {"ごう", {}},  // 号
+    {"さん", {UNIT, 3}},
+    // サンチーム (currency) v.s. 3チーム
+    {"さんちーむ", {UNIT_AND_STOP_DECODING, 3, -1, "", true, 6}},
+    {"し", {UNIT, 4}},
+    {"しあい", {}},  // 試合
+    {"しき", {}},    // 式
+    {"しち", {UNIT, 7}},
+    {"しつ", {}},        // 室
+    {"しな", {}},        // 品
+    {"しゃ", {}},        // 社, 尺
+    {"しゅ", {}},        // 種, 周
+    {"しょう", {}},      // 勝
+    {"しょく", {}},      // 色
+    {"しりんぐ", {}},    // シリング
+    {"しん", {}},        // 進, シンガポールドル
+    {"しーしー", {}},    // cc
+    {"しーと", {}},      // シート
+    {"しーべると", {}},  // シーベルト (unit)
+    {"じゅう", {SMALL_DIGIT, 10, 2, "", true}},  // "重", etc
+    {"じゅっ", {SMALL_DIGIT, 10, 2}},
+    {"じゅー", {SMALL_DIGIT, 10, 2, "", true}},
+    {"せん", {SMALL_DIGIT, 1000, 4, "", true}},  // "戦", etc
+    {"せんち", {}},  // センチ
+    {"せんと", {}},  // セント
+    {"ぜろ", {UNIT, 0}},
+    {"ぜん", {SMALL_DIGIT, 1000, 4, "", true}},  // "膳"
+    {"ちょう", {BIG_DIGIT, -1, 3, "兆", true}},  // "町", etc
+    {"ちょうめ", {}},  // 丁目
+    {"なな", {UNIT, 7}},
+    {"に", {UNIT, 2}},
+    {"にぎり", {}},  // 握り
+    {"にち", {}},    // 日
+    {"にちゃん", {UNIT_AND_STOP_DECODING, 2, -1, "", false, 3}},
+    // Conflicts with "にち".
+    {"にちょう", {UNIT_AND_BIG_DIGIT, 2, 3, "兆", true, 3}},
+    {"にちょうめ", {UNIT_AND_STOP_DECODING, 2, -1, "", false, 3}},
+    {"にん", {}},  // 人
+    {"はち", {UNIT, 8}},
+    {"はっ", {UNIT, 8}},
+    {"ひゃく", {SMALL_DIGIT, 100, 3}},
+    {"ひゃっ", {SMALL_DIGIT, 100, 3}},
+    {"びゃく", {SMALL_DIGIT, 100, 3}},
+    {"びゃっ", {SMALL_DIGIT, 100, 3}},
+    {"ぴゃく", {SMALL_DIGIT, 100, 3}},
+    {"ぴゃっ", {SMALL_DIGIT, 100, 3}},
+    {"まん", {BIG_DIGIT, 10000, 1, "万"}},
+    {"よ", {UNIT, 4}},
+    {"よう", {}},  // 葉
+    {"よん", {UNIT, 4}},
+    {"ろく", {UNIT, 6}},
+    {"ろっ", {UNIT, 6}},
+};
 
-  // big digit
-  entries_.AddEntry("まん", Entry({BIG_DIGIT, 10000, 1, "万"}));
-  entries_.AddEntry("おく", Entry({BIG_DIGIT, -1, 2, "億"}));
-  entries_.AddEntry("おっ", Entry({BIG_DIGIT, -1, 2, "億"}));
-  // "町", etc
-  entries_.AddEntry("ちょう", Entry({BIG_DIGIT, -1, 3, "兆", true}));
-  // "系", etc
-  entries_.AddEntry("けい", Entry({BIG_DIGIT, -1, 4, "京", true}));
-  entries_.AddEntry("がい", Entry({BIG_DIGIT, -1, 5, "垓"}));
+constexpr bool KeyLess(absl::string_view lhs, absl::string_view rhs) {
+  for (size_t i = 0; i < lhs.size() && i < rhs.size(); ++i) {
+    if (lhs[i] != rhs[i]) {
+      return static_cast<unsigned char>(lhs[i]) <
+             static_cast<unsigned char>(rhs[i]);
+    }
+  }
+  return lhs.size() < rhs.size();
+}
+
+constexpr bool IsSortedByKey() {
+  for (size_t i = 1; i < std::size(kEntries); ++i) {
+    if (!KeyLess(kEntries[i - 1].key, kEntries[i].key)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  // spacial cases
-  // conflict with "にち"
-  entries_.AddEntry("にちょう",
-                    Entry({UNIT_AND_BIG_DIGIT, 2, 3, "兆", true, 3}));
-  entries_.AddEntry("にちょうめ",
-                    Entry({UNIT_AND_STOP_DECODING, 2, -1, "", false, 3}));
-  entries_.AddEntry("にちゃん",
-                    Entry({UNIT_AND_STOP_DECODING, 2, -1, "", false, 3}));
-  // サンチーム (currency) v.s. 3チーム
-  entries_.AddEntry("さんちーむ",
-                    Entry({UNIT_AND_STOP_DECODING, 3, -1, "", true, 6}));
+static_assert(IsSortedByKey(), "kEntries must be sorted by key");
 
-  // number suffix conflicting with the other entries
-  const std::vector<std::string> kSuffixEntries = {
-      // に
-      // 握り, 日, 人
-      "にぎり",
-      "にち",
-      "にん",
-      // し
-      // cc, シート, シーベルト (unit), 試合, 式, 室, 品, 社, 尺, 種, 周, 勝, 色
-      // シリング, 進, シンガポールドル
-      "しーしー",
-      "しーと",
-      "しーべると",
-      "しあい",
-      "しき",
-      "しつ",
-      "しな",
-      "しゃ",
-      "しゅ",
-      "しょう",
-      "しょく",
-      "しりんぐ",
-      "しん",
-      // よ
-      // 葉
-      "よう",
-      // ご
-      // 号
-      "ごう",
-      // く
-      // 口, 組, クラス, クローナ
-      "くだり",
-      "くち",
-      "くみ",
-      "くらす",
-      "くろーな",
-      // せん
-      // センチ, セント
-      "せんち",
-      "せんと",
-      // おく
-      // オクターブ
-      "おくたーぶ",
-      // ちょう
-      // 丁目
-      "ちょうめ",
-  };
-  for (const auto &key : kSuffixEntries) {
-    entries_.AddEntry(key, Entry());
+// Returns the entry of the longest key in kEntries which is a prefix of |key|,
+// or nullptr if there is no such key.
+const NumberDecoderEntry *LongestMatch(absl::string_view key,
+                                       size_t *key_byte_len) {
+  const NumberDecoderEntry *result = nullptr;
+  const KeyAndEntry *begin = std::begin(kEntries);
+  const KeyAndEntry *end = std::end(kEntries);
+  for (size_t pos = 0; pos < key.size() && begin != end; ++pos) {
+    // [begin, end) holds the keys starting with key[0, pos). The key equal to
+    // key[0, pos), if any, comes first and the others are sorted by key[pos].
+    const unsigned char c = key[pos];
+    begin = std::partition_point(begin, end, [&](const KeyAndEntry &e) {
+      return e.key.size() <= pos ||
+             static_cast<unsigned char>(e.key[pos]) < c;
+    });
+    end = std::partition_point(begin, end, [&](const KeyAndEntry &e) {
+      return static_cast<unsigned char>(e.key[pos]) == c;
+    });
+    if (begin != end && begin->key.size() == pos + 1) {
+      result = &begin->entry;
+      *key_byte_len = pos + 1;
+    }
   }
+  return result;
 }
 
+}  // namespace
+
 bool NumberDecoder::Decode(absl::string_view key,
                            std::vector<Result> *results) const {
   State state;
@@ -164,16 +181,28 @@ bool NumberDecoder::Decode(absl::string_view key,
   return !results->empty();
 }
 
+bool NumberDecoder::DecodeAll(absl::Span<const absl::string_view> keys,
+                              std::vector<std::vector<Result>> *results) const {
+  DCHECK(results);
+  results->resize(keys.size());
+  bool decoded = false;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    decoded |= Decode(keys[i], &(*results)[i]);
+  }
+  return decoded;
+}
+
 void NumberDecoder::DecodeAux(absl::string_view key, State *state,
                               std::vector<Result> *results) const {
   if (key.size() == 0) {
     return;
   }
-  size_t key_byte_len;
-  Entry e;
-  if (!entries_.LongestMatch(key, &e, &key_byte_len)) {
+  size_t key_byte_len = 0;
+  const Entry *entry = LongestMatch(key, &key_byte_len);
+  if (entry == nullptr) {
     return;
   }
+  const Entry &e = *entry;
   switch (e.type) {
     case STOP_DECODING:
       return;
@@ -36,9 +36,9 @@
 #include <string>
 #include <vector>
 
-#include "base/container/trie.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 namespace mozc {
 
@@ -59,7 +59,7 @@ struct NumberDecoderEntry {
   NumberDecoderEntryType type = STOP_DECODING;
   int number = 0;
   int digit = 1;
-  std::string digit_str = "";
+  absl::string_view digit_str;
   // Output the current status before decoding the input with the entry.
   bool output_before_decode = false;
   // For UNIT_AND_BIG_DIGIT and UNIT_AND_STOP_DECODING.
@@ -123,9 +123,19 @@ class NumberDecoder {
   using Entry = NumberDecoderEntry;
   using Result = NumberDecoderResult;
 
-  NumberDecoder();
+  // The reading table is a compile-time constant, so the decoder has no state
+  // and is cheap to construct.
+  NumberDecoder() = default;
+
   bool Decode(absl::string_view key, std::vector<Result> *results) const;
 
+  // Decodes each of |keys| into the corresponding element of |results|, which
+  // is resized to the size of |keys|. The result vectors are reused, so
+  // calling this repeatedly with the same |results| doesn't allocate them
+  // again. Returns true if any key is decoded.
+  bool DecodeAll(absl::Span<const absl::string_view> keys,
+                 std::vector<std::vector<Result>> *results) const;
+
  private:
   void DecodeAux(absl::string_view key, State *state,
                  std::vector<Result> *results) const;
@@ -137,9 +147,6 @@ class NumberDecoder {
                            std::vector<Result> *results) const;
   void MayAppendResults(const State &state, size_t consumed_byte_len,
                         std::vector<Result> *results) const;
-  void InitEntries();
-
-  Trie<Entry> entries_;
 };
 
 }  // namespace mozc
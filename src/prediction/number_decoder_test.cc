@@ -37,6 +37,7 @@
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
+#include "absl/algorithm/container.h"
 #include "absl/random/random.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
@@ -141,6 +142,29 @@ TEST(NumberDecoderTest, Decode) {
   }
 }
 
+TEST(NumberDecoderTest, DecodeAll) {
+  const NumberDecoder decoder;
+  const std::vector<absl::string_view> keys = {"にひゃく", "あいう",
+                                               "さんちーむ"};
+  std::vector<std::vector<NumberDecoder::Result>> results;
+  ASSERT_TRUE(decoder.DecodeAll(keys, &results));
+  ASSERT_EQ(results.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::vector<NumberDecoder::Result> expected;
+    decoder.Decode(keys[i], &expected);
+    EXPECT_EQ(results[i], expected) << keys[i];
+  }
+  EXPECT_THAT(results[0], ::testing::ElementsAre(NumberDecoder::Result(
+                              std::string("にひゃく").size(), "200")));
+  EXPECT_TRUE(results[1].empty());
+
+  // Stale results from the previous call are cleared.
+  const std::vector<absl::string_view> keys2 = {"あ"};
+  EXPECT_FALSE(decoder.DecodeAll(keys2, &results));
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_TRUE(results[0].empty());
+}
+
 TEST(NumberDecoderTest, Random) {
   const std::vector<std::string> kKeys = {
       "ぜろ",   "いち",   "いっ",   "に",     "さん",   "し",     "よん",
@@ -64,6 +64,7 @@
         '../rewriter/rewriter.gyp:rewriter',
         '../session/session_base.gyp:request_test_util',
         '../storage/storage.gyp:storage',
+        '../usage_stats/usage_stats_base.gyp:latency_stats',
         '../usage_stats/usage_stats_base.gyp:usage_stats',
         'prediction_base.gyp:suggestion_filter',
         'prediction_protocol',
@@ -138,6 +138,11 @@ bool BasePredictor::Sync() { return user_history_predictor_->Sync(); }
 
 bool BasePredictor::Reload() { return user_history_predictor_->Reload(); }
 
+void BasePredictor::CollectMemoryUsage(MemoryUsageCollector *collector) const {
+  dictionary_predictor_->CollectMemoryUsage(collector);
+  user_history_predictor_->CollectMemoryUsage(collector);
+}
+
 // static
 std::unique_ptr<PredictorInterface> DefaultPredictor::CreateDefaultPredictor(
     std::unique_ptr<PredictorInterface> dictionary_predictor,
@@ -74,6 +74,8 @@ class BasePredictor : public PredictorInterface {
   // Waits for syncer to complete.
   bool Wait() override;
 
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
+
   // The following interfaces are implemented in derived classes.
   // const string &GetPredictorName() const = 0;
   // bool PredictForRequest(const ConversionRequest &request,
@@ -32,6 +32,7 @@
 
 #include <string>
 
+#include "base/memory_usage.h"
 #include "absl/base/attributes.h"
 #include "absl/strings/string_view.h"
 
@@ -80,6 +81,9 @@ class PredictorInterface {
   // Waits for syncer thread to complete.
   virtual bool Wait() { return true; }
 
+  // Reports the memory used by this predictor to |collector|.
+  virtual void CollectMemoryUsage(MemoryUsageCollector *collector) const {}
+
   virtual const std::string &GetPredictorName() const = 0;
 
  protected:
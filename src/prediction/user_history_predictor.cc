@@ -46,6 +46,7 @@
 #include "base/clock.h"
 #include "base/config_file_stream.h"
 #include "base/container/trie.h"
+#include "base/file_util.h"
 #include "base/hash.h"
 #include "base/japanese_util.h"
 #include "base/logging.h"
@@ -63,8 +64,11 @@
 #include "rewriter/variants_rewriter.h"
 #include "storage/encrypted_string_storage.h"
 #include "storage/lru_cache.h"
+#include "usage_stats/latency_stats.h"
 #include "usage_stats/usage_stats.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -76,6 +80,8 @@ namespace {
 using dictionary::DictionaryInterface;
 using dictionary::PosMatcher;
 using dictionary::SuppressionDictionary;
+using usage_stats::LatencyStats;
+using usage_stats::ScopedLatencyTimer;
 using usage_stats::UsageStats;
 
 // Finds suggestion candidates from the most recent 3000 history in LRU.
@@ -114,6 +120,14 @@ constexpr char kFileName[] = "user://history.db";
 constexpr char kFileName[] = "user://.history.db";
 #endif  // _WIN32
 
+// Suffix of the journal file, which records the changes after the history
+// file was written.
+constexpr char kJournalFileSuffix[] = ".journal";
+
+// The journal is compacted into the history file once it grows larger than
+// the history file or this size in bytes.
+constexpr size_t kMinJournalSizeToCompact = 64 * 1024;
+
 // Uses '\t' as a key/value delimiter
 constexpr char kDelimiter[] = "\t";
 constexpr char kEmojiDescription[] = "絵文字";
@@ -235,7 +249,9 @@ bool UserHistoryPredictor::IsPrivacySensitive(const Segments *segments) const {
 }
 
 UserHistoryStorage::UserHistoryStorage(const absl::string_view filename)
-    : storage_(new storage::EncryptedStringStorage(filename)) {}
+    : journal_filename_(absl::StrCat(filename, kJournalFileSuffix)),
+      storage_(new storage::EncryptedStringStorage(filename)),
+      journal_(new storage::EncryptedStringStorage(journal_filename_)) {}
 
 UserHistoryStorage::~UserHistoryStorage() = default;
 
@@ -251,6 +267,8 @@ bool UserHistoryStorage::Load() {
     return false;
   }
 
+  ReplayJournal();
+
   const int num_deleted = DeleteEntriesUntouchedFor62Days();
   LOG_IF(INFO, num_deleted > 0)
       << num_deleted << " old entries were not loaded "
@@ -281,9 +299,86 @@ bool UserHistoryStorage::Save() {
     return false;
   }
 
+  // The saved history contains all the changes in the journal.
+  if (absl::Status s = FileUtil::UnlinkIfExists(journal_filename_); !s.ok()) {
+    LOG(ERROR) << "Cannot remove the journal: " << s;
+  }
+  journal_size_ = 0;
+  has_broken_journal_ = false;
+
+  return true;
+}
+
+bool UserHistoryStorage::AppendToJournal(
+    const mozc::user_history_predictor::UserHistory &changes) {
+  std::string output;
+  if (!changes.AppendToString(&output)) {
+    LOG(ERROR) << "AppendToString failed";
+    return false;
+  }
+
+  if (!journal_->AppendRecord(output)) {
+    LOG(ERROR) << "Can't append user history changes to the journal.";
+    return false;
+  }
+
   return true;
 }
 
+void UserHistoryStorage::ReplayJournal() {
+  std::vector<std::string> records;
+  has_broken_journal_ = !journal_->LoadRecords(&records);
+  journal_size_ = 0;
+  if (records.empty()) {
+    return;
+  }
+
+  // Entries are deleted lazily by |deleted| and removed at once at the end.
+  auto *entries = proto_.mutable_entries();
+  absl::flat_hash_map<uint32_t, int> positions;
+  for (int i = 0; i < entries->size(); ++i) {
+    positions[UserHistoryPredictor::EntryFingerprint(entries->Get(i))] = i;
+  }
+  std::vector<bool> deleted(entries->size(), false);
+
+  mozc::user_history_predictor::UserHistory changes;
+  for (const std::string &record : records) {
+    journal_size_ += record.size();
+    if (!changes.ParseFromString(record)) {
+      LOG(ERROR) << "ParseFromString failed. journal looks broken";
+      has_broken_journal_ = true;
+      break;
+    }
+    for (const uint32_t fp : changes.deleted_entry_fps()) {
+      const auto it = positions.find(fp);
+      if (it != positions.end()) {
+        deleted[it->second] = true;
+        positions.erase(it);
+      }
+    }
+    for (UserHistoryPredictor::Entry &entry : *changes.mutable_entries()) {
+      const uint32_t fp = UserHistoryPredictor::EntryFingerprint(entry);
+      const auto [it, inserted] = positions.try_emplace(fp, entries->size());
+      if (!inserted) {
+        deleted[it->second] = true;
+        it->second = entries->size();
+      }
+      entries->Add()->Swap(&entry);
+      deleted.push_back(false);
+    }
+  }
+
+  int new_size = 0;
+  for (int i = 0; i < entries->size(); ++i) {
+    if (!deleted[i]) {
+      entries->SwapElements(new_size++, i);
+    }
+  }
+  entries->DeleteSubrange(new_size, entries->size() - new_size);
+
+  VLOG(1) << "Replayed " << records.size() << " journal records";
+}
+
 int UserHistoryStorage::DeleteEntriesBefore(uint64_t timestamp) {
   // Partition entries so that [0, new_size) is kept and [new_size, size) is
   // deleted.
@@ -420,6 +515,23 @@ bool UserHistoryPredictor::Wait() {
   return true;
 }
 
+void UserHistoryPredictor::CollectMemoryUsage(
+    MemoryUsageCollector *collector) const {
+  if (!CheckSyncerAndDelete()) {  // now loading/saving
+    return;
+  }
+  // Elements of the LRU list are allocated in blocks, and the hash table maps
+  // each key to its element.
+  size_t heap_bytes = sizeof(DicElement) * dic_->Capacity() +
+                      (sizeof(uint32_t) + sizeof(DicElement *)) * dic_->Size();
+  for (const DicElement *elm = dic_->Head(); elm != nullptr; elm = elm->next) {
+    heap_bytes += elm->value.SpaceUsedLong() - sizeof(Entry);
+  }
+  collector->Add("UserHistoryPredictor.Dictionary", {heap_bytes, 0});
+  collector->Add("UserHistoryPredictor.KeyIndex",
+                 {sizeof(KeyIndexEntry) * key_index_.capacity(), 0});
+}
+
 bool UserHistoryPredictor::CheckSyncerAndDelete() const {
   if (syncer_ != nullptr) {
     if (syncer_->IsRunning()) {
@@ -478,11 +590,20 @@ bool UserHistoryPredictor::Load() {
     LOG(ERROR) << "UserHistoryStorage::Load() failed";
     return false;
   }
-  return Load(history);
+  if (!Load(history)) {
+    return false;
+  }
+
+  snapshot_required_ = history.has_broken_journal();
+  snapshot_size_ = history.GetProto().ByteSizeLong();
+  journal_size_ = history.journal_size();
+  return true;
 }
 
 bool UserHistoryPredictor::Load(const UserHistoryStorage &history) {
   dic_->Clear();
+  key_index_dirty_ = true;
+  dirty_entries_.clear();
   for (const Entry &entry : history.GetProto().entries()) {
     // Workaround for b/116826494: Some garbled characters are suggested
     // from user history. This fiters such entries.
@@ -515,6 +636,11 @@ bool UserHistoryPredictor::Save() {
   const std::string filename = GetUserHistoryFileName();
 
   UserHistoryStorage history(filename);
+  if (!snapshot_required_ &&
+      journal_size_ < std::max(kMinJournalSizeToCompact, snapshot_size_)) {
+    return SaveToJournal(&history);
+  }
+
   for (const DicElement *elm = tail; elm != nullptr; elm = elm->prev) {
     *history.GetProto().add_entries() = elm->value;
   }
@@ -529,6 +655,72 @@ bool UserHistoryPredictor::Save() {
   }
   Load(history);
 
+  snapshot_required_ = false;
+  snapshot_size_ = history.GetProto().ByteSizeLong();
+  journal_size_ = 0;
+  updated_ = false;
+
+  return true;
+}
+
+bool UserHistoryPredictor::SaveToJournal(UserHistoryStorage *history) {
+  // Deletes the entries untouched for 62 days as UserHistoryStorage::Save()
+  // does.  This only compares timestamps, so it is cheap compared with
+  // serializing and encrypting the whole history.
+  const uint64_t now = Clock::GetTime();
+  std::vector<uint32_t> expired_keys;
+  for (const DicElement *elm = dic_->Head(); elm != nullptr; elm = elm->next) {
+    if (elm->value.entry_type() == Entry::DEFAULT_ENTRY &&
+        elm->value.last_access_time() + k62DaysInSec < now) {
+      expired_keys.push_back(elm->key);
+    }
+  }
+  for (const uint32_t key : expired_keys) {
+    dic_->Erase(key);
+    dirty_entries_.insert(key);
+  }
+  if (!expired_keys.empty()) {
+    key_index_dirty_ = true;
+  }
+
+  // Changed entries are usually the recently used ones, so the LRU list is
+  // scanned from the head only until all of them are found.
+  size_t num_updated = 0;
+  user_history_predictor::UserHistory changes;
+  for (const uint32_t fp : dirty_entries_) {
+    if (dic_->HasKey(fp)) {
+      ++num_updated;
+    } else {
+      changes.add_deleted_entry_fps(fp);
+    }
+  }
+  std::vector<const Entry *> updated_entries;
+  updated_entries.reserve(num_updated);
+  for (const DicElement *elm = dic_->Head();
+       elm != nullptr && updated_entries.size() < num_updated;
+       elm = elm->next) {
+    if (dirty_entries_.contains(elm->key)) {
+      updated_entries.push_back(&elm->value);
+    }
+  }
+  // The journal lists entries from the least recently used one, as the
+  // history file does.
+  for (auto it = updated_entries.rbegin(); it != updated_entries.rend(); ++it) {
+    *changes.add_entries() = **it;
+  }
+
+  UsageStats::SetInteger("UserHistoryPredictorEntrySize",
+                         static_cast<int>(dic_->Size()));
+
+  if (changes.entries_size() > 0 || changes.deleted_entry_fps_size() > 0) {
+    if (!history->AppendToJournal(changes)) {
+      LOG(ERROR) << "UserHistoryStorage::AppendToJournal() failed";
+      return false;
+    }
+    journal_size_ += changes.ByteSizeLong();
+  }
+
+  dirty_entries_.clear();
   updated_ = false;
 
   return true;
@@ -542,6 +734,9 @@ bool UserHistoryPredictor::ClearAllHistory() {
   // Renews DicCache as LruCache tries to reuse the internal value by
   // using FreeList
   dic_ = std::make_unique<DicCache>(UserHistoryPredictor::cache_size());
+  key_index_dirty_ = true;
+  dirty_entries_.clear();
+  snapshot_required_ = true;
 
   // insert a dummy event entry.
   InsertEvent(Entry::CLEAN_ALL_EVENT);
@@ -577,7 +772,9 @@ bool UserHistoryPredictor::ClearUnusedHistory() {
     if (!dic_->Erase(keys[i])) {
       LOG(ERROR) << "cannot erase " << keys[i];
     }
+    dirty_entries_.insert(keys[i]);
   }
+  key_index_dirty_ = true;
 
   // Inserts a dummy event entry.
   InsertEvent(Entry::CLEAN_UNUSED_EVENT);
@@ -721,6 +918,9 @@ bool UserHistoryPredictor::ClearHistoryEntry(const absl::string_view key,
     }
   }
   if (deleted) {
+    // The removal may touch any entry in the n-gram chains, so the whole
+    // history is saved instead of tracking the changed entries.
+    snapshot_required_ = true;
     updated_ = true;
   }
   return deleted;
@@ -1157,6 +1357,9 @@ bool UserHistoryPredictor::Predict(Segments *segments) const {
 
 bool UserHistoryPredictor::PredictForRequest(const ConversionRequest &request,
                                              Segments *segments) const {
+  static const LatencyStats::StageId kStage =
+      LatencyStats::RegisterStage("UserHistoryPredictor");
+  ScopedLatencyTimer timer(kStage);
   const RequestType request_type = request.request().zero_query_suggestion()
                                        ? ZERO_QUERY_SUGGESTION
                                        : DEFAULT;
@@ -1333,6 +1536,42 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
   GetInputKeyFromSegments(request, segments, &input_key, &base_key, &expanded);
 
   const uint64_t now = Clock::GetTime();
+
+  // Unless the input is empty (zero query suggestion) or may be misspelled,
+  // only the entries sharing a prefix with the input can match. Visit them
+  // through the key index in LRU order.
+  if (roman_input_key.empty() && (!base_key.empty() || expanded != nullptr)) {
+    std::vector<const KeyIndexEntry *> indexed_entries;
+    LookupKeyIndex(base_key, expanded.get(), &indexed_entries);
+    const uint32_t limit_position =
+        request.request_type() == ConversionRequest::SUGGESTION
+            ? GetSuggestionTrialLimitPosition(now)
+            : dic_->Size();
+    for (const KeyIndexEntry *indexed_entry : indexed_entries) {
+      if (indexed_entry->position >= limit_position) {
+        VLOG(2) << "too many trials";
+        break;
+      }
+      const Entry &entry = indexed_entry->element->value;
+      if (!IsValidEntryIgnoringRemovedField(entry)) {
+        continue;
+      }
+      if (entry.last_access_time() + k62DaysInSec < now) {
+        updated_ = true;  // We found an entry to be deleted at next save.
+        continue;
+      }
+      if (!LookupEntry(request_type, input_key, base_key, expanded.get(),
+                       &entry, prev_entry, results)) {
+        continue;
+      }
+      // already found enough results.
+      if (results->size() >= max_results_size) {
+        break;
+      }
+    }
+    return;
+  }
+
   int trial = 0;
   for (const DicElement *elm = dic_->Head(); elm != nullptr; elm = elm->next) {
     if (!IsValidEntryIgnoringRemovedField(elm->value)) {
@@ -1364,6 +1603,112 @@ void UserHistoryPredictor::GetResultsFromHistoryDictionary(
   }
 }
 
+void UserHistoryPredictor::MaybeRebuildKeyIndex() const {
+  if (!key_index_dirty_) {
+    return;
+  }
+  key_index_.clear();
+  key_index_.reserve(dic_->Size());
+  uint32_t position = 0;
+  for (const DicElement *elm = dic_->Head(); elm != nullptr;
+       elm = elm->next, ++position) {
+    // Validity is checked on lookup as it depends on the suppression
+    // dictionary, so invalid entries are indexed as well.
+    if (!elm->value.key().empty()) {
+      key_index_.push_back({elm->value.key(), elm, position});
+    }
+  }
+  std::sort(key_index_.begin(), key_index_.end(),
+            [](const KeyIndexEntry &lhs, const KeyIndexEntry &rhs) {
+              return lhs.key < rhs.key;
+            });
+  key_index_dirty_ = false;
+}
+
+uint32_t UserHistoryPredictor::GetSuggestionTrialLimitPosition(
+    uint64_t now) const {
+  if (dic_->Size() <= kMaxSuggestionTrial) {
+    return dic_->Size();
+  }
+  // Counts the trials in the same way as the scan over the whole LRU list.
+  // The validity and the expiration depend on the suppression dictionary and
+  // the current time, so they are not cached in the key index.
+  uint32_t position = 0;
+  size_t trial = 0;
+  for (const DicElement *elm = dic_->Head(); elm != nullptr;
+       elm = elm->next, ++position) {
+    if (!IsValidEntryIgnoringRemovedField(elm->value)) {
+      continue;
+    }
+    if (elm->value.last_access_time() + k62DaysInSec < now) {
+      updated_ = true;  // We found an entry to be deleted at next save.
+      continue;
+    }
+    if (trial++ >= kMaxSuggestionTrial) {
+      return position;
+    }
+  }
+  return position;
+}
+
+void UserHistoryPredictor::LookupKeyIndex(
+    const absl::string_view key_base, const Trie<std::string> *key_expanded,
+    std::vector<const KeyIndexEntry *> *entries) const {
+  DCHECK(entries);
+  DCHECK(!key_base.empty() || key_expanded != nullptr);
+  MaybeRebuildKeyIndex();
+
+  const auto key_less = [](const KeyIndexEntry &entry,
+                           const absl::string_view key) {
+    return entry.key < key;
+  };
+  // Adds the entries whose keys are exactly |key|.
+  const auto add_exact = [&](const absl::string_view key) {
+    for (auto it = std::lower_bound(key_index_.begin(), key_index_.end(), key,
+                                    key_less);
+         it != key_index_.end() && it->key == key; ++it) {
+      entries->push_back(&*it);
+    }
+  };
+  // Adds the entries whose keys start with |prefix|.
+  const auto add_predictive = [&](const absl::string_view prefix) {
+    for (auto it = std::lower_bound(key_index_.begin(), key_index_.end(),
+                                    prefix, key_less);
+         it != key_index_.end() && absl::StartsWith(it->key, prefix); ++it) {
+      entries->push_back(&*it);
+    }
+  };
+
+  // Keys which are a prefix of |key_base| (RIGHT_PREFIX_MATCH).
+  for (size_t len = 1; len < key_base.size(); ++len) {
+    add_exact(key_base.substr(0, len));
+  }
+  if (key_expanded == nullptr) {
+    // EXACT_MATCH and LEFT_PREFIX_MATCH.
+    add_predictive(key_base);
+  } else {
+    // Longer keys have to continue with one of the expansions.
+    if (!key_base.empty()) {
+      add_exact(key_base);
+    }
+    // GetInputKeyFromSegments() stores each expansion as its own value.
+    std::vector<std::string> expanded_keys;
+    key_expanded->LookUpPredictiveAll("", &expanded_keys);
+    for (const std::string &expanded_key : expanded_keys) {
+      add_predictive(absl::StrCat(key_base, expanded_key));
+    }
+  }
+
+  // Restore the LRU order, removing the duplicates found through multiple
+  // expansions.
+  std::sort(entries->begin(), entries->end(),
+            [](const KeyIndexEntry *lhs, const KeyIndexEntry *rhs) {
+              return lhs->position < rhs->position;
+            });
+  entries->erase(std::unique(entries->begin(), entries->end()),
+                 entries->end());
+}
+
 // static
 void UserHistoryPredictor::GetInputKeyFromSegments(
     const ConversionRequest &request, const Segments &segments,
@@ -1558,7 +1903,7 @@ void UserHistoryPredictor::InsertEvent(EntryType type) {
   const uint32_t dic_key = Fingerprint("", "", type);
 
   CHECK(dic_.get());
-  DicElement *e = dic_->Insert(dic_key);
+  DicElement *e = InsertToDic(dic_key);
   if (e == nullptr) {
     VLOG(2) << "insert failed";
     return;
@@ -1571,6 +1916,19 @@ void UserHistoryPredictor::InsertEvent(EntryType type) {
   entry->set_last_access_time(last_access_time);
 }
 
+UserHistoryPredictor::DicElement *UserHistoryPredictor::InsertToDic(
+    uint32_t dic_key) {
+  const DicElement *tail = dic_->Tail();
+  if (tail != nullptr && dic_->Size() >= cache_size() &&
+      !dic_->HasKey(dic_key)) {
+    // The least recently used entry is evicted by the insertion.
+    dirty_entries_.insert(tail->key);
+  }
+  dirty_entries_.insert(dic_key);
+  key_index_dirty_ = true;
+  return dic_->Insert(dic_key);
+}
+
 void UserHistoryPredictor::TryInsert(
     RequestType request_type, const absl::string_view key,
     const absl::string_view value, const absl::string_view description,
@@ -1615,7 +1973,7 @@ void UserHistoryPredictor::Insert(const absl::string_view key,
     // add a treatment for UPDATE_ENTRY mode
   }
 
-  DicElement *e = dic_->Insert(dic_key);
+  DicElement *e = InsertToDic(dic_key);
   if (e == nullptr) {
     VLOG(2) << "insert failed";
     return;
@@ -1921,9 +2279,10 @@ void UserHistoryPredictor::InsertHistory(RequestType request_type,
          Util::CharsLen(conversion_segment.value) > 1)) {
       return;
     }
-    Entry *history_entry = dic_->MutableLookupWithoutInsert(
-        LearningSegmentFingerprint(history_segment));
+    const uint32_t history_fp = LearningSegmentFingerprint(history_segment);
+    Entry *history_entry = dic_->MutableLookupWithoutInsert(history_fp);
     if (history_entry) {
+      dirty_entries_.insert(history_fp);
       NextEntry next_entry;
       if (!is_suggestion_selected) {
         next_entry.set_entry_fp(LearningSegmentFingerprint(conversion_segment));
@@ -1952,6 +2311,8 @@ void UserHistoryPredictor::Revert(Segments *segments) {
         revert_entry.revert_entry_type == Segments::RevertEntry::CREATE_ENTRY) {
       VLOG(2) << "Erasing the key: " << StringToUint32(revert_entry.key);
       dic_->Erase(StringToUint32(revert_entry.key));
+      dirty_entries_.insert(StringToUint32(revert_entry.key));
+      key_index_dirty_ = true;
     }
   }
 }
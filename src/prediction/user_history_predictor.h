@@ -52,6 +52,7 @@
 #include "storage/encrypted_string_storage.h"
 #include "storage/lru_cache.h"
 #include "testing/gunit_prod.h"  // for FRIEND_TEST
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 
 namespace mozc {
@@ -63,12 +64,27 @@ class UserHistoryStorage {
   explicit UserHistoryStorage(absl::string_view filename);
   ~UserHistoryStorage();
 
-  // Loads from encrypted file.
+  // Loads from encrypted file, and then replays the journal on top of it.
   bool Load();
 
-  // Saves history into encrypted file.
+  // Saves history into encrypted file.  The journal is removed as the saved
+  // history contains all the changes recorded in it.
   bool Save();
 
+  // Appends |changes| to the journal next to the history file as one record.
+  // |changes| holds the entries inserted or updated since the last save, from
+  // the least recently used one, and the fingerprints of the deleted entries.
+  // Unlike Save(), the cost is proportional to the size of |changes|.
+  bool AppendToJournal(
+      const mozc::user_history_predictor::UserHistory &changes);
+
+  // Returns the total size of the journal records replayed by Load().
+  size_t journal_size() const { return journal_size_; }
+
+  // Returns true if Load() found a broken journal record.  Records appended
+  // after a broken one cannot be read, so the history must be saved by Save().
+  bool has_broken_journal() const { return has_broken_journal_; }
+
   // Deletes entries before the given timestamp.  Returns the number of deleted
   // entries.
   int DeleteEntriesBefore(uint64_t timestamp);
@@ -83,8 +99,16 @@ class UserHistoryStorage {
   }
 
  private:
+  // Applies the records of the journal to |proto_|.  An updated entry is moved
+  // to the end of |proto_| as it has become the most recently used one.
+  void ReplayJournal();
+
+  const std::string journal_filename_;
   std::unique_ptr<storage::StringStorageInterface> storage_;
+  std::unique_ptr<storage::EncryptedStringStorage> journal_;
   mozc::user_history_predictor::UserHistory proto_;
+  size_t journal_size_ = 0;
+  bool has_broken_journal_ = false;
 };
 
 // UserHistoryPredictor is NOT thread safe.
@@ -136,6 +160,10 @@ class UserHistoryPredictor : public PredictorInterface {
   // Implements PredictorInterface.
   bool Wait() override;
 
+  // Reports the LRU dictionary and its key index. Nothing is reported while
+  // the history is being loaded or saved.
+  void CollectMemoryUsage(MemoryUsageCollector *collector) const override;
+
   // Gets user history filename.
   static std::string GetUserHistoryFileName();
 
@@ -231,6 +259,7 @@ class UserHistoryPredictor : public PredictorInterface {
   FRIEND_TEST(UserHistoryPredictorTest, GetRomanMisspelledKey);
   FRIEND_TEST(UserHistoryPredictorTest, RomanFuzzyLookupEntry);
   FRIEND_TEST(UserHistoryPredictorTest, ExpandedLookupRoman);
+  FRIEND_TEST(UserHistoryPredictorTest, LookupKeyIndex);
   FRIEND_TEST(UserHistoryPredictorTest, ExpandedLookupKana);
   FRIEND_TEST(UserHistoryPredictorTest, GetMatchTypeFromInputRoman);
   FRIEND_TEST(UserHistoryPredictorTest, GetMatchTypeFromInputKana);
@@ -287,9 +316,16 @@ class UserHistoryPredictor : public PredictorInterface {
   // Loads user history data to an on-memory LRU.
   bool Load(const UserHistoryStorage &history);
 
-  // Saves user history data in LRU to local file
+  // Saves user history data in LRU to local file.  Usually only the changes
+  // since the last save are appended to the journal; the whole history is
+  // written when the journal has grown as large as the history itself or when
+  // the history has been changed in bulk.
   bool Save();
 
+  // Appends the changes recorded in |dirty_entries_| to the journal of
+  // |history|.
+  bool SaveToJournal(UserHistoryStorage *history);
+
   // non-blocking version of Load
   // This makes a new thread and call Load()
   bool AsyncSave();
@@ -399,6 +435,30 @@ class UserHistoryPredictor : public PredictorInterface {
                                  const Entry &entry,
                                  EntryPriorityQueue *results) const;
 
+  // An entry of the sorted key index over |dic_|.
+  struct KeyIndexEntry {
+    absl::string_view key;  // Points to element->value.key().
+    const DicElement *element;
+    // Position of the element in the LRU list.
+    uint32_t position;
+  };
+
+  // Rebuilds |key_index_| if |dic_| has been modified since the last build.
+  void MaybeRebuildKeyIndex() const;
+
+  // Returns the position in the LRU list where the scan for suggestion stops
+  // as it reaches the trial limit, counting the entries which are valid and
+  // not expired at |now|. Returns the size of |dic_| if the limit is not
+  // reached.
+  uint32_t GetSuggestionTrialLimitPosition(uint64_t now) const;
+
+  // Collects the indexed entries whose keys can match |key_base| and
+  // |key_expanded| (see GetMatchTypeFromInput()) in LRU order. |key_base|
+  // must not be empty unless |key_expanded| is given.
+  void LookupKeyIndex(absl::string_view key_base,
+                      const Trie<std::string> *key_expanded,
+                      std::vector<const KeyIndexEntry *> *entries) const;
+
   void GetResultsFromHistoryDictionary(RequestType request_type,
                                        const ConversionRequest &request,
                                        const Segments &segments,
@@ -471,6 +531,10 @@ class UserHistoryPredictor : public PredictorInterface {
   // Inserts event entry (CLEAN_ALL_EVENT|CLEAN_UNUSED_EVENT).
   void InsertEvent(EntryType type);
 
+  // Inserts |dic_key| to |dic_| and records it, as well as the entry evicted
+  // to make room for it, as a change for the journal.
+  DicElement *InsertToDic(uint32_t dic_key);
+
   // Inserts a new |next_entry| into |entry|.
   // it makes a bigram connection from entry to next_entry.
   void InsertNextEntry(const NextEntry &next_entry, Entry *entry) const;
@@ -499,6 +563,21 @@ class UserHistoryPredictor : public PredictorInterface {
   bool content_word_learning_enabled_;
   mutable std::atomic<bool> updated_;
   std::unique_ptr<DicCache> dic_;
+  // Entries of |dic_| with non-empty keys sorted by key, so that prediction
+  // visits only the entries sharing a prefix with the input instead of the
+  // whole LRU list. It is rebuilt lazily; set |key_index_dirty_| whenever
+  // |dic_| is modified. Like |dic_|, it is not guarded by a lock, and must be
+  // accessed only from the thread calling the predictor, not from the syncer.
+  mutable std::vector<KeyIndexEntry> key_index_;
+  mutable bool key_index_dirty_ = true;
+  // Fingerprints of the entries inserted, updated or deleted since the last
+  // save.  Changes which are not tracked here, e.g. ClearHistoryEntry(), set
+  // |snapshot_required_| so that the next save writes the whole history.
+  absl::flat_hash_set<uint32_t> dirty_entries_;
+  bool snapshot_required_ = true;
+  // Sizes of the history file and of the journal appended after it.
+  size_t snapshot_size_ = 0;
+  size_t journal_size_ = 0;
   mutable std::unique_ptr<UserHistoryPredictorSyncer> syncer_;
 };
 
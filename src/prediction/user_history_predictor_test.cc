@@ -38,6 +38,7 @@
 #include <string>
 #include <vector>
 
+#include "base/clock.h"
 #include "base/clock_mock.h"
 #include "base/container/trie.h"
 #include "base/file_util.h"
@@ -79,6 +80,8 @@ using ::mozc::commands::Request;
 using ::mozc::config::Config;
 using ::mozc::dictionary::MockDictionary;
 using ::mozc::dictionary::SuppressionDictionary;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 
 }  // namespace
 
@@ -161,6 +164,7 @@ class UserHistoryPredictorTest : public ::testing::Test {
     e->set_key(std::string(key));
     e->set_value(std::string(value));
     e->set_removed(false);
+    predictor->key_index_dirty_ = true;
     return e;
   }
 
@@ -2203,6 +2207,95 @@ TEST_F(UserHistoryPredictorTest, UserHistoryStorage) {
   EXPECT_OK(FileUtil::UnlinkIfExists(filename));
 }
 
+TEST_F(UserHistoryPredictorTest, UserHistoryStorageJournal) {
+  const std::string filename =
+      FileUtil::JoinPath(SystemUtil::GetUserProfileDirectory(), "test");
+  const std::string journal_filename = filename + ".journal";
+  FileUnlinker unlinker(filename);
+  FileUnlinker journal_unlinker(journal_filename);
+
+  auto make_entry = [](absl::string_view key, uint32_t freq) {
+    UserHistoryPredictor::Entry entry;
+    entry.set_key(std::string(key));
+    entry.set_value(std::string(key));
+    entry.set_conversion_freq(freq);
+    entry.set_last_access_time(Clock::GetTime());
+    return entry;
+  };
+
+  {
+    UserHistoryStorage storage(filename);
+    *storage.GetProto().add_entries() = make_entry("a", 1);
+    *storage.GetProto().add_entries() = make_entry("b", 1);
+    *storage.GetProto().add_entries() = make_entry("c", 1);
+    ASSERT_TRUE(storage.Save());
+  }
+  {
+    UserHistoryStorage storage(filename);
+    user_history_predictor::UserHistory changes;
+    *changes.add_entries() = make_entry("a", 2);
+    changes.add_deleted_entry_fps(
+        UserHistoryPredictor::EntryFingerprint(make_entry("b", 1)));
+    ASSERT_TRUE(storage.AppendToJournal(changes));
+    changes.Clear();
+    *changes.add_entries() = make_entry("d", 1);
+    ASSERT_TRUE(storage.AppendToJournal(changes));
+  }
+  EXPECT_OK(FileUtil::FileExists(journal_filename));
+
+  // The updated entry is moved to the most recently used position.
+  UserHistoryStorage storage(filename);
+  ASSERT_TRUE(storage.Load());
+  EXPECT_FALSE(storage.has_broken_journal());
+  EXPECT_GT(storage.journal_size(), 0);
+  ASSERT_EQ(storage.GetProto().entries_size(), 3);
+  EXPECT_EQ(storage.GetProto().entries(0).key(), "c");
+  EXPECT_EQ(storage.GetProto().entries(1).key(), "a");
+  EXPECT_EQ(storage.GetProto().entries(1).conversion_freq(), 2);
+  EXPECT_EQ(storage.GetProto().entries(2).key(), "d");
+
+  // Saving the whole history removes the journal.
+  ASSERT_TRUE(storage.Save());
+  EXPECT_FALSE(FileUtil::FileExists(journal_filename).ok());
+  UserHistoryStorage storage2(filename);
+  ASSERT_TRUE(storage2.Load());
+  EXPECT_EQ(storage2.journal_size(), 0);
+  EXPECT_EQ(storage2.GetProto().DebugString(), storage.GetProto().DebugString());
+}
+
+TEST_F(UserHistoryPredictorTest, SyncAppendsChangesToJournal) {
+  UserHistoryPredictor *predictor = GetUserHistoryPredictorWithClearedHistory();
+  const std::string journal_filename =
+      UserHistoryPredictor::GetUserHistoryFileName() + ".journal";
+
+  // ClearAllHistory() writes the whole history, which removes the journal.
+  EXPECT_FALSE(FileUtil::FileExists(journal_filename).ok());
+
+  Segments segments;
+  SetUpInputForConversion("わたしのなまえはなかのです", composer_.get(),
+                          &segments);
+  AddCandidate("私の名前は中野です", &segments);
+  predictor->Finish(*convreq_, &segments);
+  ASSERT_TRUE(predictor->Sync());
+  WaitForSyncer(predictor);
+  EXPECT_OK(FileUtil::FileExists(journal_filename));
+
+  // The learned entry is restored from the history file and the journal.
+  ASSERT_TRUE(predictor->Reload());
+  WaitForSyncer(predictor);
+  segments.Clear();
+  SetUpInputForPrediction("わたしの", composer_.get(), &segments);
+  EXPECT_TRUE(predictor->PredictForRequest(*convreq_, &segments));
+  EXPECT_TRUE(FindCandidateByValue("私の名前は中野です", segments));
+
+  // ClearHistoryEntry() may change any entry, so the whole history is written.
+  EXPECT_TRUE(predictor->ClearHistoryEntry("わたしのなまえはなかのです",
+                                           "私の名前は中野です"));
+  ASSERT_TRUE(predictor->Sync());
+  WaitForSyncer(predictor);
+  EXPECT_FALSE(FileUtil::FileExists(journal_filename).ok());
+}
+
 TEST_F(UserHistoryPredictorTest, UserHistoryStorageContainingOldEntries) {
   ScopedClockMock clock(1, 0);
 
@@ -2487,6 +2580,71 @@ TEST_F(UserHistoryPredictorTest, ExpandedLookupRoman) {
   }
 }
 
+TEST_F(UserHistoryPredictorTest, LookupKeyIndex) {
+  UserHistoryPredictor *predictor = GetUserHistoryPredictorWithClearedHistory();
+  // Inserted in this order, so the LRU order is the reverse.
+  for (const char *key : {"あ", "あか", "あかい", "あまい", "いか", "かい"}) {
+    InsertEntry(predictor, key, key);
+  }
+  const auto lookup = [predictor](absl::string_view key_base,
+                                  const Trie<std::string> *expanded) {
+    std::vector<const UserHistoryPredictor::KeyIndexEntry *> entries;
+    predictor->LookupKeyIndex(key_base, expanded, &entries);
+    std::vector<std::string> keys;
+    for (const auto *entry : entries) {
+      keys.emplace_back(entry->key);
+    }
+    return keys;
+  };
+
+  // Prefixes of the base key and keys starting with it.
+  EXPECT_THAT(lookup("あか", nullptr), ElementsAre("あかい", "あか", "あ"));
+  EXPECT_THAT(lookup("う", nullptr), IsEmpty());
+
+  // Keys have to continue with one of the expansions.
+  Trie<std::string> expanded;
+  expanded.AddEntry("か", "か");
+  expanded.AddEntry("き", "き");
+  EXPECT_THAT(lookup("あ", &expanded), ElementsAre("あかい", "あか", "あ"));
+  EXPECT_THAT(lookup("", &expanded), ElementsAre("かい"));
+
+  // The index follows updates of the history.
+  InsertEntry(predictor, "かき", "柿");
+  EXPECT_THAT(lookup("", &expanded), ElementsAre("かき", "かい"));
+  InsertEntry(predictor, "かい", "かい");
+  EXPECT_THAT(lookup("", &expanded), ElementsAre("かい", "かき"));
+}
+
+TEST_F(UserHistoryPredictorTest, SuggestionTrialLimitSkipsExpiredEntries) {
+  ScopedClockMock clock(100 * 24 * 60 * 60, 0);
+  UserHistoryPredictor *predictor = GetUserHistoryPredictorWithClearedHistory();
+  const uint64_t now = Clock::GetTime();
+
+  // The LRU list is: 5 expired entries, 2999 entries, and "ほげほげ".
+  InsertEntry(predictor, "ほげほげ", "ホゲホゲ")->set_last_access_time(now);
+  for (int i = 0; i < 2999; ++i) {
+    const std::string key = absl::StrFormat("filler%d", i);
+    InsertEntry(predictor, key, key)->set_last_access_time(now);
+  }
+  for (int i = 0; i < 5; ++i) {
+    const std::string key = absl::StrFormat("expired%d", i);
+    InsertEntry(predictor, key, key)->set_last_access_time(0);
+  }
+
+  // Expired entries are not counted as trials, so "ほげほげ" is the 3000th
+  // trial, which is the last one within the limit.
+  Segments segments;
+  SetUpInputForSuggestion("ほげ", composer_.get(), &segments);
+  EXPECT_TRUE(predictor->PredictForRequest(*convreq_, &segments));
+  EXPECT_TRUE(FindCandidateByValue("ホゲホゲ", segments));
+
+  // One more valid entry pushes it out of the limit.
+  InsertEntry(predictor, "filler", "filler")->set_last_access_time(now);
+  segments.Clear();
+  SetUpInputForSuggestion("ほげ", composer_.get(), &segments);
+  EXPECT_FALSE(predictor->PredictForRequest(*convreq_, &segments));
+}
+
 TEST_F(UserHistoryPredictorTest, ExpandedLookupKana) {
   UserHistoryPredictor *predictor = GetUserHistoryPredictor();
   UserHistoryPredictor::Entry entry;
@@ -3099,6 +3257,20 @@ TEST_F(UserHistoryPredictorTest, RemoveNgramChain) {
   }
 }
 
+TEST_F(UserHistoryPredictorTest, CollectMemoryUsage) {
+  UserHistoryPredictor *predictor = GetUserHistoryPredictorWithClearedHistory();
+  auto get_heap_bytes = [predictor]() {
+    MemoryUsageCollector collector;
+    predictor->CollectMemoryUsage(&collector);
+    EXPECT_EQ(collector.entries().size(), 2);
+    return collector.Total().heap_bytes;
+  };
+
+  const size_t initial_heap_bytes = get_heap_bytes();
+  InsertEntry(predictor, std::string(1000, 'a'), std::string(1000, 'b'));
+  EXPECT_GE(get_heap_bytes(), initial_heap_bytes + 2000);
+}
+
 TEST_F(UserHistoryPredictorTest, ClearHistoryEntryUnigram) {
   ScopedClockMock clock(1, 0);
 
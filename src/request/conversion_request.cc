@@ -29,6 +29,7 @@
 
 #include "request/conversion_request.h"
 
+#include "base/clock.h"
 #include "base/logging.h"
 #include "config/config_handler.h"
 #include "protocol/commands.pb.h"
@@ -45,7 +46,12 @@ ConversionRequest::ConversionRequest(const composer::Composer *c,
     : request_type_(ConversionRequest::CONVERSION),
       composer_(c),
       request_(request),
-      config_(config) {}
+      config_(config) {
+  if (request_ != nullptr && request_->conversion_time_budget_msec() > 0) {
+    deadline_ = Clock::GetAbslTime() +
+                absl::Milliseconds(request_->conversion_time_budget_msec());
+  }
+}
 
 ConversionRequest::ConversionRequest(const ConversionRequest &x) = default;
 ConversionRequest &ConversionRequest::operator=(const ConversionRequest &x) =
@@ -118,6 +124,22 @@ void ConversionRequest::set_skip_slow_rewriters(bool value) {
   skip_slow_rewriters_ = value;
 }
 
+bool ConversionRequest::ShouldSkipSlowRewriters() const {
+  return skip_slow_rewriters_ || IsDeadlineExceeded();
+}
+
+absl::Time ConversionRequest::deadline() const { return deadline_; }
+
+void ConversionRequest::set_deadline(absl::Time deadline) {
+  deadline_ = deadline;
+}
+
+bool ConversionRequest::IsDeadlineExceeded() const {
+  // Avoid reading the clock in the common case without a deadline.
+  return deadline_ != absl::InfiniteFuture() &&
+         Clock::GetAbslTime() >= deadline_;
+}
+
 bool ConversionRequest::create_partial_candidates() const {
   return create_partial_candidates_;
 }
@@ -185,4 +207,12 @@ void ConversionRequest::set_should_call_set_key_in_prediction(bool value) {
   should_call_set_key_in_prediction_ = value;
 }
 
+bool ConversionRequest::keep_candidate_generator_state() const {
+  return keep_candidate_generator_state_;
+}
+
+void ConversionRequest::set_keep_candidate_generator_state(bool value) {
+  keep_candidate_generator_state_ = value;
+}
+
 }  // namespace mozc
@@ -33,6 +33,7 @@
 #include <string>
 
 #include "base/port.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 constexpr size_t kMaxConversionCandidatesSize = 200;
@@ -143,6 +144,26 @@ class ConversionRequest {
   bool should_call_set_key_in_prediction() const;
   void set_should_call_set_key_in_prediction(bool value);
 
+  bool keep_candidate_generator_state() const;
+  void set_keep_candidate_generator_state(bool value);
+
+  // The point in time by which the result is wanted. Conversion stages check
+  // it cooperatively and, once it has passed, cut their optional work and
+  // return the best result found so far. Initialized from
+  // commands::Request::conversion_time_budget_msec when the request is
+  // constructed; absl::InfiniteFuture() means no deadline.
+  absl::Time deadline() const;
+  void set_deadline(absl::Time deadline);
+
+  // Returns true if the deadline has passed.
+  bool IsDeadlineExceeded() const;
+
+  // Returns true if slow rewriters should be skipped, either because
+  // skip_slow_rewriters() is set or because the deadline has passed. The
+  // rewriters which only add optional candidates, e.g. emoji, symbols and
+  // dates, are skipped as well as UserBoundaryHistoryRewriter.
+  bool ShouldSkipSlowRewriters() const;
+
  private:
   RequestType request_type_ = CONVERSION;
 
@@ -171,8 +192,8 @@ class ConversionRequest {
   bool use_actual_converter_for_realtime_conversion_ = false;
 
   // Don't use this flag directly. This flag is used by DictionaryPredictor to
-  // skip some heavy rewriters, such as UserBoundaryHistoryRewriter and
-  // TransliterationRewriter.
+  // skip some heavy rewriters, such as UserBoundaryHistoryRewriter,
+  // TransliterationRewriter and the rewriters adding optional candidates.
   // TODO(noriyukit): Fix such a hacky handling for realtime conversion.
   bool skip_slow_rewriters_ = false;
 
@@ -188,6 +209,13 @@ class ConversionRequest {
   // If true, set conversion key to output segments in prediction.
   bool should_call_set_key_in_prediction_ = false;
 
+  // If true, realtime conversion keeps its N-best generator in the segments
+  // so that ImmutableConverterInterface::ExpandCandidatesForRequest() can
+  // resume it.
+  bool keep_candidate_generator_state_ = false;
+
+  absl::Time deadline_ = absl::InfiniteFuture();
+
   // TODO(noriyukit): Moves all the members of Segments that are irrelevant to
   // this structure, e.g., Segments::request_type_.
   // Also, a key for conversion is eligible to live in this class.
@@ -39,6 +39,7 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../base/base.gyp:clock',
         '../config/config.gyp:config_handler',
         '../protocol/protocol.gyp:commands_proto',
         '../protocol/protocol.gyp:config_proto',
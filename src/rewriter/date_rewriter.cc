@@ -1382,6 +1382,10 @@ bool DateRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
+
   bool modified = false;
 
   // Japanese ERA to AD works for resegmented input only
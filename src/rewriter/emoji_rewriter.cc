@@ -165,6 +165,10 @@ bool EmojiRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
+
   CHECK(segments != nullptr);
   return RewriteCandidates(segments);
 }
@@ -52,6 +52,7 @@
 #include "usage_stats/usage_stats_testing_util.h"
 #include "absl/container/btree_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace {
@@ -303,6 +304,19 @@ TEST_F(EmojiRewriterTest, NoConversionWithDisabledSettings) {
   EXPECT_EQ(CountEmojiCandidates(segments), 0);
 }
 
+TEST_F(EmojiRewriterTest, NoConversionAfterDeadline) {
+  convreq_.set_deadline(absl::InfinitePast());
+
+  Segments segments;
+  SetSegment("Neko", "test", &segments);
+  EXPECT_FALSE(rewriter_->Rewrite(convreq_, &segments));
+  EXPECT_EQ(CountEmojiCandidates(segments), 0);
+
+  convreq_.set_deadline(absl::InfiniteFuture());
+  EXPECT_TRUE(rewriter_->Rewrite(convreq_, &segments));
+  EXPECT_EQ(CountEmojiCandidates(segments), 1);
+}
+
 TEST_F(EmojiRewriterTest, CheckDescription) {
   const testing::MockDataManager data_manager;
   Segments segments;
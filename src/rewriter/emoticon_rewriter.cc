@@ -242,6 +242,10 @@ bool EmoticonRewriter::Rewrite(const ConversionRequest &request,
     VLOG(2) << "no use_emoticon_conversion";
     return false;
   }
+
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
   return RewriteCandidate(segments);
 }
 }  // namespace mozc
@@ -30,6 +30,7 @@
 #ifndef MOZC_REWRITER_MERGER_REWRITER_H_
 #define MOZC_REWRITER_MERGER_REWRITER_H_
 
+#include <cstddef>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -40,6 +41,9 @@
 #include "protocol/config.pb.h"
 #include "request/conversion_request.h"
 #include "rewriter/rewriter_interface.h"
+#include "usage_stats/latency_stats.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 
 namespace mozc {
 
@@ -81,14 +85,26 @@ class MergerRewriter : public RewriterInterface {
 
   void AddRewriter(std::unique_ptr<RewriterInterface> rewriter) {
     rewriters_.push_back(std::move(rewriter));
+    stages_.push_back(usage_stats::LatencyStats::kInvalidStage);
+  }
+
+  // Same as above, and records the latency of Rewrite() under the stage
+  // "Rewriter.<name>".
+  void AddRewriter(absl::string_view name,
+                   std::unique_ptr<RewriterInterface> rewriter) {
+    rewriters_.push_back(std::move(rewriter));
+    stages_.push_back(usage_stats::LatencyStats::RegisterStage(
+        absl::StrCat("Rewriter.", name)));
   }
 
   bool Rewrite(const ConversionRequest &request,
                Segments *segments) const override {
     bool result = false;
-    for (const std::unique_ptr<RewriterInterface> &rewriter : rewriters_) {
-      if (CheckCapability(request, segments, *rewriter)) {
-        result |= rewriter->Rewrite(request, segments);
+    for (size_t i = 0; i < rewriters_.size(); ++i) {
+      const RewriterInterface &rewriter = *rewriters_[i];
+      if (CheckCapability(request, segments, rewriter)) {
+        usage_stats::ScopedLatencyTimer timer(stages_[i]);
+        result |= rewriter.Rewrite(request, segments);
       }
     }
 
@@ -154,6 +170,8 @@ class MergerRewriter : public RewriterInterface {
 
  private:
   std::vector<std::unique_ptr<RewriterInterface>> rewriters_;
+  // Latency stages of |rewriters_|, indexed in parallel.
+  std::vector<usage_stats::LatencyStats::StageId> stages_;
 };
 
 }  // namespace mozc
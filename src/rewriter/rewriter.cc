@@ -97,51 +97,68 @@ RewriterImpl::RewriterImpl(const ConverterInterface *parent_converter,
   DCHECK(pos_group);
   // |dictionary| can be NULL
 
-  AddRewriter(std::make_unique<UserDictionaryRewriter>());
-  AddRewriter(std::make_unique<FocusCandidateRewriter>(data_manager));
+  AddRewriter("UserDictionary", std::make_unique<UserDictionaryRewriter>());
+  AddRewriter("FocusCandidate",
+              std::make_unique<FocusCandidateRewriter>(data_manager));
   AddRewriter(
+      "LanguageAware",
       std::make_unique<LanguageAwareRewriter>(pos_matcher_, dictionary));
-  AddRewriter(std::make_unique<TransliterationRewriter>(pos_matcher_));
-  AddRewriter(std::make_unique<EnglishVariantsRewriter>());
-  AddRewriter(std::make_unique<NumberRewriter>(data_manager));
-  AddRewriter(std::make_unique<CollocationRewriter>(data_manager));
-  AddRewriter(std::make_unique<SingleKanjiRewriter>(*data_manager));
-  AddRewriter(std::make_unique<IvsVariantsRewriter>());
-  AddRewriter(std::make_unique<EmojiRewriter>(*data_manager));
-  AddRewriter(EmoticonRewriter::CreateFromDataManager(*data_manager));
-  AddRewriter(std::make_unique<CalculatorRewriter>(parent_converter));
-  AddRewriter(std::make_unique<SymbolRewriter>(parent_converter, data_manager));
-  AddRewriter(std::make_unique<UnicodeRewriter>(parent_converter));
-  AddRewriter(std::make_unique<VariantsRewriter>(pos_matcher_));
-  AddRewriter(std::make_unique<ZipcodeRewriter>(&pos_matcher_));
-  AddRewriter(std::make_unique<DiceRewriter>());
-  AddRewriter(std::make_unique<SmallLetterRewriter>(parent_converter));
+  AddRewriter("Transliteration",
+              std::make_unique<TransliterationRewriter>(pos_matcher_));
+  AddRewriter("EnglishVariants", std::make_unique<EnglishVariantsRewriter>());
+  AddRewriter("Number", std::make_unique<NumberRewriter>(data_manager));
+  AddRewriter("Collocation",
+              std::make_unique<CollocationRewriter>(data_manager));
+  AddRewriter("SingleKanji",
+              std::make_unique<SingleKanjiRewriter>(*data_manager));
+  AddRewriter("IvsVariants", std::make_unique<IvsVariantsRewriter>());
+  AddRewriter("Emoji", std::make_unique<EmojiRewriter>(*data_manager));
+  AddRewriter("Emoticon",
+              EmoticonRewriter::CreateFromDataManager(*data_manager));
+  AddRewriter("Calculator",
+              std::make_unique<CalculatorRewriter>(parent_converter));
+  AddRewriter("Symbol",
+              std::make_unique<SymbolRewriter>(parent_converter, data_manager));
+  AddRewriter("Unicode", std::make_unique<UnicodeRewriter>(parent_converter));
+  AddRewriter("Variants", std::make_unique<VariantsRewriter>(pos_matcher_));
+  AddRewriter("Zipcode", std::make_unique<ZipcodeRewriter>(&pos_matcher_));
+  AddRewriter("Dice", std::make_unique<DiceRewriter>());
+  AddRewriter("SmallLetter",
+              std::make_unique<SmallLetterRewriter>(parent_converter));
 
   if (absl::GetFlag(FLAGS_use_history_rewriter)) {
     AddRewriter(
+        "UserBoundaryHistory",
         std::make_unique<UserBoundaryHistoryRewriter>(parent_converter));
     AddRewriter(
+        "UserSegmentHistory",
         std::make_unique<UserSegmentHistoryRewriter>(&pos_matcher_, pos_group));
   }
 
-  AddRewriter(std::make_unique<DateRewriter>(dictionary));
-  AddRewriter(std::make_unique<FortuneRewriter>());
+  AddRewriter("Date", std::make_unique<DateRewriter>(dictionary));
+  AddRewriter("Fortune", std::make_unique<FortuneRewriter>());
 #if !(defined(__ANDROID__) || (defined(TARGET_OS_IPHONE) && TARGET_OS_IPHONE))
   // CommandRewriter is not tested well on Android or iOS.
   // So we temporarily disable it.
   // TODO(yukawa, team): Enable CommandRewriter on Android if necessary.
-  AddRewriter(std::make_unique<CommandRewriter>());
+  AddRewriter("Command", std::make_unique<CommandRewriter>());
 #endif  // !(__ANDROID__ || TARGET_OS_IPHONE)
 #ifndef NO_USAGE_REWRITER
-  AddRewriter(std::make_unique<UsageRewriter>(data_manager, dictionary));
+  AddRewriter("Usage",
+              std::make_unique<UsageRewriter>(data_manager, dictionary));
 #endif  // NO_USAGE_REWRITER
   AddRewriter(
+      "Version",
       std::make_unique<VersionRewriter>(data_manager->GetDataVersion()));
-  AddRewriter(CorrectionRewriter::CreateCorrectionRewriter(data_manager));
-  AddRewriter(std::make_unique<T13nPromotionRewriter>());
-  AddRewriter(std::make_unique<EnvironmentalFilterRewriter>(*data_manager));
-  AddRewriter(std::make_unique<RemoveRedundantCandidateRewriter>());
-  AddRewriter(std::make_unique<A11yDescriptionRewriter>(data_manager));
+  AddRewriter("Correction",
+              CorrectionRewriter::CreateCorrectionRewriter(data_manager));
+  AddRewriter("T13nPromotion", std::make_unique<T13nPromotionRewriter>());
+  AddRewriter("EnvironmentalFilter",
+              std::make_unique<EnvironmentalFilterRewriter>(*data_manager));
+  AddRewriter("RemoveRedundantCandidate",
+              std::make_unique<RemoveRedundantCandidateRewriter>());
+  AddRewriter("A11yDescription",
+              std::make_unique<A11yDescriptionRewriter>(data_manager));
 }
 
 }  // namespace mozc
@@ -98,6 +98,7 @@
         '../protocol/protocol.gyp:config_proto',
         '../request/request.gyp:conversion_request',
         '../storage/storage.gyp:storage',
+        '../usage_stats/usage_stats_base.gyp:latency_stats',
         '../usage_stats/usage_stats_base.gyp:usage_stats',
         'calculator/calculator.gyp:calculator',
         'rewriter_base.gyp:gen_rewriter_files#host',
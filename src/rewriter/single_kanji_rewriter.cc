@@ -130,6 +130,10 @@ bool SingleKanjiRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
+
   bool modified = false;
   const size_t segments_size = segments->conversion_segments_size();
   const bool is_single_segment = (segments_size == 1);
@@ -380,6 +380,10 @@ bool SymbolRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
+
   // apply entire candidate first, as we want to
   // find character combinations first, e.g.,
   // "－＞" -> "→"
@@ -192,6 +192,10 @@ bool UsageRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
+  if (request.ShouldSkipSlowRewriters()) {
+    return false;
+  }
+
   bool modified = false;
   // UsageIDs for embedded usage dictionary are generated in advance by
   // gen_usage_rewriter_dictionary_main.cc (which are just sequential numbers).
@@ -183,7 +183,7 @@ bool UserBoundaryHistoryRewriter::Rewrite(const ConversionRequest &request,
     return false;
   }
 
-  if (request.skip_slow_rewriters()) {
+  if (request.ShouldSkipSlowRewriters()) {
     return false;
   }
 
@@ -108,6 +108,7 @@
         '../protocol/protocol.gyp:config_proto',
         '../protocol/protocol.gyp:engine_builder_proto',
         '../protocol/protocol.gyp:user_dictionary_storage_proto',
+        '../usage_stats/usage_stats_base.gyp:latency_stats',
         '../usage_stats/usage_stats_base.gyp:usage_stats',
         ':session_watch_dog',
         'session_base.gyp:keymap',
@@ -164,6 +165,7 @@
       ],
       'dependencies': [
         '../base/absl.gyp:absl_strings',
+        '../base/absl.gyp:absl_synchronization',
         '../base/base.gyp:base',
         '../engine/engine.gyp:engine_factory',
         '../usage_stats/usage_stats_base.gyp:usage_stats_uploader',
@@ -1164,6 +1164,10 @@ void SessionConverter::FillOutput(const composer::Composer &composer,
     }
   }
 
+  if (segments_->truncated()) {
+    output->set_conversion_truncated(true);
+  }
+
   // For debug. Removed candidate words through the conversion process.
   if (CheckState(SUGGESTION | PREDICTION | CONVERSION)) {
     SessionOutput::FillRemovedCandidates(
@@ -41,6 +41,7 @@
 
 #include "base/clock.h"
 #include "base/logging.h"
+#include "base/memory_usage.h"
 #include "base/port.h"
 #include "base/stopwatch.h"
 #include "composer/table.h"
@@ -56,9 +57,11 @@
 #include "session/internal/keymap.h"
 #include "session/session.h"
 #include "session/session_observer_handler.h"
+#include "usage_stats/latency_stats.h"
 #include "usage_stats/usage_stats.h"
 #include "absl/flags/flag.h"
 #include "absl/random/random.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
@@ -67,6 +70,7 @@
 #include "session/session_watch_dog.h"
 #endif  // MOZC_DISABLE_SESSION_WATCHDOG
 
+using mozc::usage_stats::LatencyStats;
 using mozc::usage_stats::UsageStats;
 
 // TODO(b/275437228): Convert this to use `absl::Duration`. Note that existing
@@ -126,6 +130,25 @@ bool IsApplicationAlive(const session::SessionInterface *session) {
 #endif  // MOZC_DISABLE_SESSION_WATCHDOG
   return true;
 }
+
+// Returns the latency stage of the command |type|, e.g.
+// "SessionHandler.SEND_KEY".
+LatencyStats::StageId GetCommandStage(commands::Input::CommandType type) {
+  static const std::vector<LatencyStats::StageId> *stages = [] {
+    auto *stages = new std::vector<LatencyStats::StageId>(
+        commands::Input::CommandType_ARRAYSIZE, LatencyStats::kInvalidStage);
+    for (int i = 0; i < commands::Input::CommandType_ARRAYSIZE; ++i) {
+      if (commands::Input::CommandType_IsValid(i)) {
+        (*stages)[i] = LatencyStats::RegisterStage(absl::StrCat(
+            "SessionHandler.", commands::Input::CommandType_Name(
+                                   static_cast<commands::Input::CommandType>(
+                                       i))));
+      }
+    }
+    return stages;
+  }();
+  return (*stages)[type];
+}
 }  // namespace
 
 SessionHandler::SessionHandler(std::unique_ptr<EngineInterface> engine) {
@@ -339,6 +362,8 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
   bool eval_succeeded = false;
   Stopwatch stopwatch;
   stopwatch.Start();
+  usage_stats::ScopedLatencyTimer timer(
+      GetCommandStage(command->input().type()));
 
   switch (command->input().type()) {
     case commands::Input::CREATE_SESSION:
@@ -401,6 +426,12 @@ bool SessionHandler::EvalCommand(commands::Command *command) {
     case commands::Input::RELOAD_SPELL_CHECKER:
       eval_succeeded = ReloadSpellChecker(command);
       break;
+    case commands::Input::GET_LATENCY_STATS:
+      eval_succeeded = GetLatencyStats(command);
+      break;
+    case commands::Input::GET_MEMORY_STATS:
+      eval_succeeded = GetMemoryStats(command);
+      break;
     default:
       eval_succeeded = false;
   }
@@ -697,6 +728,40 @@ bool SessionHandler::ReloadSpellChecker(commands::Command *command) {
   return true;
 }
 
+bool SessionHandler::GetLatencyStats(commands::Command *command) {
+  commands::LatencyStats *stats =
+      command->mutable_output()->mutable_latency_stats();
+  for (const LatencyStats::StageSummary &summary :
+       LatencyStats::GetSummaries()) {
+    commands::LatencyStats::Stage *stage = stats->add_stage();
+    stage->set_name(summary.name);
+    stage->set_count(summary.count);
+    stage->set_total_usec(absl::ToInt64Microseconds(summary.total));
+    stage->set_p50_usec(absl::ToInt64Microseconds(summary.p50));
+    stage->set_p90_usec(absl::ToInt64Microseconds(summary.p90));
+    stage->set_p99_usec(absl::ToInt64Microseconds(summary.p99));
+    stage->set_max_usec(absl::ToInt64Microseconds(summary.max));
+  }
+  if (command->input().reset_latency_stats()) {
+    LatencyStats::Reset();
+  }
+  return true;
+}
+
+bool SessionHandler::GetMemoryStats(commands::Command *command) {
+  MemoryUsageCollector collector;
+  engine_->CollectMemoryUsage(&collector);
+  commands::MemoryStats *stats =
+      command->mutable_output()->mutable_memory_stats();
+  for (const auto &[name, usage] : collector.entries()) {
+    commands::MemoryStats::Component *component = stats->add_component();
+    component->set_name(name);
+    component->set_heap_bytes(usage.heap_bytes);
+    component->set_mapped_bytes(usage.mapped_bytes);
+  }
+  return true;
+}
+
 // Create Random Session ID in order to make the session id unpredicable
 SessionID SessionHandler::CreateNewSessionID() {
   while (true) {
@@ -146,6 +146,10 @@ class SessionHandler : public SessionHandlerInterface {
   bool NoOperation(commands::Command *command);
   bool CheckSpelling(commands::Command *command);
   bool ReloadSpellChecker(commands::Command *command);
+  // Fills the latency histograms of the conversion stages.
+  bool GetLatencyStats(commands::Command *command);
+  // Fills the memory usage of the engine components.
+  bool GetMemoryStats(commands::Command *command);
 
   SessionID CreateNewSessionID();
   bool DeleteSessionID(SessionID id);
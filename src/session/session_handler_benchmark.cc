@@ -0,0 +1,305 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/session_handler_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/thread2.h"
+#include "engine/engine_interface.h"
+#include "engine/user_data_manager_interface.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler.h"
+#include "session/session_handler_interface.h"
+#include "session/session_handler_tool.h"
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace session {
+namespace {
+
+// SessionHandler is not thread-safe. Like SessionServer, serializes the
+// commands from the concurrent sessions.
+class SynchronizedSessionHandler : public SessionHandlerInterface {
+ public:
+  SynchronizedSessionHandler(std::unique_ptr<EngineInterface> engine,
+                             absl::Mutex *mutex)
+      : mutex_(mutex), handler_(std::move(engine)) {}
+
+  bool IsAvailable() const override { return handler_.IsAvailable(); }
+
+  bool EvalCommand(commands::Command *command) override {
+    absl::MutexLock lock(mutex_);
+    return handler_.EvalCommand(command);
+  }
+
+  bool StartWatchDog() override { return false; }
+
+  void AddObserver(SessionObserverInterface *observer) override {
+    absl::MutexLock lock(mutex_);
+    handler_.AddObserver(observer);
+  }
+
+  absl::string_view GetDataVersion() const override {
+    return handler_.GetDataVersion();
+  }
+
+ private:
+  absl::Mutex *mutex_;
+  SessionHandler handler_;
+};
+
+// The user data manager of the engine, e.g. UserHistoryPredictor, shares its
+// state with the commands. Serializes it with SynchronizedSessionHandler.
+class SynchronizedUserDataManager : public UserDataManagerInterface {
+ public:
+  SynchronizedUserDataManager(UserDataManagerInterface *manager,
+                              absl::Mutex *mutex)
+      : mutex_(mutex), manager_(manager) {}
+
+  bool Sync() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->Sync();
+  }
+
+  bool Reload() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->Reload();
+  }
+
+  bool ClearUserHistory() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->ClearUserHistory();
+  }
+
+  bool ClearUserPrediction() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->ClearUserPrediction();
+  }
+
+  bool ClearUnusedUserPrediction() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->ClearUnusedUserPrediction();
+  }
+
+  bool ClearUserPredictionEntry(absl::string_view key,
+                                absl::string_view value) override {
+    absl::MutexLock lock(mutex_);
+    return manager_->ClearUserPredictionEntry(key, value);
+  }
+
+  bool Wait() override {
+    absl::MutexLock lock(mutex_);
+    return manager_->Wait();
+  }
+
+ private:
+  absl::Mutex *mutex_;
+  UserDataManagerInterface *manager_;
+};
+
+// Latency samples keyed by the scenario command.
+using Samples = absl::btree_map<std::string, std::vector<absl::Duration>>;
+
+struct SessionResult {
+  Samples samples;
+  size_t num_commands = 0;
+  size_t num_errors = 0;
+};
+
+void ReplayScenarios(const std::vector<std::vector<std::string>> &scenarios,
+                     int iterations, SessionHandlerInterpreter *interpreter,
+                     SessionResult *result) {
+  for (int i = 0; i < iterations; ++i) {
+    for (const std::vector<std::string> &scenario : scenarios) {
+      interpreter->ResetContext();
+      for (const std::string &line : scenario) {
+        const std::vector<std::string> args = interpreter->Parse(line);
+        if (args.empty()) {
+          continue;
+        }
+        // Waits for the user data written by the previous command outside of
+        // the measured time.
+        interpreter->SyncDataToStorage();
+        const absl::Time start = absl::Now();
+        const absl::Status status = interpreter->Eval(args);
+        const absl::Duration elapsed = absl::Now() - start;
+        // EXPECT_* lines are not commands of the interpreter.
+        if (absl::IsUnimplemented(status)) {
+          continue;
+        }
+        ++result->num_commands;
+        if (!status.ok()) {
+          ++result->num_errors;
+          LOG(WARNING) << line << ": " << status;
+        }
+        result->samples[args[0]].push_back(elapsed);
+      }
+    }
+  }
+}
+
+absl::Duration GetPercentile(const std::vector<absl::Duration> &sorted,
+                             double percentile) {
+  const size_t rank =
+      static_cast<size_t>(std::ceil(sorted.size() * percentile));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+double SessionHandlerBenchmark::Result::GetThroughput() const {
+  const double seconds = absl::ToDoubleSeconds(elapsed);
+  return seconds > 0 ? num_commands / seconds : 0;
+}
+
+SessionHandlerBenchmark::SessionHandlerBenchmark(
+    std::unique_ptr<EngineInterface> engine)
+    : data_manager_(std::make_unique<SynchronizedUserDataManager>(
+          engine->GetUserDataManager(), &mutex_)),
+      handler_(std::make_unique<SynchronizedSessionHandler>(std::move(engine),
+                                                            &mutex_)) {
+  handler_->AddObserver(&usage_observer_);
+}
+
+SessionHandlerBenchmark::~SessionHandlerBenchmark() = default;
+
+absl::Status SessionHandlerBenchmark::AddScenarioFile(const std::string &path) {
+  if (absl::Status status = FileUtil::FileExists(path); !status.ok()) {
+    return status;
+  }
+  InputFileStream input(path);
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(input, line)) {
+    lines.push_back(std::move(line));
+  }
+  AddScenario(std::move(lines));
+  return absl::OkStatus();
+}
+
+void SessionHandlerBenchmark::AddScenario(std::vector<std::string> lines) {
+  scenarios_.push_back(std::move(lines));
+}
+
+SessionHandlerBenchmark::Result SessionHandlerBenchmark::Run(int iterations,
+                                                             int num_sessions) {
+  num_sessions = std::max(num_sessions, 1);
+  // Sessions are created up front so that the creation is not measured.
+  std::vector<std::unique_ptr<SessionHandlerInterpreter>> interpreters;
+  for (int i = 0; i < num_sessions; ++i) {
+    interpreters.push_back(std::make_unique<SessionHandlerInterpreter>(
+        handler_.get(), data_manager_.get()));
+    interpreters.back()->SetSyncDataOnEval(false);
+  }
+
+  std::vector<SessionResult> session_results(num_sessions);
+  const absl::Time start = absl::Now();
+  if (num_sessions == 1) {
+    ReplayScenarios(scenarios_, iterations, interpreters[0].get(),
+                    &session_results[0]);
+  } else {
+    std::vector<Thread2> threads;
+    for (int i = 0; i < num_sessions; ++i) {
+      threads.emplace_back([&, i] {
+        ReplayScenarios(scenarios_, iterations, interpreters[i].get(),
+                        &session_results[i]);
+      });
+    }
+    for (Thread2 &thread : threads) {
+      thread.Join();
+    }
+  }
+
+  Result result;
+  result.elapsed = absl::Now() - start;
+  Samples samples;
+  for (SessionResult &session_result : session_results) {
+    result.num_commands += session_result.num_commands;
+    result.num_errors += session_result.num_errors;
+    for (auto &[command, durations] : session_result.samples) {
+      std::vector<absl::Duration> &merged = samples[command];
+      merged.insert(merged.end(), durations.begin(), durations.end());
+    }
+  }
+  for (auto &[command, durations] : samples) {
+    std::sort(durations.begin(), durations.end());
+    CommandStats &stats = result.commands.emplace_back();
+    stats.command = command;
+    stats.count = durations.size();
+    for (const absl::Duration duration : durations) {
+      stats.total += duration;
+    }
+    stats.p50 = GetPercentile(durations, 0.5);
+    stats.p95 = GetPercentile(durations, 0.95);
+    stats.p99 = GetPercentile(durations, 0.99);
+    stats.max = durations.back();
+  }
+  return result;
+}
+
+std::string SessionHandlerBenchmark::FormatResult(const Result &result) {
+  std::string output = absl::StrFormat(
+      "commands: %d, errors: %d, elapsed: %.3f ms, throughput: %.1f "
+      "commands/s\n",
+      result.num_commands, result.num_errors,
+      absl::ToDoubleMilliseconds(result.elapsed), result.GetThroughput());
+  absl::StrAppendFormat(&output, "%-32s %8s %10s %10s %10s %10s %12s\n",
+                        "command", "count", "p50(us)", "p95(us)", "p99(us)",
+                        "max(us)", "total(ms)");
+  for (const CommandStats &stats : result.commands) {
+    absl::StrAppendFormat(
+        &output, "%-32s %8d %10.1f %10.1f %10.1f %10.1f %12.3f\n",
+        stats.command, stats.count, absl::ToDoubleMicroseconds(stats.p50),
+        absl::ToDoubleMicroseconds(stats.p95),
+        absl::ToDoubleMicroseconds(stats.p99),
+        absl::ToDoubleMicroseconds(stats.max),
+        absl::ToDoubleMilliseconds(stats.total));
+  }
+  return output;
+}
+
+}  // namespace session
+}  // namespace mozc
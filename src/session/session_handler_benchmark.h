@@ -0,0 +1,109 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Replays session scenarios (see data/test/session/scenario) against one
+// SessionHandler and measures the latency of the scenario commands. Unlike the
+// scenario tests, EXPECT_* lines are skipped; the outputs are not verified.
+
+#ifndef MOZC_SESSION_SESSION_HANDLER_BENCHMARK_H_
+#define MOZC_SESSION_SESSION_HANDLER_BENCHMARK_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine/engine_interface.h"
+#include "engine/user_data_manager_interface.h"
+#include "session/session_handler_interface.h"
+#include "session/session_usage_observer.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace session {
+
+class SessionHandlerBenchmark {
+ public:
+  // Latency of one scenario command, e.g. "SEND_KEY".
+  struct CommandStats {
+    std::string command;
+    size_t count = 0;
+    absl::Duration total;
+    absl::Duration p50;
+    absl::Duration p95;
+    absl::Duration p99;
+    absl::Duration max;
+  };
+
+  struct Result {
+    // Number of the evaluated commands, including the failed ones.
+    size_t num_commands = 0;
+    size_t num_errors = 0;
+    // Wall time of the whole replay.
+    absl::Duration elapsed;
+    // Sorted by the command name.
+    std::vector<CommandStats> commands;
+
+    // Returns the number of commands per second.
+    double GetThroughput() const;
+  };
+
+  explicit SessionHandlerBenchmark(std::unique_ptr<EngineInterface> engine);
+  SessionHandlerBenchmark(const SessionHandlerBenchmark &) = delete;
+  SessionHandlerBenchmark &operator=(const SessionHandlerBenchmark &) = delete;
+  ~SessionHandlerBenchmark();
+
+  // Adds a scenario from the file |path|.
+  absl::Status AddScenarioFile(const std::string &path);
+  // Adds a scenario given as lines of the scenario format.
+  void AddScenario(std::vector<std::string> lines);
+
+  // Replays all the scenarios |iterations| times on each of |num_sessions|
+  // sessions. Each session runs on its own thread, and the commands are
+  // serialized on the shared handler as in the server.
+  Result Run(int iterations, int num_sessions);
+
+  // Returns |result| as a human readable table.
+  static std::string FormatResult(const Result &result);
+
+ private:
+  SessionUsageObserver usage_observer_;
+  // Serializes the commands and the user data operations of the sessions.
+  absl::Mutex mutex_;
+  std::unique_ptr<UserDataManagerInterface> data_manager_;
+  std::unique_ptr<SessionHandlerInterface> handler_;
+  std::vector<std::vector<std::string>> scenarios_;
+};
+
+}  // namespace session
+}  // namespace mozc
+
+#endif  // MOZC_SESSION_SESSION_HANDLER_BENCHMARK_H_
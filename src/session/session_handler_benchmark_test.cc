@@ -0,0 +1,110 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/session_handler_benchmark.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/engine_interface.h"
+#include "engine/mock_data_engine_factory.h"
+#include "session/session_handler_test_util.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace session {
+namespace {
+
+using ::mozc::session::testing::SessionHandlerTestBase;
+
+class SessionHandlerBenchmarkTest : public SessionHandlerTestBase {
+ protected:
+  static const SessionHandlerBenchmark::CommandStats *FindCommand(
+      const SessionHandlerBenchmark::Result &result,
+      const std::string &command) {
+    for (const SessionHandlerBenchmark::CommandStats &stats :
+         result.commands) {
+      if (stats.command == command) {
+        return &stats;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(SessionHandlerBenchmarkTest, Run) {
+  std::unique_ptr<EngineInterface> engine =
+      MockDataEngineFactory::Create().value();
+  SessionHandlerBenchmark benchmark(std::move(engine));
+  benchmark.AddScenario({
+      "# Comment",
+      "SEND_KEY\tON",
+      "SEND_KEYS\tkyouhaiitenki",
+      "EXPECT_PREEDIT\tきょうはいいてんき",
+      "SEND_KEY\tSpace",
+      "SEND_KEY\tEnter",
+  });
+
+  constexpr int kIterations = 3;
+  constexpr int kSessions = 2;
+  const SessionHandlerBenchmark::Result result =
+      benchmark.Run(kIterations, kSessions);
+  EXPECT_EQ(result.num_commands, 4 * kIterations * kSessions);
+  EXPECT_EQ(result.num_errors, 0);
+  EXPECT_GT(result.GetThroughput(), 0);
+
+  const SessionHandlerBenchmark::CommandStats *send_key =
+      FindCommand(result, "SEND_KEY");
+  ASSERT_NE(send_key, nullptr);
+  EXPECT_EQ(send_key->count, 3 * kIterations * kSessions);
+  EXPECT_LE(send_key->p50, send_key->p95);
+  EXPECT_LE(send_key->p95, send_key->p99);
+  EXPECT_LE(send_key->p99, send_key->max);
+
+  const SessionHandlerBenchmark::CommandStats *send_keys =
+      FindCommand(result, "SEND_KEYS");
+  ASSERT_NE(send_keys, nullptr);
+  EXPECT_EQ(send_keys->count, kIterations * kSessions);
+
+  // EXPECT_* lines are not measured.
+  EXPECT_EQ(FindCommand(result, "EXPECT_PREEDIT"), nullptr);
+  EXPECT_NE(SessionHandlerBenchmark::FormatResult(result).find("SEND_KEYS"),
+            std::string::npos);
+}
+
+TEST_F(SessionHandlerBenchmarkTest, MissingScenarioFile) {
+  SessionHandlerBenchmark benchmark(MockDataEngineFactory::Create().value());
+  EXPECT_FALSE(benchmark.AddScenarioFile("/nonexistent/scenario.txt").ok());
+}
+
+}  // namespace
+}  // namespace session
+}  // namespace mozc
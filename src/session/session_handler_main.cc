@@ -33,6 +33,11 @@
 // session_handler_main --logtostderr --input input.txt --profile /tmp/mozc
 //                      --dictionary oss --engine desktop
 //
+// Benchmark mode, replaying scenarios 10 times on 4 concurrent sessions:
+// session_handler_main --profile /tmp/mozc --benchmark_iterations 10
+//     --benchmark_sessions 4
+//     --benchmark_scenarios data/test/session/scenario/conversion.txt,...
+//
 /* Example of input.txt (tsv format)
 # Enable IME
 SEND_KEY        ON
@@ -50,6 +55,10 @@ SEND_KEY        Enter
 SHOW
 SHOW_LOG_BY_VALUE       ございます
 SHOW_LOG_BY_VALUE       ございました
+# Per-stage latency percentiles since the start (or the last RESET).
+SHOW_LATENCY_STATS
+# Heap and mapped bytes of each engine component.
+SHOW_MEMORY_STATS
 */
 
 #include <cstdint>
@@ -65,11 +74,15 @@ SHOW_LOG_BY_VALUE       ございました
 #include "base/system_util.h"
 #include "data_manager/oss/oss_data_manager.h"
 #include "engine/engine.h"
+#include "engine/engine_interface.h"
 #include "protocol/candidates.pb.h"
 #include "protocol/commands.pb.h"
+#include "session/session_handler_benchmark.h"
 #include "session/session_handler_tool.h"
+#include "usage_stats/latency_stats.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 
@@ -78,6 +91,17 @@ ABSL_FLAG(std::string, profile, "", "User profile directory");
 ABSL_FLAG(std::string, engine, "", "Conversion engine: 'mobile' or 'desktop'");
 ABSL_FLAG(std::string, dictionary, "",
           "Dictionary: 'google', 'android' or 'oss'");
+ABSL_FLAG(bool, show_latency_stats, false,
+          "Show the per-stage latency stats before exiting");
+ABSL_FLAG(bool, show_memory_stats, false,
+          "Show the memory usage of the engine components before exiting");
+ABSL_FLAG(int32_t, benchmark_iterations, 0,
+          "If positive, replays --benchmark_scenarios this many times and "
+          "reports the latency of each command instead of reading --input");
+ABSL_FLAG(int32_t, benchmark_sessions, 1,
+          "Number of sessions replaying the scenarios concurrently");
+ABSL_FLAG(std::vector<std::string>, benchmark_scenarios, {},
+          "Comma separated scenario files for the benchmark mode");
 
 namespace mozc {
 void Show(const commands::Output &output) {
@@ -109,6 +133,38 @@ void ShowLog(const commands::Output &output, const int cand_id) {
   }
 }
 
+void ShowLatencyStats(const commands::LatencyStats &stats) {
+  std::cout << absl::StrFormat("%-48s %8s %8s %8s %8s %8s %10s", "stage",
+                               "count", "p50(us)", "p90(us)", "p99(us)",
+                               "max(us)", "total(us)")
+            << std::endl;
+  for (const auto &stage : stats.stage()) {
+    std::cout << absl::StrFormat("%-48s %8d %8d %8d %8d %8d %10d",
+                                 stage.name(), stage.count(), stage.p50_usec(),
+                                 stage.p90_usec(), stage.p99_usec(),
+                                 stage.max_usec(), stage.total_usec())
+              << std::endl;
+  }
+}
+
+void ShowMemoryStats(const commands::MemoryStats &stats) {
+  std::cout << absl::StrFormat("%-48s %12s %12s", "component", "heap",
+                               "mapped")
+            << std::endl;
+  uint64_t total_heap_bytes = 0, total_mapped_bytes = 0;
+  for (const auto &component : stats.component()) {
+    std::cout << absl::StrFormat("%-48s %12d %12d", component.name(),
+                                 component.heap_bytes(),
+                                 component.mapped_bytes())
+              << std::endl;
+    total_heap_bytes += component.heap_bytes();
+    total_mapped_bytes += component.mapped_bytes();
+  }
+  std::cout << absl::StrFormat("%-48s %12d %12d", "total", total_heap_bytes,
+                               total_mapped_bytes)
+            << std::endl;
+}
+
 void ParseLine(session::SessionHandlerInterpreter &handler, std::string line) {
   std::vector<std::string> args = handler.Parse(line);
   if (args.empty()) {
@@ -151,6 +207,24 @@ void ParseLine(session::SessionHandlerInterpreter &handler, std::string line) {
     }
     return;
   }
+  if (command == "SHOW_LATENCY_STATS") {
+    const absl::Status status = handler.Eval({"GET_LATENCY_STATS"});
+    if (status.ok()) {
+      ShowLatencyStats(handler.LastOutput().latency_stats());
+    } else {
+      std::cout << "ERROR: " << status.message() << std::endl;
+    }
+    return;
+  }
+  if (command == "SHOW_MEMORY_STATS") {
+    const absl::Status status = handler.Eval({"GET_MEMORY_STATS"});
+    if (status.ok()) {
+      ShowMemoryStats(handler.LastOutput().memory_stats());
+    } else {
+      std::cout << "ERROR: " << status.message() << std::endl;
+    }
+    return;
+  }
   if (command == "SHOW_LOG_BY_VALUE") {
     if (args.size() != 2) {
       std::cout << "ERROR: " << line << std::endl;
@@ -195,6 +269,25 @@ absl::StatusOr<std::unique_ptr<Engine>> CreateEngine(
   return Engine::CreateMobileEngine(CreateDataManager(dictionary));
 }
 
+int RunBenchmark(std::unique_ptr<EngineInterface> engine) {
+  session::SessionHandlerBenchmark benchmark(std::move(engine));
+  for (const std::string &path : absl::GetFlag(FLAGS_benchmark_scenarios)) {
+    if (const absl::Status status = benchmark.AddScenarioFile(path);
+        !status.ok()) {
+      std::cout << "ERROR: " << status << std::endl;
+      return 1;
+    }
+  }
+  const session::SessionHandlerBenchmark::Result result =
+      benchmark.Run(absl::GetFlag(FLAGS_benchmark_iterations),
+                    absl::GetFlag(FLAGS_benchmark_sessions));
+  std::cout << session::SessionHandlerBenchmark::FormatResult(result);
+  if (absl::GetFlag(FLAGS_show_latency_stats)) {
+    std::cout << usage_stats::LatencyStats::Dump();
+  }
+  return result.num_errors == 0 ? 0 : 1;
+}
+
 }  // namespace mozc
 
 int main(int argc, char **argv) {
@@ -208,6 +301,9 @@ int main(int argc, char **argv) {
     std::cout << "engine init error" << std::endl;
     return 1;
   }
+  if (absl::GetFlag(FLAGS_benchmark_iterations) > 0) {
+    return mozc::RunBenchmark(*std::move(engine));
+  }
   mozc::session::SessionHandlerInterpreter handler(*std::move(engine));
 
   std::string line;
@@ -221,5 +317,12 @@ int main(int argc, char **argv) {
   while (std::getline(std::cin, line)) {
     mozc::ParseLine(handler, line);
   }
+
+  if (absl::GetFlag(FLAGS_show_latency_stats)) {
+    mozc::ParseLine(handler, "SHOW_LATENCY_STATS");
+  }
+  if (absl::GetFlag(FLAGS_show_memory_stats)) {
+    mozc::ParseLine(handler, "SHOW_MEMORY_STATS");
+  }
   return 0;
 }
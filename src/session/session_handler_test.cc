@@ -58,6 +58,7 @@
 #include "usage_stats/usage_stats_testing_util.h"
 #include "absl/flags/declare.h"
 #include "absl/flags/flag.h"
+#include "absl/strings/string_view.h"
 
 ABSL_DECLARE_FLAG(int32_t, max_session_size);
 ABSL_DECLARE_FLAG(int32_t, create_session_min_interval);
@@ -449,6 +450,66 @@ TEST_F(SessionHandlerTest, ElapsedTimeTest) {
   Clock::SetClockForUnitTest(nullptr);
 }
 
+TEST_F(SessionHandlerTest, GetLatencyStats) {
+  SessionHandler handler(CreateMockDataEngine());
+
+  uint64_t id = 0;
+  EXPECT_TRUE(CreateSession(&handler, &id));
+
+  auto get_latency_stats = [&](bool reset) {
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::GET_LATENCY_STATS);
+    command.mutable_input()->set_reset_latency_stats(reset);
+    EXPECT_TRUE(handler.EvalCommand(&command));
+    return command.output().latency_stats();
+  };
+  auto find_stage = [](const commands::LatencyStats &stats,
+                       absl::string_view name) {
+    for (const commands::LatencyStats::Stage &stage : stats.stage()) {
+      if (stage.name() == name) {
+        return stage.count();
+      }
+    }
+    return uint64_t{0};
+  };
+
+  get_latency_stats(/*reset=*/true);
+  EXPECT_TRUE(CreateSession(&handler, &id));
+  const commands::LatencyStats stats = get_latency_stats(/*reset=*/true);
+  EXPECT_EQ(find_stage(stats, "SessionHandler.CREATE_SESSION"), 1);
+
+  // The stats read above have been cleared.
+  EXPECT_EQ(find_stage(get_latency_stats(/*reset=*/false),
+                       "SessionHandler.CREATE_SESSION"),
+            0);
+}
+
+TEST_F(SessionHandlerTest, GetMemoryStats) {
+  SessionHandler handler(CreateMockDataEngine());
+
+  commands::Command command;
+  command.mutable_input()->set_type(commands::Input::GET_MEMORY_STATS);
+  EXPECT_TRUE(handler.EvalCommand(&command));
+
+  auto find_component = [&](absl::string_view name) {
+    for (const commands::MemoryStats::Component &component :
+         command.output().memory_stats().component()) {
+      if (component.name() == name) {
+        return component;
+      }
+    }
+    ADD_FAILURE() << "No component: " << name;
+    return commands::MemoryStats::Component();
+  };
+
+  EXPECT_GT(find_component("Connector").mapped_bytes(), 0);
+  const commands::MemoryStats::Component key_trie =
+      find_component("SystemDictionary.KeyTrie");
+  EXPECT_GT(key_trie.heap_bytes(), 0);
+  EXPECT_GT(key_trie.mapped_bytes(), 0);
+  find_component("UserDictionary.Tokens");
+}
+
 TEST_F(SessionHandlerTest, ConfigTest) {
   config::Config config;
   config::ConfigHandler::GetConfig(&config);
@@ -125,10 +125,15 @@ SessionHandlerTool::SessionHandlerTool(std::unique_ptr<EngineInterface> engine)
     : id_(0),
       usage_observer_(new SessionUsageObserver),
       data_manager_(engine->GetUserDataManager()),
-      handler_(new SessionHandler(std::move(engine))) {
+      owned_handler_(new SessionHandler(std::move(engine))),
+      handler_(owned_handler_.get()) {
   handler_->AddObserver(usage_observer_.get());
 }
 
+SessionHandlerTool::SessionHandlerTool(SessionHandlerInterface *handler,
+                                       UserDataManagerInterface *data_manager)
+    : id_(0), data_manager_(data_manager), handler_(handler) {}
+
 SessionHandlerTool::~SessionHandlerTool() {}
 
 bool SessionHandlerTool::CreateSession() {
@@ -206,6 +211,20 @@ bool SessionHandlerTool::Reload() {
   return EvalCommand(&input, nullptr);
 }
 
+bool SessionHandlerTool::GetLatencyStats(bool reset,
+                                         commands::Output *output) {
+  commands::Input input;
+  input.set_type(commands::Input::GET_LATENCY_STATS);
+  input.set_reset_latency_stats(reset);
+  return EvalCommand(&input, output);
+}
+
+bool SessionHandlerTool::GetMemoryStats(commands::Output *output) {
+  commands::Input input;
+  input.set_type(commands::Input::GET_MEMORY_STATS);
+  return EvalCommand(&input, output);
+}
+
 bool SessionHandlerTool::ResetContext() {
   commands::Input input;
   input.set_type(commands::Input::SEND_COMMAND);
@@ -287,8 +306,18 @@ SessionHandlerInterpreter::SessionHandlerInterpreter()
     : SessionHandlerInterpreter(EngineFactory::Create().value()) {}
 
 SessionHandlerInterpreter::SessionHandlerInterpreter(
-    std::unique_ptr<EngineInterface> engine) {
-  client_ = std::make_unique<SessionHandlerTool>(std::move(engine));
+    std::unique_ptr<EngineInterface> engine)
+    : SessionHandlerInterpreter(
+          std::make_unique<SessionHandlerTool>(std::move(engine))) {}
+
+SessionHandlerInterpreter::SessionHandlerInterpreter(
+    SessionHandlerInterface *handler, UserDataManagerInterface *data_manager)
+    : SessionHandlerInterpreter(
+          std::make_unique<SessionHandlerTool>(handler, data_manager)) {}
+
+SessionHandlerInterpreter::SessionHandlerInterpreter(
+    std::unique_ptr<SessionHandlerTool> client) {
+  client_ = std::move(client);
   config_ = std::make_unique<Config>();
   last_output_ = std::make_unique<Output>();
   request_ = std::make_unique<Request>();
@@ -539,7 +568,9 @@ absl::Status SessionHandlerInterpreter::Eval(
     return absl::Status();
   }
 
-  SyncDataToStorage();
+  if (sync_data_on_eval_) {
+    SyncDataToStorage();
+  }
 
   const std::string &command = args[0];
   // TODO(hidehiko): Refactor out about each command when the number of
@@ -675,6 +706,15 @@ absl::Status SessionHandlerInterpreter::Eval(
   } else if (command == "CLEAR_USAGE_STATS") {
     MOZC_ASSERT_EQ(1, args.size());
     ClearUsageStats();
+  } else if (command == "GET_LATENCY_STATS") {
+    // GET_LATENCY_STATS [RESET]
+    MOZC_ASSERT_TRUE(args.size() == 1 ||
+                     (args.size() == 2 && args[1] == "RESET"));
+    MOZC_ASSERT_TRUE(
+        client_->GetLatencyStats(args.size() == 2, last_output_.get()));
+  } else if (command == "GET_MEMORY_STATS") {
+    MOZC_ASSERT_EQ(1, args.size());
+    MOZC_ASSERT_TRUE(client_->GetMemoryStats(last_output_.get()));
   } else {
     return absl::Status(absl::StatusCode::kUnimplemented, "");
   }
@@ -686,5 +726,9 @@ void SessionHandlerInterpreter::SetRequest(const commands::Request &request) {
   *request_ = request;
 }
 
+void SessionHandlerInterpreter::SetSyncDataOnEval(bool value) {
+  sync_data_on_eval_ = value;
+}
+
 }  // namespace session
 }  // namespace mozc
@@ -50,6 +50,11 @@ namespace session {
 class SessionHandlerTool {
  public:
   explicit SessionHandlerTool(std::unique_ptr<EngineInterface> engine);
+  // Creates a tool on |handler| shared with other tools. |handler| and
+  // |data_manager| must outlive this object, and |handler| must be safe to
+  // call from the threads using the tools.
+  SessionHandlerTool(SessionHandlerInterface *handler,
+                     UserDataManagerInterface *data_manager);
   SessionHandlerTool(const SessionHandlerTool &) = delete;
   SessionHandlerTool &operator=(const SessionHandlerTool &) = delete;
   ~SessionHandlerTool();
@@ -81,6 +86,10 @@ class SessionHandlerTool {
   bool SetRequest(const commands::Request &request, commands::Output *output);
   bool SetConfig(const config::Config &config, commands::Output *output);
   bool SyncData();
+  // Fills output->latency_stats(), clearing the stats afterwards if |reset|.
+  bool GetLatencyStats(bool reset, commands::Output *output);
+  // Fills output->memory_stats().
+  bool GetMemoryStats(commands::Output *output);
   void SetCallbackText(const std::string &text);
 
  private:
@@ -91,7 +100,8 @@ class SessionHandlerTool {
   uint64_t id_;  // Session ID
   std::unique_ptr<SessionObserverInterface> usage_observer_;
   UserDataManagerInterface *data_manager_;
-  std::unique_ptr<SessionHandlerInterface> handler_;
+  std::unique_ptr<SessionHandlerInterface> owned_handler_;
+  SessionHandlerInterface *handler_;
   std::string callback_text_;
 };
 
@@ -99,6 +109,10 @@ class SessionHandlerInterpreter {
  public:
   SessionHandlerInterpreter();
   explicit SessionHandlerInterpreter(std::unique_ptr<EngineInterface> engine);
+  // Creates an interpreter with its own session on the shared |handler|.
+  // See SessionHandlerTool for the requirements.
+  SessionHandlerInterpreter(SessionHandlerInterface *handler,
+                            UserDataManagerInterface *data_manager);
   virtual ~SessionHandlerInterpreter();
 
   void ClearState();
@@ -115,12 +129,18 @@ class SessionHandlerInterpreter {
   std::vector<std::string> Parse(const std::string &line);
   absl::Status Eval(const std::vector<std::string> &args);
   void SetRequest(const commands::Request &request);
+  // If false, Eval() does not call SyncDataToStorage() before each command,
+  // and the caller syncs the data when needed.
+  void SetSyncDataOnEval(bool value);
 
  private:
+  explicit SessionHandlerInterpreter(std::unique_ptr<SessionHandlerTool> client);
+
   std::unique_ptr<SessionHandlerTool> client_;
   std::unique_ptr<config::Config> config_;
   std::unique_ptr<commands::Output> last_output_;
   std::unique_ptr<commands::Request> request_;
+  bool sync_data_on_eval_ = true;
 };
 
 }  // namespace session
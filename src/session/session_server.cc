@@ -33,6 +33,7 @@
 
 #include "session/session_server.h"
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -45,6 +46,7 @@
 #include "session/session_usage_observer.h"
 #include "usage_stats/usage_stats_uploader.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
 namespace {
@@ -58,6 +60,12 @@ constexpr int kNumConnections = 1;
 constexpr int kNumConnections = 10;
 #endif  // _WIN32
 
+// The number of workers which receive, parse and serialize the requests of
+// different connections in parallel, so that a client slow to send or read
+// does not block the others. Only the request I/O runs in parallel:
+// EvalCommand() is serialized by SessionServer::mutex_.
+constexpr size_t kNumIoWorkers = 4;
+
 constexpr absl::Duration kTimeOut = absl::Milliseconds(5000);
 constexpr char kSessionName[] = "session";
 constexpr char kEventName[] = "session";
@@ -71,6 +79,8 @@ SessionServer::SessionServer()
       usage_observer_(std::make_unique<session::SessionUsageObserver>()),
       session_handler_(
           std::make_unique<SessionHandler>(EngineFactory::Create().value())) {
+  SetNumWorkers(kNumIoWorkers);
+
   // start session watch dog timer
   session_handler_->StartWatchDog();
   session_handler_->AddObserver(usage_observer_.get());
@@ -103,7 +113,12 @@ bool SessionServer::Process(absl::string_view request, std::string *response) {
     return true;
   }
 
-  if (!session_handler_->EvalCommand(&command)) {
+  bool result = false;
+  {
+    absl::MutexLock l(&mutex_);
+    result = session_handler_->EvalCommand(&command);
+  }
+  if (!result) {
     LOG(WARNING) << "EvalCommand() returned false. Exiting the loop.";
     response->clear();
     return false;
@@ -39,6 +39,7 @@
 #include "session/session_handler_interface.h"
 #include "session/session_usage_observer.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 namespace mozc {
 
@@ -64,6 +65,9 @@ class SessionServer : public IPCServer {
   bool Process(absl::string_view request, std::string *response) override;
 
  private:
+  // Serializes EvalCommand() of all the sessions, as Process() is called from
+  // multiple I/O workers. The session handler and its engine are shared.
+  absl::Mutex mutex_;
   std::unique_ptr<session::SessionUsageObserver> usage_observer_;
   std::unique_ptr<SessionHandlerInterface> session_handler_;
 };
@@ -34,8 +34,11 @@
 #endif  // _WIN32
 
 #include <cstddef>
+#include <cstdint>
 #include <ios>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/encryptor.h"
 #include "base/file_stream.h"
@@ -56,6 +59,10 @@ constexpr size_t kSaltSize = 32;
 
 // Maximum file size (64Mbyte)
 constexpr size_t kMaxFileSize = 64 * 1024 * 1024;
+
+// Size of the header of a record written by AppendRecord(), which holds the
+// size of the encrypted body in little endian.
+constexpr size_t kRecordHeaderSize = 4;
 }  // namespace
 
 EncryptedStringStorage::EncryptedStringStorage(const absl::string_view filename)
@@ -167,6 +174,98 @@ bool EncryptedStringStorage::Save(const std::string &input) const {
   return true;
 }
 
+bool EncryptedStringStorage::AppendRecord(const std::string &input) const {
+  // Each record has its own salt so that the same content never produces
+  // the same cipher text.
+  const std::string salt = random_.ByteString(kSaltSize);
+
+  std::string body(input);
+  if (!Encrypt(salt, &body)) {
+    return false;
+  }
+
+  const uint32_t body_size = body.size();
+  char header[kRecordHeaderSize];
+  for (size_t i = 0; i < kRecordHeaderSize; ++i) {
+    header[i] = static_cast<char>((body_size >> (8 * i)) & 0xff);
+  }
+
+  OutputFileStream ofs(filename_,
+                       std::ios::out | std::ios::app | std::ios::binary);
+  if (!ofs) {
+    LOG(ERROR) << "failed to open: " << filename_;
+    return false;
+  }
+  ofs.write(header, kRecordHeaderSize);
+  ofs.write(salt.data(), salt.size());
+  ofs.write(body.data(), body.size());
+  ofs.flush();
+  if (!ofs) {
+    LOG(ERROR) << "failed to append a record to: " << filename_;
+    return false;
+  }
+
+#ifdef _WIN32
+  if (!FileUtil::HideFile(filename_)) {
+    LOG(ERROR) << "Cannot make hidden: " << filename_ << " "
+               << ::GetLastError();
+  }
+#endif  // _WIN32
+
+  return true;
+}
+
+bool EncryptedStringStorage::LoadRecords(
+    std::vector<std::string> *output) const {
+  DCHECK(output);
+  output->clear();
+
+  if (!FileUtil::FileExists(filename_).ok()) {
+    return true;
+  }
+
+  const absl::StatusOr<Mmap> mmap = Mmap::Map(filename_, Mmap::READ_ONLY);
+  if (!mmap.ok()) {
+    LOG(ERROR) << "cannot open journal file: " << mmap.status();
+    return false;
+  }
+
+  if (mmap->size() > kMaxFileSize) {
+    LOG(ERROR) << "file size is too big.";
+    return false;
+  }
+
+  const char *ptr = mmap->begin();
+  const char *end = mmap->end();
+  while (ptr != end) {
+    if (end - ptr < kRecordHeaderSize + kSaltSize) {
+      LOG(ERROR) << "Truncated record header in " << filename_;
+      return false;
+    }
+    uint32_t body_size = 0;
+    for (size_t i = 0; i < kRecordHeaderSize; ++i) {
+      body_size |= static_cast<uint32_t>(static_cast<uint8_t>(ptr[i]))
+                   << (8 * i);
+    }
+    ptr += kRecordHeaderSize;
+    const std::string salt(ptr, kSaltSize);
+    ptr += kSaltSize;
+    if (end - ptr < body_size) {
+      LOG(ERROR) << "Truncated record body in " << filename_;
+      return false;
+    }
+    std::string body(ptr, body_size);
+    ptr += body_size;
+    if (!Decrypt(salt, &body)) {
+      LOG(ERROR) << "Broken record in " << filename_;
+      return false;
+    }
+    output->push_back(std::move(body));
+  }
+
+  return true;
+}
+
 bool EncryptedStringStorage::Encrypt(const std::string &salt,
                                      std::string *data) const {
   DCHECK(data);
@@ -31,6 +31,7 @@
 #define MOZC_STORAGE_ENCRYPTED_STRING_STORAGE_H_
 
 #include <string>
+#include <vector>
 
 #include "base/random.h"
 #include "absl/strings/string_view.h"
@@ -56,6 +57,19 @@ class EncryptedStringStorage : public StringStorageInterface {
   bool Load(std::string *output) const override;
   bool Save(const std::string &input) const override;
 
+  // Appends |input| to the file as a record encrypted with its own salt.
+  // Unlike Save(), the existing content is kept, so the cost is proportional
+  // to the size of |input|.  Files written by AppendRecord() must be read by
+  // LoadRecords(), not by Load().
+  bool AppendRecord(const std::string &input) const;
+
+  // Loads the records written by AppendRecord() in the order of appending.
+  // A missing file is loaded as no records.  Returns false if the file has a
+  // broken record, e.g., the one truncated by a crash during AppendRecord().
+  // |output| then holds the records before it, and the file should be
+  // rewritten as records appended after a broken one cannot be read.
+  bool LoadRecords(std::vector<std::string> *output) const;
+
  protected:
   virtual bool Encrypt(const std::string &salt, std::string *data) const;
   virtual bool Decrypt(const std::string &salt, std::string *data) const;
@@ -33,19 +33,26 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/file_stream.h"
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/system_util.h"
+#include "testing/gmock.h"
 #include "testing/googletest.h"
 #include "testing/gunit.h"
 #include "absl/flags/flag.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 
 namespace mozc {
 namespace storage {
 
 namespace {
+
+using ::testing::ElementsAre;
+
 #ifdef __ANDROID__
 // Mock the encryption/decryption for android.
 // For android, we use Java's library for encryption. However, we cannot use
@@ -128,6 +135,45 @@ TEST_F(EncryptedStringStorageTest, Encrypt) {
   EXPECT_LT(original_data.size(), result.size());
   EXPECT_TRUE(result.find(original_data) == std::string::npos);
 }
+
+// The mock for Android supports only one record at a time.
+TEST_F(EncryptedStringStorageTest, AppendAndLoadRecords) {
+  ASSERT_OK(FileUtil::UnlinkIfExists(filename_));
+
+  // A missing file has no records.
+  std::vector<std::string> records = {"dummy"};
+  ASSERT_TRUE(storage_->LoadRecords(&records));
+  EXPECT_TRUE(records.empty());
+
+  ASSERT_TRUE(storage_->AppendRecord("first"));
+  ASSERT_TRUE(storage_->AppendRecord("second"));
+  ASSERT_TRUE(storage_->AppendRecord("first"));
+
+  ASSERT_TRUE(storage_->LoadRecords(&records));
+  EXPECT_THAT(records, ElementsAre("first", "second", "first"));
+
+  // Records are encrypted with different salts.
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(filename_);
+  ASSERT_OK(contents);
+  EXPECT_EQ(contents->find("first"), std::string::npos);
+}
+
+TEST_F(EncryptedStringStorageTest, LoadRecordsStopsAtTruncatedRecord) {
+  ASSERT_OK(FileUtil::UnlinkIfExists(filename_));
+  ASSERT_TRUE(storage_->AppendRecord("first"));
+  ASSERT_TRUE(storage_->AppendRecord("second"));
+
+  // Simulates a crash in the middle of appending the second record.
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(filename_);
+  ASSERT_OK(contents);
+  ASSERT_OK(FileUtil::SetContents(
+      filename_, absl::string_view(*contents).substr(0, contents->size() - 3)));
+
+  // The records before the broken one are still loaded.
+  std::vector<std::string> records;
+  EXPECT_FALSE(storage_->LoadRecords(&records));
+  EXPECT_THAT(records, ElementsAre("first"));
+}
 #endif  // __ANDROID__
 
 }  // namespace storage
@@ -54,6 +54,10 @@ class BitVectorBasedArray {
   // Note: the result may contain '\0' chars, or may NOT be '\0'-terminated.
   const char *Get(size_t index, size_t *length) const;
 
+  // Returns the number of bytes allocated for the index (the image itself is
+  // not included).
+  size_t GetIndexByteSize() const { return index_.GetIndexByteSize(); }
+
  private:
   SimpleSuccinctBitVectorIndex index_;
   size_t base_length_;
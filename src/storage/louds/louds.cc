@@ -31,21 +31,28 @@
 
 #include <cstdint>
 
+#include "storage/louds/rank_select_bit_vector_index.h"
+
 namespace mozc {
 namespace storage {
 namespace louds {
 
 void Louds::Init(const uint8_t *image, int length, size_t bitvec_lb0_cache_size,
                  size_t bitvec_lb1_cache_size, size_t select0_cache_size,
-                 size_t select1_cache_size) {
-  index_.Init(image, length, bitvec_lb0_cache_size, bitvec_lb1_cache_size);
+                 size_t select1_cache_size, BitVectorIndexType index_type) {
+  use_rank_select_index_ = index_type == BitVectorIndexType::kRankSelect;
+  if (use_rank_select_index_) {
+    rank_select_index_.Init(image, length);
+  } else {
+    index_.Init(image, length, bitvec_lb0_cache_size, bitvec_lb1_cache_size);
+  }
 
   // Cap the cache sizes.
-  if (select0_cache_size > index_.GetNum0Bits()) {
-    select0_cache_size = index_.GetNum0Bits();
+  if (select0_cache_size > GetNum0Bits()) {
+    select0_cache_size = GetNum0Bits();
   }
-  if (select1_cache_size > index_.GetNum1Bits()) {
-    select1_cache_size = index_.GetNum1Bits();
+  if (select1_cache_size > GetNum1Bits()) {
+    select1_cache_size = GetNum1Bits();
   }
 
   // Initialize Select0 and Select1 cache for speed.  In LOUDS traversal, nodes
@@ -65,7 +72,7 @@ void Louds::Init(const uint8_t *image, int length, size_t bitvec_lb0_cache_size,
     // Precompute Select0(i) + 1 for i in (0, select0_cache_size).
     select_cache_[0] = 0;
     for (size_t i = 1; i < select0_cache_size; ++i) {
-      select_cache_[i] = index_.Select0(i) + 1;
+      select_cache_[i] = Select0(i) + 1;
     }
   }
 
@@ -74,13 +81,15 @@ void Louds::Init(const uint8_t *image, int length, size_t bitvec_lb0_cache_size,
     select1_cache_ptr_ = select_cache_.get() + select0_cache_size;
     select1_cache_ptr_[0] = 0;
     for (size_t i = 1; i < select1_cache_size; ++i) {
-      select1_cache_ptr_[i] = index_.Select1(i);
+      select1_cache_ptr_[i] = Select1(i);
     }
   }
 }
 
 void Louds::Reset() {
   index_.Reset();
+  rank_select_index_.Reset();
+  use_rank_select_index_ = false;
   select_cache_.reset();
   select0_cache_size_ = 0;
   select1_cache_size_ = 0;
@@ -39,6 +39,7 @@
       ],
       'dependencies': [
         '../../base/base.gyp:base',
+        'rank_select_bit_vector_index',
         'simple_succinct_bit_vector_index',
       ],
     },
@@ -54,6 +55,7 @@
         '../../base/base.gyp:base',
         'bit_stream',
         'louds',
+        'rank_select_bit_vector_index',
         'simple_succinct_bit_vector_index',
       ],
     },
@@ -107,6 +109,18 @@
         '../../base/base.gyp:base',
       ],
     },
+    # Implementation of the succinct bit vector with rank/select directories.
+    {
+      'target_name': 'rank_select_bit_vector_index',
+      'type': 'static_library',
+      'toolsets': ['target', 'host'],
+      'sources': [
+        'rank_select_bit_vector_index.cc',
+      ],
+      'dependencies': [
+        '../../base/base.gyp:base',
+      ],
+    },
     # Bit stream implementation for builders.
     {
       'target_name': 'bit_stream',
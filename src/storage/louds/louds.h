@@ -34,6 +34,7 @@
 #include <memory>
 
 #include "base/port.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
 
 namespace mozc {
@@ -94,7 +95,17 @@ class Louds {
   // |bitvec_lb1_cache_size| and |select1_cache_size| to larger values.
   void Init(const uint8_t *image, int length, size_t bitvec_lb0_cache_size,
             size_t bitvec_lb1_cache_size, size_t select0_cache_size,
-            size_t select1_cache_size);
+            size_t select1_cache_size) {
+    Init(image, length, bitvec_lb0_cache_size, bitvec_lb1_cache_size,
+         select0_cache_size, select1_cache_size, BitVectorIndexType::kSimple);
+  }
+
+  // Same as above but also selects the type of the underlying bit vector
+  // index.  The lb0/lb1 cache sizes are used only for kSimple, as the
+  // RankSelectBitVectorIndex has its own select samples.
+  void Init(const uint8_t *image, int length, size_t bitvec_lb0_cache_size,
+            size_t bitvec_lb1_cache_size, size_t select0_cache_size,
+            size_t select1_cache_size, BitVectorIndexType index_type);
 
   // Initializes this LOUDS from bit array without cache.
   void Init(const uint8_t *image, int length) {
@@ -104,6 +115,13 @@ class Louds {
   // Explicitly clears the internal bit array.
   void Reset();
 
+  // Returns the number of bytes allocated for the bit vector index and the
+  // select caches (the image itself is not included).
+  size_t GetIndexByteSize() const {
+    return index_.GetIndexByteSize() + rank_select_index_.GetIndexByteSize() +
+           (select0_cache_size_ + select1_cache_size_) * sizeof(int);
+  }
+
   // APIs for traversal (all the methods are inline for performance).
 
   // Initializes a Node instance from node ID.
@@ -112,7 +130,7 @@ class Louds {
     node->node_id_ = node_id;
     node->edge_index_ = node_id < select1_cache_size_
                             ? select1_cache_ptr_[node_id]
-                            : index_.Select1(node_id);
+                            : Select1(node_id);
   }
 
   // Returns true if the given node is the root.
@@ -128,10 +146,21 @@ class Louds {
   void MoveToFirstChild(Node *node) const {
     node->edge_index_ = node->node_id_ < select0_cache_size_
                             ? select_cache_[node->node_id_]
-                            : index_.Select0(node->node_id_) + 1;
+                            : Select0(node->node_id_) + 1;
     node->node_id_ = node->edge_index_ - node->node_id_ + 1;
   }
 
+  // Moves the given node to its child whose ID is |child_node_id|, which is
+  // computed by other means, e.g., a precomputed table of first child IDs.
+  // Passing (the last child's ID + 1) makes the node invalid in the same way
+  // as MoveToNextSibling() from the last child.
+  // REQUIRES: |child_node_id| is one of the children of |node| or (the last
+  // child's ID + 1).
+  static void MoveToChildWithId(int child_node_id, Node *node) {
+    node->edge_index_ = child_node_id + node->node_id_ - 1;
+    node->node_id_ = child_node_id;
+  }
+
   // Moves the given node to its next (right) sibling.  If there's no sibling
   // for |node|, the resulting node becomes invalid. For example, in the above
   // diagram of tree, moves are as follows:
@@ -154,16 +183,40 @@ class Louds {
     node->node_id_ = node->edge_index_ - node->node_id_ + 1;
     node->edge_index_ = node->node_id_ < select1_cache_size_
                             ? select1_cache_ptr_[node->node_id_]
-                            : index_.Select1(node->node_id_);
+                            : Select1(node->node_id_);
   }
 
   // Returns true if |node| is in a valid state.
   bool IsValidNode(const Node &node) const {
-    return index_.Get(node.edge_index_) != 0;
+    return use_rank_select_index_
+               ? rank_select_index_.Get(node.edge_index_) != 0
+               : index_.Get(node.edge_index_) != 0;
   }
 
  private:
+  int Select0(int n) const {
+    return use_rank_select_index_ ? rank_select_index_.Select0(n)
+                                  : index_.Select0(n);
+  }
+  int Select1(int n) const {
+    return use_rank_select_index_ ? rank_select_index_.Select1(n)
+                                  : index_.Select1(n);
+  }
+  int GetNum0Bits() const {
+    return use_rank_select_index_ ? rank_select_index_.GetNum0Bits()
+                                  : index_.GetNum0Bits();
+  }
+  int GetNum1Bits() const {
+    return use_rank_select_index_ ? rank_select_index_.GetNum1Bits()
+                                  : index_.GetNum1Bits();
+  }
+
+  // Only one of the following indices is initialized, depending on the index
+  // type passed to Init().  Both have the same bit order, so Get() can be
+  // delegated to either of them.
   SimpleSuccinctBitVectorIndex index_;
+  RankSelectBitVectorIndex rank_select_index_;
+  bool use_rank_select_index_ = false;
   size_t select0_cache_size_ = 0;
   size_t select1_cache_size_ = 0;
   std::unique_ptr<int[]> select_cache_;
@@ -88,18 +88,23 @@ std::vector<uint8_t> MakeSequence(absl::string_view s) {
   } while (false)
 
 struct CacheSizeParam {
-  CacheSizeParam(size_t lb0, size_t lb1, size_t s0, size_t s1)
+  CacheSizeParam(size_t lb0, size_t lb1, size_t s0, size_t s1,
+                 BitVectorIndexType type = BitVectorIndexType::kSimple)
       : bitvec_lb0_cache_size(lb0),
         bitvec_lb1_cache_size(lb1),
         select0_cache_size(s0),
-        select1_cache_size(s1) {}
+        select1_cache_size(s1),
+        index_type(type) {}
 
   size_t bitvec_lb0_cache_size;
   size_t bitvec_lb1_cache_size;
   size_t select0_cache_size;
   size_t select1_cache_size;
+  BitVectorIndexType index_type;
 };
 
+constexpr BitVectorIndexType kRankSelect = BitVectorIndexType::kRankSelect;
+
 class LoudsTest : public ::testing::TestWithParam<CacheSizeParam> {};
 
 TEST_P(LoudsTest, Basic) {
@@ -110,7 +115,7 @@ TEST_P(LoudsTest, Basic) {
   Louds louds;
   louds.Init(kSeq.data(), kSeq.size(), param.bitvec_lb0_cache_size,
              param.bitvec_lb1_cache_size, param.select0_cache_size,
-             param.select1_cache_size);
+             param.select1_cache_size, param.index_type);
 
   // root -> 2 -> 3 -> 4 -> 5
   {
@@ -164,7 +169,22 @@ INSTANTIATE_TEST_SUITE_P(
                       CacheSizeParam(1, 1, 0, 0), CacheSizeParam(1, 1, 0, 1),
                       CacheSizeParam(1, 1, 1, 0), CacheSizeParam(1, 1, 1, 1),
                       CacheSizeParam(2, 2, 2, 2), CacheSizeParam(8, 8, 8, 8),
-                      CacheSizeParam(1024, 1024, 1024, 1024)));
+                      CacheSizeParam(1024, 1024, 1024, 1024),
+                      CacheSizeParam(0, 0, 0, 0, kRankSelect),
+                      CacheSizeParam(0, 0, 1, 1, kRankSelect),
+                      CacheSizeParam(0, 0, 1024, 1024, kRankSelect)));
+
+TEST(LoudsIndexByteSizeTest, IncludesSelectCaches) {
+  const std::vector<uint8_t> kSeq = MakeSequence("10 110 0 110 0 0");
+  Louds without_cache;
+  without_cache.Init(kSeq.data(), kSeq.size());
+  const size_t index_size = without_cache.GetIndexByteSize();
+  EXPECT_GT(index_size, 0);
+
+  Louds with_cache;
+  with_cache.Init(kSeq.data(), kSeq.size(), 0, 0, 2, 3);
+  EXPECT_EQ(with_cache.GetIndexByteSize(), index_size + 5 * sizeof(int));
+}
 
 }  // namespace
 }  // namespace louds
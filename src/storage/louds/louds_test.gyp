@@ -52,6 +52,7 @@
       ],
       'dependencies': [
         '../../testing/testing.gyp:gtest_main',
+        'louds.gyp:bit_stream',
         'louds.gyp:louds_trie',
         'louds.gyp:louds_trie_builder',
       ],
@@ -88,6 +89,20 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'rank_select_bit_vector_index_test',
+      'type': 'executable',
+      'sources': [
+        'rank_select_bit_vector_index_test.cc',
+      ],
+      'dependencies': [
+        '../../testing/testing.gyp:gtest_main',
+        'louds.gyp:rank_select_bit_vector_index',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     {
       'target_name': 'bit_stream_test',
       'type': 'executable',
@@ -111,6 +126,7 @@
         'bit_vector_based_array_test',
         'louds_test',
         'louds_trie_test',
+        'rank_select_bit_vector_index_test',
         'simple_succinct_bit_vector_index_test',
       ],
     },
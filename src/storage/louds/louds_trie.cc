@@ -31,10 +31,12 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "base/logging.h"
 #include "storage/louds/bit_stream.h"
 #include "storage/louds/louds.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
 #include "absl/strings/string_view.h"
 
@@ -48,7 +50,8 @@ bool LoudsTrie::Open(const uint8_t *image, size_t louds_lb0_cache_size,
                      size_t louds_lb1_cache_size,
                      size_t louds_select0_cache_size,
                      size_t louds_select1_cache_size,
-                     size_t termvec_lb1_cache_size) {
+                     size_t termvec_lb1_cache_size,
+                     BitVectorIndexType index_type) {
   // Reads a binary image data, which is compatible with rx.
   // The format is as follows:
   // [trie size: little endian 4byte int]
@@ -84,22 +87,73 @@ bool LoudsTrie::Open(const uint8_t *image, size_t louds_lb0_cache_size,
 
   louds_.Init(louds_image, louds_size, louds_lb0_cache_size,
               louds_lb1_cache_size, louds_select0_cache_size,
-              louds_select1_cache_size);
-  terminal_bit_vector_.Init(terminal_image, terminal_size,
-                            0,  // Select0 is not carried out.
-                            termvec_lb1_cache_size);
+              louds_select1_cache_size, index_type);
+  use_rank_select_index_ = index_type == BitVectorIndexType::kRankSelect;
+  if (use_rank_select_index_) {
+    terminal_rank_select_index_.Init(terminal_image, terminal_size);
+  } else {
+    terminal_bit_vector_.Init(terminal_image, terminal_size,
+                              0,  // Select0 is not carried out.
+                              termvec_lb1_cache_size);
+  }
   edge_character_ = reinterpret_cast<const char *>(edge_character);
+  num_nodes_ = edge_character_size;
+  child_table_ = nullptr;
+  num_child_table_nodes_ = 0;
 
   return true;
 }
 
+bool LoudsTrie::OpenChildTable(const uint8_t *image, size_t size) {
+  // See LoudsTrieBuilder::BuildChildTableImage() for the format.
+  if (image == nullptr || size < 4) {
+    return false;
+  }
+  const int num_nodes = ReadInt32(image);
+  if (num_nodes < 0 || num_nodes > num_nodes_ ||
+      size != (static_cast<size_t>(num_nodes) + 3) * 4) {
+    LOG(ERROR) << "Broken child table: num_nodes=" << num_nodes
+               << ", size=" << size;
+    return false;
+  }
+  const int32_t *table = reinterpret_cast<const int32_t *>(image + 4);
+  if (table[num_nodes + 1] > num_nodes_ + 1) {
+    LOG(ERROR) << "Child table doesn't match the trie";
+    return false;
+  }
+  child_table_ = table;
+  num_child_table_nodes_ = num_nodes;
+  return true;
+}
+
 void LoudsTrie::Close() {
   louds_.Reset();
   terminal_bit_vector_.Reset();
+  terminal_rank_select_index_.Reset();
+  use_rank_select_index_ = false;
   edge_character_ = nullptr;
+  num_nodes_ = 0;
+  child_table_ = nullptr;
+  num_child_table_nodes_ = 0;
 }
 
 bool LoudsTrie::MoveToChildByLabel(char label, Node *node) const {
+  if (node->node_id() <= num_child_table_nodes_) {
+    // The children of a node have consecutive IDs, so their labels are stored
+    // contiguously in |edge_character_|.
+    const int first_child_id = child_table_[node->node_id()];
+    const int end_child_id = child_table_[node->node_id() + 1];
+    const char *labels = edge_character_ + first_child_id - 1;
+    const void *found = memchr(labels, label, end_child_id - first_child_id);
+    if (found == nullptr) {
+      Louds::MoveToChildWithId(end_child_id, node);
+      return false;
+    }
+    Louds::MoveToChildWithId(
+        first_child_id + static_cast<const char *>(found) - labels, node);
+    return true;
+  }
+
   MoveToFirstChild(node);
   while (IsValidNode(*node)) {
     if (GetEdgeLabelToParentNode(*node) == label) {
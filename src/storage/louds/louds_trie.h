@@ -35,6 +35,7 @@
 
 #include "base/port.h"
 #include "storage/louds/louds.h"
+#include "storage/louds/rank_select_bit_vector_index.h"
 #include "storage/louds/simple_succinct_bit_vector_index.h"
 #include "absl/strings/string_view.h"
 
@@ -63,14 +64,43 @@ class LoudsTrie {
   // for the detailed format of the binary image.
   bool Open(const uint8_t *image, size_t louds_lb0_cache_size,
             size_t louds_lb1_cache_size, size_t louds_select0_cache_size,
-            size_t louds_select1_cache_size, size_t termvec_lb1_cache_size);
+            size_t louds_select1_cache_size, size_t termvec_lb1_cache_size) {
+    return Open(image, louds_lb0_cache_size, louds_lb1_cache_size,
+                louds_select0_cache_size, louds_select1_cache_size,
+                termvec_lb1_cache_size, BitVectorIndexType::kSimple);
+  }
+
+  // Same as above but also selects the type of the bit vector index used for
+  // both the LOUDS and the terminal bit vector.  For kRankSelect, the lb0/lb1
+  // cache sizes are ignored.
+  bool Open(const uint8_t *image, size_t louds_lb0_cache_size,
+            size_t louds_lb1_cache_size, size_t louds_select0_cache_size,
+            size_t louds_select1_cache_size, size_t termvec_lb1_cache_size,
+            BitVectorIndexType index_type);
 
   bool Open(const uint8_t *data) { return Open(data, 0, 0, 0, 0, 0); }
 
+  // Opens the child table image built by
+  // LoudsTrieBuilder::BuildChildTableImage() for the trie opened above.  For
+  // the nodes covered by the table, MoveToChildByLabel() finds the child by
+  // scanning the contiguous labels of the children, without accessing the
+  // LOUDS bit vector.  Like Open(), this class doesn't own the image.  Returns
+  // false if the image is inconsistent with the trie.
+  // REQUIRES: Open() has been called.
+  bool OpenChildTable(const uint8_t *image, size_t size);
+
   // Destructs the internal data structure explicitly (the destructor will do
   // clean up too).
   void Close();
 
+  // Returns the number of bytes allocated for the indices built on top of the
+  // image, including the select caches.  The image is not included.
+  size_t GetIndexByteSize() const {
+    return louds_.GetIndexByteSize() +
+           terminal_bit_vector_.GetIndexByteSize() +
+           terminal_rank_select_index_.GetIndexByteSize();
+  }
+
   // Generic APIs for tree traversal, some of which are delegated from Louds
   // class; see louds.h.
 
@@ -80,7 +110,9 @@ class LoudsTrie {
 
   // Returns true if |node| is a terminal node.
   bool IsTerminalNode(const Node &node) const {
-    return terminal_bit_vector_.Get(node.node_id() - 1) != 0;
+    return use_rank_select_index_
+               ? terminal_rank_select_index_.Get(node.node_id() - 1) != 0
+               : terminal_bit_vector_.Get(node.node_id() - 1) != 0;
   }
 
   // Returns the label of the edge from |node|'s parent (predecessor) to |node|.
@@ -91,13 +123,19 @@ class LoudsTrie {
   // Computes the ID of key that reaches to |node|.
   // REQUIRES: |node| is a terminal node.
   int GetKeyIdOfTerminalNode(const Node &node) const {
-    return terminal_bit_vector_.Rank1(node.node_id() - 1);
+    return use_rank_select_index_
+               ? terminal_rank_select_index_.Rank1(node.node_id() - 1)
+               : terminal_bit_vector_.Rank1(node.node_id() - 1);
   }
 
   // Initializes a node corresponding to |key_id|.
   // REQUIRES: |key_id| is a valid ID.
   void GetTerminalNodeFromKeyId(int key_id, Node *node) const {
-    const int node_id = terminal_bit_vector_.Select1(key_id + 1) + 1;
+    const int node_id =
+        (use_rank_select_index_
+             ? terminal_rank_select_index_.Select1(key_id + 1)
+             : terminal_bit_vector_.Select1(key_id + 1)) +
+        1;
     louds_.InitNodeFromNodeId(node_id, node);
   }
 
@@ -198,10 +236,20 @@ class LoudsTrie {
   // super root in this bit vector.
   SimpleSuccinctBitVectorIndex terminal_bit_vector_;
 
+  // Used instead of |terminal_bit_vector_| when opened with kRankSelect.
+  RankSelectBitVectorIndex terminal_rank_select_index_;
+  bool use_rank_select_index_ = false;
+
   // A sequence of characters, annotated to each edge.
   // This array also doesn't have an entry for super root.
   // In other words, id=2 in louds_ corresponds to edge_character_[1].
   const char *edge_character_;
+  int num_nodes_ = 0;
+
+  // child_table_[i] is the ID of the first child of the node i, for
+  // 0 <= i <= num_child_table_nodes_ + 1.  May be nullptr.
+  const int32_t *child_table_ = nullptr;
+  int num_child_table_nodes_ = 0;
 };
 
 }  // namespace louds
@@ -107,6 +107,13 @@ void LoudsTrieBuilder::Build() {
   edge_character.push_back('\0');
   terminal_stream.PushBit(0);
 
+  // The first child of the super root is the root, and the children of the
+  // root begin with the node 2.  As the nodes are numbered in breadth first
+  // order, every stop bit below starts the children of the next node.
+  first_child_ids_.clear();
+  first_child_ids_.push_back(1);
+  first_child_ids_.push_back(2);
+
   // Then, traverse the sorted word list.
   // The basic concept to output the trie is simple:
   // - Iterate the depth beginning with 0.
@@ -177,6 +184,7 @@ void LoudsTrieBuilder::Build() {
           word.compare(0, depth, entry_list[i + 1].word(), 0, depth) != 0) {
         // This is the last child (string) for the parent.
         trie_stream.PushBit(0);
+        first_child_ids_.push_back(edge_character.size() + 1);
       }
     }
 
@@ -209,6 +217,26 @@ const std::string &LoudsTrieBuilder::image() const {
   return image_;
 }
 
+std::string LoudsTrieBuilder::BuildChildTableImage(int max_num_nodes) const {
+  CHECK(built_);
+  // The image format is as follows:
+  // [number of nodes covered by the table (N): little endian 4byte int]
+  // [first child IDs for the node 0 to N + 1: little endian 4byte int each]
+  // The entries for the super root (node 0) and the node N + 1 are included
+  // so that the children of the node i (1 <= i <= N) are given by the i-th and
+  // (i + 1)-th entries.
+  const int num_nodes = std::max(
+      0, std::min(max_num_nodes,
+                  static_cast<int>(first_child_ids_.size()) - 2));
+  std::string image;
+  image.reserve((num_nodes + 3) * 4);
+  PushInt32(num_nodes, image);
+  for (int i = 0; i < num_nodes + 2; ++i) {
+    PushInt32(first_child_ids_[i], image);
+  }
+  return image;
+}
+
 int LoudsTrieBuilder::GetId(const std::string &word) const {
   CHECK(built_);
 
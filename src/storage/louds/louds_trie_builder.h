@@ -61,6 +61,12 @@ class LoudsTrieBuilder {
   // Returns the binary image of the trie.
   const std::string &image() const;
 
+  // Builds the image of the child table for the nodes whose IDs are at most
+  // |max_num_nodes|.  As nodes are numbered in breadth first order, the table
+  // covers the upper levels of the trie.  The image can be passed to
+  // LoudsTrie::OpenChildTable() together with image().
+  std::string BuildChildTableImage(int max_num_nodes) const;
+
   // Returns the key_id for the word (-1 if not found).
   // Note: in Mozc, the key_id will be used to build additional data
   // related to the built LoudsTrie.
@@ -71,6 +77,9 @@ class LoudsTrieBuilder {
 
   std::vector<std::string> word_list_;
   std::vector<int> id_list_;
+  // first_child_ids_[i] is the ID of the first child of the node i.  The
+  // children of the node i are [first_child_ids_[i], first_child_ids_[i + 1]).
+  std::vector<int> first_child_ids_;
   std::string image_;
 };
 
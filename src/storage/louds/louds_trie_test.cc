@@ -30,9 +30,14 @@
 #include "storage/louds/louds_trie.h"
 
 #include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "base/port.h"
+#include "storage/louds/bit_stream.h"
 #include "storage/louds/louds_trie_builder.h"
 #include "testing/gunit.h"
 #include "absl/strings/string_view.h"
@@ -75,20 +80,25 @@ LoudsTrie::Node Traverse(const LoudsTrie &trie, absl::string_view key) {
 }
 
 struct CacheSizeParam {
-  CacheSizeParam(size_t lb0, size_t lb1, size_t s0, size_t s1, size_t term_lb1)
+  CacheSizeParam(size_t lb0, size_t lb1, size_t s0, size_t s1, size_t term_lb1,
+                 BitVectorIndexType type = BitVectorIndexType::kSimple)
       : louds_lb0_cache_size(lb0),
         louds_lb1_cache_size(lb1),
         louds_select0_cache_size(s0),
         louds_select1_cache_size(s1),
-        termvec_lb1_cache_size(term_lb1) {}
+        termvec_lb1_cache_size(term_lb1),
+        index_type(type) {}
 
   size_t louds_lb0_cache_size;
   size_t louds_lb1_cache_size;
   size_t louds_select0_cache_size;
   size_t louds_select1_cache_size;
   size_t termvec_lb1_cache_size;
+  BitVectorIndexType index_type;
 };
 
+constexpr BitVectorIndexType kRankSelect = BitVectorIndexType::kRankSelect;
+
 class LoudsTrieTest : public ::testing::TestWithParam<CacheSizeParam> {};
 
 #define INSTANTIATE_TEST_CASE(Generator)                                \
@@ -112,7 +122,10 @@ class LoudsTrieTest : public ::testing::TestWithParam<CacheSizeParam> {};
           CacheSizeParam(1, 1, 1, 0, 0), CacheSizeParam(1, 1, 1, 0, 1), \
           CacheSizeParam(1, 1, 1, 1, 0), CacheSizeParam(1, 1, 1, 1, 1), \
           CacheSizeParam(2, 2, 2, 2, 2), CacheSizeParam(8, 8, 8, 8, 8), \
-          CacheSizeParam(1024, 1024, 1024, 1024, 1024)));
+          CacheSizeParam(1024, 1024, 1024, 1024, 1024),                 \
+          CacheSizeParam(0, 0, 0, 0, 0, kRankSelect),                   \
+          CacheSizeParam(0, 0, 1, 1, 0, kRankSelect),                   \
+          CacheSizeParam(0, 0, 1024, 1024, 0, kRankSelect)));
 
 TEST_P(LoudsTrieTest, NodeBasedApis) {
   // Create the following trie (* stands for non-terminal nodes):
@@ -140,7 +153,7 @@ TEST_P(LoudsTrieTest, NodeBasedApis) {
   trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()),
             param.louds_lb0_cache_size, param.louds_lb1_cache_size,
             param.louds_select0_cache_size, param.louds_select1_cache_size,
-            param.termvec_lb1_cache_size);
+            param.termvec_lb1_cache_size, param.index_type);
 
   char buf[LoudsTrie::kMaxDepth + 1];  // for RestoreKeyString().
 
@@ -358,7 +371,7 @@ TEST_P(LoudsTrieTest, HasKey) {
   trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()),
             param.louds_lb0_cache_size, param.louds_lb1_cache_size,
             param.louds_select0_cache_size, param.louds_select1_cache_size,
-            param.termvec_lb1_cache_size);
+            param.termvec_lb1_cache_size, param.index_type);
 
   EXPECT_TRUE(trie.HasKey("a"));
   EXPECT_TRUE(trie.HasKey("abc"));
@@ -431,7 +444,7 @@ TEST_P(LoudsTrieTest, PrefixSearch) {
   trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()),
             param.louds_lb0_cache_size, param.louds_lb1_cache_size,
             param.louds_select0_cache_size, param.louds_select1_cache_size,
-            param.termvec_lb1_cache_size);
+            param.termvec_lb1_cache_size, param.index_type);
   {
     const absl::string_view kKey = "abc";
     std::vector<RecordCallbackArgs::CallbackArgs> actual;
@@ -511,7 +524,7 @@ TEST_P(LoudsTrieTest, RestoreKeyString) {
   trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()),
             param.louds_lb0_cache_size, param.louds_lb1_cache_size,
             param.louds_select0_cache_size, param.louds_select1_cache_size,
-            param.termvec_lb1_cache_size);
+            param.termvec_lb1_cache_size, param.index_type);
 
   char buffer[LoudsTrie::kMaxDepth + 1];
   EXPECT_EQ(trie.RestoreKeyString(builder.GetId("aa"), buffer), "aa");
@@ -529,6 +542,85 @@ TEST_P(LoudsTrieTest, RestoreKeyString) {
 }
 INSTANTIATE_TEST_CASE(GenRestoreKeyStringTest);
 
+TEST(LoudsTrieTest, ChildTable) {
+  // Same trie as NodeBasedApis.  Node IDs in BFS order:
+  //   1: root, 2: a, 3: b, 4: aa, 5: ab, 6: bd, 7: abc, 8: abd, 9: abcd
+  LoudsTrieBuilder builder;
+  builder.Add("a");
+  builder.Add("aa");
+  builder.Add("ab");
+  builder.Add("abcd");
+  builder.Add("abd");
+  builder.Add("bd");
+  builder.Build();
+
+  const std::string image = builder.BuildChildTableImage(100);
+  ASSERT_EQ(image.size(), (9 + 3) * 4);
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(image.data());
+  const int kExpected[] = {9, 1, 2, 4, 6, 7, 7, 9, 9, 10, 10, 10};
+  for (size_t i = 0; i < std::size(kExpected); ++i) {
+    EXPECT_EQ(internal::ReadInt32(ptr + i * 4), kExpected[i]) << i;
+  }
+  EXPECT_EQ(builder.BuildChildTableImage(3).size(), (3 + 3) * 4);
+  EXPECT_EQ(builder.BuildChildTableImage(0).size(), 3 * 4);
+
+  LoudsTrie trie;
+  trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()));
+  EXPECT_FALSE(trie.OpenChildTable(ptr, image.size() - 4));
+  EXPECT_FALSE(trie.OpenChildTable(nullptr, 0));
+  const std::string too_large = builder.BuildChildTableImage(100) + "abcd";
+  EXPECT_FALSE(trie.OpenChildTable(
+      reinterpret_cast<const uint8_t *>(too_large.data()), too_large.size()));
+  ASSERT_TRUE(trie.OpenChildTable(ptr, image.size()));
+
+  EXPECT_EQ(trie.ExactSearch("abcd"), builder.GetId("abcd"));
+  EXPECT_EQ(trie.ExactSearch("bd"), builder.GetId("bd"));
+  EXPECT_EQ(trie.ExactSearch("abc"), -1);
+  EXPECT_EQ(trie.ExactSearch("ba"), -1);
+  EXPECT_EQ(trie.ExactSearch("abcde"), -1);
+}
+
+TEST(LoudsTrieTest, ChildTableIsConsistentWithLouds) {
+  LoudsTrieBuilder builder;
+  std::vector<std::string> words;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> length_dist(1, 5);
+  std::uniform_int_distribution<int> char_dist('a', 'h');
+  for (int i = 0; i < 1000; ++i) {
+    std::string word(length_dist(gen), '\0');
+    for (char &c : word) {
+      c = static_cast<char>(char_dist(gen));
+    }
+    builder.Add(word);
+    words.push_back(std::move(word));
+  }
+  builder.Build();
+
+  LoudsTrie expected_trie;
+  expected_trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()));
+
+  for (const int max_num_nodes : {0, 1, 2, 10, 100, 100000}) {
+    SCOPED_TRACE(max_num_nodes);
+    const std::string table = builder.BuildChildTableImage(max_num_nodes);
+    LoudsTrie trie;
+    trie.Open(reinterpret_cast<const uint8_t *>(builder.image().data()));
+    ASSERT_TRUE(trie.OpenChildTable(
+        reinterpret_cast<const uint8_t *>(table.data()), table.size()));
+    for (const std::string &word : words) {
+      for (size_t len = 0; len <= word.size(); ++len) {
+        const absl::string_view prefix(word.data(), len);
+        for (char label = 'a'; label <= 'i'; ++label) {
+          LoudsTrie::Node expected = Traverse(expected_trie, prefix);
+          LoudsTrie::Node actual = Traverse(trie, prefix);
+          ASSERT_EQ(trie.MoveToChildByLabel(label, &actual),
+                    expected_trie.MoveToChildByLabel(label, &expected));
+          EXPECT_EQ(actual, expected);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace louds
 }  // namespace storage
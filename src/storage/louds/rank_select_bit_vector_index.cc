@@ -0,0 +1,227 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/louds/rank_select_bit_vector_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "base/logging.h"
+#include "absl/numeric/bits.h"
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif  // __BMI2__
+
+namespace mozc {
+namespace storage {
+namespace louds {
+namespace {
+
+constexpr int kWordsPerBlock = 8;
+
+// Every kSelectSampleInterval-th bit is sampled for select.
+constexpr int kSelectSampleInterval = 512;
+
+// Returns the position of the (r + 1)-th 1-bit in |x| (r is 0-origin).
+// REQUIRES: r < popcount(x).
+inline int SelectInWord(uint64_t x, int r) {
+#ifdef __BMI2__
+  return absl::countr_zero(_pdep_u64(uint64_t{1} << r, x));
+#else   // __BMI2__
+  // Broadword select.  First, compute the inclusive prefix sums of the number
+  // of 1-bits in each byte, which fit in a byte each.
+  constexpr uint64_t kOnesStep8 = 0x0101010101010101ULL;
+  constexpr uint64_t kMsbsStep8 = 0x80 * kOnesStep8;
+  uint64_t byte_sums = x - ((x >> 1) & 0x5555555555555555ULL);
+  byte_sums = (byte_sums & 0x3333333333333333ULL) +
+              ((byte_sums >> 2) & 0x3333333333333333ULL);
+  byte_sums = ((byte_sums + (byte_sums >> 4)) & 0x0F0F0F0F0F0F0F0FULL) *
+              kOnesStep8;
+
+  // The MSB of each byte is set iff the prefix sum up to the byte is <= r, so
+  // the number of such bytes is the index of the byte containing the target.
+  const uint64_t r_step8 = static_cast<uint64_t>(r) * kOnesStep8;
+  const int byte_pos =
+      absl::popcount(((r_step8 | kMsbsStep8) - byte_sums) & kMsbsStep8) * 8;
+  int rank_in_byte =
+      r - static_cast<int>(((byte_sums << 8) >> byte_pos) & 0xFF);
+
+  // Drop the lower 1-bits in the byte.
+  uint32_t byte = static_cast<uint32_t>((x >> byte_pos) & 0xFF);
+  for (; rank_in_byte > 0; --rank_in_byte) {
+    byte &= byte - 1;
+  }
+  return byte_pos + absl::countr_zero(byte);
+#endif  // __BMI2__
+}
+
+// Fills |samples| so that samples[i] is the block containing the
+// (kSelectSampleInterval * i + 1)-th target bit, where |get_block_rank(b)|
+// returns the number of target bits before block b.
+template <typename BlockRank>
+void InitSelectSamples(int num_blocks, int num_bits, BlockRank get_block_rank,
+                       std::vector<int> *samples) {
+  samples->clear();
+  samples->reserve(num_bits / kSelectSampleInterval + 2);
+  int next = 1;
+  for (int block = 0; block < num_blocks; ++block) {
+    const int block_end = block + 1 < num_blocks
+                              ? std::min(get_block_rank(block + 1), num_bits)
+                              : num_bits;
+    for (; next <= block_end; next += kSelectSampleInterval) {
+      samples->push_back(block);
+    }
+  }
+  samples->push_back(num_blocks - 1);
+}
+
+// Finds the last block whose rank is less than n, from the blocks in
+// [samples[(n - 1) / interval], samples[(n - 1) / interval + 1]].
+template <typename BlockRank>
+int FindBlock(const std::vector<int> &samples, int n,
+              BlockRank get_block_rank) {
+  const int sample_index = (n - 1) / kSelectSampleInterval;
+  int lo = samples[sample_index];
+  int hi = samples[sample_index + 1];
+  while (lo < hi) {
+    const int mid = lo + (hi - lo + 1) / 2;
+    if (get_block_rank(mid) < n) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+}  // namespace
+
+void RankSelectBitVectorIndex::Init(const uint8_t *data, int length) {
+  DCHECK_EQ(length % 4, 0);
+  data_ = data;
+  length_ = length;
+  num_full_words_ = length / 8;
+  num_words_ = (length + 7) / 8;
+
+  // Always have a block for the position of the end of data, so that
+  // Rank1(8 * length) can be answered without a special case.
+  num_blocks_ = num_words_ / kWordsPerBlock + 1;
+  rank_directory_.assign(2 * num_blocks_, 0);
+  int num_1bits = 0;
+  for (int block = 0; block < num_blocks_; ++block) {
+    rank_directory_[2 * block] = num_1bits;
+    uint64_t relative_counts = 0;
+    int count_in_block = 0;
+    for (int i = 0; i < kWordsPerBlock; ++i) {
+      if (i > 0) {
+        relative_counts |= static_cast<uint64_t>(count_in_block)
+                           << (9 * (i - 1));
+      }
+      const int word_index = block * kWordsPerBlock + i;
+      if (word_index < num_words_) {
+        count_in_block += absl::popcount(GetWord(word_index));
+      }
+    }
+    rank_directory_[2 * block + 1] = relative_counts;
+    num_1bits += count_in_block;
+  }
+  num_1bits_ = num_1bits;
+
+  InitSelectSamples(
+      num_blocks_, GetNum0Bits(),
+      [this](int block) { return GetBlockRank0(block); }, &select0_samples_);
+  InitSelectSamples(
+      num_blocks_, GetNum1Bits(),
+      [this](int block) { return GetBlockRank1(block); }, &select1_samples_);
+}
+
+void RankSelectBitVectorIndex::Reset() {
+  data_ = nullptr;
+  length_ = 0;
+  num_full_words_ = 0;
+  num_words_ = 0;
+  num_blocks_ = 0;
+  num_1bits_ = 0;
+  rank_directory_.clear();
+  select0_samples_.clear();
+  select1_samples_.clear();
+}
+
+int RankSelectBitVectorIndex::Select0(int n) const {
+  DCHECK_GT(n, 0);
+  DCHECK_LE(n, GetNum0Bits());
+
+  const int block = FindBlock(select0_samples_, n, [this](int block) {
+    return GetBlockRank0(block);
+  });
+  n -= GetBlockRank0(block);
+
+  // Find the word in the block.  Note that the words past the end of data are
+  // regarded as filled with 0-bits, but they are never reached as the
+  // remaining 0-bits are found in the preceding words.
+  int word_in_block = 0;
+  for (; word_in_block + 1 < kWordsPerBlock; ++word_in_block) {
+    const int num_0bits =
+        64 * (word_in_block + 1) - GetWordRank1(block, word_in_block + 1);
+    if (num_0bits >= n) {
+      break;
+    }
+  }
+  n -= 64 * word_in_block - GetWordRank1(block, word_in_block);
+
+  const int word_index = block * kWordsPerBlock + word_in_block;
+  return word_index * 64 + SelectInWord(~GetWord(word_index), n - 1);
+}
+
+int RankSelectBitVectorIndex::Select1(int n) const {
+  DCHECK_GT(n, 0);
+  DCHECK_LE(n, GetNum1Bits());
+
+  const int block = FindBlock(select1_samples_, n, [this](int block) {
+    return GetBlockRank1(block);
+  });
+  n -= GetBlockRank1(block);
+
+  int word_in_block = 0;
+  for (; word_in_block + 1 < kWordsPerBlock; ++word_in_block) {
+    if (GetWordRank1(block, word_in_block + 1) >= n) {
+      break;
+    }
+  }
+  n -= GetWordRank1(block, word_in_block);
+
+  const int word_index = block * kWordsPerBlock + word_in_block;
+  return word_index * 64 + SelectInWord(GetWord(word_index), n - 1);
+}
+
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
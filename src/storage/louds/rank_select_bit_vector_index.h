@@ -0,0 +1,176 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
+#define MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/internal/endian.h"
+#include "absl/numeric/bits.h"
+
+namespace mozc {
+namespace storage {
+namespace louds {
+
+// Selects the implementation of the bit vector index used by the LOUDS based
+// data structures (Louds, LoudsTrie) and Connector.
+enum class BitVectorIndexType {
+  // SimpleSuccinctBitVectorIndex: small, but Select0/Select1 need a binary
+  // search over chunks and a byte scan.
+  kSimple,
+  // RankSelectBitVectorIndex: larger index, but rank is O(1) with a couple of
+  // memory accesses and select only scans a few 64-bit words.
+  kRankSelect,
+};
+
+// Succinct bit vector index with a two-level rank directory and sampled select
+// hints (a.k.a. rank9 + select hints).
+//
+// The bit vector is divided into blocks of 512 bits (8 words of 64 bits).  For
+// each block, two 64-bit entries are stored in |rank_directory_|:
+//   * the number of 1-bits before the block, and
+//   * seven 9-bit counters holding the number of 1-bits in the block before
+//     the 2nd, ..., 8th word.
+// Thus, Rank1() is computed by two directory reads and a popcount.  For
+// Select0() and Select1(), the block containing every 512th 0-bit (1-bit) is
+// sampled so that the binary search over blocks runs in a narrow range.  The
+// position in a word is found by PDEP/TZCNT if BMI2 is available at compile
+// time, otherwise by a broadword (SWAR) select on the byte counts.
+//
+// The interface is compatible with SimpleSuccinctBitVectorIndex, and the bit
+// order of |data| is the same, so both indices can be built on the same image.
+class RankSelectBitVectorIndex {
+ public:
+  RankSelectBitVectorIndex() = default;
+
+  RankSelectBitVectorIndex(const RankSelectBitVectorIndex &) = delete;
+  RankSelectBitVectorIndex &operator=(const RankSelectBitVectorIndex &) =
+      delete;
+
+  // Initializes the index. This class doesn't have the ownership of the memory
+  // pointed by data, so it is caller's responsibility to manage its life time.
+  // The 'data' needs to be aligned to 32-bits and 'length' (in bytes) needs to
+  // be a multiple of 4.
+  void Init(const uint8_t *data, int length);
+
+  // Resets the internal state, especially releases the allocated memory
+  // for the index used internally.
+  void Reset();
+
+  // Returns the bit at the index in data. See SimpleSuccinctBitVectorIndex for
+  // the bit order.
+  int Get(int index) const { return (data_[index / 8] >> (index % 8)) & 1; }
+
+  // Returns the number of 0-bit in [0, n) bits of data.
+  int Rank0(int n) const { return n - Rank1(n); }
+
+  // Returns the number of 1-bit in [0, n) bits of data.
+  int Rank1(int n) const {
+    const int word_index = n / 64;
+    int result = GetBlockRank1(word_index / 8) +
+                 GetWordRank1(word_index / 8, word_index % 8);
+    const int num_bits = n % 64;
+    if (num_bits > 0) {
+      result += absl::popcount(GetWord(word_index) << (64 - num_bits));
+    }
+    return result;
+  }
+
+  // Returns the position of n-th 0-bit on the data. (n is 1-origin).
+  // Returned index is 0-origin.
+  int Select0(int n) const;
+
+  // Returns the position of n-th 1-bit in the data. (n is 1-origin).
+  // Returned index is 0-origin.
+  int Select1(int n) const;
+
+  int GetNum1Bits() const { return num_1bits_; }
+  int GetNum0Bits() const { return 8 * length_ - num_1bits_; }
+
+  // Returns the number of bytes allocated for the index (the data itself is
+  // not included).
+  size_t GetIndexByteSize() const {
+    return rank_directory_.capacity() * sizeof(uint64_t) +
+           (select0_samples_.capacity() + select1_samples_.capacity()) *
+               sizeof(int);
+  }
+
+ private:
+  static constexpr uint64_t kRelativeCountMask = 0x1FF;
+
+  // Loads the i-th 64-bit word.  The last word may have only 32 valid bits,
+  // in which case the upper half is filled with 0.
+  uint64_t GetWord(int i) const {
+    return i < num_full_words_
+               ? absl::little_endian::Load64(data_ + 8 * i)
+               : absl::little_endian::Load32(data_ + 8 * i);
+  }
+
+  // Returns the number of 1-bits before the |block|.
+  int GetBlockRank1(int block) const {
+    return static_cast<int>(rank_directory_[2 * block]);
+  }
+
+  // Returns the number of 0-bits before the |block|.
+  int GetBlockRank0(int block) const {
+    return 512 * block - GetBlockRank1(block);
+  }
+
+  // Returns the number of 1-bits before the |word_in_block|-th word in the
+  // |block|.
+  int GetWordRank1(int block, int word_in_block) const {
+    return word_in_block == 0
+               ? 0
+               : static_cast<int>(
+                     (rank_directory_[2 * block + 1] >>
+                      (9 * (word_in_block - 1))) &
+                     kRelativeCountMask);
+  }
+
+  const uint8_t *data_ = nullptr;
+  int length_ = 0;
+  int num_full_words_ = 0;
+  int num_words_ = 0;
+  int num_blocks_ = 0;
+  int num_1bits_ = 0;
+  std::vector<uint64_t> rank_directory_;
+  // The i-th element is the block containing the (512 * i + 1)-th 0-bit
+  // (1-bit).  The last element is the sentinel (the last block).
+  std::vector<int> select0_samples_;
+  std::vector<int> select1_samples_;
+};
+
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
+
+#endif  // MOZC_STORAGE_LOUDS_RANK_SELECT_BIT_VECTOR_INDEX_H_
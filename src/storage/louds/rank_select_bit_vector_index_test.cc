@@ -0,0 +1,170 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "storage/louds/rank_select_bit_vector_index.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace storage {
+namespace louds {
+namespace {
+
+TEST(RankSelectBitVectorIndexTest, Rank) {
+  static constexpr char kData[] = "\x00\x00\xFF\xFF\x00\x00\xFF\xFF";
+  RankSelectBitVectorIndex bit_vector;
+
+  bit_vector.Init(reinterpret_cast<const uint8_t *>(kData), 8);
+  EXPECT_EQ(bit_vector.GetNum0Bits(), 32);
+  EXPECT_EQ(bit_vector.GetNum1Bits(), 32);
+  EXPECT_EQ(bit_vector.Rank0(0), 0);
+  EXPECT_EQ(bit_vector.Rank1(0), 0);
+
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(bit_vector.Rank0(i), i) << i;
+    EXPECT_EQ(bit_vector.Rank1(i), 0) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(bit_vector.Rank0(i), 16) << i;
+    EXPECT_EQ(bit_vector.Rank1(i), i - 16) << i;
+  }
+  for (int i = 33; i <= 48; ++i) {
+    EXPECT_EQ(bit_vector.Rank0(i), i - 16) << i;
+    EXPECT_EQ(bit_vector.Rank1(i), 16) << i;
+  }
+  for (int i = 49; i <= 64; ++i) {
+    EXPECT_EQ(bit_vector.Rank0(i), 32) << i;
+    EXPECT_EQ(bit_vector.Rank1(i), i - 32) << i;
+  }
+}
+
+TEST(RankSelectBitVectorIndexTest, Select) {
+  static constexpr char kData[] = "\x00\x00\xFF\xFF\x00\x00\xFF\xFF";
+  RankSelectBitVectorIndex bit_vector;
+
+  bit_vector.Init(reinterpret_cast<const uint8_t *>(kData), 8);
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(bit_vector.Select0(i), i - 1) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(bit_vector.Select0(i), i + 15) << i;
+  }
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(bit_vector.Select1(i), i + 15) << i;
+  }
+  for (int i = 17; i <= 32; ++i) {
+    EXPECT_EQ(bit_vector.Select1(i), i + 31) << i;
+  }
+}
+
+TEST(RankSelectBitVectorIndexTest, Pattern) {
+  // Repeat the bit pattern '0b10101010'.
+  const std::string data(1024, '\xAA');
+
+  RankSelectBitVectorIndex bit_vector;
+  bit_vector.Init(reinterpret_cast<const uint8_t *>(data.data()),
+                  data.length());
+  EXPECT_EQ(bit_vector.GetNum0Bits(), 4 * 1024);
+  EXPECT_EQ(bit_vector.GetNum1Bits(), 4 * 1024);
+
+  for (int i = 0; i < 1024 * 8; ++i) {
+    EXPECT_EQ(bit_vector.Rank1(i), i / 2) << i;
+    EXPECT_EQ(bit_vector.Rank0(i), (i + 1) / 2) << i;
+  }
+  for (int i = 0; i < 1024 * 4; ++i) {
+    EXPECT_EQ(bit_vector.Select0(i + 1), i * 2) << i;
+    EXPECT_EQ(bit_vector.Select1(i + 1), i * 2 + 1) << i;
+  }
+}
+
+// Compares the results with the naive implementation for random bit vectors
+// of various densities and lengths, including the lengths that are not a
+// multiple of 8 bytes.
+TEST(RankSelectBitVectorIndexTest, CompareWithNaiveImplementation) {
+  std::mt19937 gen(0);
+  for (const int length : {4, 8, 12, 60, 64, 68, 1020, 1024, 4100}) {
+    for (const double density : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+      std::bernoulli_distribution dist(density);
+      std::vector<uint8_t> data(length, 0);
+      std::vector<int> pos0, pos1;
+      for (int i = 0; i < length * 8; ++i) {
+        if (dist(gen)) {
+          data[i / 8] |= 1 << (i % 8);
+          pos1.push_back(i);
+        } else {
+          pos0.push_back(i);
+        }
+      }
+
+      RankSelectBitVectorIndex bit_vector;
+      bit_vector.Init(data.data(), length);
+      ASSERT_EQ(bit_vector.GetNum0Bits(), pos0.size());
+      ASSERT_EQ(bit_vector.GetNum1Bits(), pos1.size());
+
+      int rank1 = 0;
+      for (int i = 0; i <= length * 8; ++i) {
+        ASSERT_EQ(bit_vector.Rank1(i), rank1) << length << ", " << i;
+        ASSERT_EQ(bit_vector.Rank0(i), i - rank1) << length << ", " << i;
+        if (i < length * 8) {
+          ASSERT_EQ(bit_vector.Get(i), (data[i / 8] >> (i % 8)) & 1);
+          rank1 += bit_vector.Get(i);
+        }
+      }
+      for (size_t i = 0; i < pos0.size(); ++i) {
+        ASSERT_EQ(bit_vector.Select0(i + 1), pos0[i]) << length << ", " << i;
+      }
+      for (size_t i = 0; i < pos1.size(); ++i) {
+        ASSERT_EQ(bit_vector.Select1(i + 1), pos1[i]) << length << ", " << i;
+      }
+    }
+  }
+}
+
+TEST(RankSelectBitVectorIndexTest, Reset) {
+  const std::string data(64, '\xFF');
+  RankSelectBitVectorIndex bit_vector;
+  bit_vector.Init(reinterpret_cast<const uint8_t *>(data.data()),
+                  data.length());
+  EXPECT_EQ(bit_vector.GetNum1Bits(), 512);
+  EXPECT_GT(bit_vector.GetIndexByteSize(), 0);
+
+  bit_vector.Reset();
+  EXPECT_EQ(bit_vector.GetNum0Bits(), 0);
+  EXPECT_EQ(bit_vector.GetNum1Bits(), 0);
+}
+
+}  // namespace
+}  // namespace louds
+}  // namespace storage
+}  // namespace mozc
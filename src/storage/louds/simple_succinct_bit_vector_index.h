@@ -98,6 +98,13 @@ class SimpleSuccinctBitVectorIndex {
   int GetNum1Bits() const { return index_.back(); }
   int GetNum0Bits() const { return 8 * length_ - index_.back(); }
 
+  // Returns the number of bytes allocated for the index and the select caches
+  // (the data itself is not included).
+  size_t GetIndexByteSize() const {
+    return index_.capacity() * sizeof(int) +
+           (lb0_cache_.capacity() + lb1_cache_.capacity()) * sizeof(const int *);
+  }
+
  private:
   // The order of members is optimized to minimize the padding size.
   const uint8_t *data_;
@@ -98,6 +98,10 @@ class LruCache {
   // Returns the number of entries currently in the cache.
   size_t Size() const { return table_.size(); }
 
+  // Returns the number of elements allocated so far, including the ones on
+  // the free list.
+  size_t Capacity() const { return block_capacity_; }
+
   bool HasKey(const Key& key) const { return table_.find(key) != table_.end(); }
 
   // Returns the head of LRU list
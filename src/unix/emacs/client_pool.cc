@@ -31,29 +31,63 @@
 
 #include "unix/emacs/client_pool.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else  // _WIN32
+#include <unistd.h>
+#endif  // _WIN32
+
+#include <cstdint>
 #include <memory>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/thread2.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler_interface.h"
+#include "storage/lru_cache.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace emacs {
+namespace {
 
-static constexpr int kMaxClients = 64;  // max number of parallel clients
-
-ClientPool::ClientPool() : lru_cache_(kMaxClients), next_id_(1) {}
+constexpr int kMaxClients = 64;  // max number of parallel clients
 
-int ClientPool::CreateClient() {
+// Returns a session ID which is not in |lru_cache|, advancing |next_id|.
+template <typename Value>
+int GetUnusedId(const storage::LruCache<int, Value>& lru_cache,
+                int* next_id) {
   // Emacs supports at-least 28-bit integer.
   const int k28BitIntMax = 134217727;
-  while (lru_cache_.HasKey(next_id_)) {
-    if (++next_id_ <= 0 || k28BitIntMax < next_id_) {
-      next_id_ = 1;  // Keep next_id_ to be a positive 28-bit integer.
+  while (lru_cache.HasKey(*next_id)) {
+    if (++*next_id <= 0 || k28BitIntMax < *next_id) {
+      *next_id = 1;  // Keep next_id to be a positive 28-bit integer.
     }
   }
-  lru_cache_.Insert(next_id_, std::make_shared<Client>());
-  return next_id_++;
+  return (*next_id)++;
+}
+
+}  // namespace
+
+ClientPool::ClientPool() : lru_cache_(kMaxClients), next_id_(1) {}
+
+int ClientPool::CreateClient() {
+  const int id = GetUnusedId(lru_cache_, &next_id_);
+  lru_cache_.Insert(id, std::make_shared<Client>());
+  return id;
 }
 
 void ClientPool::DeleteClient(int id) { lru_cache_.Erase(id); }
 
+bool ClientPool::SendKey(int id, const commands::KeyEvent& key,
+                         commands::Output* output) {
+  std::shared_ptr<Client> client = GetClient(id);
+  CHECK(client.get());
+  return client->SendKey(key, output);
+}
+
 std::shared_ptr<ClientPool::Client> ClientPool::GetClient(int id) {
   const std::shared_ptr<Client> *value = lru_cache_.Lookup(id);
   if (value) {
@@ -66,5 +100,140 @@ std::shared_ptr<ClientPool::Client> ClientPool::GetClient(int id) {
   }
 }
 
+InProcessClientPool::InProcessClientPool(
+    std::unique_ptr<SessionHandlerInterface> handler,
+    absl::Duration cleanup_interval)
+    : handler_(std::move(handler)),
+      lru_cache_(kMaxClients),
+      next_id_(1),
+      cleanup_interval_(cleanup_interval),
+      cleanup_thread_([this] { CleanupLoop(); }) {}
+
+InProcessClientPool::~InProcessClientPool() {
+  {
+    absl::MutexLock l(&mutex_);
+    stopped_ = true;
+  }
+  cleanup_thread_.Join();
+  for (const auto* element = lru_cache_.Head(); element != nullptr;
+       element = element->next) {
+    DeleteSession(element->value);
+  }
+  SyncData();
+}
+
+int InProcessClientPool::CreateClient() {
+  const int id = GetUnusedId(lru_cache_, &next_id_);
+  InsertSession(id, CreateSession());
+  return id;
+}
+
+void InProcessClientPool::DeleteClient(int id) {
+  if (const uint64_t* session_id = lru_cache_.Lookup(id);
+      session_id != nullptr) {
+    DeleteSession(*session_id);
+    lru_cache_.Erase(id);
+    // Saves the learning promptly as the server may read the same files.
+    SyncData();
+  }
+}
+
+bool InProcessClientPool::SendKey(int id, const commands::KeyEvent& key,
+                                  commands::Output* output) {
+  const uint64_t* cached_session_id = lru_cache_.Lookup(id);
+  uint64_t session_id =
+      cached_session_id == nullptr ? 0 : *cached_session_id;
+
+  commands::Command command;
+  commands::Input* input = command.mutable_input();
+  input->set_type(commands::Input::SEND_KEY);
+  *input->mutable_key() = key;
+  bool result = false;
+  for (int trial = 0; trial < 2 && !result; ++trial) {
+    if (session_id == 0) {
+      // Unknown ID, or the session has been removed by the handler, e.g. by
+      // the session timeout.
+      session_id = CreateSession();
+    }
+    input->set_id(session_id);
+    command.clear_output();
+    result = EvalCommand(&command);
+    if (!result) {
+      session_id = 0;
+    }
+  }
+  InsertSession(id, session_id);  // Put id at the head of LRU.
+  if (result) {
+    *output = command.output();
+  }
+  return result;
+}
+
+void InProcessClientPool::InsertSession(int id, uint64_t session_id) {
+  if (!lru_cache_.HasKey(id) && lru_cache_.Size() >= kMaxClients) {
+    // LruCache evicts the tail silently; release its session beforehand.
+    const int evicted_id = lru_cache_.Tail()->key;
+    DeleteSession(lru_cache_.Tail()->value);
+    lru_cache_.Erase(evicted_id);
+  }
+  lru_cache_.Insert(id, session_id);
+}
+
+uint64_t InProcessClientPool::CreateSession() {
+  commands::Command command;
+  commands::Input* input = command.mutable_input();
+  input->set_type(commands::Input::CREATE_SESSION);
+  commands::ApplicationInfo* info = input->mutable_application_info();
+#ifdef _WIN32
+  info->set_process_id(static_cast<uint32_t>(::GetCurrentProcessId()));
+  info->set_thread_id(static_cast<uint32_t>(::GetCurrentThreadId()));
+#else   // _WIN32
+  info->set_process_id(static_cast<uint32_t>(getpid()));
+  info->set_thread_id(0);
+#endif  // _WIN32
+  if (!EvalCommand(&command)) {
+    LOG(ERROR) << "CREATE_SESSION failed";
+    return 0;
+  }
+  return command.output().id();
+}
+
+void InProcessClientPool::DeleteSession(uint64_t session_id) {
+  if (session_id == 0) {
+    return;
+  }
+  commands::Command command;
+  command.mutable_input()->set_type(commands::Input::DELETE_SESSION);
+  command.mutable_input()->set_id(session_id);
+  EvalCommand(&command);
+}
+
+bool InProcessClientPool::EvalCommand(commands::Command* command) {
+  absl::MutexLock l(&mutex_);
+  return handler_->EvalCommand(command) &&
+         command->output().error_code() == commands::Output::SESSION_SUCCESS;
+}
+
+void InProcessClientPool::SyncData() {
+  commands::Command command;
+  command.mutable_input()->set_type(commands::Input::SYNC_DATA);
+  EvalCommand(&command);
+}
+
+void InProcessClientPool::CleanupLoop() {
+  while (true) {
+    {
+      absl::MutexLock l(&mutex_);
+      if (mutex_.AwaitWithTimeout(absl::Condition(&stopped_),
+                                  cleanup_interval_)) {
+        return;
+      }
+    }
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::CLEANUP);
+    EvalCommand(&command);
+  }
+}
+
 }  // namespace emacs
 }  // namespace mozc
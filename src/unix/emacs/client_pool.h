@@ -32,29 +32,53 @@
 #ifndef MOZC_UNIX_EMACS_CLIENT_POOL_H_
 #define MOZC_UNIX_EMACS_CLIENT_POOL_H_
 
+#include <cstdint>
 #include <memory>
 
+#include "base/thread2.h"
 #include "client/client.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler_interface.h"
 #include "storage/lru_cache.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 
 namespace mozc {
 namespace emacs {
 
-class ClientPool {
+// Sessions addressed by the session IDs exchanged with Emacs.
+class ClientPoolInterface {
+ public:
+  virtual ~ClientPoolInterface() = default;
+
+  // Returns a new session ID, which is not used in this pool.
+  virtual int CreateClient() = 0;
+
+  // Deletes a client.  If the specified session ID is not in this pool,
+  // does nothing.
+  virtual void DeleteClient(int id) = 0;
+
+  // Sends |key| to the client |id|.  If the specified session ID is not in
+  // this pool, creates a new client first.
+  virtual bool SendKey(int id, const commands::KeyEvent& key,
+                       commands::Output* output) = 0;
+};
+
+// Clients talking to mozc_server over IPC.
+class ClientPool : public ClientPoolInterface {
  public:
   typedef mozc::client::Client Client;
 
   ClientPool();
   ClientPool(const ClientPool&) = delete;
   ClientPool& operator=(const ClientPool&) = delete;
-  virtual ~ClientPool() {}
+  ~ClientPool() override {}
 
-  // Returns a new session ID, which is not used in this pool.
-  int CreateClient();
-
-  // Deletes a client.  If the specified session ID is not in this pool,
-  // does nothing.
-  void DeleteClient(int id);
+  int CreateClient() override;
+  void DeleteClient(int id) override;
+  bool SendKey(int id, const commands::KeyEvent& key,
+               commands::Output* output) override;
 
   // Returns a Client instance.  If the specified session ID is not in this
   // pool, creates a new Client and returns it.
@@ -65,6 +89,60 @@ class ClientPool {
   int next_id_;
 };
 
+// Sessions of a SessionHandler running in this process, which saves the IPC
+// round trip and the protobuf serialization of every key.  The user data
+// (history, user dictionary and config) is read from and synced to the same
+// user profile directory as mozc_server.
+//
+// Emacs usually kills the helper rather than closing its input, so the pool
+// sends CLEANUP every |cleanup_interval| like the watch dog of mozc_server.
+// It removes the stale sessions and syncs the user data.
+//
+// The helper and a running mozc_server keep their own copies of the learning
+// and rewrite the same files, so the last writer wins. The user history
+// predictor appends its changes to a journal, which keeps the changes of both
+// until either rewrites the whole history file and drops the journal.
+class InProcessClientPool : public ClientPoolInterface {
+ public:
+  static constexpr absl::Duration kDefaultCleanupInterval = absl::Seconds(60);
+
+  explicit InProcessClientPool(
+      std::unique_ptr<SessionHandlerInterface> handler,
+      absl::Duration cleanup_interval = kDefaultCleanupInterval);
+  InProcessClientPool(const InProcessClientPool&) = delete;
+  InProcessClientPool& operator=(const InProcessClientPool&) = delete;
+  // Deletes all the sessions and syncs the user data.
+  ~InProcessClientPool() override;
+
+  int CreateClient() override;
+  void DeleteClient(int id) override;
+  bool SendKey(int id, const commands::KeyEvent& key,
+               commands::Output* output) override;
+
+ private:
+  // Returns the ID of a new session of |handler_|, or 0 on failure.
+  uint64_t CreateSession();
+  // Maps |id| to |session_id|, deleting the least recently used session if
+  // the pool is full.
+  void InsertSession(int id, uint64_t session_id);
+  void DeleteSession(uint64_t session_id);
+  // Evaluates |command| and returns true if the session accepted it.
+  bool EvalCommand(commands::Command* command);
+  void SyncData();
+  // Sends CLEANUP every |cleanup_interval_| until the pool is destroyed.
+  void CleanupLoop();
+
+  // Serializes the commands of the main thread and |cleanup_thread_|.
+  absl::Mutex mutex_;
+  std::unique_ptr<SessionHandlerInterface> handler_ ABSL_PT_GUARDED_BY(mutex_);
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  // Maps the session IDs of Emacs to the ones of |handler_|.
+  mozc::storage::LruCache<int, uint64_t> lru_cache_;
+  int next_id_;
+  const absl::Duration cleanup_interval_;
+  Thread2 cleanup_thread_;
+};
+
 }  // namespace emacs
 }  // namespace mozc
 
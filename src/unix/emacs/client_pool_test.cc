@@ -0,0 +1,201 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "unix/emacs/client_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "protocol/commands.pb.h"
+#include "session/session_handler_interface.h"
+#include "testing/gunit.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace emacs {
+namespace {
+
+// Minimal SessionHandler which only manages session IDs. The state is kept
+// outside so that it can be inspected after the pool deletes the handler.
+struct FakeState {
+  absl::flat_hash_set<uint64_t> sessions;
+  uint64_t next_id = 1000;
+  int sync_count = 0;
+  absl::Notification cleaned_up;
+};
+
+class FakeSessionHandler : public SessionHandlerInterface {
+ public:
+  explicit FakeSessionHandler(FakeState *state) : state_(state) {}
+
+  bool IsAvailable() const override { return true; }
+
+  bool EvalCommand(commands::Command *command) override {
+    const commands::Input &input = command->input();
+    commands::Output *output = command->mutable_output();
+    switch (input.type()) {
+      case commands::Input::CREATE_SESSION:
+        state_->sessions.insert(state_->next_id);
+        output->set_id(state_->next_id++);
+        return true;
+      case commands::Input::DELETE_SESSION:
+        state_->sessions.erase(input.id());
+        return true;
+      case commands::Input::SEND_KEY:
+        if (!state_->sessions.contains(input.id())) {
+          output->set_error_code(commands::Output::SESSION_FAILURE);
+          return true;
+        }
+        output->set_id(input.id());
+        output->set_consumed(true);
+        return true;
+      case commands::Input::SYNC_DATA:
+        ++state_->sync_count;
+        return true;
+      case commands::Input::CLEANUP:
+        if (!state_->cleaned_up.HasBeenNotified()) {
+          state_->cleaned_up.Notify();
+        }
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool StartWatchDog() override { return false; }
+  void AddObserver(session::SessionObserverInterface *observer) override {}
+  absl::string_view GetDataVersion() const override { return ""; }
+
+ private:
+  FakeState *state_;
+};
+
+class InProcessClientPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    pool_ = std::make_unique<InProcessClientPool>(
+        std::make_unique<FakeSessionHandler>(&state_));
+  }
+
+  static commands::KeyEvent KeyA() {
+    commands::KeyEvent key;
+    key.set_key_code('a');
+    return key;
+  }
+
+  FakeState state_;
+  std::unique_ptr<InProcessClientPool> pool_;
+};
+
+TEST_F(InProcessClientPoolTest, CreateAndDelete) {
+  const int id1 = pool_->CreateClient();
+  const int id2 = pool_->CreateClient();
+  EXPECT_NE(id1, id2);
+  EXPECT_EQ(state_.sessions.size(), 2);
+
+  commands::Output output;
+  EXPECT_TRUE(pool_->SendKey(id1, KeyA(), &output));
+  EXPECT_TRUE(output.consumed());
+
+  pool_->DeleteClient(id1);
+  EXPECT_EQ(state_.sessions.size(), 1);
+  EXPECT_EQ(state_.sync_count, 1);
+
+  // Unknown IDs are ignored.
+  pool_->DeleteClient(id1);
+  EXPECT_EQ(state_.sync_count, 1);
+}
+
+TEST_F(InProcessClientPoolTest, SendKeyRecreatesSession) {
+  const int id = pool_->CreateClient();
+  const uint64_t session_id = *state_.sessions.begin();
+
+  // The handler may remove sessions by itself, e.g. on timeout.
+  state_.sessions.clear();
+
+  commands::Output output;
+  EXPECT_TRUE(pool_->SendKey(id, KeyA(), &output));
+  EXPECT_NE(output.id(), session_id);
+  EXPECT_EQ(state_.sessions.size(), 1);
+
+  // The new session is kept for the subsequent keys.
+  commands::Output output2;
+  EXPECT_TRUE(pool_->SendKey(id, KeyA(), &output2));
+  EXPECT_EQ(output2.id(), output.id());
+  EXPECT_EQ(state_.sessions.size(), 1);
+}
+
+TEST_F(InProcessClientPoolTest, SendKeyToUnknownId) {
+  commands::Output output;
+  EXPECT_TRUE(pool_->SendKey(12345, KeyA(), &output));
+  EXPECT_EQ(state_.sessions.size(), 1);
+}
+
+TEST_F(InProcessClientPoolTest, EvictsLeastRecentlyUsedSession) {
+  constexpr int kMaxClients = 64;
+  const int first_id = pool_->CreateClient();
+  for (int i = 1; i < kMaxClients; ++i) {
+    pool_->CreateClient();
+  }
+  EXPECT_EQ(state_.sessions.size(), kMaxClients);
+
+  pool_->CreateClient();
+  EXPECT_EQ(state_.sessions.size(), kMaxClients);
+
+  // The session of |first_id| has been evicted, so a new one is created in
+  // place of the least recently used one.
+  commands::Output output;
+  EXPECT_TRUE(pool_->SendKey(first_id, KeyA(), &output));
+  EXPECT_EQ(state_.sessions.size(), kMaxClients);
+}
+
+TEST_F(InProcessClientPoolTest, DestructorDeletesSessions) {
+  pool_->CreateClient();
+  pool_->CreateClient();
+  EXPECT_EQ(state_.sessions.size(), 2);
+
+  pool_.reset();
+  EXPECT_TRUE(state_.sessions.empty());
+  EXPECT_EQ(state_.sync_count, 1);
+}
+
+TEST(InProcessClientPoolCleanupTest, SendsCleanupPeriodically) {
+  FakeState state;
+  InProcessClientPool pool(std::make_unique<FakeSessionHandler>(&state),
+                           absl::Milliseconds(1));
+  EXPECT_TRUE(
+      state.cleaned_up.WaitForNotificationWithTimeout(absl::Seconds(10)));
+}
+
+}  // namespace
+}  // namespace emacs
+}  // namespace mozc
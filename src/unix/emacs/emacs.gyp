@@ -43,9 +43,12 @@
         '../../base/base.gyp:base',
         '../../base/base.gyp:version',
         '../../config/config.gyp:config_handler',
+        '../../engine/engine.gyp:engine_builder',
+        '../../engine/engine.gyp:engine_factory',
         '../../ipc/ipc.gyp:ipc',
         '../../protocol/protocol.gyp:commands_proto',
         '../../protocol/protocol.gyp:config_proto',
+        '../../session/session.gyp:session_handler',
         'mozc_emacs_helper_lib',
       ],
     },
@@ -58,6 +61,8 @@
       ],
       'dependencies': [
         '../../base/absl.gyp:absl_strings',
+        '../../base/absl.gyp:absl_synchronization',
+        '../../base/absl.gyp:absl_time',
         '../../base/base.gyp:base',
         '../../base/base.gyp:number_util',
         '../../client/client.gyp:client',
@@ -82,11 +87,29 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'client_pool_test',
+      'type': 'executable',
+      'sources': [
+        'client_pool_test.cc',
+      ],
+      'dependencies': [
+        '../../base/absl.gyp:absl_strings',
+        '../../base/absl.gyp:absl_synchronization',
+        '../../base/absl.gyp:absl_time',
+        '../../testing/testing.gyp:gtest_main',
+        'mozc_emacs_helper_lib',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     # Test cases meta target: this target is referred from gyp/tests.gyp
     {
       'target_name': 'emacs_all_test',
       'type': 'none',
       'dependencies': [
+        'client_pool_test',
         'mozc_emacs_helper_lib_test',
       ],
     },
@@ -1546,7 +1546,10 @@ The helper program helps Emacs communicate with Mozc server,
 which doesn't understand S-expression.")
 
 (defvar mozc-helper-program-args '("--suppress_stderr")
-  "A list of arguments passed to the helper program.")
+  "A list of arguments passed to the helper program.
+Add \"--in_process\" to run the conversion engine inside the helper process
+instead of connecting to mozc_server.  The learning is saved to the same
+files as mozc_server, so running both loses the learning of either.")
 
 (defvar mozc-helper-process-timeout-sec 1
   "Time-out in second to wait a response from Mozc server.")
@@ -32,7 +32,6 @@
 #include <iostream>
 #include <memory>
 #include <string>
-#include <vector>
 
 #include "base/init_mozc.h"
 #include "base/logging.h"
@@ -40,14 +39,19 @@
 #include "base/version.h"
 #include "client/client.h"
 #include "config/config_handler.h"
+#include "engine/engine_builder.h"
+#include "engine/engine_factory.h"
 #include "protocol/commands.pb.h"
+#include "session/session_handler.h"
 #include "unix/emacs/client_pool.h"
 #include "unix/emacs/mozc_emacs_helper_lib.h"
 #include "absl/flags/flag.h"
 #include "absl/strings/str_format.h"
-#include "absl/strings/str_join.h"
 
 ABSL_FLAG(bool, suppress_stderr, false, "Discards all the output to stderr.");
+ABSL_FLAG(bool, in_process, false,
+          "Runs the conversion engine in this process instead of connecting "
+          "to mozc_server.");
 
 namespace {
 
@@ -73,14 +77,30 @@ void PrintGreetingMessage() {
   fflush(stdout);
 }
 
+std::unique_ptr<mozc::emacs::ClientPoolInterface> CreateClientPool() {
+  if (!absl::GetFlag(FLAGS_in_process)) {
+    return std::make_unique<mozc::emacs::ClientPool>();
+  }
+  auto engine = mozc::EngineFactory::Create();
+  if (!engine.ok()) {
+    mozc::emacs::ErrorExit(mozc::emacs::kErrSessionError,
+                           "Engine initialization failed");
+  }
+  return std::make_unique<mozc::emacs::InProcessClientPool>(
+      std::make_unique<mozc::SessionHandler>(
+          *std::move(engine), std::make_unique<mozc::EngineBuilder>()));
+}
+
 // Main loop, which takes an input line as a command and print a corresponding
 // result returned by Mozc server in S-expression.
 void ProcessLoop() {
   using mozc::emacs::ErrorExit;
 
-  mozc::emacs::ClientPool client_pool;
+  std::unique_ptr<mozc::emacs::ClientPoolInterface> client_pool =
+      CreateClientPool();
   mozc::commands::Command command;
   std::string line;
+  std::string output;
 
   while (std::getline(std::cin, line)) {
     command.clear_input();
@@ -94,20 +114,17 @@ void ProcessLoop() {
 
     switch (command.input().type()) {
       case mozc::commands::Input::CREATE_SESSION:
-        session_id = client_pool.CreateClient();
+        session_id = client_pool->CreateClient();
         break;
       case mozc::commands::Input::DELETE_SESSION:
-        client_pool.DeleteClient(session_id);
+        client_pool->DeleteClient(session_id);
         break;
-      case mozc::commands::Input::SEND_KEY: {
-        std::shared_ptr<mozc::client::Client> client =
-            client_pool.GetClient(session_id);
-        CHECK(client.get());
-        if (!client->SendKey(command.input().key(), command.mutable_output())) {
+      case mozc::commands::Input::SEND_KEY:
+        if (!client_pool->SendKey(session_id, command.input().key(),
+                                  command.mutable_output())) {
           ErrorExit(mozc::emacs::kErrSessionError, "Session failed");
         }
         break;
-      }
       default:
         ErrorExit(mozc::emacs::kErrVoidFunction, "Unknown function");
     }
@@ -115,9 +132,8 @@ void ProcessLoop() {
     mozc::emacs::RemoveUsageData(command.mutable_output());
 
     // Output results.
-    std::vector<std::string> buffer;
-    mozc::emacs::PrintMessage(command.output(), &buffer);
-    const std::string output = absl::StrJoin(buffer, "");
+    output.clear();
+    mozc::emacs::PrintMessage(command.output(), &output);
     absl::FPrintF(
         stdout, "((emacs-event-id . %u)(emacs-session-id . %u)(output . %s))\n",
         event_id, session_id, output);
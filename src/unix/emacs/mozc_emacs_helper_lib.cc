@@ -36,6 +36,8 @@
 #include <cstdlib>
 #include <iterator>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "base/logging.h"
@@ -45,8 +47,11 @@
 #include "composer/key_parser.h"
 #include "protocol/candidates.pb.h"
 #include "protocol/commands.pb.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 
 namespace mozc {
 namespace emacs {
@@ -55,12 +60,12 @@ namespace {
 // forward declaration
 void PrintField(const protobuf::Message &message,
                 const protobuf::Reflection &reflection,
-                const protobuf::FieldDescriptor &field,
-                std::vector<std::string> *output);
+                const protobuf::FieldDescriptor &field, std::string *output);
 void PrintFieldValue(const protobuf::Message &message,
                      const protobuf::Reflection &reflection,
                      const protobuf::FieldDescriptor &field, int index,
-                     std::vector<std::string> *output);
+                     std::string *output);
+void PrintTypedMessage(const protobuf::Message &message, std::string *output);
 }  // namespace
 
 // Parses a line, which must be a single complete command in form of:
@@ -178,21 +183,38 @@ void ParseInputLine(const std::string &line, uint32_t *event_id,
 // 'output' is a text buffer to output 'message'.
 //
 // This function never outputs newlines except for ones in strings.
+void PrintMessage(const protobuf::Message &message, std::string *output) {
+  DCHECK(output);
+  PrintTypedMessage(message, output);
+}
+
 void PrintMessage(const protobuf::Message &message,
                   std::vector<std::string> *output) {
   DCHECK(output);
+  std::string buffer;
+  PrintMessage(message, &buffer);
+  output->push_back(std::move(buffer));
+}
+
+namespace internal {
+
+void PrintMessageWithReflection(const protobuf::Message &message,
+                                std::string *output) {
+  DCHECK(output);
 
   const protobuf::Reflection *reflection = message.GetReflection();
   std::vector<const protobuf::FieldDescriptor *> fields;
   reflection->ListFields(message, &fields);
 
-  output->push_back("(");
+  output->push_back('(');
   for (int i = 0; i < fields.size(); ++i) {
     PrintField(message, *reflection, *fields[i], output);
   }
-  output->push_back(")");
+  output->push_back(')');
 }
 
+}  // namespace internal
+
 // Utilities
 
 // Normalizes a symbol with the following rules:
@@ -393,6 +415,100 @@ bool RemoveUsageData(mozc::commands::Output *output) {
 
 namespace {
 
+// Appends a symbol normalized in the same way as NormalizeSymbol().
+// Symbols are field and enum value names, which consist of ASCII only.
+void AppendSymbol(absl::string_view symbol, std::string *output) {
+  for (const char c : symbol) {
+    output->push_back(c == '_' ? '-' : absl::ascii_tolower(c));
+  }
+}
+
+// Value printers shared by the reflection-based and the typed encoders.
+// - integer and floating point number are represented as is
+// - bool is represented as "t" or "nil"
+// - enum is represented as symbol
+// - string is represented as quoted string
+// - message and group are represented as alist
+void PrintValue(int32_t value, std::string *output) {
+  absl::StrAppend(output, value);
+}
+
+void PrintValue(uint32_t value, std::string *output) {
+  absl::StrAppend(output, value);
+}
+
+// Since Emacs does not support 64-bit integers, it supports only
+// 60-bit integers on 64-bit version, and 28-bit on 32-bit version,
+// we escape it into a string as a workaround.
+// We don't need any 64-bit values on Emacs so far, and 32-bit
+// integer values have never got over 28-bit yet.
+void PrintValue(int64_t value, std::string *output) {
+  absl::StrAppend(output, "\"", value, "\"");  // as a string
+}
+
+void PrintValue(uint64_t value, std::string *output) {
+  absl::StrAppend(output, "\"", value, "\"");  // as a string
+}
+
+void PrintValue(double value, std::string *output) {
+  absl::StrAppendFormat(output, "%f", value);
+}
+
+void PrintValue(float value, std::string *output) {
+  absl::StrAppendFormat(output, "%f", value);
+}
+
+void PrintValue(bool value, std::string *output) {
+  output->append(value ? "t" : "nil");
+}
+
+// Same as QuoteString() but appends to |output| directly.
+void PrintValue(const std::string &value, std::string *output) {
+  output->push_back('"');
+  for (const char c : value) {
+    if (c == '\\' || c == '"') {
+      output->push_back('\\');
+    }
+    output->push_back(c);
+  }
+  output->push_back('"');
+}
+
+template <typename T>
+std::enable_if_t<std::is_enum_v<T>> PrintValue(T value, std::string *output) {
+  const protobuf::EnumValueDescriptor *value_descriptor =
+      protobuf::GetEnumDescriptor<T>()->FindValueByNumber(value);
+  DCHECK(value_descriptor);
+  AppendSymbol(value_descriptor->name(), output);
+}
+
+// Typed encoders for the messages which the helper emits on every key event.
+// They access fields through the generated accessors instead of Reflection,
+// and must print fields in the order of their field numbers, as
+// Reflection::ListFields() does.  Messages without a typed encoder fall back
+// to internal::PrintMessageWithReflection().
+void PrintValue(const commands::Output &output_message, std::string *output);
+void PrintValue(const commands::Result &result, std::string *output);
+void PrintValue(const commands::Preedit &preedit, std::string *output);
+void PrintValue(const commands::Preedit::Segment &segment,
+                std::string *output);
+void PrintValue(const commands::Candidates &candidates, std::string *output);
+void PrintValue(const commands::Candidates::Candidate &candidate,
+                std::string *output);
+void PrintValue(const commands::CandidateList &candidate_list,
+                std::string *output);
+void PrintValue(const commands::CandidateWord &candidate_word,
+                std::string *output);
+void PrintValue(const commands::Annotation &annotation, std::string *output);
+void PrintValue(const commands::Footer &footer, std::string *output);
+void PrintValue(const commands::Status &status, std::string *output);
+void PrintValue(const commands::DeletionRange &deletion_range,
+                std::string *output);
+
+void PrintValue(const protobuf::Message &message, std::string *output) {
+  PrintTypedMessage(message, output);
+}
+
 // Prints one entry of a protocol buffer in S-expression.
 // An entry is a cons cell of key and value.
 //
@@ -403,28 +519,27 @@ namespace {
 // 'output' is a pseudo output stream to output field's key and value(s).
 void PrintField(const protobuf::Message &message,
                 const protobuf::Reflection &reflection,
-                const protobuf::FieldDescriptor &field,
-                std::vector<std::string> *output) {
-  output->push_back("(");
-  output->push_back(NormalizeSymbol(field.name()));
+                const protobuf::FieldDescriptor &field, std::string *output) {
+  output->push_back('(');
+  AppendSymbol(field.name(), output);
 
   if (!field.is_repeated()) {
-    output->push_back(" . ");  // Print an object as a value.
+    output->append(" . ");  // Print an object as a value.
     PrintFieldValue(message, reflection, field, -1 /* dummy arg */, output);
   } else {
-    output->push_back(" ");  // Print objects as a list.
+    output->push_back(' ');  // Print objects as a list.
     const int count = reflection.FieldSize(message, &field);
     const bool is_message =
         field.cpp_type() == protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
     for (int i = 0; i < count; ++i) {
       if (i != 0 && !is_message) {
-        output->push_back(" ");
+        output->push_back(' ');
       }
       PrintFieldValue(message, reflection, field, i, output);
     }
   }
 
-  output->push_back(")");
+  output->push_back(')');
 }
 
 // Prints a value of a field of a protocol buffer in S-expression.
@@ -443,7 +558,7 @@ void PrintField(const protobuf::Message &message,
 void PrintFieldValue(const protobuf::Message &message,
                      const protobuf::Reflection &reflection,
                      const protobuf::FieldDescriptor &field, int index,
-                     std::vector<std::string> *output) {
+                     std::string *output) {
 #define GET_FIELD_VALUE(METHOD_TYPE)                                 \
   (field.is_repeated()                                               \
        ? reflection.GetRepeated##METHOD_TYPE(message, &field, index) \
@@ -451,31 +566,22 @@ void PrintFieldValue(const protobuf::Message &message,
 
   switch (field.cpp_type()) {
     // Number (integer and floating point)
-#define PRINT_FIELD_VALUE(PROTO_CPP_TYPE, METHOD_TYPE, CPP_TYPE, FORMAT) \
-  case protobuf::FieldDescriptor::CPPTYPE_##PROTO_CPP_TYPE:              \
-    output->push_back(absl::StrFormat(                                   \
-        FORMAT, static_cast<CPP_TYPE>(GET_FIELD_VALUE(METHOD_TYPE))));   \
+#define PRINT_FIELD_VALUE(PROTO_CPP_TYPE, METHOD_TYPE, CPP_TYPE)             \
+  case protobuf::FieldDescriptor::CPPTYPE_##PROTO_CPP_TYPE:                 \
+    PrintValue(static_cast<CPP_TYPE>(GET_FIELD_VALUE(METHOD_TYPE)), output); \
     break;
 
-    // Since Emacs does not support 64-bit integers, it supports only
-    // 60-bit integers on 64-bit version, and 28-bit on 32-bit version,
-    // we escape it into a string as a workaround.
-    // We don't need any 64-bit values on Emacs so far, and 32-bit
-    // integer values have never got over 28-bit yet.
-    PRINT_FIELD_VALUE(INT32, Int32, int32_t, "%d");
-    PRINT_FIELD_VALUE(INT64, Int64, int64_t, "\"%d\"");  // as a string
-    PRINT_FIELD_VALUE(UINT32, UInt32, uint32_t, "%u");
-    PRINT_FIELD_VALUE(UINT64, UInt64, uint64_t, "\"%u\"");  // as a string
-    PRINT_FIELD_VALUE(DOUBLE, Double, double, "%f");
-    PRINT_FIELD_VALUE(FLOAT, Float, float, "%f");
+    PRINT_FIELD_VALUE(INT32, Int32, int32_t);
+    PRINT_FIELD_VALUE(INT64, Int64, int64_t);
+    PRINT_FIELD_VALUE(UINT32, UInt32, uint32_t);
+    PRINT_FIELD_VALUE(UINT64, UInt64, uint64_t);
+    PRINT_FIELD_VALUE(DOUBLE, Double, double);
+    PRINT_FIELD_VALUE(FLOAT, Float, float);
+    PRINT_FIELD_VALUE(BOOL, Bool, bool);
 #undef PRINT_FIELD_VALUE
 
-    case protobuf::FieldDescriptor::CPPTYPE_BOOL:  // bool
-      output->push_back(GET_FIELD_VALUE(Bool) ? "t" : "nil");
-      break;
-
     case protobuf::FieldDescriptor::CPPTYPE_ENUM:  // enum
-      output->push_back(NormalizeSymbol(GET_FIELD_VALUE(Enum)->name()));
+      AppendSymbol(GET_FIELD_VALUE(Enum)->name(), output);
       break;
 
     case protobuf::FieldDescriptor::CPPTYPE_STRING: {  // string
@@ -484,19 +590,217 @@ void PrintFieldValue(const protobuf::Message &message,
                 ? reflection.GetRepeatedStringReference(message, &field, index,
                                                         &str)
                 : reflection.GetStringReference(message, &field, &str);
-      output->push_back(QuoteString(str));
+      PrintValue(str, output);
       break;
     }
 
     // message and group
     case protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
-      PrintMessage(GET_FIELD_VALUE(Message), output);
+      internal::PrintMessageWithReflection(GET_FIELD_VALUE(Message), output);
       break;
   }
 
 #undef GET_FIELD_VALUE
 }
 
+template <typename T>
+constexpr bool IsMessage() {
+  return std::is_base_of_v<protobuf::Message, std::decay_t<T>>;
+}
+
+#define PRINT_FIELD(MESSAGE, FIELD)    \
+  if (MESSAGE.has_##FIELD()) {         \
+    output->push_back('(');            \
+    AppendSymbol(#FIELD, output);      \
+    output->append(" . ");             \
+    PrintValue(MESSAGE.FIELD(), output); \
+    output->push_back(')');            \
+  }
+
+#define PRINT_REPEATED_FIELD(MESSAGE, FIELD)                     \
+  if (MESSAGE.FIELD##_size() > 0) {                              \
+    output->push_back('(');                                      \
+    AppendSymbol(#FIELD, output);                                \
+    output->push_back(' ');                                      \
+    for (int i = 0; i < MESSAGE.FIELD##_size(); ++i) {           \
+      if (i != 0 && !IsMessage<decltype(MESSAGE.FIELD(i))>()) {  \
+        output->push_back(' ');                                  \
+      }                                                          \
+      PrintValue(MESSAGE.FIELD(i), output);                      \
+    }                                                            \
+    output->push_back(')');                                      \
+  }
+
+void PrintValue(const commands::Output &output_message, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(output_message, id);
+  PRINT_FIELD(output_message, mode);
+  PRINT_FIELD(output_message, consumed);
+  PRINT_FIELD(output_message, result);
+  PRINT_FIELD(output_message, preedit);
+  PRINT_FIELD(output_message, candidates);
+  PRINT_FIELD(output_message, key);
+  PRINT_FIELD(output_message, url);
+  PRINT_FIELD(output_message, config);
+  PRINT_FIELD(output_message, preedit_method);
+  PRINT_FIELD(output_message, error_code);
+  PRINT_FIELD(output_message, status);
+  PRINT_FIELD(output_message, all_candidate_words);
+  PRINT_FIELD(output_message, deletion_range);
+  PRINT_FIELD(output_message, launch_tool_mode);
+  PRINT_FIELD(output_message, callback);
+  PRINT_FIELD(output_message, user_dictionary_command_status);
+  PRINT_FIELD(output_message, engine_reload_response);
+  PRINT_FIELD(output_message, removed_candidate_words_for_debug);
+  PRINT_FIELD(output_message, check_spelling_response);
+  PRINT_FIELD(output_message, incognito_candidate_words);
+  PRINT_FIELD(output_message, latency_stats);
+  PRINT_FIELD(output_message, conversion_truncated);
+  PRINT_FIELD(output_message, memory_stats);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Result &result, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(result, type);
+  PRINT_FIELD(result, value);
+  PRINT_FIELD(result, key);
+  PRINT_FIELD(result, cursor_offset);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Preedit &preedit, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(preedit, cursor);
+  PRINT_REPEATED_FIELD(preedit, segment);
+  PRINT_FIELD(preedit, highlighted_position);
+  PRINT_FIELD(preedit, is_toggleable);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Preedit::Segment &segment,
+                std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(segment, annotation);
+  PRINT_FIELD(segment, value);
+  PRINT_FIELD(segment, value_length);
+  PRINT_FIELD(segment, key);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Candidates &candidates, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(candidates, focused_index);
+  PRINT_FIELD(candidates, size);
+  PRINT_REPEATED_FIELD(candidates, candidate);
+  PRINT_FIELD(candidates, position);
+  PRINT_FIELD(candidates, subcandidates);
+  PRINT_FIELD(candidates, usages);
+  PRINT_FIELD(candidates, category);
+  PRINT_FIELD(candidates, display_type);
+  PRINT_FIELD(candidates, footer);
+  PRINT_FIELD(candidates, direction);
+  PRINT_FIELD(candidates, page_size);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Candidates::Candidate &candidate,
+                std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(candidate, index);
+  PRINT_FIELD(candidate, value);
+  PRINT_FIELD(candidate, annotation);
+  PRINT_FIELD(candidate, id);
+  PRINT_FIELD(candidate, information_id);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::CandidateList &candidate_list,
+                std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(candidate_list, focused_index);
+  PRINT_REPEATED_FIELD(candidate_list, candidates);
+  PRINT_FIELD(candidate_list, category);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::CandidateWord &candidate_word,
+                std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(candidate_word, id);
+  PRINT_FIELD(candidate_word, index);
+  PRINT_FIELD(candidate_word, key);
+  PRINT_FIELD(candidate_word, value);
+  PRINT_FIELD(candidate_word, annotation);
+  PRINT_REPEATED_FIELD(candidate_word, attributes);
+  PRINT_FIELD(candidate_word, num_segments_in_candidate);
+  PRINT_FIELD(candidate_word, log);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Annotation &annotation, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(annotation, prefix);
+  PRINT_FIELD(annotation, suffix);
+  PRINT_FIELD(annotation, description);
+  PRINT_FIELD(annotation, shortcut);
+  PRINT_FIELD(annotation, deletable);
+  PRINT_FIELD(annotation, a11y_description);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Footer &footer, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(footer, label);
+  PRINT_FIELD(footer, index_visible);
+  PRINT_FIELD(footer, logo_visible);
+  PRINT_FIELD(footer, sub_label);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::Status &status, std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(status, activated);
+  PRINT_FIELD(status, mode);
+  PRINT_FIELD(status, comeback_mode);
+  PRINT_FIELD(status, undo_available);
+  output->push_back(')');
+}
+
+void PrintValue(const commands::DeletionRange &deletion_range,
+                std::string *output) {
+  output->push_back('(');
+  PRINT_FIELD(deletion_range, offset);
+  PRINT_FIELD(deletion_range, length);
+  output->push_back(')');
+}
+
+#undef PRINT_REPEATED_FIELD
+#undef PRINT_FIELD
+
+// Prints |message| with its typed encoder if |message| is of type T.
+template <typename T>
+bool MaybePrintTyped(const protobuf::Message &message, std::string *output) {
+  const T *typed = protobuf::DynamicCastToGenerated<T>(&message);
+  if (typed == nullptr) {
+    return false;
+  }
+  PrintValue(*typed, output);
+  return true;
+}
+
+void PrintTypedMessage(const protobuf::Message &message, std::string *output) {
+  if (MaybePrintTyped<commands::Output>(message, output) ||
+      MaybePrintTyped<commands::Candidates>(message, output) ||
+      MaybePrintTyped<commands::CandidateList>(message, output) ||
+      MaybePrintTyped<commands::Preedit>(message, output) ||
+      MaybePrintTyped<commands::Result>(message, output) ||
+      MaybePrintTyped<commands::Status>(message, output)) {
+    return;
+  }
+  internal::PrintMessageWithReflection(message, output);
+}
+
 }  // namespace
 }  // namespace emacs
 }  // namespace mozc
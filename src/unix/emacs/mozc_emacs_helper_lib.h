@@ -77,6 +77,13 @@ void ParseInputLine(const std::string &line, uint32_t *event_id,
 // 'output' is a text buffer to output 'message'.
 //
 // This function never outputs newlines except for ones in strings.
+//
+// The result is appended to 'output', so a caller can reuse a single buffer
+// across calls.  Output and the messages nested in it are printed with typed
+// encoders and do not go through protobuf::Reflection.
+void PrintMessage(const mozc::protobuf::Message &message, std::string *output);
+
+// Same as above, but pushes the result into 'output' as a single token.
 void PrintMessage(const mozc::protobuf::Message &message,
                   std::vector<std::string> *output);
 
@@ -114,6 +121,15 @@ void ErrorExit(const std::string &error, const std::string &message);
 // This function returns true if usage data is removed.
 bool RemoveUsageData(mozc::commands::Output *output);
 
+namespace internal {
+
+// Prints 'message' in the same format as PrintMessage() by walking its fields
+// with protobuf::Reflection.  Used for messages without a typed encoder and
+// as a reference in tests.
+void PrintMessageWithReflection(const mozc::protobuf::Message &message,
+                                std::string *output);
+
+}  // namespace internal
 }  // namespace emacs
 }  // namespace mozc
 
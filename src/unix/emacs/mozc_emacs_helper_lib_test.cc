@@ -41,6 +41,7 @@
 #include "protocol/commands.pb.h"
 #include "testing/googletest.h"
 #include "testing/gunit.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 
 class MozcEmacsHelperLibTest : public testing::Test {
@@ -298,3 +299,70 @@ TEST_F(MozcEmacsHelperLibTest, RemoveUsageDataTest) {
     EXPECT_TRUE(output.candidates().has_usages());
   }
 }
+
+namespace {
+
+// Sets all the fields of |message| to non-default values so that every typed
+// encoder is exercised.  Nested messages are filled up to |depth| levels.
+void FillAllFields(mozc::protobuf::Message *message, int depth) {
+  const mozc::protobuf::Descriptor *descriptor = message->GetDescriptor();
+  const mozc::protobuf::Reflection *reflection = message->GetReflection();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const mozc::protobuf::FieldDescriptor *field = descriptor->field(i);
+    const int count = field->is_repeated() ? 2 : 1;
+    for (int j = 0; j < count; ++j) {
+      const int value = i * 10 + j + 1;
+      switch (field->cpp_type()) {
+#define SET_FIELD(PROTO_CPP_TYPE, METHOD_TYPE, VALUE)             \
+  case mozc::protobuf::FieldDescriptor::CPPTYPE_##PROTO_CPP_TYPE: \
+    if (field->is_repeated()) {                                   \
+      reflection->Add##METHOD_TYPE(message, field, VALUE);        \
+    } else {                                                      \
+      reflection->Set##METHOD_TYPE(message, field, VALUE);        \
+    }                                                             \
+    break;
+
+        SET_FIELD(INT32, Int32, -value);
+        SET_FIELD(INT64, Int64, -value);
+        SET_FIELD(UINT32, UInt32, value);
+        SET_FIELD(UINT64, UInt64, value);
+        SET_FIELD(DOUBLE, Double, value + 0.5);
+        SET_FIELD(FLOAT, Float, value + 0.25f);
+        SET_FIELD(BOOL, Bool, j == 0);
+        SET_FIELD(STRING, String, absl::StrCat("\"\\", field->name(), j));
+        SET_FIELD(ENUM, Enum,
+                  field->enum_type()->value(field->enum_type()->value_count() -
+                                            1));
+#undef SET_FIELD
+
+        case mozc::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+          if (depth > 0) {
+            FillAllFields(field->is_repeated()
+                              ? reflection->AddMessage(message, field)
+                              : reflection->MutableMessage(message, field),
+                          depth - 1);
+          }
+          break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_F(MozcEmacsHelperLibTest, PrintMessageMatchesReflection) {
+  mozc::commands::Output output;
+  FillAllFields(&output, 3);
+  ASSERT_TRUE(output.candidates().candidate(0).has_annotation());
+  ASSERT_TRUE(output.all_candidate_words().candidates(0).has_annotation());
+
+  std::string expected;
+  mozc::emacs::internal::PrintMessageWithReflection(output, &expected);
+  std::string actual;
+  mozc::emacs::PrintMessage(output, &actual);
+  EXPECT_EQ(actual, expected);
+
+  // The result is appended to the buffer.
+  mozc::emacs::PrintMessage(output, &actual);
+  EXPECT_EQ(actual, expected + expected);
+}
@@ -0,0 +1,342 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "usage_stats/latency_stats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/numeric/bits.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace usage_stats {
+namespace {
+
+// Samples are bucketed by nanoseconds on a log-linear scale: every power of
+// two is split into 2^kSubBucketBits buckets. Samples longer than
+// 2^kMaxExponent ns (about 68 seconds) go to the last bucket.
+constexpr int kSubBucketBits = 2;
+constexpr int kSubBuckets = 1 << kSubBucketBits;
+constexpr int kMaxExponent = 36;
+constexpr size_t kNumBuckets =
+    (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxExponent) - 1;
+
+size_t GetBucketIndex(uint64_t value) {
+  value = std::min(value, kMaxValue);
+  if (value < kSubBuckets) {
+    return value;
+  }
+  const int msb = absl::bit_width(value) - 1;
+  const int shift = msb - kSubBucketBits;
+  const uint64_t sub = (value >> shift) & (kSubBuckets - 1);
+  return (shift + 1) * kSubBuckets + sub;
+}
+
+// Returns the largest value which falls into the bucket |index|.
+uint64_t GetBucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const int shift = index / kSubBuckets - 1;
+  const uint64_t sub = index % kSubBuckets;
+  return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+// Histogram of one stage on one thread. Only the owner thread adds samples;
+// the counters are atomic so that readers and Reset() can access them
+// concurrently without a lock.
+struct Histogram {
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets = {};
+  std::atomic<uint64_t> total_ns = 0;
+  std::atomic<uint64_t> max_ns = 0;
+
+  void Add(uint64_t ns) {
+    buckets[GetBucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > max_ns.load(std::memory_order_relaxed)) {
+      max_ns.store(ns, std::memory_order_relaxed);
+    }
+  }
+
+  void Clear() {
+    for (std::atomic<uint64_t> &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+  }
+};
+
+// Plain counterpart of Histogram used to merge the per-thread histograms.
+struct MergedHistogram {
+  std::array<uint64_t, kNumBuckets> buckets = {};
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+
+  void Merge(const Histogram &histogram) {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      const uint64_t n = histogram.buckets[i].load(std::memory_order_relaxed);
+      buckets[i] += n;
+      count += n;
+    }
+    total_ns += histogram.total_ns.load(std::memory_order_relaxed);
+    max_ns = std::max(max_ns, histogram.max_ns.load(std::memory_order_relaxed));
+  }
+
+  void MergeTo(Histogram *histogram) const {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      histogram->buckets[i].fetch_add(buckets[i], std::memory_order_relaxed);
+    }
+    histogram->total_ns.fetch_add(total_ns, std::memory_order_relaxed);
+    histogram->max_ns.store(
+        std::max(max_ns, histogram->max_ns.load(std::memory_order_relaxed)),
+        std::memory_order_relaxed);
+  }
+
+  absl::Duration GetPercentile(double percentile) const {
+    const uint64_t rank =
+        std::max<uint64_t>(1, static_cast<uint64_t>(count * percentile));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        return absl::Nanoseconds(std::min(GetBucketUpperBound(i), max_ns));
+      }
+    }
+    return absl::Nanoseconds(max_ns);
+  }
+};
+
+class ThreadBuffer;
+
+class Registry {
+ public:
+  static Registry *Get() {
+    // Intentionally leaked so that threads exiting after main() can still
+    // unregister their buffers.
+    static Registry *registry = new Registry();
+    return registry;
+  }
+
+  LatencyStats::StageId RegisterStage(absl::string_view name) {
+    absl::MutexLock lock(&mutex_);
+    if (const auto it = ids_.find(name); it != ids_.end()) {
+      return it->second;
+    }
+    const size_t id = names_.size();
+    if (id >= LatencyStats::kMaxStages) {
+      return LatencyStats::kInvalidStage;
+    }
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+  }
+
+  void AddBuffer(ThreadBuffer *buffer) {
+    absl::MutexLock lock(&mutex_);
+    buffers_.insert(buffer);
+  }
+
+  // Moves the samples of |buffer| to retired_ and forgets the buffer.
+  void RemoveBuffer(ThreadBuffer *buffer);
+
+  std::vector<LatencyStats::StageSummary> GetSummaries();
+  void Reset();
+
+ private:
+  Registry() = default;
+
+  MergedHistogram MergeLocked(size_t stage)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  absl::Mutex mutex_;
+  std::vector<std::string> names_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, LatencyStats::StageId> ids_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_set<ThreadBuffer *> buffers_ ABSL_GUARDED_BY(mutex_);
+  // Samples of the threads which have already exited.
+  std::array<Histogram, LatencyStats::kMaxStages> retired_;
+};
+
+// Per-thread set of histograms, allocated lazily on the first sample of each
+// stage.
+class ThreadBuffer {
+ public:
+  ThreadBuffer() { Registry::Get()->AddBuffer(this); }
+
+  ThreadBuffer(const ThreadBuffer &) = delete;
+  ThreadBuffer &operator=(const ThreadBuffer &) = delete;
+
+  ~ThreadBuffer() {
+    Registry::Get()->RemoveBuffer(this);
+    for (std::atomic<Histogram *> &histogram : histograms_) {
+      delete histogram.load(std::memory_order_relaxed);
+    }
+  }
+
+  static ThreadBuffer &Get() {
+    thread_local ThreadBuffer buffer;
+    return buffer;
+  }
+
+  void Add(LatencyStats::StageId stage, uint64_t ns) {
+    Histogram *histogram = histograms_[stage].load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+      histogram = new Histogram();
+      // Publishes the initialized histogram to the readers.
+      histograms_[stage].store(histogram, std::memory_order_release);
+    }
+    histogram->Add(ns);
+  }
+
+  // Returns the histogram of |stage|, or nullptr if no sample was recorded.
+  // Must be called with the registry lock held, which keeps |this| alive.
+  const Histogram *GetHistogram(size_t stage) const {
+    return histograms_[stage].load(std::memory_order_acquire);
+  }
+
+  Histogram *GetMutableHistogram(size_t stage) {
+    return histograms_[stage].load(std::memory_order_acquire);
+  }
+
+ private:
+  std::array<std::atomic<Histogram *>, LatencyStats::kMaxStages> histograms_ =
+      {};
+};
+
+void Registry::RemoveBuffer(ThreadBuffer *buffer) {
+  absl::MutexLock lock(&mutex_);
+  for (size_t stage = 0; stage < names_.size(); ++stage) {
+    if (const Histogram *histogram = buffer->GetHistogram(stage);
+        histogram != nullptr) {
+      MergedHistogram merged;
+      merged.Merge(*histogram);
+      merged.MergeTo(&retired_[stage]);
+    }
+  }
+  buffers_.erase(buffer);
+}
+
+MergedHistogram Registry::MergeLocked(size_t stage) {
+  MergedHistogram merged;
+  merged.Merge(retired_[stage]);
+  for (const ThreadBuffer *buffer : buffers_) {
+    if (const Histogram *histogram = buffer->GetHistogram(stage);
+        histogram != nullptr) {
+      merged.Merge(*histogram);
+    }
+  }
+  return merged;
+}
+
+std::vector<LatencyStats::StageSummary> Registry::GetSummaries() {
+  std::vector<LatencyStats::StageSummary> summaries;
+  absl::MutexLock lock(&mutex_);
+  for (size_t stage = 0; stage < names_.size(); ++stage) {
+    const MergedHistogram merged = MergeLocked(stage);
+    if (merged.count == 0) {
+      continue;
+    }
+    LatencyStats::StageSummary &summary = summaries.emplace_back();
+    summary.name = names_[stage];
+    summary.count = merged.count;
+    summary.total = absl::Nanoseconds(merged.total_ns);
+    summary.p50 = merged.GetPercentile(0.5);
+    summary.p90 = merged.GetPercentile(0.9);
+    summary.p99 = merged.GetPercentile(0.99);
+    summary.max = absl::Nanoseconds(merged.max_ns);
+  }
+  return summaries;
+}
+
+void Registry::Reset() {
+  absl::MutexLock lock(&mutex_);
+  for (size_t stage = 0; stage < names_.size(); ++stage) {
+    retired_[stage].Clear();
+    for (ThreadBuffer *buffer : buffers_) {
+      if (Histogram *histogram = buffer->GetMutableHistogram(stage);
+          histogram != nullptr) {
+        histogram->Clear();
+      }
+    }
+  }
+}
+
+}  // namespace
+
+LatencyStats::StageId LatencyStats::RegisterStage(absl::string_view name) {
+  return Registry::Get()->RegisterStage(name);
+}
+
+void LatencyStats::Record(StageId stage, absl::Duration elapsed) {
+  if (stage < 0 || stage >= kMaxStages) {
+    return;
+  }
+  const int64_t ns = absl::ToInt64Nanoseconds(elapsed);
+  ThreadBuffer::Get().Add(stage, ns < 0 ? 0 : ns);
+}
+
+std::vector<LatencyStats::StageSummary> LatencyStats::GetSummaries() {
+  return Registry::Get()->GetSummaries();
+}
+
+std::string LatencyStats::Dump() {
+  std::string result =
+      absl::StrFormat("%-48s %8s %10s %10s %10s %10s %12s\n", "stage", "count",
+                      "p50(us)", "p90(us)", "p99(us)", "max(us)", "total(ms)");
+  for (const StageSummary &summary : GetSummaries()) {
+    absl::StrAppendFormat(
+        &result, "%-48s %8d %10.1f %10.1f %10.1f %10.1f %12.3f\n",
+        summary.name, summary.count,
+        absl::ToDoubleMicroseconds(summary.p50),
+        absl::ToDoubleMicroseconds(summary.p90),
+        absl::ToDoubleMicroseconds(summary.p99),
+        absl::ToDoubleMicroseconds(summary.max),
+        absl::ToDoubleMilliseconds(summary.total));
+  }
+  return result;
+}
+
+void LatencyStats::Reset() { Registry::Get()->Reset(); }
+
+}  // namespace usage_stats
+}  // namespace mozc
@@ -0,0 +1,124 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Lightweight latency histograms for the stages of the conversion pipeline.
+//
+// Each stage is registered once by name and then recorded from any thread.
+// Recording only touches a buffer owned by the calling thread, so the hot
+// path takes no lock; readers merge the per-thread buffers on demand.
+//
+// Usage:
+//   static const LatencyStats::StageId kStage =
+//       LatencyStats::RegisterStage("ImmutableConverter.MakeLattice");
+//   ScopedLatencyTimer timer(kStage);
+
+#ifndef MOZC_USAGE_STATS_LATENCY_STATS_H_
+#define MOZC_USAGE_STATS_LATENCY_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace usage_stats {
+
+class LatencyStats {
+ public:
+  using StageId = int;
+
+  // Recording to this stage is a no-op.
+  static constexpr StageId kInvalidStage = -1;
+
+  // Maximum number of stages. RegisterStage() returns kInvalidStage once the
+  // table is full.
+  static constexpr size_t kMaxStages = 128;
+
+  struct StageSummary {
+    std::string name;
+    uint64_t count = 0;
+    absl::Duration total;
+    // Percentiles are the upper bounds of the histogram buckets, whose width
+    // is at most 25% of their lower bounds.
+    absl::Duration p50;
+    absl::Duration p90;
+    absl::Duration p99;
+    absl::Duration max;
+  };
+
+  LatencyStats() = delete;
+
+  // Returns the id of the stage |name|, registering it on the first call.
+  // Callers should cache the result as it takes a lock.
+  static StageId RegisterStage(absl::string_view name);
+
+  // Records one sample of |elapsed| to |stage|.
+  static void Record(StageId stage, absl::Duration elapsed);
+
+  // Returns the summaries of the stages which have at least one sample, in
+  // the order of registration.
+  static std::vector<StageSummary> GetSummaries();
+
+  // Returns the summaries as a human readable table.
+  static std::string Dump();
+
+  // Clears all the samples. The registered stages are kept.
+  static void Reset();
+};
+
+// Records the lifetime of this object to the given stage.
+class ScopedLatencyTimer {
+ public:
+  explicit ScopedLatencyTimer(LatencyStats::StageId stage)
+      : stage_(stage),
+        start_(stage == LatencyStats::kInvalidStage ? absl::InfinitePast()
+                                                    : absl::Now()) {}
+
+  ScopedLatencyTimer(const ScopedLatencyTimer &) = delete;
+  ScopedLatencyTimer &operator=(const ScopedLatencyTimer &) = delete;
+
+  ~ScopedLatencyTimer() {
+    if (stage_ != LatencyStats::kInvalidStage) {
+      LatencyStats::Record(stage_, absl::Now() - start_);
+    }
+  }
+
+ private:
+  const LatencyStats::StageId stage_;
+  const absl::Time start_;
+};
+
+}  // namespace usage_stats
+}  // namespace mozc
+
+#endif  // MOZC_USAGE_STATS_LATENCY_STATS_H_
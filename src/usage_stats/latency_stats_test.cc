@@ -0,0 +1,158 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "usage_stats/latency_stats.h"
+
+#include <string>
+#include <vector>
+
+#include "base/thread2.h"
+#include "testing/gunit.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace usage_stats {
+namespace {
+
+class LatencyStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { LatencyStats::Reset(); }
+  void TearDown() override { LatencyStats::Reset(); }
+
+  static const LatencyStats::StageSummary *FindSummary(
+      const std::vector<LatencyStats::StageSummary> &summaries,
+      const std::string &name) {
+    for (const LatencyStats::StageSummary &summary : summaries) {
+      if (summary.name == name) {
+        return &summary;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(LatencyStatsTest, RegisterStage) {
+  const LatencyStats::StageId a = LatencyStats::RegisterStage("Test.A");
+  const LatencyStats::StageId b = LatencyStats::RegisterStage("Test.B");
+  EXPECT_NE(a, LatencyStats::kInvalidStage);
+  EXPECT_NE(b, LatencyStats::kInvalidStage);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(LatencyStats::RegisterStage("Test.A"), a);
+}
+
+TEST_F(LatencyStatsTest, Percentiles) {
+  const LatencyStats::StageId stage =
+      LatencyStats::RegisterStage("Test.Percentiles");
+  for (int i = 1; i <= 100; ++i) {
+    LatencyStats::Record(stage, absl::Microseconds(i));
+  }
+  LatencyStats::Record(LatencyStats::kInvalidStage, absl::Seconds(1));
+
+  const std::vector<LatencyStats::StageSummary> summaries =
+      LatencyStats::GetSummaries();
+  const LatencyStats::StageSummary *summary =
+      FindSummary(summaries, "Test.Percentiles");
+  ASSERT_NE(summary, nullptr);
+  EXPECT_EQ(summary->count, 100);
+  EXPECT_EQ(summary->total, absl::Microseconds(5050));
+  EXPECT_EQ(summary->max, absl::Microseconds(100));
+  // Buckets are at most 25% wide.
+  EXPECT_GE(summary->p50, absl::Microseconds(50));
+  EXPECT_LE(summary->p50, absl::Microseconds(63));
+  EXPECT_GE(summary->p90, absl::Microseconds(90));
+  EXPECT_LE(summary->p90, absl::Microseconds(100));
+  EXPECT_GE(summary->p99, absl::Microseconds(99));
+  EXPECT_LE(summary->p99, absl::Microseconds(100));
+}
+
+TEST_F(LatencyStatsTest, Reset) {
+  const LatencyStats::StageId stage =
+      LatencyStats::RegisterStage("Test.Reset");
+  LatencyStats::Record(stage, absl::Milliseconds(1));
+  EXPECT_NE(FindSummary(LatencyStats::GetSummaries(), "Test.Reset"), nullptr);
+
+  LatencyStats::Reset();
+  EXPECT_EQ(FindSummary(LatencyStats::GetSummaries(), "Test.Reset"), nullptr);
+  EXPECT_EQ(LatencyStats::RegisterStage("Test.Reset"), stage);
+}
+
+TEST_F(LatencyStatsTest, MergesThreads) {
+  const LatencyStats::StageId stage =
+      LatencyStats::RegisterStage("Test.MergesThreads");
+  constexpr int kNumThreads = 4;
+  constexpr int kNumSamples = 1000;
+
+  // Keeps one thread alive while reading so that both the live and the
+  // retired buffers are merged.
+  absl::Notification done;
+  Thread2 live([&] {
+    LatencyStats::Record(stage, absl::Microseconds(1));
+    done.WaitForNotification();
+  });
+  std::vector<Thread2> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([stage] {
+      for (int j = 0; j < kNumSamples; ++j) {
+        ScopedLatencyTimer timer(stage);
+      }
+    });
+  }
+  for (Thread2 &thread : threads) {
+    thread.Join();
+  }
+
+  // The live thread may not have recorded yet; retry until it has.
+  const LatencyStats::StageSummary *summary = nullptr;
+  std::vector<LatencyStats::StageSummary> summaries;
+  do {
+    summaries = LatencyStats::GetSummaries();
+    summary = FindSummary(summaries, "Test.MergesThreads");
+  } while (summary == nullptr || summary->count < kNumThreads * kNumSamples + 1);
+  EXPECT_EQ(summary->count, kNumThreads * kNumSamples + 1);
+
+  done.Notify();
+  live.Join();
+  summaries = LatencyStats::GetSummaries();
+  summary = FindSummary(summaries, "Test.MergesThreads");
+  ASSERT_NE(summary, nullptr);
+  EXPECT_EQ(summary->count, kNumThreads * kNumSamples + 1);
+}
+
+TEST_F(LatencyStatsTest, Dump) {
+  const LatencyStats::StageId stage = LatencyStats::RegisterStage("Test.Dump");
+  LatencyStats::Record(stage, absl::Microseconds(10));
+  const std::string dump = LatencyStats::Dump();
+  EXPECT_NE(dump.find("p99(us)"), std::string::npos);
+  EXPECT_NE(dump.find("Test.Dump"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace usage_stats
+}  // namespace mozc
@@ -49,6 +49,19 @@
         'usage_stats_protocol',
       ],
     },
+    {
+      'target_name': 'latency_stats',
+      'type': 'static_library',
+      'sources': [
+        'latency_stats.cc',
+      ],
+      'dependencies': [
+        '../base/absl.gyp:absl_hash_internal',
+        '../base/absl.gyp:absl_strings',
+        '../base/absl.gyp:absl_synchronization',
+        '../base/absl.gyp:absl_time',
+      ],
+    },
     {
       'target_name': 'gen_usage_stats_list',
       'type': 'none',
@@ -61,6 +61,21 @@
         'test_size': 'small',
       },
     },
+    {
+      'target_name': 'latency_stats_test',
+      'type': 'executable',
+      'sources': [
+        'latency_stats_test.cc',
+      ],
+      'dependencies': [
+        '../base/base.gyp:base',
+        '../testing/testing.gyp:gtest_main',
+        'usage_stats_base.gyp:latency_stats',
+      ],
+      'variables': {
+        'test_size': 'small',
+      },
+    },
     {
       'target_name': 'usage_stats_uploader_test',
       'type': 'executable',
@@ -82,6 +97,7 @@
       'target_name': 'usage_stats_all_test',
       'type': 'none',
       'dependencies': [
+        'latency_stats_test',
         'usage_stats_test',
         'usage_stats_uploader_test',
       ],